@@ -0,0 +1,154 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include "acceptbenchmark.h"
+#include "../net/socket.h"
+#include "../net/eventloop.h"
+#include "../net/connection.h"
+
+using namespace std::chrono;
+using MSIYBCore::Arena;
+using MSIYBCore::Pool;
+
+#ifdef __linux__
+/*!
+\class AcceptBenchmarkServer
+\brief  Accepts the connections as Server does and stops the loop after the last one is closed.
+*/
+class AcceptBenchmarkServer : public IEventHandler, public IConnectionHandler
+{
+public:
+	AcceptBenchmarkServer(Socket &listener, EventLoop &loop) : _listener(listener), _loop(loop)
+	{
+		_arena = NULL;
+		_connections = 0;
+		_closed = 0;
+	}
+
+	~AcceptBenchmarkServer()
+	{
+		delete _arena;
+	}
+
+	/*!
+	Waits for the next measurement.
+	\param[in] connections The number of the connections to be closed before the loop stops.
+	*/
+	void Reset(int connections)
+	{
+		_connections = connections;
+		_closed = 0;
+	}
+
+	void HandleEvents(int /*events*/) override
+	{
+		Socket *client;
+		for (;;)
+		{
+			if (!_arena)
+			{
+				_arena = new Arena();
+			}
+			if ((client = _listener.AcceptSocket(_arena)) == NULL)
+			{
+				break;
+			}
+			new Connection(client, _loop, *this, _arena);
+			_arena = NULL;
+		}
+	}
+
+	void OnMessage(Connection &connection, char * /*data*/, int /*size*/) override
+	{
+		connection.Send(NULL, 0);
+	}
+
+	void OnStream(Connection & /*connection*/, File *file, size_lt /*size*/, Hasher *hasher) override
+	{
+		delete file;
+		delete hasher;
+	}
+
+	void OnClose(Connection & /*connection*/) override
+	{
+		if (++_closed == _connections)
+		{
+			_loop.Stop();
+		}
+	}
+
+private:
+	Socket &_listener;		///< The listener
+	EventLoop &_loop;		///< The loop of the connections
+	Arena *_arena;			///< The arena for the next accepted connection
+	int _connections;		///< The connections of the measurement
+	int _closed;			///< The connections closed in the measurement
+};
+
+/*!
+Serves the connections of the clients.
+\param[in] recycle TRUE to recycle the memory of the connections through Pool, FALSE to take it from the heap.
+\return The connections per second.
+*/
+static double MeasureAccept(AcceptBenchmarkServer &server, EventLoop &loop, bool recycle, int connections, int clients)
+{
+	int perClient = connections / clients;
+	Pool::SetRecycling(recycle);
+	server.Reset(perClient * clients);
+
+	steady_clock::time_point start = steady_clock::now();
+	std::vector<std::thread> connectors;
+	for (int c = 0; c < clients; c++)
+	{
+		connectors.emplace_back([perClient]()
+		{
+			char request[] = "ping";
+			char reply[16];
+			for (int i = 0; i < perClient; i++)
+			{
+				Socket client(BENCHMARK_ACCEPT_PORT, (char*)"127.0.0.1");
+				client.Connect();
+				client.SendAll(request, (int)sizeof(request));
+				client.RecvAll(reply);
+				client.Close();
+			}
+		});
+	}
+	loop.Run();
+	for (std::thread &connector : connectors)
+	{
+		connector.join();
+	}
+	double elapsed = (double)duration_cast<nanoseconds>(steady_clock::now() - start).count();
+	Pool::SetRecycling(true);
+	return (double)perClient * clients * 1e9 / elapsed;
+}
+#endif
+
+void RunAcceptBenchmark(int connections, int clients)
+{
+#ifdef __linux__
+	Socket listener((short)BENCHMARK_ACCEPT_PORT);
+	listener.Bind();
+	listener.Listen(SERVER_LISTEN_BACKLOG);
+	listener.SetNonBlocking(true);
+	EventLoop loop;
+	AcceptBenchmarkServer server(listener, loop);
+	loop.Add(&listener, &server, EVENTREAD);
+
+	printf("Accept benchmark: %d connections from %d threads, %u processors\n", connections, clients,
+		std::thread::hardware_concurrency());
+	printf("%-6s %14s %14s %10s\n", "run", "heap conn/s", "pool conn/s", "gain");
+	for (int run = 1; run <= BENCHMARK_ACCEPT_RUNS; run++)
+	{
+		double heapRate = MeasureAccept(server, loop, false, connections, clients);
+		double poolRate = MeasureAccept(server, loop, true, connections, clients);
+		printf("%-6d %14.0f %14.0f %9.1f%%\n", run, heapRate, poolRate, (poolRate / heapRate - 1) * 100);
+	}
+	loop.Remove(&listener);
+	listener.Close();
+#else
+	printf("Accept benchmark: skipped, the event loop is Linux only\n");
+#endif
+}
@@ -0,0 +1,27 @@
+/*!
+\file acceptbenchmark.h "server\desktop\src\benchmarks\acceptbenchmark.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 17 October 2017
+*/
+
+#pragma once
+#include "../defines.h"
+
+#define BENCHMARK_ACCEPT_CONNECTIONS 10000		///< The connections accepted in one measurement
+#define BENCHMARK_ACCEPT_CLIENTS 4				///< The threads connecting to the listener
+#define BENCHMARK_ACCEPT_RUNS 3					///< The measurements of each allocator
+#define BENCHMARK_ACCEPT_PORT 2346				///< The loopback port of the listener (SERVER_PORT may be busy)
+
+/*!
+Compares the accept rate of the server with Pool recycling the memory of the connections and without it
+(every block from the heap, as before the pools). The listener is served the way Server serves it:
+every accepted connection gets its arena with the socket wrappers and its Connection with the pooled buffers,
+the client sends the request, gets the empty frame and closes, the connection is destroyed.
+The connections per second of every run are printed to stdout. Linux only (see EventLoop).
+\param[in] connections The number of the connections in one measurement.
+\param[in] clients The number of the connecting threads.
+*/
+void RunAcceptBenchmark(int connections = BENCHMARK_ACCEPT_CONNECTIONS, int clients = BENCHMARK_ACCEPT_CLIENTS);
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <stdlib.h>
+#include "filebenchmark.h"
+
+using namespace std::chrono;
+
+/// The measured cache configuration
+typedef struct
+{
+	const char *name;			///< The name to be printed
+	FileCachePolicy policy;		///< The sizing rule
+	size_lt bufferSize;			///< The initial size of the caches
+} FileBenchmarkPolicy;
+
+static double MegabytesPerSecond(size_lt bytes, steady_clock::time_point start)
+{
+	double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+	return seconds > 0 ? bytes / seconds / (1024 * 1024) : 0;
+}
+
+void RunFileBenchmark(const char *fileName, size_lt fileSize, size_lt blockSize)
+{
+	FileBenchmarkPolicy policies[] =
+	{
+		{ "fixed 1 KB", CACHEFIXED, FILE_BUFFER_SIZE },
+		{ "fixed max", CACHEFIXED, FILE_BUFFER_MAX_SIZE },
+		{ "adaptive", CACHEADAPTIVE, FILE_BUFFER_SIZE }
+	};
+
+	byte *block = new byte[blockSize];
+	for (size_lt i = 0; i < blockSize; i++)
+	{
+		block[i] = (byte)i;
+	}
+	size_lt blocks = fileSize / blockSize;
+
+	printf("File benchmark: %llu MB, %llu byte blocks\n", (unsigned long long)(fileSize >> 20), (unsigned long long)blockSize);
+	printf("%-12s %14s %14s %14s\n", "policy", "write MB/s", "read MB/s", "random reads/s");
+	for (FileBenchmarkPolicy &policy : policies)
+	{
+		File file(fileName, policy.bufferSize);
+		file.SetCachePolicy(policy.policy);
+
+		file.Open(FileOpenMode::WRITENEWFILE);
+		steady_clock::time_point start = steady_clock::now();
+		for (size_lt i = 0; i < blocks; i++)
+		{
+			file.WriteBlock(block, blockSize);
+		}
+		file.Close();
+		double write = MegabytesPerSecond(blocks * blockSize, start);
+
+		file.Open(FileOpenMode::READONLY);
+		start = steady_clock::now();
+		size_lt readed = 0, part;
+		while ((part = file.ReadBlock(block, blockSize)) > 0)
+		{
+			readed += part;
+		}
+		double read = MegabytesPerSecond(readed, start);
+
+		srand(1);
+		start = steady_clock::now();
+		for (int i = 0; i < BENCHMARK_RANDOM_READS; i++)
+		{
+			size_lt offset = ((size_lt)rand() * RAND_MAX + rand()) % blocks * blockSize;
+			file.Seek(offset, SeekReference::START);
+			file.ReadBlock(block, blockSize);
+		}
+		double seconds = duration_cast<duration<double>>(steady_clock::now() - start).count();
+		file.Close();
+
+		printf("%-12s %14.1f %14.1f %14.0f\n", policy.name, write, read, seconds > 0 ? BENCHMARK_RANDOM_READS / seconds : 0);
+	}
+
+	delete[] block;
+	File::Delete(fileName);
+}
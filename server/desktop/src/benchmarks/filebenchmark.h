@@ -0,0 +1,26 @@
+/*!
+\file filebenchmark.h "server\desktop\src\benchmarks\filebenchmark.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 28 August 2017
+*/
+
+#pragma once
+#include "../common/file.h"
+
+#define BENCHMARK_FILE_SIZE (2048ULL * 1024 * 1024)
+#define BENCHMARK_BLOCK_SIZE 512
+#define BENCHMARK_RANDOM_READS 100000
+
+/*!
+Compares the throughput of the File cache policies on the big file:
+the fixed 1 KB cache (the old behaviour), the fixed FILE_BUFFER_MAX_SIZE cache and the adaptive one.
+Every policy writes the file with small blocks, reads it back sequentially and reads random blocks.
+The results are printed to stdout. Drop the OS cache between the runs for the cold numbers.
+\param[in] fileName The name of the temporary file. It is deleted at the end.
+\param[in] fileSize The size of the file.
+\param[in] blockSize The size of the blocks the file is written and read with.
+*/
+void RunFileBenchmark(const char *fileName, size_lt fileSize = BENCHMARK_FILE_SIZE, size_lt blockSize = BENCHMARK_BLOCK_SIZE);
@@ -0,0 +1,86 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include "lockbenchmark.h"
+#include "../common/locker.h"
+#include "../common/shardedrwlock.h"
+
+using namespace std::chrono;
+using MSIYBCore::ILocker;
+using MSIYBCore::RWLock;
+using MSIYBCore::ShardedRWLock;
+
+/// The read-mostly data
+typedef struct
+{
+	unsigned long long version;		///< Changed by the writers
+	unsigned long long size;		///< Always equal to the version
+} LockBenchmarkRecord;
+
+/*!
+Runs the threads reading and updating the record.
+\return The nanoseconds per operation, 0 if the readers saw the torn record.
+*/
+static double MeasureLock(ILocker &lock, int threads, int operations)
+{
+	LockBenchmarkRecord record = { 0, 0 };
+	std::atomic<bool> torn(false);
+	std::atomic<unsigned long long> checksum(0);	// Keeps the reads
+	int perThread = operations / threads;
+
+	steady_clock::time_point start = steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&lock, &record, &torn, &checksum, perThread, t]()
+		{
+			unsigned long long sum = 0;
+			for (int i = 1; i <= perThread; i++)
+			{
+				if ((i + t * 7) % BENCHMARK_LOCK_WRITE_RATIO == 0)
+				{
+					lock.Lock();
+					record.version++;
+					record.size = record.version;
+					lock.Unlock();
+				}
+				else
+				{
+					lock.LockShared();
+					if (record.version != record.size)
+					{
+						torn = true;
+					}
+					sum += record.size;
+					lock.Unlock();
+				}
+			}
+			checksum.fetch_add(sum, std::memory_order_relaxed);
+		});
+	}
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+	double elapsed = (double)duration_cast<nanoseconds>(steady_clock::now() - start).count();
+	return torn ? 0 : elapsed / ((double)perThread * threads);
+}
+
+void RunLockBenchmark(int maxThreads, int operations)
+{
+	RWLock rwLock;
+	ShardedRWLock shardedLock;
+
+	printf("Lock benchmark: %d operations, 1 write per %d, %d shards, %u processors\n", operations, BENCHMARK_LOCK_WRITE_RATIO,
+		shardedLock.GetShardCount(), std::thread::hardware_concurrency());
+	printf("%-8s %14s %14s %14s %14s\n", "threads", "RWLock ns/op", "Mops/s", "sharded ns/op", "Mops/s");
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		double rw = MeasureLock(rwLock, threads, operations);
+		double sharded = MeasureLock(shardedLock, threads, operations);
+		printf("%-8d %14.1f %14.1f %14.1f %14.1f\n", threads,
+			rw, rw > 0 ? 1000 / rw : 0, sharded, sharded > 0 ? 1000 / sharded : 0);
+	}
+}
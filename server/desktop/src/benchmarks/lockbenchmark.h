@@ -0,0 +1,25 @@
+/*!
+\file lockbenchmark.h "server\desktop\src\benchmarks\lockbenchmark.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 15 October 2017
+*/
+
+#pragma once
+#include "../defines.h"
+
+#define BENCHMARK_LOCK_THREADS 64			///< The most threads measured (the counts are doubled from 1)
+#define BENCHMARK_LOCK_OPERATIONS 2000000	///< The operations of all the threads in one measurement
+#define BENCHMARK_LOCK_WRITE_RATIO 1000		///< One operation of this many is the write
+
+/*!
+Compares the read scalability of the RWLock of the OS and the ShardedRWLock on the read-mostly data.
+The threads read the shared record under the shared lock and update it under the exclusive lock
+once per BENCHMARK_LOCK_WRITE_RATIO operations. The nanoseconds per operation and the total
+millions of operations per second are printed to stdout for 1, 2, 4... maxThreads threads.
+\param[in] maxThreads The most threads to be measured.
+\param[in] operations The number of the operations of all the threads in one measurement.
+*/
+void RunLockBenchmark(int maxThreads = BENCHMARK_LOCK_THREADS, int operations = BENCHMARK_LOCK_OPERATIONS);
@@ -0,0 +1,146 @@
+#include "adaptivelock.h"
+#include <chrono>
+#include "locker.h"
+
+using MSIYBCore::AdaptiveLock;
+using MSIYBCore::LockStatistics;
+using MSIYBCore::DefaultLock;
+using MSIYBCore::Locker;
+
+static AdaptiveLock *registered = NULL;		///< The last registered lock
+
+/*!
+\return The lock of the registry. Created by the first lock, so it outlives the static locks.
+*/
+static DefaultLock& RegistryLock()
+{
+	static DefaultLock lock;
+	return lock;
+}
+
+/*!
+Adds to the counter written by the owner of the lock only.
+*/
+static inline void Add(std::atomic<unsigned long long> &counter, unsigned long long value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+AdaptiveLock::AdaptiveLock(const char *name) : _acquisitions(0), _contended(0), _spins(0), _sleeps(0), _waitTime(0), _maxWaitTime(0)
+{
+	_name = name;
+	Locker locker(RegistryLock());
+	_previous = registered;
+	_next = NULL;
+	if (registered)
+	{
+		registered->_next = this;
+	}
+	registered = this;
+}
+
+AdaptiveLock::~AdaptiveLock()
+{
+	Locker locker(RegistryLock());
+	if (_previous)
+	{
+		_previous->_next = _next;
+	}
+	if (_next)
+	{
+		_next->_previous = _previous;
+	}
+	else
+	{
+		registered = _previous;
+	}
+}
+
+bool AdaptiveLock::Lock()
+{
+	if (!_lock.TryLock())
+	{
+		LockContended();
+	}
+	Add(_acquisitions, 1);
+	return true;
+}
+
+bool AdaptiveLock::LockShared()
+{
+	return false;
+}
+
+bool AdaptiveLock::TryLock()
+{
+	if (!_lock.TryLock())
+	{
+		return false;
+	}
+	Add(_acquisitions, 1);
+	return true;
+}
+
+bool AdaptiveLock::TryLockShared()
+{
+	return false;
+}
+
+bool AdaptiveLock::Unlock()
+{
+	return _lock.Unlock();
+}
+
+LockStatistics AdaptiveLock::GetStatistics()
+{
+	LockStatistics statistics;
+	statistics.name = _name;
+	statistics.acquisitions = _acquisitions.load(std::memory_order_relaxed);
+	statistics.contended = _contended.load(std::memory_order_relaxed);
+	statistics.spins = _spins.load(std::memory_order_relaxed);
+	statistics.sleeps = _sleeps.load(std::memory_order_relaxed);
+	statistics.waitTime = _waitTime.load(std::memory_order_relaxed);
+	statistics.maxWaitTime = _maxWaitTime.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+void AdaptiveLock::ResetStatistics()
+{
+	Locker locker(*this);
+	_acquisitions.store(0, std::memory_order_relaxed);
+	_contended.store(0, std::memory_order_relaxed);
+	_spins.store(0, std::memory_order_relaxed);
+	_sleeps.store(0, std::memory_order_relaxed);
+	_waitTime.store(0, std::memory_order_relaxed);
+	_maxWaitTime.store(0, std::memory_order_relaxed);
+}
+
+std::vector<LockStatistics> AdaptiveLock::GetAll()
+{
+	std::vector<LockStatistics> all;
+	Locker locker(RegistryLock());
+	for (AdaptiveLock *lock = registered; lock; lock = lock->_previous)
+	{
+		all.push_back(lock->GetStatistics());
+	}
+	return all;
+}
+
+void AdaptiveLock::LockContended()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned long long spun = 0;
+	unsigned long long slept = 0;
+	_lock.LockContended(INFINITE, &spun, &slept);
+
+	// Owned now: the statistics are written under the lock
+	unsigned long long wait = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	Add(_contended, 1);
+	Add(_spins, spun);
+	Add(_sleeps, slept);
+	Add(_waitTime, wait);
+	if (wait > _maxWaitTime.load(std::memory_order_relaxed))
+	{
+		_maxWaitTime.store(wait, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,119 @@
+/*!
+\file adaptivelock.h "server\desktop\src\common\adaptivelock.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 14 October 2017
+*/
+
+#pragma once
+#include <atomic>
+#include <vector>
+#include "futex.h"
+#include "../cross/ilocker.h"
+
+namespace MSIYBCore
+{
+	/// The contention of the lock since its creation or the last reset
+	typedef struct LockStatistics_
+	{
+		const char *name;					///< The name of the lock
+		unsigned long long acquisitions;	///< The number of the locks
+		unsigned long long contended;		///< The number of the locks which found the lock taken
+		unsigned long long spins;			///< The spin iterations of the contended locks
+		unsigned long long sleeps;			///< The number of the times the threads slept on the futex
+		unsigned long long waitTime;		///< The total time the contended locks waited (ns)
+		unsigned long long maxWaitTime;		///< The longest wait (ns)
+	} LockStatistics;
+
+	/*!
+	\class AdaptiveLock adaptivelock.h "server\desktop\src\common\adaptivelock.h"
+	\brief  The exclusive lock which spins and then sleeps on the futex (FutexLock), and counts its contention.
+	The statistics are written by the owner under the lock and read without it, so they cost
+	one counter on the free lock and the clock only on the contended one.
+	Every lock is registered: GetAll shows which of them the threads wait for. Not recursive.
+	*/
+	class AdaptiveLock : public ILocker
+	{
+	public:
+		/*!
+		\param[in] name The name of the lock in the statistics (the string must outlive the lock).
+		*/
+		AdaptiveLock(const char *name = "");
+
+		AdaptiveLock(const AdaptiveLock& other) = delete;
+		AdaptiveLock& operator=(const AdaptiveLock& other) = delete;
+
+		/*!
+		Unregisters the lock. The lock must be unlocked.
+		*/
+		~AdaptiveLock();
+
+		/*!
+		Locks the lock.
+		If another thread has already locked the lock,
+		a call to lock spins and then sleeps until the lock is acquired.
+		\return always TRUE.
+		*/
+		bool Lock() override;
+
+		/*!
+		Unavailable for the exclusive lock.
+		\return FALSE
+		*/
+		bool LockShared() override;
+
+		/*!
+		Try to lock the lock.
+		If another thread has already locked the lock,
+		function returns false immediatly (not counted as contended).
+		\return TRUE if the lock is taken and FALSE if it is already locked.
+		*/
+		bool TryLock() override;
+
+		/*!
+		Unavailable for the exclusive lock.
+		\return FALSE
+		*/
+		bool TryLockShared() override;
+
+		/*!
+		Unlocks the lock and wakes up one sleeping thread if there is any.
+		\return TRUE if succeed and FALSE if the lock isn't locked.
+		*/
+		bool Unlock() override;
+
+		/*!
+		\return The statistics of the lock. Taken without the lock: the counters may be a lock apart.
+		*/
+		LockStatistics GetStatistics();
+
+		/*!
+		Zeroes the statistics. Takes the lock.
+		*/
+		void ResetStatistics();
+
+		/*!
+		\return The statistics of all the existing locks. Static.
+		*/
+		static std::vector<LockStatistics> GetAll();
+
+	private:
+		/*!
+		Spins and then sleeps until the lock is taken, counts the wait.
+		*/
+		void LockContended();
+
+		FutexLock _lock;									///< The lock word
+		const char *_name;									///< The name of the lock
+		std::atomic<unsigned long long> _acquisitions;		///< The number of the locks
+		std::atomic<unsigned long long> _contended;			///< The number of the contended locks
+		std::atomic<unsigned long long> _spins;				///< The spin iterations
+		std::atomic<unsigned long long> _sleeps;			///< The sleeps on the futex
+		std::atomic<unsigned long long> _waitTime;			///< The total wait (ns)
+		std::atomic<unsigned long long> _maxWaitTime;		///< The longest wait (ns)
+		AdaptiveLock *_previous;							///< The lock registered before
+		AdaptiveLock *_next;								///< The lock registered after
+	};
+}
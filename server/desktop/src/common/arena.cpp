@@ -0,0 +1,143 @@
+#include "arena.h"
+
+using namespace MSIYBCore;
+
+static inline size_lt Align(size_lt size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_lt)(ARENA_ALIGNMENT - 1);
+}
+
+Arena::Arena(size_lt blockSize)
+{
+	// The header is taken from the block: the whole block is the class of Pool
+	blockSize = Align(blockSize);
+	_blockSize = blockSize > 2 * Align(sizeof(ArenaBlock)) ? blockSize - Align(sizeof(ArenaBlock)) : Align(sizeof(ArenaBlock));
+	_first = NULL;
+	_current = NULL;
+	_pos = 0;
+	_finalizers = NULL;
+	_large = NULL;
+}
+
+Arena::~Arena()
+{
+	Reset();
+	while (_first)
+	{
+		ArenaBlock *next = _first->next;
+		FreeBlock(_first);
+		_first = next;
+	}
+}
+
+void* Arena::Allocate(size_lt size)
+{
+	size = Align(size == 0 ? 1 : size);
+	if (_current && size <= _current->size - _pos)
+	{
+		void *memory = Data(_current) + _pos;
+		_pos += size;
+		return memory;
+	}
+
+	if (size > _blockSize / 2)
+	{
+		// Would waste the most of the block: the allocation gets its own block
+		ArenaBlock *block = NewBlock(size);
+		block->next = _large;
+		_large = block;
+		return Data(block);
+	}
+
+	if (!_current)
+	{
+		if (!_first)
+		{
+			_first = NewBlock(_blockSize);
+		}
+		_current = _first;
+	}
+	else
+	{
+		if (!_current->next)
+		{
+			_current->next = NewBlock(_blockSize);
+		}
+		_current = _current->next;
+	}
+	_pos = size;
+	return Data(_current);
+}
+
+char* Arena::Duplicate(const char *string, size_lt size)
+{
+	char *copy = (char*)Allocate(size + 1);
+	memcpy(copy, string, size);
+	copy[size] = '\0';
+	return copy;
+}
+
+ArenaMark Arena::Mark()
+{
+	ArenaMark mark;
+	mark.block = _current;
+	mark.pos = _pos;
+	mark.finalizers = _finalizers;
+	mark.large = _large;
+	return mark;
+}
+
+void Arena::Rewind(const ArenaMark &mark)
+{
+	while (_finalizers != mark.finalizers)
+	{
+		ArenaFinalizer *finalizer = _finalizers;
+		_finalizers = finalizer->previous;
+		finalizer->destroy(finalizer->object);
+	}
+	while (_large != mark.large)
+	{
+		ArenaBlock *block = _large;
+		_large = block->next;
+		FreeBlock(block);
+	}
+	_current = mark.block;
+	_pos = mark.pos;
+}
+
+void Arena::Reset()
+{
+	ArenaMark empty = { NULL, 0, NULL, NULL };
+	Rewind(empty);
+}
+
+size_lt Arena::GetUsed()
+{
+	size_lt used = 0;
+	if (_current)
+	{
+		used = _pos;
+		for (ArenaBlock *block = _first; block != _current; block = block->next)
+		{
+			used += block->size;
+		}
+	}
+	for (ArenaBlock *block = _large; block; block = block->next)
+	{
+		used += block->size;
+	}
+	return used;
+}
+
+ArenaBlock* Arena::NewBlock(size_lt size)
+{
+	ArenaBlock *block = (ArenaBlock*)Pool::Allocate(Align(sizeof(ArenaBlock)) + size);
+	block->next = NULL;
+	block->size = size;
+	return block;
+}
+
+void Arena::FreeBlock(ArenaBlock *block)
+{
+	Pool::Free((byte*)block, Align(sizeof(ArenaBlock)) + block->size);
+}
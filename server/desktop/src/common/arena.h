@@ -0,0 +1,172 @@
+/*!
+\file arena.h "server\desktop\src\common\arena.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 06 October 2017
+*/
+
+#pragma once
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "../defines.h"
+#include "../tools/exception.h"
+#include "pool.h"
+
+#define ARENA_BLOCK_SIZE (16 * 1024)	///< The default size of the arena blocks with their headers (the class of Pool)
+#define ARENA_ALIGNMENT 16				///< The alignment of the allocations (enough for any type)
+
+namespace MSIYBCore
+{
+	/// The block of the arena memory, the data follows the header
+	typedef struct ArenaBlock_
+	{
+		ArenaBlock_ *next;		///< The next block (the chain is kept for the reuse)
+		size_lt size;			///< The size of the data
+	} ArenaBlock;
+
+	/// The destructor of the object created in the arena
+	typedef struct ArenaFinalizer_
+	{
+		void(*destroy)(void *object);	///< Calls the destructor of the object
+		void *object;					///< The object
+		ArenaFinalizer_ *previous;		///< The finalizer registered before
+	} ArenaFinalizer;
+
+	/// The state of the arena to be rewound to
+	typedef struct ArenaMark_
+	{
+		ArenaBlock *block;				///< The current block
+		size_lt pos;					///< The offset in the current block
+		ArenaFinalizer *finalizers;		///< The last registered finalizer
+		ArenaBlock *large;				///< The last separate block of the large allocation
+	} ArenaMark;
+
+	/*!
+	\class Arena arena.h "server\desktop\src\common\arena.h"
+	\brief  The bump allocator of the memory with the common lifetime (ex. the connection or the request).
+	The allocation moves the pointer in the current block, nothing is freed separately:
+	Rewind and Reset release everything allocated after the mark at once and call the destructors
+	of the objects created by New in the reverse order. The blocks are kept for the reuse,
+	only the allocations bigger than a half of the block get their own blocks, freed on the rewind.
+	The arena and its blocks are taken from Pool, so the arena of the short-lived owner
+	(ex. the accepted connection) is recycled after the warm-up instead of going to the heap.
+	Not thread-safe: the arena belongs to one owner.
+	*/
+	class Arena : public Pooled
+	{
+	public:
+		/*!
+		\param[in] blockSize The size of the blocks with their headers, the power of two fits the class of Pool.
+		The first one is allocated on the first use.
+		*/
+		Arena(size_lt blockSize = ARENA_BLOCK_SIZE);
+
+		/*!
+		Calls the destructors and frees all the blocks.
+		*/
+		~Arena();
+
+		/*!
+		Allocates the memory.
+		\param[in] size The size of the memory.
+		\return The memory aligned to ARENA_ALIGNMENT, valid until the rewind past it.
+		*/
+		void* Allocate(size_lt size);
+
+		/*!
+		Creates the object in the arena. Its destructor is called on the rewind past it.
+		\param[in] args The arguments of the constructor.
+		\return The object. Must not be deleted.
+		*/
+		template <typename T, typename... Args> T* New(Args&&... args)
+		{
+			if (std::is_trivially_destructible<T>::value)
+			{
+				return ::new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+			}
+			// The finalizer is registered after the construction: the failed one isn't destroyed
+			ArenaFinalizer *finalizer = (ArenaFinalizer*)Allocate(sizeof(ArenaFinalizer));
+			T *object = ::new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+			finalizer->destroy = &Destroy<T>;
+			finalizer->object = object;
+			finalizer->previous = _finalizers;
+			_finalizers = finalizer;
+			return object;
+		}
+
+		/*!
+		Allocates the array of the bytes.
+		\param[in] size The size of the array.
+		\return The array.
+		*/
+		inline byte* AllocateBytes(size_lt size)
+		{
+			return (byte*)Allocate(size);
+		}
+
+		/*!
+		Copies the string into the arena.
+		\param[in] string The string.
+		\param[in] size The length of the string without the terminating zero.
+		\return The zero-terminated copy.
+		*/
+		char* Duplicate(const char *string, size_lt size);
+
+		/*!
+		\return The current state to be passed to Rewind.
+		*/
+		ArenaMark Mark();
+
+		/*!
+		Releases everything allocated after the mark, the destructors are called first.
+		\param[in] mark The state returned by Mark.
+		*/
+		void Rewind(const ArenaMark &mark);
+
+		/*!
+		Releases everything allocated in the arena. The blocks are kept for the reuse.
+		*/
+		void Reset();
+
+		/*!
+		\return The number of the bytes taken from the blocks since the last reset.
+		*/
+		size_lt GetUsed();
+
+	private:
+		template <typename T> static void Destroy(void *object)
+		{
+			((T*)object)->~T();
+		}
+
+		/*!
+		Allocates the new block.
+		\param[in] size The size of the data.
+		*/
+		static ArenaBlock* NewBlock(size_lt size);
+
+		/*!
+		Returns the block to Pool.
+		\param[in] block The block.
+		*/
+		static void FreeBlock(ArenaBlock *block);
+
+		/*!
+		\return The data of the block.
+		*/
+		static inline byte* Data(ArenaBlock *block)
+		{
+			return (byte*)block + ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_lt)(ARENA_ALIGNMENT - 1));
+		}
+
+		size_lt _blockSize;				///< The size of the data of the blocks
+		ArenaBlock *_first;				///< The first block of the chain
+		ArenaBlock *_current;			///< The block being filled
+		size_lt _pos;					///< The offset of the free memory in the current block
+		ArenaFinalizer *_finalizers;	///< The last registered finalizer
+		ArenaBlock *_large;				///< The separate blocks of the large allocations (the last one first)
+	};
+}
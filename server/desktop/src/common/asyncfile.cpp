@@ -0,0 +1,151 @@
+#include "asyncfile.h"
+#include <memory>
+
+AsyncFile::AsyncFile(IEventLoop &loop) : _loop(loop)
+{
+	_engine = NULL;
+	_jobEngine = NULL;
+	_native = false;
+#ifdef __linux__
+	try
+	{
+		_engine = new UnixAsyncFile();
+		_native = true;
+	}
+	catch (FileException &)
+	{
+		// No io_uring (old kernel, seccomp, container): the thread pool does the same job
+		_engine = NULL;
+	}
+	if (!_engine)
+	{
+		_engine = new UnixPooledAsyncFile();
+		_jobEngine = _engine;
+	}
+#else
+	// The completions are handled by the event loop, which is Linux only (see EventLoop)
+	ThrowFileException("Asynchronous file I/O is implemented for Linux only");
+#endif
+	_loop.AddDescriptor(_engine->GetDescriptor(), this, EVENTREAD);
+}
+
+AsyncFile::~AsyncFile()
+{
+	if (_jobEngine && _jobEngine != _engine)
+	{
+		_loop.RemoveDescriptor(_jobEngine->GetDescriptor());
+		delete _jobEngine;
+	}
+	_loop.RemoveDescriptor(_engine->GetDescriptor());
+	delete _engine;
+}
+
+void AsyncFile::Read(AsyncFileRequest *request)
+{
+	request->operation = ASYNCFILEREAD;
+	_engine->Submit(request);
+}
+
+void AsyncFile::Write(AsyncFileRequest *request)
+{
+	request->operation = ASYNCFILEWRITE;
+	_engine->Submit(request);
+}
+
+void AsyncFile::Execute(std::function<bool()> job, std::function<void(bool success)> done)
+{
+	Job *started = new Job();
+	started->job = std::move(job);
+	started->done = std::move(done);
+	started->request.operation = ASYNCFILEJOB;
+	started->request.handler = this;
+	started->request.result = 0;
+	started->request.job = &AsyncFile::RunJob;
+	started->request.context = started;
+	try
+	{
+		GetJobEngine()->Submit(&started->request);
+	}
+	catch (...)
+	{
+		delete started;
+		throw;
+	}
+}
+
+void AsyncFile::Submit(AsyncFileRequest *request)
+{
+	if (request->operation == ASYNCFILEJOB)
+	{
+		GetJobEngine()->Submit(request);
+		return;
+	}
+	_engine->Submit(request);
+}
+
+int AsyncFile::Complete()
+{
+	int count = _engine->Complete();
+	if (_jobEngine && _jobEngine != _engine)
+	{
+		count += _jobEngine->Complete();
+	}
+	return count;
+}
+
+t_descriptor AsyncFile::GetDescriptor()
+{
+	return _engine->GetDescriptor();
+}
+
+void AsyncFile::HandleEvents(int /*events*/)
+{
+	// Both engines signal this handler, the idle one has nothing to complete
+	Complete();
+}
+
+void AsyncFile::OnFileComplete(AsyncFileRequest *request)
+{
+	// Deleted even if the completion throws
+	std::unique_ptr<Job> job((Job*)request->context);
+	job->done(request->result >= 0);
+}
+
+long long AsyncFile::RunJob(AsyncFileRequest *request)
+{
+	try
+	{
+		return ((Job*)request->context)->job() ? 0 : -1;
+	}
+	catch (...)
+	{
+		// The failure is the result, the pool doesn't keep it
+		return -1;
+	}
+}
+
+IAsyncFile* AsyncFile::GetJobEngine()
+{
+	if (!_jobEngine)
+	{
+#ifdef __linux__
+		IAsyncFile *engine = new UnixPooledAsyncFile();
+		try
+		{
+			_loop.AddDescriptor(engine->GetDescriptor(), this, EVENTREAD);
+		}
+		catch (...)
+		{
+			delete engine;
+			throw;
+		}
+		_jobEngine = engine;
+#endif
+	}
+	return _jobEngine;
+}
+
+bool AsyncFile::IsNative()
+{
+	return _native;
+}
@@ -0,0 +1,111 @@
+/*!
+\file asyncfile.h "server\desktop\src\common\asyncfile.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 01 September 2017
+*/
+
+#pragma once
+#include "../cross/iasyncfile.h"
+#include "../cross/ieventloop.h"
+#include "../tools/exceptions/fileexception.h"
+#include <functional>
+#ifdef __unix__
+#include "../cross/unix/unixasyncfile.h"
+#endif
+
+/*!
+\class AsyncFile asyncfile.h "server\desktop\src\common\asyncfile.h"
+\brief  The asynchronous file engine bound to the event loop.
+Picks io_uring when the kernel has it and the thread pool otherwise.
+The completions are handled by the loop thread, the same one which serves the sockets.
+The blocking calls which have no asynchronous form (hashing, fsync, rename) are run by Execute.
+Linux only, like the event loop: on the other systems the constructor throws FileException.
+*/
+class AsyncFile : public IAsyncFile, public IEventHandler, public IAsyncFileHandler
+{
+public:
+	/*!
+	Creates the OS engine and registers its notification in the loop.
+	\param[in] loop The loop to handle the completions.
+	*/
+	AsyncFile(IEventLoop &loop);
+
+	/*!
+	Removes the notification from the loop and deletes the engine.
+	*/
+	~AsyncFile();
+
+	/*!
+	Queues the read of the block. Must be called on the loop thread.
+	\param[in] request The request, the operation is set to ASYNCFILEREAD.
+	*/
+	void Read(AsyncFileRequest *request);
+
+	/*!
+	Queues the write of the block. Must be called on the loop thread.
+	\param[in] request The request, the operation is set to ASYNCFILEWRITE.
+	*/
+	void Write(AsyncFileRequest *request);
+
+	/*!
+	Runs the blocking job on the I/O threads and its completion on the loop thread.
+	Must be called on the loop thread. The job must not touch what the loop thread uses until it is completed.
+	\param[in] job The blocking call. Returns FALSE (or throws) if it failed.
+	\param[in] done Called on the loop thread with the result of the job.
+	*/
+	void Execute(std::function<bool()> job, std::function<void(bool success)> done);
+
+	/*!
+	Starts the request. ASYNCFILEJOB goes to the thread pool engine even if the engine is io_uring.
+	\param[in] request The request. Must stay valid until its handler is called.
+	*/
+	virtual void Submit(AsyncFileRequest *request) override;
+	virtual int Complete() override;
+	virtual t_descriptor GetDescriptor() override;
+
+	/*!
+	Handles the completions signalled to the loop.
+	\param[in] events The combination of EventType flags.
+	*/
+	void HandleEvents(int events) override;
+
+	/*!
+	Calls the completion of the job started by Execute and deletes the job.
+	\param[in] request The request of the job.
+	*/
+	void OnFileComplete(AsyncFileRequest *request) override;
+
+	/*!
+	\return TRUE if the engine is io_uring, FALSE if it is the thread pool.
+	*/
+	bool IsNative();
+
+private:
+	/// The job started by Execute
+	typedef struct Job_
+	{
+		AsyncFileRequest request;				///< The request run by the I/O threads, context points to the job
+		std::function<bool()> job;				///< The blocking call
+		std::function<void(bool success)> done;	///< The completion
+	} Job;
+
+	/*!
+	Runs the job on the I/O thread. Static.
+	\param[in] request The request of the job.
+	\return 0 if the job succeeded, -1 if it failed or threw.
+	*/
+	static long long RunJob(AsyncFileRequest *request);
+
+	/*!
+	\return The engine which runs the jobs, created on the first use if the engine is io_uring.
+	*/
+	IAsyncFile* GetJobEngine();
+
+	IAsyncFile *_engine;		///< The OS engine
+	IAsyncFile *_jobEngine;		///< The thread pool engine for the jobs (the OS engine if it is the pool)
+	IEventLoop &_loop;			///< The loop the notification is registered in
+	bool _native;				///< The engine is io_uring
+};
@@ -0,0 +1,391 @@
+/*!
+\file boundedqueue.h "server\desktop\src\common\boundedqueue.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 12 October 2017
+*/
+
+#pragma once
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../defines.h"
+#include "cpu.h"
+#include "futex.h"
+
+#define QUEUE_SPIN_COUNT 128		///< The number of the attempts before the blocking call parks the thread
+#define QUEUE_CACHE_LINE 64			///< The padding between the indices written by the different threads
+
+namespace MSIYBCore
+{
+	/*!
+	\class BoundedQueue boundedqueue.h "server\desktop\src\common\boundedqueue.h"
+	\brief  The blocking part of the lock-free queues: spins, then parks the thread on EventCount.
+	The waiting costs nothing to the other side while nobody is parked.
+	*/
+	class BoundedQueue
+	{
+	public:
+		BoundedQueue() : _closed(false) {}
+
+		/*!
+		Closes the queue: the blocked and the following Push calls fail,
+		Pop fails after the queue is empty.
+		*/
+		void Close()
+		{
+			_closed.store(true);
+			_notEmpty.NotifyAll();
+			_notFull.NotifyAll();
+		}
+
+		/*!
+		\return TRUE if the queue was closed.
+		*/
+		bool IsClosed()
+		{
+			return _closed.load();
+		}
+
+	protected:
+		/*!
+		Repeats the attempt until it succeeds or the queue is closed.
+		\param[in] event The event signalled when the attempt may succeed.
+		\param[in] attempt The non-blocking operation.
+		\return TRUE if the attempt succeeded, FALSE if the queue was closed.
+		*/
+		template <typename Attempt> bool Block(EventCount &event, Attempt attempt)
+		{
+			int spins = Cpu::GetCount() > 1 ? QUEUE_SPIN_COUNT : 0;
+			for (int i = 0; i < spins; i++)
+			{
+				if (attempt())
+				{
+					return true;
+				}
+				if (_closed.load(std::memory_order_relaxed))
+				{
+					break;
+				}
+				Cpu::Pause();
+			}
+			for (;;)
+			{
+				int key = event.PrepareWait();
+				if (attempt())
+				{
+					event.CancelWait();
+					return true;
+				}
+				if (_closed.load())
+				{
+					event.CancelWait();
+					return false;
+				}
+				event.Wait(key);
+			}
+		}
+
+		EventCount _notEmpty;			///< Signalled after the push
+		EventCount _notFull;			///< Signalled after the pop
+		std::atomic<bool> _closed;		///< TRUE after Close
+	};
+
+	/*!
+	\class MpmcQueue boundedqueue.h "server\desktop\src\common\boundedqueue.h"
+	\brief  The bounded lock-free queue of the multiple producers and consumers (the ring of D. Vyukov).
+	Every cell has the sequence number telling whose turn it is, so the producer and the consumer
+	take their positions with one CAS and never wait for each other unless the queue is full or empty.
+	*/
+	template <typename T> class MpmcQueue : public BoundedQueue
+	{
+	public:
+		/*!
+		\param[in] capacity The maximum number of the items, rounded up to the power of two.
+		*/
+		MpmcQueue(size_lt capacity)
+		{
+			size_lt size = 2;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			_mask = size - 1;
+			_cells = new Cell[size];
+			for (size_lt i = 0; i < size; i++)
+			{
+				_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			_enqueue.store(0, std::memory_order_relaxed);
+			_dequeue.store(0, std::memory_order_relaxed);
+		}
+
+		/*!
+		Destroys the items left. No thread may use the queue.
+		*/
+		~MpmcQueue()
+		{
+			T item;
+			while (TryPop(item))
+			{
+			}
+			delete[] _cells;
+		}
+
+		/*!
+		Adds the item if there is room.
+		\param[in] item The item, moved into the queue only on success.
+		\return TRUE if the item was added, FALSE if the queue is full.
+		*/
+		template <typename U> bool TryPush(U &&item)
+		{
+			Cell *cell;
+			size_lt pos = _enqueue.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				cell = &_cells[pos & _mask];
+				size_lt sequence = cell->sequence.load(std::memory_order_acquire);
+				long long diff = (long long)sequence - (long long)pos;
+				if (diff == 0)
+				{
+					if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = _enqueue.load(std::memory_order_relaxed);
+				}
+			}
+			::new (&cell->storage) T(std::forward<U>(item));
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			_notEmpty.NotifyOne();
+			return true;
+		}
+
+		/*!
+		Takes the oldest item if there is any.
+		\param[out] item The item.
+		\return TRUE if the item was taken, FALSE if the queue is empty.
+		*/
+		bool TryPop(T &item)
+		{
+			Cell *cell;
+			size_lt pos = _dequeue.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				cell = &_cells[pos & _mask];
+				size_lt sequence = cell->sequence.load(std::memory_order_acquire);
+				long long diff = (long long)sequence - (long long)(pos + 1);
+				if (diff == 0)
+				{
+					if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = _dequeue.load(std::memory_order_relaxed);
+				}
+			}
+			T *stored = (T*)&cell->storage;
+			item = std::move(*stored);
+			stored->~T();
+			cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+			_notFull.NotifyOne();
+			return true;
+		}
+
+		/*!
+		Adds the item, waits while the queue is full.
+		\param[in] item The item.
+		\return TRUE if the item was added, FALSE if the queue was closed.
+		*/
+		template <typename U> bool Push(U &&item)
+		{
+			if (IsClosed())
+			{
+				return false;
+			}
+			return Block(_notFull, [&]() { return TryPush(std::forward<U>(item)); });
+		}
+
+		/*!
+		Takes the oldest item, waits while the queue is empty.
+		\param[out] item The item.
+		\return TRUE if the item was taken, FALSE if the queue was closed and is empty.
+		*/
+		bool Pop(T &item)
+		{
+			return Block(_notEmpty, [&]() { return TryPop(item); });
+		}
+
+		/*!
+		\return The maximum number of the items.
+		*/
+		size_lt GetCapacity()
+		{
+			return _mask + 1;
+		}
+
+	private:
+		/// The slot of the ring
+		typedef struct
+		{
+			std::atomic<size_lt> sequence;		///< The position expected by the next producer (pos) or consumer (pos + 1)
+			typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;	///< The item
+		} Cell;
+
+		Cell *_cells;									///< The ring
+		size_lt _mask;									///< The capacity minus one
+		char _padding0[QUEUE_CACHE_LINE];
+		std::atomic<size_lt> _enqueue;					///< The position of the next push
+		char _padding1[QUEUE_CACHE_LINE];
+		std::atomic<size_lt> _dequeue;					///< The position of the next pop
+		char _padding2[QUEUE_CACHE_LINE];
+	};
+
+	/*!
+	\class SpscQueue boundedqueue.h "server\desktop\src\common\boundedqueue.h"
+	\brief  The bounded lock-free queue of one producer and one consumer.
+	No atomic read-modify-write at all: each side writes only its own index
+	and keeps the cached copy of the other one, which is reloaded only when the ring looks full or empty.
+	*/
+	template <typename T> class SpscQueue : public BoundedQueue
+	{
+	public:
+		/*!
+		\param[in] capacity The maximum number of the items, rounded up to the power of two.
+		*/
+		SpscQueue(size_lt capacity)
+		{
+			size_lt size = 2;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			_mask = size - 1;
+			_items = new Storage[size];
+			_head.store(0, std::memory_order_relaxed);
+			_tail.store(0, std::memory_order_relaxed);
+			_headCache = 0;
+			_tailCache = 0;
+		}
+
+		/*!
+		Destroys the items left. No thread may use the queue.
+		*/
+		~SpscQueue()
+		{
+			T item;
+			while (TryPop(item))
+			{
+			}
+			delete[] _items;
+		}
+
+		/*!
+		Adds the item if there is room. Called by the producer only.
+		\param[in] item The item, moved into the queue only on success.
+		\return TRUE if the item was added, FALSE if the queue is full.
+		*/
+		template <typename U> bool TryPush(U &&item)
+		{
+			size_lt tail = _tail.load(std::memory_order_relaxed);
+			if (tail - _headCache > _mask)
+			{
+				_headCache = _head.load(std::memory_order_acquire);
+				if (tail - _headCache > _mask)
+				{
+					return false;
+				}
+			}
+			::new (&_items[tail & _mask]) T(std::forward<U>(item));
+			_tail.store(tail + 1, std::memory_order_release);
+			_notEmpty.NotifyOne();
+			return true;
+		}
+
+		/*!
+		Takes the oldest item if there is any. Called by the consumer only.
+		\param[out] item The item.
+		\return TRUE if the item was taken, FALSE if the queue is empty.
+		*/
+		bool TryPop(T &item)
+		{
+			size_lt head = _head.load(std::memory_order_relaxed);
+			if (head == _tailCache)
+			{
+				_tailCache = _tail.load(std::memory_order_acquire);
+				if (head == _tailCache)
+				{
+					return false;
+				}
+			}
+			T *stored = (T*)&_items[head & _mask];
+			item = std::move(*stored);
+			stored->~T();
+			_head.store(head + 1, std::memory_order_release);
+			_notFull.NotifyOne();
+			return true;
+		}
+
+		/*!
+		Adds the item, waits while the queue is full. Called by the producer only.
+		\param[in] item The item.
+		\return TRUE if the item was added, FALSE if the queue was closed.
+		*/
+		template <typename U> bool Push(U &&item)
+		{
+			if (IsClosed())
+			{
+				return false;
+			}
+			return Block(_notFull, [&]() { return TryPush(std::forward<U>(item)); });
+		}
+
+		/*!
+		Takes the oldest item, waits while the queue is empty. Called by the consumer only.
+		\param[out] item The item.
+		\return TRUE if the item was taken, FALSE if the queue was closed and is empty.
+		*/
+		bool Pop(T &item)
+		{
+			return Block(_notEmpty, [&]() { return TryPop(item); });
+		}
+
+		/*!
+		\return The maximum number of the items.
+		*/
+		size_lt GetCapacity()
+		{
+			return _mask + 1;
+		}
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+		Storage *_items;							///< The ring
+		size_lt _mask;								///< The capacity minus one
+		char _padding0[QUEUE_CACHE_LINE];
+		std::atomic<size_lt> _head;					///< The position of the next pop, written by the consumer
+		size_lt _tailCache;							///< The tail last seen by the consumer
+		char _padding1[QUEUE_CACHE_LINE];
+		std::atomic<size_lt> _tail;					///< The position of the next push, written by the producer
+		size_lt _headCache;							///< The head last seen by the producer
+		char _padding2[QUEUE_CACHE_LINE];
+	};
+}
@@ -0,0 +1,206 @@
+#include "buffer.h"
+
+using namespace MSIYBCore;
+
+/// The data follows the header aligned to the cache line
+#define BUFFER_HEADER_SIZE ((sizeof(Buffer) + 63) & ~(size_lt)63)
+
+Buffer::Buffer()
+	: _references(1)
+{
+	_size = 0;
+}
+
+Buffer* Buffer::Create()
+{
+	return ::new (Pool::Allocate(BUFFER_BLOCK_SIZE)) Buffer();
+}
+
+void Buffer::AddRef()
+{
+	_references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Buffer::Release()
+{
+	// The last owner must see all the writes of the others before the block is reused
+	if (_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		this->~Buffer();
+		Pool::Free((byte*)this, BUFFER_BLOCK_SIZE);
+	}
+}
+
+bool Buffer::IsUnique()
+{
+	return _references.load(std::memory_order_acquire) == 1;
+}
+
+byte* Buffer::GetData()
+{
+	return (byte*)this + BUFFER_HEADER_SIZE;
+}
+
+size_lt Buffer::GetSize()
+{
+	return _size;
+}
+
+size_lt Buffer::GetCapacity()
+{
+	return BUFFER_BLOCK_SIZE - BUFFER_HEADER_SIZE;
+}
+
+byte* Buffer::GetTail(size_lt *free)
+{
+	*free = GetCapacity() - _size;
+	return GetData() + _size;
+}
+
+void Buffer::Commit(size_lt size)
+{
+	if (size > GetCapacity() - _size)
+	{
+		ThrowException("Buffer overflow!");
+	}
+	_size += size;
+}
+
+void Buffer::Clear()
+{
+	if (!IsUnique())
+	{
+		ThrowException("Can't clear the shared buffer!");
+	}
+	_size = 0;
+}
+
+BufferSlice::BufferSlice()
+{
+	_buffer = NULL;
+	_offset = 0;
+	_size = 0;
+}
+
+BufferSlice::BufferSlice(Buffer *buffer, size_lt offset, size_lt size)
+{
+	if (offset + size > buffer->GetSize())
+	{
+		ThrowException("Slice is out of the buffer!");
+	}
+	_buffer = buffer;
+	_buffer->AddRef();
+	_offset = offset;
+	_size = size;
+}
+
+BufferSlice::BufferSlice(const BufferSlice &slice)
+{
+	_buffer = slice._buffer;
+	_offset = slice._offset;
+	_size = slice._size;
+	if (_buffer)
+	{
+		_buffer->AddRef();
+	}
+}
+
+BufferSlice::BufferSlice(BufferSlice &&slice)
+{
+	_buffer = slice._buffer;
+	_offset = slice._offset;
+	_size = slice._size;
+	slice._buffer = NULL;
+	slice._offset = 0;
+	slice._size = 0;
+}
+
+BufferSlice& BufferSlice::operator=(const BufferSlice &slice)
+{
+	if (slice._buffer)
+	{
+		slice._buffer->AddRef();
+	}
+	Clear();
+	_buffer = slice._buffer;
+	_offset = slice._offset;
+	_size = slice._size;
+	return *this;
+}
+
+BufferSlice& BufferSlice::operator=(BufferSlice &&slice)
+{
+	if (this != &slice)
+	{
+		Clear();
+		_buffer = slice._buffer;
+		_offset = slice._offset;
+		_size = slice._size;
+		slice._buffer = NULL;
+		slice._offset = 0;
+		slice._size = 0;
+	}
+	return *this;
+}
+
+BufferSlice::~BufferSlice()
+{
+	Clear();
+}
+
+BufferSlice BufferSlice::Slice(size_lt offset, size_lt size) const
+{
+	if (offset + size > _size)
+	{
+		ThrowException("Slice is out of the slice!");
+	}
+	if (size == 0)
+	{
+		return BufferSlice();
+	}
+	return BufferSlice(_buffer, _offset + offset, size);
+}
+
+bool BufferSlice::Join(const BufferSlice &next)
+{
+	if (!_buffer || next._buffer != _buffer || next._offset != _offset + _size)
+	{
+		return false;
+	}
+	_size += next._size;
+	return true;
+}
+
+void BufferSlice::Clear()
+{
+	if (_buffer)
+	{
+		_buffer->Release();
+	}
+	_buffer = NULL;
+	_offset = 0;
+	_size = 0;
+}
+
+const byte* BufferSlice::GetData() const
+{
+	return _buffer ? _buffer->GetData() + _offset : NULL;
+}
+
+size_lt BufferSlice::GetSize() const
+{
+	return _size;
+}
+
+bool BufferSlice::IsEmpty() const
+{
+	return _size == 0;
+}
+
+IOBuffer BufferSlice::ToIOBuffer() const
+{
+	IOBuffer buffer;
+	buffer.data = (byte*)GetData();
+	buffer.size = _size;
+	return buffer;
+}
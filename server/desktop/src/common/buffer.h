@@ -0,0 +1,164 @@
+/*!
+\file buffer.h "server\desktop\src\common\buffer.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 11 October 2017
+*/
+
+#pragma once
+#include <atomic>
+#include "pool.h"
+#include "../cross/iobuffer.h"
+
+#define BUFFER_BLOCK_SIZE (64 * 1024)	///< The size of the pooled block, the header included
+
+namespace MSIYBCore
+{
+	/*!
+	\class Buffer buffer.h "server\desktop\src\common\buffer.h"
+	\brief  The fixed-size pooled block of the I/O data with the reference counter.
+	The data is appended to the free tail (ex. received from the socket) and then handed out
+	as BufferSlice views, so the same bytes go to the disk, the hash and the other consumers
+	without being copied. The block returns to the pool when the last reference is released
+	(from any thread). The filled part must not be changed while it is shared.
+	*/
+	class Buffer
+	{
+	public:
+		/*!
+		Takes the block from the pool. Static.
+		\return The empty buffer with one reference.
+		*/
+		static Buffer* Create();
+
+		/*!
+		Adds the reference.
+		*/
+		void AddRef();
+
+		/*!
+		Releases the reference, the last one returns the block to the pool.
+		*/
+		void Release();
+
+		/*!
+		\return TRUE if only the caller references the buffer (the filled part may be overwritten).
+		*/
+		bool IsUnique();
+
+		/*!
+		\return The first byte of the data.
+		*/
+		byte* GetData();
+
+		/*!
+		\return The number of the filled bytes.
+		*/
+		size_lt GetSize();
+
+		/*!
+		\return The maximum number of the bytes in the buffer. Static.
+		*/
+		static size_lt GetCapacity();
+
+		/*!
+		\param[out] free The number of the bytes in the free tail.
+		\return The first byte of the free tail.
+		*/
+		byte* GetTail(size_lt *free);
+
+		/*!
+		Appends the bytes written to the free tail to the filled part.
+		\param[in] size The number of the bytes.
+		*/
+		void Commit(size_lt size);
+
+		/*!
+		Empties the buffer. Only the unique buffer can be cleared.
+		*/
+		void Clear();
+
+	private:
+		Buffer();
+
+		std::atomic<int> _references;	///< The number of the owners (the buffer itself and the slices)
+		size_lt _size;					///< The number of the filled bytes
+	};
+
+	/*!
+	\class BufferSlice buffer.h "server\desktop\src\common\buffer.h"
+	\brief  The view of the filled bytes of the buffer. Holds the reference while it is alive,
+	so the slice can outlive the receiver (ex. while the asynchronous write is in flight).
+	*/
+	class BufferSlice
+	{
+	public:
+		/*!
+		The empty slice.
+		*/
+		BufferSlice();
+
+		/*!
+		\param[in] buffer The buffer. The slice adds its own reference.
+		\param[in] offset The offset of the first byte in the buffer.
+		\param[in] size The number of the bytes.
+		*/
+		BufferSlice(Buffer *buffer, size_lt offset, size_lt size);
+
+		BufferSlice(const BufferSlice &slice);
+		BufferSlice(BufferSlice &&slice);
+		BufferSlice& operator=(const BufferSlice &slice);
+		BufferSlice& operator=(BufferSlice &&slice);
+
+		/*!
+		Releases the buffer.
+		*/
+		~BufferSlice();
+
+		/*!
+		\param[in] offset The offset in this slice.
+		\param[in] size The number of the bytes.
+		\return The part of this slice sharing its buffer.
+		*/
+		BufferSlice Slice(size_lt offset, size_lt size) const;
+
+		/*!
+		Appends the next slice if it follows this one in the same buffer.
+		\param[in] next The slice.
+		\return TRUE if the slice was appended, FALSE if it is not adjacent.
+		*/
+		bool Join(const BufferSlice &next);
+
+		/*!
+		Releases the buffer and makes the slice empty.
+		*/
+		void Clear();
+
+		/*!
+		\return The first byte of the slice.
+		*/
+		const byte* GetData() const;
+
+		/*!
+		\return The number of the bytes.
+		*/
+		size_lt GetSize() const;
+
+		/*!
+		\return TRUE if the slice has no bytes.
+		*/
+		bool IsEmpty() const;
+
+		/*!
+		\return The slice as the scatter/gather buffer. Valid while the slice is alive.
+		*/
+		IOBuffer ToIOBuffer() const;
+
+	private:
+		Buffer *_buffer;	///< The referenced buffer, NULL for the empty slice
+		size_lt _offset;	///< The offset of the first byte in the buffer
+		size_lt _size;		///< The number of the bytes
+	};
+}
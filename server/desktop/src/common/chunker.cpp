@@ -0,0 +1,139 @@
+#include "chunker.h"
+
+// The one bits are the high ones: they depend on the last 64 bytes
+#define CHUNK_MASK_SMALL 0xFFFFC00000000000ULL	///< 18 bits, before the average size
+#define CHUNK_MASK_LARGE 0xFFFC000000000000ULL	///< 14 bits, after the average size
+#define CHUNK_BUFFER_SIZE (CHUNK_MAX_SIZE * 2)
+
+/// The random values of the bytes for the gear hash. The same on every run: the boundaries must be stable
+static unsigned long long gear[256];
+
+/*!
+Fills the gear table with splitmix64 before main.
+*/
+static bool InitGear()
+{
+	unsigned long long seed = 0x4D534959424344ULL;
+	for (int i = 0; i < 256; i++)
+	{
+		unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		gear[i] = z ^ (z >> 31);
+	}
+	return true;
+}
+
+static bool gearReady = InitGear();
+
+Chunker::Chunker(File &file)
+{
+	_pos = 0;
+	if (file.IsMapped())
+	{
+		ByteSpan view = file.GetView();
+		_file = NULL;
+		_buffer = NULL;
+		_data = view.data;
+		_size = view.size;
+		_eof = true;
+		return;
+	}
+
+	_file = &file;
+	_buffer = new byte[CHUNK_BUFFER_SIZE];
+	if (!_buffer)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+	_data = _buffer;
+	_size = 0;
+	_eof = false;
+}
+
+Chunker::Chunker(ByteSpan data)
+{
+	_file = NULL;
+	_buffer = NULL;
+	_data = data.data;
+	_size = data.size;
+	_pos = 0;
+	_eof = true;
+}
+
+Chunker::~Chunker()
+{
+	delete[] _buffer;
+}
+
+bool Chunker::Next(ByteSpan *chunk)
+{
+	if (!_eof && _size - _pos < CHUNK_MAX_SIZE)
+	{
+		Fill();
+	}
+	if (_pos == _size)
+	{
+		return false;
+	}
+
+	size_lt cut = FindCut(_data + _pos, _size - _pos);
+	chunk->data = _data + _pos;
+	chunk->size = cut;
+	_pos += cut;
+	return true;
+}
+
+size_lt Chunker::FindCut(const byte *data, size_lt size)
+{
+	if (size <= CHUNK_MIN_SIZE)
+	{
+		return size;
+	}
+
+	size_lt normal = size < CHUNK_AVG_SIZE ? size : CHUNK_AVG_SIZE;
+	size_lt max = size < CHUNK_MAX_SIZE ? size : CHUNK_MAX_SIZE;
+	unsigned long long hash = 0;
+	size_lt i = CHUNK_MIN_SIZE;
+	for (; i < normal; i++)
+	{
+		hash = (hash << 1) + gear[data[i]];
+		if (!(hash & CHUNK_MASK_SMALL))
+		{
+			return i + 1;
+		}
+	}
+	for (; i < max; i++)
+	{
+		hash = (hash << 1) + gear[data[i]];
+		if (!(hash & CHUNK_MASK_LARGE))
+		{
+			return i + 1;
+		}
+	}
+	return max;
+}
+
+void Chunker::Fill()
+{
+	size_lt left = _size - _pos;
+	if (left > 0 && _pos > 0)
+	{
+		memmove(_buffer, _buffer + _pos, left);
+	}
+	_size = left;
+	_pos = 0;
+
+	// Reads until the buffer is full, the short reads must not make the boundaries depend on the timing
+	while (_size < CHUNK_BUFFER_SIZE)
+	{
+		size_lt readed = _file->ReadBlock(_buffer + _size, CHUNK_BUFFER_SIZE - _size);
+		if (readed == 0)
+		{
+			_eof = true;
+			break;
+		}
+		_size += readed;
+	}
+	_data = _buffer;
+}
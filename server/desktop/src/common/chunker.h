@@ -0,0 +1,68 @@
+/*!
+\file chunker.h "server\desktop\src\common\chunker.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 15 September 2017
+*/
+
+#pragma once
+#include "file.h"
+
+/*!
+\class Chunker chunker.h "server\desktop\src\common\chunker.h"
+\brief  The content-defined splitter of the data (FastCDC).
+The chunk ends where the rolling gear hash of the last 64 bytes matches the mask,
+so an insertion moves only the boundaries near it and the other chunks stay the same.
+The masks are stricter before CHUNK_AVG_SIZE and looser after it (normalized chunking),
+so the sizes gather around the average between CHUNK_MIN_SIZE and CHUNK_MAX_SIZE.
+*/
+class Chunker
+{
+public:
+	/*!
+	Splits the opened file. The mapped file (MAPPED mode) is split without copying.
+	\param[in] file The file opened to read. Not owned, must outlive the chunker.
+	*/
+	Chunker(File &file);
+
+	/*!
+	Splits the memory block.
+	\param[in] data The data. Must outlive the chunker.
+	*/
+	Chunker(ByteSpan data);
+
+	/*!
+	Deallocates the buffer.
+	*/
+	~Chunker();
+
+	/*!
+	Returns the next chunk.
+	\param[out] chunk The chunk, valid until the next call.
+	\return FALSE if there are no more chunks.
+	*/
+	bool Next(ByteSpan *chunk);
+
+	/*!
+	Finds the end of the chunk. Static.
+	\param[in] data The data starting with the chunk.
+	\param[in] size The size of the data. Must be at least CHUNK_MAX_SIZE unless the data ends there.
+	\return The size of the chunk.
+	*/
+	static size_lt FindCut(const byte *data, size_lt size);
+
+private:
+	/*!
+	Moves the unsplit data to the beginning of the buffer and reads the file after it.
+	*/
+	void Fill();
+
+	File *_file;			///< The split file, NULL for the memory block
+	byte *_buffer;			///< The buffer of the file
+	const byte *_data;		///< The data being split
+	size_lt _size;			///< The size of the data
+	size_lt _pos;			///< The start of the next chunk
+	bool _eof;				///< Nothing more to read from the file
+};
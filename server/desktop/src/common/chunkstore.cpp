@@ -0,0 +1,299 @@
+#include "chunkstore.h"
+
+ChunkStore::ChunkStore(const char *root)
+{
+	std::string rootDir = root;
+	while (rootDir.size() > 1 && (rootDir.back() == '/' || rootDir.back() == PATH_SEPARATOR))
+	{
+		rootDir.pop_back();
+	}
+	_chunksDir = rootDir + PATH_SEPARATOR + "chunks";
+	_manifestsDir = rootDir + PATH_SEPARATOR + "manifests";
+
+	if (!Dir::Exists(_chunksDir.c_str()))
+	{
+		Dir::MakeDir(rootDir.c_str());
+		Dir::MakeDir(_chunksDir.c_str());
+		// The chunks are spread over 256 directories by the first byte of the hash
+		char fanOut[3];
+		for (int i = 0; i < 256; i++)
+		{
+			sprintf(fanOut, "%02x", i);
+			Dir::MakeDir((_chunksDir + PATH_SEPARATOR + fanOut).c_str());
+		}
+	}
+	Dir::MakeDir(_manifestsDir.c_str());
+}
+
+bool ChunkStore::Has(const ChunkRef &ref)
+{
+	return File::Exist(GetChunkPath(ref).c_str());
+}
+
+bool ChunkStore::Put(const byte *data, size_lt size, ChunkRef *ref)
+{
+	MakeRef(data, size, ref);
+	std::string path = GetChunkPath(*ref);
+	if (File::Exist(path.c_str()))
+	{
+		return false;
+	}
+	WriteAtomic(path, data, size);
+	return true;
+}
+
+bool ChunkStore::PutVerified(const ChunkRef &ref, const byte *data, size_lt size)
+{
+	ChunkRef actual;
+	MakeRef(data, size, &actual);
+	if (size != ref.size || memcmp(actual.hash, ref.hash, CHUNK_HASH_SIZE) != 0)
+	{
+		ThrowFileException("The chunk doesn't match its hash!");
+	}
+
+	std::string path = GetChunkPath(ref);
+	if (File::Exist(path.c_str()))
+	{
+		return false;
+	}
+	WriteAtomic(path, data, size);
+	return true;
+}
+
+void ChunkStore::Get(const ChunkRef &ref, byte *buffer)
+{
+	File chunk;
+	chunk.Open(GetChunkPath(ref).c_str(), READONLY);
+	size_lt readed = 0;
+	while (readed < ref.size)
+	{
+		size_lt part = chunk.ReadBlock(buffer + readed, ref.size - readed);
+		if (part == 0)
+		{
+			ThrowFileException("The chunk is cut!");
+		}
+		readed += part;
+	}
+}
+
+std::string ChunkStore::GetChunkPath(const ChunkRef &ref)
+{
+	char hex[CHUNK_HASH_SIZE * 2 + 1];
+	ToHex(ref.hash, hex);
+	std::string path = _chunksDir;
+	path += PATH_SEPARATOR;
+	path.append(hex, 2);
+	path += PATH_SEPARATOR;
+	path += hex;
+	return path;
+}
+
+size_lt ChunkStore::Store(const char *name, File &file)
+{
+	std::vector<ChunkRef> chunks;
+	size_lt written = 0;
+	Chunker chunker(file);
+	ByteSpan chunk;
+	while (chunker.Next(&chunk))
+	{
+		ChunkRef ref;
+		if (Put(chunk.data, chunk.size, &ref))
+		{
+			written += chunk.size;
+		}
+		chunks.push_back(ref);
+	}
+	PutManifest(name, chunks);
+	return written;
+}
+
+size_lt ChunkStore::Restore(const char *name, File &file)
+{
+	std::vector<ChunkRef> chunks;
+	if (!GetManifest(name, &chunks))
+	{
+		ThrowFileException("There is no such file in the store!");
+	}
+
+	byte *buffer = new byte[CHUNK_MAX_SIZE];
+	if (!buffer)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+
+	size_lt size = 0;
+	try
+	{
+		for (size_lt i = 0; i < chunks.size(); i++)
+		{
+			Get(chunks[i], buffer);
+			file.WriteBlock(buffer, chunks[i].size);
+			size += chunks[i].size;
+		}
+		file.Flush();
+	}
+	catch (...)
+	{
+		delete[] buffer;
+		throw;
+	}
+	delete[] buffer;
+	return size;
+}
+
+void ChunkStore::PutManifest(const char *name, const std::vector<ChunkRef> &chunks)
+{
+	std::vector<byte> out;
+	unsigned long long magic = CHUNK_MANIFEST_MAGIC;
+	unsigned int version = CHUNK_MANIFEST_VERSION;
+	out.insert(out.end(), (byte*)&magic, (byte*)&magic + sizeof(magic));
+	out.insert(out.end(), (byte*)&version, (byte*)&version + sizeof(version));
+
+	std::vector<byte> refs;
+	PackRefs(chunks, &refs);
+	out.insert(out.end(), refs.begin(), refs.end());
+
+	// The nested name ("dir/file") keeps its directories; they may be made by another thread at the same time
+	std::string path = GetManifestPath(name);
+	const char separators[] = { '/', PATH_SEPARATOR, '\0' };
+	for (size_t pos = _manifestsDir.size() + 1; (pos = path.find_first_of(separators, pos)) != std::string::npos; pos++)
+	{
+		Dir::MakeDir(path.substr(0, pos).c_str());
+	}
+	WriteAtomic(path, out.data(), out.size());
+}
+
+bool ChunkStore::GetManifest(const char *name, std::vector<ChunkRef> *chunks)
+{
+	std::string path = GetManifestPath(name);
+	if (!File::Exist(path.c_str()))
+	{
+		return false;
+	}
+
+	File manifest;
+	manifest.Open(path.c_str(), MAPPED);
+	ByteSpan data = manifest.GetView();
+	unsigned long long magic;
+	unsigned int version;
+	size_lt header = sizeof(magic) + sizeof(version);
+	if (data.size < header)
+	{
+		ThrowFileException("The manifest is damaged!");
+	}
+	memcpy(&magic, data.data, sizeof(magic));
+	memcpy(&version, data.data + sizeof(magic), sizeof(version));
+	if (magic != CHUNK_MANIFEST_MAGIC || version != CHUNK_MANIFEST_VERSION ||
+		!UnpackRefs(data.data + header, data.size - header, chunks))
+	{
+		ThrowFileException("The manifest is damaged!");
+	}
+	return true;
+}
+
+void ChunkStore::PackRefs(const std::vector<ChunkRef> &chunks, std::vector<byte> *out)
+{
+	unsigned long long fileSize = 0;
+	for (size_lt i = 0; i < chunks.size(); i++)
+	{
+		fileSize += chunks[i].size;
+	}
+
+	out->resize(CHUNK_MANIFEST_HEADER_SIZE + chunks.size() * CHUNK_REF_SIZE);
+	byte *pos = out->data();
+	memcpy(pos, &fileSize, sizeof(fileSize));
+	pos += CHUNK_MANIFEST_HEADER_SIZE;
+	for (size_lt i = 0; i < chunks.size(); i++)
+	{
+		memcpy(pos, chunks[i].hash, CHUNK_HASH_SIZE);
+		memcpy(pos + CHUNK_HASH_SIZE, &chunks[i].size, sizeof(chunks[i].size));
+		pos += CHUNK_REF_SIZE;
+	}
+}
+
+bool ChunkStore::UnpackRefs(const byte *data, size_lt size, std::vector<ChunkRef> *chunks)
+{
+	if (size < CHUNK_MANIFEST_HEADER_SIZE || (size - CHUNK_MANIFEST_HEADER_SIZE) % CHUNK_REF_SIZE != 0)
+	{
+		return false;
+	}
+
+	unsigned long long fileSize;
+	memcpy(&fileSize, data, sizeof(fileSize));
+	size_lt count = (size - CHUNK_MANIFEST_HEADER_SIZE) / CHUNK_REF_SIZE;
+	chunks->resize(count);
+	unsigned long long total = 0;
+	const byte *pos = data + CHUNK_MANIFEST_HEADER_SIZE;
+	for (size_lt i = 0; i < count; i++)
+	{
+		ChunkRef &ref = (*chunks)[i];
+		memcpy(ref.hash, pos, CHUNK_HASH_SIZE);
+		memcpy(&ref.size, pos + CHUNK_HASH_SIZE, sizeof(ref.size));
+		if (ref.size == 0 || ref.size > CHUNK_MAX_SIZE)
+		{
+			return false;
+		}
+		total += ref.size;
+		pos += CHUNK_REF_SIZE;
+	}
+	return total == fileSize;
+}
+
+void ChunkStore::MakeRef(const byte *data, size_lt size, ChunkRef *ref)
+{
+	Sha256::Hash(data, size, ref->hash);
+	ref->size = (unsigned int)size;
+}
+
+void ChunkStore::ToHex(const byte *hash, char *hex)
+{
+	static const char digits[] = "0123456789abcdef";
+	for (int i = 0; i < CHUNK_HASH_SIZE; i++)
+	{
+		hex[i * 2] = digits[hash[i] >> 4];
+		hex[i * 2 + 1] = digits[hash[i] & 0x0F];
+	}
+	hex[CHUNK_HASH_SIZE * 2] = '\0';
+}
+
+bool ChunkStore::FromHex(const char *hex, byte *hash)
+{
+	for (int i = 0; i < CHUNK_HASH_SIZE * 2; i++)
+	{
+		char c = hex[i];
+		int digit;
+		if (c >= '0' && c <= '9')
+		{
+			digit = c - '0';
+		}
+		else if (c >= 'a' && c <= 'f')
+		{
+			digit = c - 'a' + 10;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (i % 2 == 0)
+		{
+			hash[i / 2] = (byte)(digit << 4);
+		}
+		else
+		{
+			hash[i / 2] |= (byte)digit;
+		}
+	}
+	return true;
+}
+
+std::string ChunkStore::GetManifestPath(const char *name)
+{
+	return _manifestsDir + PATH_SEPARATOR + name;
+}
+
+void ChunkStore::WriteAtomic(const std::string &fileName, const byte *data, size_lt size)
+{
+	// Synced before the rename: the chunk or the manifest is never found cut after a crash
+	File::ReplaceAllBytes(fileName.c_str(), (byte*)data, size);
+}
@@ -0,0 +1,168 @@
+/*!
+\file chunkstore.h "server\desktop\src\common\chunkstore.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 15 September 2017
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include "chunker.h"
+#include "sha256.h"
+#include "dir.h"
+
+#define CHUNK_HASH_SIZE SHA256_SIZE
+#define CHUNK_REF_SIZE (CHUNK_HASH_SIZE + 4)		///< The hash and the 32-bit size
+#define CHUNK_MANIFEST_HEADER_SIZE 8				///< The 64-bit size of the file
+#define CHUNK_MANIFEST_MAGIC 0x4E414D425949534DULL	///< "MSIYBMAN" stamp of the stored manifests
+#define CHUNK_MANIFEST_VERSION 1
+
+/// The reference to the stored chunk
+typedef struct ChunkRef_
+{
+	byte hash[CHUNK_HASH_SIZE];		///< The SHA-256 of the chunk, its key in the store
+	unsigned int size;				///< The size of the chunk
+} ChunkRef;
+
+/*!
+\class ChunkStore chunkstore.h "server\desktop\src\common\chunkstore.h"
+\brief  The content-addressed storage of the files.
+The files are split by Chunker, every distinct chunk is stored once as root/chunks/xx/<hash>,
+the file itself is the manifest root/manifests/<name> listing its chunks.
+A file stored again after a small change adds only the chunks around the change.
+The chunks and the manifests may be stored from several threads at once (ex. the disk threads of the server).
+*/
+class ChunkStore
+{
+public:
+	/*!
+	Creates the directories of the store if there are none.
+	\param[in] root The directory of the store.
+	*/
+	ChunkStore(const char *root);
+
+	/*!
+	\param[in] ref The chunk.
+	\return TRUE if the chunk is stored.
+	*/
+	bool Has(const ChunkRef &ref);
+
+	/*!
+	Hashes and stores the chunk unless it is already stored.
+	\param[in] data The chunk.
+	\param[in] size The size of the chunk.
+	\param[out] ref The reference to the chunk.
+	\return TRUE if the chunk was written, FALSE if it was already stored.
+	*/
+	bool Put(const byte *data, size_lt size, ChunkRef *ref);
+
+	/*!
+	Stores the chunk received from the peer. Throws FileException if the data doesn't match the reference.
+	\param[in] ref The expected reference.
+	\param[in] data The chunk.
+	\param[in] size The size of the chunk.
+	\return TRUE if the chunk was written, FALSE if it was already stored.
+	*/
+	bool PutVerified(const ChunkRef &ref, const byte *data, size_lt size);
+
+	/*!
+	Reads the chunk.
+	\param[in] ref The chunk.
+	\param[out] buffer The chunk data, ref.size bytes.
+	*/
+	void Get(const ChunkRef &ref, byte *buffer);
+
+	/*!
+	\param[in] ref The chunk.
+	\return The name of the file of the chunk.
+	*/
+	std::string GetChunkPath(const ChunkRef &ref);
+
+	/*!
+	Splits the file and stores its new chunks and the manifest.
+	\param[in] name The name of the file in the store.
+	\param[in] file The file opened to read (MAPPED is the fastest).
+	\return The number of the bytes written as the new chunks.
+	*/
+	size_lt Store(const char *name, File &file);
+
+	/*!
+	Writes the stored file. Throws FileException if there is no such file.
+	\param[in] name The name of the file in the store.
+	\param[in] file The file opened to write.
+	\return The size of the file.
+	*/
+	size_lt Restore(const char *name, File &file);
+
+	/*!
+	Stores the list of the chunks of the file. All the chunks must be already stored.
+	\param[in] name The name of the file in the store, may be nested ("dir/file").
+	\param[in] chunks The chunks of the file in order.
+	*/
+	void PutManifest(const char *name, const std::vector<ChunkRef> &chunks);
+
+	/*!
+	Reads the list of the chunks of the file.
+	\param[in] name The name of the file in the store.
+	\param[out] chunks The chunks of the file in order.
+	\return FALSE if there is no such file.
+	*/
+	bool GetManifest(const char *name, std::vector<ChunkRef> *chunks);
+
+	/*!
+	Packs the chunk list as it is sent over the network: the 64-bit file size and CHUNK_REF_SIZE bytes per chunk. Static.
+	\param[in] chunks The chunks.
+	\param[out] out The packed list.
+	*/
+	static void PackRefs(const std::vector<ChunkRef> &chunks, std::vector<byte> *out);
+
+	/*!
+	Unpacks the list packed by PackRefs. Static.
+	\param[in] data The packed list.
+	\param[in] size The size of the packed list.
+	\param[out] chunks The chunks.
+	\return FALSE if the list is damaged.
+	*/
+	static bool UnpackRefs(const byte *data, size_lt size, std::vector<ChunkRef> *chunks);
+
+	/*!
+	Hashes the chunk. Static.
+	\param[in] data The chunk.
+	\param[in] size The size of the chunk.
+	\param[out] ref The reference to the chunk.
+	*/
+	static void MakeRef(const byte *data, size_lt size, ChunkRef *ref);
+
+	/*!
+	Writes the hash as the lower-case hex. Static.
+	\param[in] hash The hash, CHUNK_HASH_SIZE bytes.
+	\param[out] hex The hex, CHUNK_HASH_SIZE * 2 + 1 chars.
+	*/
+	static void ToHex(const byte *hash, char *hex);
+
+	/*!
+	Parses the hex written by ToHex. Static.
+	\param[in] hex The hex, CHUNK_HASH_SIZE * 2 chars.
+	\param[out] hash The hash, CHUNK_HASH_SIZE bytes.
+	\return FALSE if the hex is damaged.
+	*/
+	static bool FromHex(const char *hex, byte *hash);
+
+private:
+	/*!
+	\return The name of the file of the manifest.
+	*/
+	std::string GetManifestPath(const char *name);
+
+	/*!
+	Writes the file so it never exists half-written: into the temporary file synced and renamed after.
+	The same file may be written by several threads at once.
+	*/
+	static void WriteAtomic(const std::string &fileName, const byte *data, size_lt size);
+
+	std::string _chunksDir;		///< The directory of the chunks
+	std::string _manifestsDir;	///< The directory of the manifests
+};
@@ -0,0 +1,60 @@
+#include "cpu.h"
+#include <thread>
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+using namespace MSIYBCore;
+
+/// The detected extensions
+typedef struct CpuFeatures_
+{
+	bool sse42;		///< SSE4.2
+	bool pclmul;	///< PCLMULQDQ
+} CpuFeatures;
+
+/*!
+Reads the feature flags of CPUID leaf 1.
+*/
+static CpuFeatures Detect()
+{
+	CpuFeatures features = { false, false };
+#if defined(_M_X64) || defined(_M_IX86)
+	int regs[4];
+	__cpuid(regs, 1);
+	features.sse42 = (regs[2] >> 20) & 1;
+	features.pclmul = (regs[2] >> 1) & 1;
+#elif defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		features.sse42 = (ecx >> 20) & 1;
+		features.pclmul = (ecx >> 1) & 1;
+	}
+#endif
+	return features;
+}
+
+static const CpuFeatures& GetFeatures()
+{
+	static CpuFeatures features = Detect();
+	return features;
+}
+
+bool Cpu::HasSse42()
+{
+	return GetFeatures().sse42;
+}
+
+bool Cpu::HasPclmul()
+{
+	return GetFeatures().pclmul;
+}
+
+int Cpu::GetCount()
+{
+	static int count = std::thread::hardware_concurrency() > 0 ? (int)std::thread::hardware_concurrency() : 1;
+	return count;
+}
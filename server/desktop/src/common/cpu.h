@@ -0,0 +1,51 @@
+/*!
+\file cpu.h "server\desktop\src\common\cpu.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 29 September 2017
+*/
+
+#pragma once
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace MSIYBCore
+{
+	/*!
+	\class Cpu cpu.h "server\desktop\src\common\cpu.h"
+	\brief  The instruction set extensions of the processor, detected once at the first call.
+	The code built for the baseline checks them to choose the accelerated path at runtime.
+	*/
+	class Cpu
+	{
+	public:
+		/*!
+		\return TRUE if the processor has SSE4.2 (the CRC32 instruction).
+		*/
+		static bool HasSse42();
+
+		/*!
+		\return TRUE if the processor has PCLMULQDQ (the carry-less multiplication).
+		*/
+		static bool HasPclmul();
+
+		/*!
+		\return The number of the logical processors (1 if it is unknown).
+		There is no point to spin waiting for the other thread on the single processor.
+		*/
+		static int GetCount();
+
+		/*!
+		Tells the processor that the thread spins (PAUSE): saves the power and the sibling hyper-thread time.
+		*/
+		static inline void Pause()
+		{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+			_mm_pause();
+#endif
+		}
+	};
+}
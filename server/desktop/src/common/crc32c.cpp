@@ -0,0 +1,244 @@
+#include "crc32c.h"
+#include "cpu.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CRC32C_HARDWARE
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32C_TARGET_SSE42
+#define CRC32C_TARGET_PCLMUL
+#else
+#include <x86intrin.h>
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define CRC32C_TARGET_PCLMUL __attribute__((target("sse4.2,pclmul")))
+#endif
+#endif
+
+#define CRC32C_POLY 0x82F63B78			///< The reflected polynomial
+#define CRC32C_STREAM_SIZE (8 * 1024)	///< The bytes of each of the three streams of the hardware loop
+
+using namespace MSIYBCore;
+
+/// The tables of the bytes at the 8 positions of the word (slicing-by-8)
+static unsigned int table[8][256];
+
+/// x^(8 * CRC32C_STREAM_SIZE) and x^(16 * CRC32C_STREAM_SIZE) mod P: shift the checksum over one and two streams
+static unsigned int shift1;
+static unsigned int shift2;
+
+/// The same powers over x^33 which the carry-less multiplication and the CRC32 reduction add
+static unsigned int clmulShift1;
+static unsigned int clmulShift2;
+
+/*!
+Multiplies the polynomials modulo P (both reflected).
+*/
+static unsigned int MultiplyModP(unsigned int a, unsigned int b)
+{
+	unsigned int m = 1u << 31;
+	unsigned int p = 0;
+	for (;;)
+	{
+		if (a & m)
+		{
+			p ^= b;
+			if ((a & (m - 1)) == 0)
+			{
+				break;
+			}
+		}
+		m >>= 1;
+		b = b & 1 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+	}
+	return p;
+}
+
+/*!
+\return x^n mod P (reflected).
+*/
+static unsigned int PowerModP(size_lt n)
+{
+	unsigned int p = 1u << 31;
+	for (size_lt i = 0; i < n; i++)
+	{
+		p = p & 1 ? (p >> 1) ^ CRC32C_POLY : p >> 1;
+	}
+	return p;
+}
+
+static bool InitTables()
+{
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		unsigned int crc = i;
+		for (int k = 0; k < 8; k++)
+		{
+			crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+		}
+		table[0][i] = crc;
+	}
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		for (int k = 1; k < 8; k++)
+		{
+			table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+		}
+	}
+	shift1 = PowerModP(8 * CRC32C_STREAM_SIZE);
+	shift2 = PowerModP(16 * CRC32C_STREAM_SIZE);
+	clmulShift1 = PowerModP(8 * CRC32C_STREAM_SIZE - 33);
+	clmulShift2 = PowerModP(16 * CRC32C_STREAM_SIZE - 33);
+	return true;
+}
+
+static bool tablesReady = InitTables();
+
+static inline unsigned long long Load64(const byte *data)
+{
+	unsigned long long word;
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+/*!
+Continues the raw (not inverted) register with the tables.
+*/
+static unsigned int ExtendSoftware(unsigned int crc, const byte *data, size_lt size)
+{
+	// Assumes the little-endian words as all the supported platforms
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		unsigned long long word = Load64(data) ^ crc;
+		crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^
+			table[5][(word >> 16) & 0xFF] ^ table[4][(word >> 24) & 0xFF] ^
+			table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^
+			table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+	}
+	for (; size > 0; size--, data++)
+	{
+		crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+	}
+	return crc;
+}
+
+#ifdef CRC32C_HARDWARE
+static bool usePclmul = false;
+
+/*!
+Joins the registers of the three streams with the carry-less multiplication.
+*/
+CRC32C_TARGET_PCLMUL static unsigned int CombineClmul(unsigned int crc0, unsigned int crc1, unsigned int crc2)
+{
+	__m128i product0 = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)crc0), _mm_cvtsi32_si128((int)clmulShift2), 0);
+	__m128i product1 = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)crc1), _mm_cvtsi32_si128((int)clmulShift1), 0);
+	unsigned long long product = (unsigned long long)_mm_cvtsi128_si64(_mm_xor_si128(product0, product1));
+	return (unsigned int)_mm_crc32_u64(0, product) ^ crc2;
+}
+
+/*!
+Continues the raw register with the CRC32 instruction.
+*/
+CRC32C_TARGET_SSE42 static unsigned int ExtendHardware(unsigned int crc, const byte *data, size_lt size)
+{
+	for (; size > 0 && ((size_t)data & 7); size--, data++)
+	{
+		crc = _mm_crc32_u8(crc, *data);
+	}
+
+	// The instruction has the latency of 3 and the throughput of 1: three streams keep it busy
+	while (size >= 3 * CRC32C_STREAM_SIZE)
+	{
+		unsigned long long crc0 = crc;
+		unsigned long long crc1 = 0;
+		unsigned long long crc2 = 0;
+		const byte *end = data + CRC32C_STREAM_SIZE;
+		for (; data < end; data += 8)
+		{
+			crc0 = _mm_crc32_u64(crc0, Load64(data));
+			crc1 = _mm_crc32_u64(crc1, Load64(data + CRC32C_STREAM_SIZE));
+			crc2 = _mm_crc32_u64(crc2, Load64(data + 2 * CRC32C_STREAM_SIZE));
+		}
+		if (usePclmul)
+		{
+			crc = CombineClmul((unsigned int)crc0, (unsigned int)crc1, (unsigned int)crc2);
+		}
+		else
+		{
+			crc = MultiplyModP(shift2, (unsigned int)crc0) ^ MultiplyModP(shift1, (unsigned int)crc1) ^ (unsigned int)crc2;
+		}
+		data += 2 * CRC32C_STREAM_SIZE;
+		size -= 3 * CRC32C_STREAM_SIZE;
+	}
+
+	unsigned long long crc64 = crc;
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		crc64 = _mm_crc32_u64(crc64, Load64(data));
+	}
+	crc = (unsigned int)crc64;
+	for (; size > 0; size--, data++)
+	{
+		crc = _mm_crc32_u8(crc, *data);
+	}
+	return crc;
+}
+#endif
+
+typedef unsigned int(*ExtendFunction)(unsigned int crc, const byte *data, size_lt size);
+
+static ExtendFunction Choose()
+{
+#ifdef CRC32C_HARDWARE
+	if (Cpu::HasSse42())
+	{
+		usePclmul = Cpu::HasPclmul();
+		return ExtendHardware;
+	}
+#endif
+	return ExtendSoftware;
+}
+
+static ExtendFunction extend = Choose();
+
+Crc32c::Crc32c()
+{
+	Reset();
+}
+
+void Crc32c::Reset()
+{
+	_crc = 0;
+}
+
+void Crc32c::Update(const byte *data, size_lt size)
+{
+	_crc = Extend(_crc, data, size);
+}
+
+void Crc32c::Final(byte *digest)
+{
+	digest[0] = (byte)(_crc >> 24);
+	digest[1] = (byte)(_crc >> 16);
+	digest[2] = (byte)(_crc >> 8);
+	digest[3] = (byte)_crc;
+}
+
+size_lt Crc32c::GetSize()
+{
+	return CRC32C_SIZE;
+}
+
+unsigned int Crc32c::GetValue()
+{
+	return _crc;
+}
+
+unsigned int Crc32c::Extend(unsigned int crc, const byte *data, size_lt size)
+{
+	return ~extend(~crc, data, size);
+}
+
+bool Crc32c::IsHardware()
+{
+	return extend != ExtendSoftware;
+}
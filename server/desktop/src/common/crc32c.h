@@ -0,0 +1,52 @@
+/*!
+\file crc32c.h "server\desktop\src\common\crc32c.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 29 September 2017
+*/
+
+#pragma once
+#include "hasher.h"
+
+#define CRC32C_SIZE 4
+
+/*!
+\class Crc32c crc32c.h "server\desktop\src\common\crc32c.h"
+\brief  CRC-32C (Castagnoli, iSCSI), the integrity checksum of the stored files.
+With SSE4.2 the CRC32 instruction runs on three independent streams and PCLMULQDQ joins them,
+otherwise the tables are used 8 bytes at a time. The path is chosen once at the start.
+*/
+class Crc32c : public Hasher
+{
+public:
+	Crc32c();
+
+	void Reset();
+	void Update(const byte *data, size_lt size);
+	void Final(byte *digest);
+	size_lt GetSize();
+
+	/*!
+	\return The checksum of the data hashed so far.
+	*/
+	unsigned int GetValue();
+
+	/*!
+	Continues the checksum with the data. Static.
+	\param[in] crc The checksum of the previous data (0 for none).
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	\return The checksum of the previous data and the data.
+	*/
+	static unsigned int Extend(unsigned int crc, const byte *data, size_lt size);
+
+	/*!
+	\return TRUE if the CRC32 instruction is used. Static.
+	*/
+	static bool IsHardware();
+
+private:
+	unsigned int _crc;	///< The checksum of the data hashed so far
+};
@@ -0,0 +1,490 @@
+#include "delta.h"
+#include <cmath>
+
+/*!
+Reads the block, the short reads are repeated until the file ends.
+\return The number of the bytes read.
+*/
+static size_lt ReadFull(File &file, byte *block, size_lt size)
+{
+	size_lt readed = 0;
+	while (readed < size)
+	{
+		size_lt part = file.ReadBlock(block + readed, size - readed);
+		if (part == 0)
+		{
+			break;
+		}
+		readed += part;
+	}
+	return readed;
+}
+
+template <typename T> static void Append(std::vector<byte> *out, T value)
+{
+	byte *bytes = (byte*)&value;
+	out->insert(out->end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T> static bool Take(const byte *data, size_lt size, size_lt *pos, T *value)
+{
+	if (size - *pos < sizeof(T))
+	{
+		return false;
+	}
+	memcpy(value, data + *pos, sizeof(T));
+	*pos += sizeof(T);
+	return true;
+}
+
+DeltaSignature::DeltaSignature()
+{
+	_blockSize = DELTA_BLOCK_MIN_SIZE;
+	_fileSize = 0;
+}
+
+void DeltaSignature::Build(File &file)
+{
+	_fileSize = file.FileSize();
+	_blockSize = ChooseBlockSize(_fileSize);
+	_blocks.resize((size_t)((_fileSize + _blockSize - 1) / _blockSize));
+
+	ByteSpan view = { NULL, 0 };
+	std::vector<byte> buffer;
+	if (file.IsMapped())
+	{
+		view = file.GetView();
+	}
+	else
+	{
+		buffer.resize(_blockSize);
+	}
+
+	RollingChecksum rolling;
+	for (size_lt i = 0; i < _blocks.size(); i++)
+	{
+		size_lt size = GetBlockSize(i);
+		const byte *block = view.data + i * _blockSize;
+		if (!file.IsMapped())
+		{
+			if (ReadFull(file, buffer.data(), size) != size)
+			{
+				ThrowFileException("The file was truncated while its signature was computed!");
+			}
+			block = buffer.data();
+		}
+		rolling.Init(block, size);
+		_blocks[i].weak = rolling.Get();
+		Strong(block, size, _blocks[i].strong);
+	}
+	Index();
+}
+
+void DeltaSignature::Pack(std::vector<byte> *out) const
+{
+	out->clear();
+	out->reserve(DELTA_SIGNATURE_HEADER_SIZE + _blocks.size() * DELTA_BLOCK_SIGNATURE_SIZE);
+	Append(out, _blockSize);
+	Append(out, (unsigned long long)_fileSize);
+	for (size_lt i = 0; i < _blocks.size(); i++)
+	{
+		Append(out, _blocks[i].weak);
+		out->insert(out->end(), _blocks[i].strong, _blocks[i].strong + DELTA_STRONG_SIZE);
+	}
+}
+
+bool DeltaSignature::Unpack(const byte *data, size_lt size)
+{
+	size_lt pos = 0;
+	unsigned int blockSize;
+	unsigned long long fileSize;
+	if (!Take(data, size, &pos, &blockSize) || !Take(data, size, &pos, &fileSize) ||
+		blockSize < DELTA_BLOCK_MIN_SIZE || blockSize > DELTA_BLOCK_MAX_SIZE)
+	{
+		return false;
+	}
+	size_lt count = (size_lt)((fileSize + blockSize - 1) / blockSize);
+	if ((size - pos) / DELTA_BLOCK_SIGNATURE_SIZE != count || (size - pos) % DELTA_BLOCK_SIGNATURE_SIZE)
+	{
+		return false;
+	}
+
+	_blockSize = blockSize;
+	_fileSize = (size_lt)fileSize;
+	_blocks.resize((size_t)count);
+	for (size_lt i = 0; i < count; i++)
+	{
+		Take(data, size, &pos, &_blocks[i].weak);
+		memcpy(_blocks[i].strong, data + pos, DELTA_STRONG_SIZE);
+		pos += DELTA_STRONG_SIZE;
+	}
+	Index();
+	return true;
+}
+
+long long DeltaSignature::Find(unsigned int weak, const byte *data, size_lt size) const
+{
+	auto range = _weak.equal_range(weak);
+	if (range.first == range.second)
+	{
+		return -1;
+	}
+
+	byte strong[DELTA_STRONG_SIZE];
+	Strong(data, size, strong);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (GetBlockSize(it->second) == size && !memcmp(_blocks[it->second].strong, strong, DELTA_STRONG_SIZE))
+		{
+			return (long long)it->second;
+		}
+	}
+	return -1;
+}
+
+unsigned int DeltaSignature::GetBlockSize() const
+{
+	return _blockSize;
+}
+
+unsigned int DeltaSignature::GetBlockSize(size_lt index) const
+{
+	size_lt offset = index * _blockSize;
+	return _fileSize - offset < _blockSize ? (unsigned int)(_fileSize - offset) : _blockSize;
+}
+
+size_lt DeltaSignature::GetFileSize() const
+{
+	return _fileSize;
+}
+
+size_lt DeltaSignature::GetCount() const
+{
+	return _blocks.size();
+}
+
+unsigned int DeltaSignature::ChooseBlockSize(size_lt fileSize)
+{
+	// The signature and the missed matches grow in the opposite directions, the root balances them
+	size_lt size = (size_lt)std::sqrt((double)fileSize);
+	size = (size + 1023) & ~(size_lt)1023;
+	if (size < DELTA_BLOCK_MIN_SIZE)
+	{
+		size = DELTA_BLOCK_MIN_SIZE;
+	}
+	if (size > DELTA_BLOCK_MAX_SIZE)
+	{
+		size = DELTA_BLOCK_MAX_SIZE;
+	}
+	return (unsigned int)size;
+}
+
+void DeltaSignature::Strong(const byte *data, size_lt size, byte *strong)
+{
+	byte digest[SHA256_SIZE];
+	Sha256::Hash(data, size, digest);
+	memcpy(strong, digest, DELTA_STRONG_SIZE);
+}
+
+void DeltaSignature::Index()
+{
+	_weak.clear();
+	_weak.reserve(_blocks.size());
+	for (size_lt i = 0; i < _blocks.size(); i++)
+	{
+		_weak.insert(std::make_pair(_blocks[i].weak, i));
+	}
+}
+
+DeltaEncoder::DeltaEncoder(const DeltaSignature &signature, File &file) : _signature(signature)
+{
+	_pos = 0;
+	_literal = 0;
+	_finished = false;
+	_rollingValid = false;
+	_lastCopy = SIZE_MAX;
+	_literalSize = 0;
+	_total = 0;
+	if (file.IsMapped())
+	{
+		ByteSpan view = file.GetView();
+		_file = NULL;
+		_buffer = NULL;
+		_bufferSize = 0;
+		_data = view.data;
+		_size = view.size;
+		_eof = true;
+		return;
+	}
+
+	// Holds the longest literal and the window after it, twice to make the reads big
+	_file = &file;
+	_bufferSize = 2 * (DELTA_LITERAL_MAX_SIZE + (size_lt)signature.GetBlockSize());
+	_buffer = new byte[_bufferSize];
+	if (!_buffer)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+	_data = _buffer;
+	_size = 0;
+	_eof = false;
+}
+
+DeltaEncoder::~DeltaEncoder()
+{
+	delete[] _buffer;
+}
+
+bool DeltaEncoder::Next(std::vector<byte> *frame)
+{
+	frame->clear();
+	_lastCopy = SIZE_MAX;
+	if (_finished)
+	{
+		return false;
+	}
+
+	size_lt blockSize = _signature.GetBlockSize();
+	size_lt count = _signature.GetCount();
+	while (frame->size() < DELTA_FRAME_SIZE)
+	{
+		if (!_eof && _size - _pos <= blockSize)
+		{
+			Fill();
+		}
+		size_lt window = _size - _pos;
+		if (window == 0)
+		{
+			FlushLiteral(frame);
+			byte digest[SHA256_SIZE];
+			_hash.Final(digest);
+			frame->push_back(DELTAEND);
+			Append(frame, (unsigned long long)_total);
+			frame->insert(frame->end(), digest, digest + SHA256_SIZE);
+			_finished = true;
+			return true;
+		}
+
+		if (count == 0)
+		{
+			// Nothing to match: the whole file is literal
+			_pos = window < DELTA_LITERAL_MAX_SIZE - (_pos - _literal) ? _size : _literal + DELTA_LITERAL_MAX_SIZE;
+			FlushLiteral(frame);
+			continue;
+		}
+
+		if (window < blockSize)
+		{
+			// The tail can match only the short last block of the basis
+			if (window == _signature.GetBlockSize(count - 1))
+			{
+				_rolling.Init(_data + _pos, window);
+				long long index = _signature.Find(_rolling.Get(), _data + _pos, window);
+				if (index >= 0)
+				{
+					FlushLiteral(frame);
+					AppendCopy(frame, (size_lt)index);
+					_hash.Update(_data + _pos, window);
+					_total += window;
+					_pos += window;
+					_literal = _pos;
+					continue;
+				}
+			}
+			_pos = _size;
+			FlushLiteral(frame);
+			continue;
+		}
+
+		if (!_rollingValid)
+		{
+			_rolling.Init(_data + _pos, blockSize);
+			_rollingValid = true;
+		}
+		long long index = _signature.Find(_rolling.Get(), _data + _pos, blockSize);
+		if (index >= 0)
+		{
+			FlushLiteral(frame);
+			AppendCopy(frame, (size_lt)index);
+			_hash.Update(_data + _pos, blockSize);
+			_total += blockSize;
+			_pos += blockSize;
+			_literal = _pos;
+			_rollingValid = false;
+			continue;
+		}
+
+		if (_pos - _literal >= DELTA_LITERAL_MAX_SIZE)
+		{
+			FlushLiteral(frame);
+		}
+		if (_pos + blockSize < _size)
+		{
+			_rolling.Roll(_data[_pos], _data[_pos + blockSize]);
+		}
+		else
+		{
+			_rollingValid = false;
+		}
+		_pos++;
+	}
+	FlushLiteral(frame);
+	return true;
+}
+
+size_lt DeltaEncoder::GetLiteralSize()
+{
+	return _literalSize;
+}
+
+void DeltaEncoder::Fill()
+{
+	// The literal data not yet appended is kept together with the window
+	size_lt left = _size - _literal;
+	if (left > 0 && _literal > 0)
+	{
+		memmove(_buffer, _buffer + _literal, left);
+	}
+	_pos -= _literal;
+	_size = left;
+	_literal = 0;
+
+	while (_size < _bufferSize)
+	{
+		size_lt readed = _file->ReadBlock(_buffer + _size, _bufferSize - _size);
+		if (readed == 0)
+		{
+			_eof = true;
+			break;
+		}
+		_size += readed;
+	}
+	_data = _buffer;
+}
+
+void DeltaEncoder::FlushLiteral(std::vector<byte> *frame)
+{
+	if (_pos == _literal)
+	{
+		return;
+	}
+	unsigned int size = (unsigned int)(_pos - _literal);
+	frame->push_back(DELTALITERAL);
+	Append(frame, size);
+	frame->insert(frame->end(), _data + _literal, _data + _pos);
+	_hash.Update(_data + _literal, size);
+	_literalSize += size;
+	_total += size;
+	_literal = _pos;
+	_lastCopy = SIZE_MAX;
+}
+
+void DeltaEncoder::AppendCopy(std::vector<byte> *frame, size_lt index)
+{
+	if (_lastCopy != SIZE_MAX)
+	{
+		// The runs of the consecutive blocks are one operation
+		unsigned int first;
+		unsigned int count;
+		memcpy(&first, frame->data() + _lastCopy + 1, sizeof(first));
+		memcpy(&count, frame->data() + _lastCopy + 1 + sizeof(first), sizeof(count));
+		if (first + count == index)
+		{
+			count++;
+			memcpy(frame->data() + _lastCopy + 1 + sizeof(first), &count, sizeof(count));
+			return;
+		}
+	}
+	_lastCopy = frame->size();
+	frame->push_back(DELTACOPY);
+	Append(frame, (unsigned int)index);
+	Append(frame, (unsigned int)1);
+}
+
+DeltaDecoder::DeltaDecoder(const DeltaSignature &signature, File *basis, File &output) : _signature(signature)
+{
+	_basis = basis;
+	_output = &output;
+	_total = 0;
+	_finished = false;
+}
+
+bool DeltaDecoder::Apply(const byte *data, size_lt size)
+{
+	size_lt pos = 0;
+	while (pos < size)
+	{
+		byte operation = data[pos++];
+		if (_finished)
+		{
+			ThrowFileException("The delta continues after its end!");
+		}
+
+		if (operation == DELTALITERAL)
+		{
+			unsigned int length;
+			if (!Take(data, size, &pos, &length) || size - pos < length)
+			{
+				ThrowFileException("The delta is damaged!");
+			}
+			_output->WriteBlock((byte*)data + pos, length);
+			_hash.Update(data + pos, length);
+			_total += length;
+			pos += length;
+		}
+		else if (operation == DELTACOPY)
+		{
+			unsigned int index;
+			unsigned int count;
+			if (!Take(data, size, &pos, &index) || !Take(data, size, &pos, &count) ||
+				(size_lt)index + count > _signature.GetCount())
+			{
+				ThrowFileException("The delta is damaged!");
+			}
+			Copy(index, count);
+		}
+		else if (operation == DELTAEND)
+		{
+			unsigned long long total;
+			byte digest[SHA256_SIZE];
+			if (!Take(data, size, &pos, &total) || size - pos < SHA256_SIZE)
+			{
+				ThrowFileException("The delta is damaged!");
+			}
+			_hash.Final(digest);
+			if (total != _total || memcmp(digest, data + pos, SHA256_SIZE))
+			{
+				ThrowFileException("The rebuilt file doesn't match its hash!");
+			}
+			pos += SHA256_SIZE;
+			_output->Flush();
+			_finished = true;
+		}
+		else
+		{
+			ThrowFileException("The delta is damaged!");
+		}
+	}
+	return _finished;
+}
+
+void DeltaDecoder::Copy(size_lt index, size_lt count)
+{
+	if (_basis == NULL)
+	{
+		ThrowFileException("The delta refers to the missing basis file!");
+	}
+	_block.resize(_signature.GetBlockSize());
+	_basis->Seek(index * _signature.GetBlockSize(), SeekReference::START);
+	for (size_lt i = index; i < index + count; i++)
+	{
+		size_lt size = _signature.GetBlockSize(i);
+		if (ReadFull(*_basis, _block.data(), size) != size)
+		{
+			ThrowFileException("The basis file was changed during the delta!");
+		}
+		_output->WriteBlock(_block.data(), size);
+		_hash.Update(_block.data(), size);
+		_total += size;
+	}
+}
@@ -0,0 +1,278 @@
+/*!
+\file delta.h "server\desktop\src\common\delta.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 22 September 2017
+*/
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "file.h"
+#include "sha256.h"
+
+#define DELTA_STRONG_SIZE 16								///< The bytes of SHA-256 kept as the strong hash of the block
+#define DELTA_SIGNATURE_HEADER_SIZE 12						///< The 32-bit block size and the 64-bit file size
+#define DELTA_BLOCK_SIGNATURE_SIZE (4 + DELTA_STRONG_SIZE)	///< The 32-bit weak checksum and the strong hash
+
+/// The operations of the delta frames
+typedef enum DeltaOperation_
+{
+	DELTALITERAL = 1,	///< The 32-bit size and the data which is not in the basis file
+	DELTACOPY = 2,		///< The 32-bit index and the 32-bit count of the basis blocks to be copied
+	DELTAEND = 3		///< The 64-bit size and the SHA-256 of the whole new file
+} DeltaOperation;
+
+/// The signature of the block of the basis file
+typedef struct BlockSignature_
+{
+	unsigned int weak;					///< The rolling checksum
+	byte strong[DELTA_STRONG_SIZE];		///< The head of the SHA-256
+} BlockSignature;
+
+/*!
+\class RollingChecksum delta.h "server\desktop\src\common\delta.h"
+\brief  The rsync weak checksum of the window which can be moved by one byte in O(1).
+*/
+class RollingChecksum
+{
+public:
+	/*!
+	Computes the checksum of the window.
+	\param[in] data The window.
+	\param[in] size The size of the window.
+	*/
+	inline void Init(const byte *data, size_lt size)
+	{
+		_a = 0;
+		_b = 0;
+		_size = (unsigned int)size;
+		for (size_lt i = 0; i < size; i++)
+		{
+			_a += data[i];
+			_b += (unsigned int)(size - i) * data[i];
+		}
+	}
+
+	/*!
+	Moves the window by one byte.
+	\param[in] out The first byte of the window.
+	\param[in] in The byte after the window.
+	*/
+	inline void Roll(byte out, byte in)
+	{
+		_a += in - out;
+		_b += _a - _size * out;
+	}
+
+	/*!
+	\return The checksum of the window.
+	*/
+	inline unsigned int Get()
+	{
+		return (_a & 0xFFFF) | (_b << 16);
+	}
+
+private:
+	unsigned int _a;		///< The sum of the bytes
+	unsigned int _b;		///< The sum of the bytes weighted by their distance from the end
+	unsigned int _size;		///< The size of the window
+};
+
+/*!
+\class DeltaSignature delta.h "server\desktop\src\common\delta.h"
+\brief  The checksums of the fixed-size blocks of the basis file (the old copy on the receiver).
+The last block may be shorter than the others.
+*/
+class DeltaSignature
+{
+public:
+	/*!
+	Creates the signature of the empty file.
+	*/
+	DeltaSignature();
+
+	/*!
+	Computes the signature of the file. The mapped file (MAPPED mode) is read without copying.
+	\param[in] file The file opened to read.
+	*/
+	void Build(File &file);
+
+	/*!
+	Serializes the signature: the block size, the file size and the block signatures.
+	\param[out] out The packed signature.
+	*/
+	void Pack(std::vector<byte> *out) const;
+
+	/*!
+	Deserializes the signature.
+	\param[in] data The packed signature.
+	\param[in] size The size of the packed signature.
+	\return FALSE if the data is not a valid signature.
+	*/
+	bool Unpack(const byte *data, size_lt size);
+
+	/*!
+	Looks for the block with the same content.
+	\param[in] weak The rolling checksum of the data.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	\return The index of the block or -1. The strong hash is computed only if the weak checksum matches.
+	*/
+	long long Find(unsigned int weak, const byte *data, size_lt size) const;
+
+	/*!
+	\return The size of the blocks.
+	*/
+	unsigned int GetBlockSize() const;
+
+	/*!
+	\param[in] index The index of the block.
+	\return The size of the block (the last one may be shorter).
+	*/
+	unsigned int GetBlockSize(size_lt index) const;
+
+	/*!
+	\return The size of the basis file.
+	*/
+	size_lt GetFileSize() const;
+
+	/*!
+	\return The number of the blocks.
+	*/
+	size_lt GetCount() const;
+
+	/*!
+	Chooses the block size for the file: about the square root of its size. Static.
+	\param[in] fileSize The size of the file.
+	\return The block size between DELTA_BLOCK_MIN_SIZE and DELTA_BLOCK_MAX_SIZE.
+	*/
+	static unsigned int ChooseBlockSize(size_lt fileSize);
+
+	/*!
+	Computes the strong hash of the data. Static.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	\param[out] strong The hash of DELTA_STRONG_SIZE bytes.
+	*/
+	static void Strong(const byte *data, size_lt size, byte *strong);
+
+private:
+	/*!
+	Fills the map of the weak checksums.
+	*/
+	void Index();
+
+	unsigned int _blockSize;							///< The size of the blocks
+	size_lt _fileSize;									///< The size of the basis file
+	std::vector<BlockSignature> _blocks;				///< The signatures of the blocks
+	std::unordered_multimap<unsigned int, size_lt> _weak;	///< The indexes of the blocks by their weak checksums
+};
+
+/*!
+\class DeltaEncoder delta.h "server\desktop\src\common\delta.h"
+\brief  The sender side of the delta: describes the new file as the basis blocks and the literal data.
+Every window of the file is checked against the signature, the window is rolled by one byte on the miss.
+*/
+class DeltaEncoder
+{
+public:
+	/*!
+	Prepares the encoding. The mapped file (MAPPED mode) is read without copying.
+	\param[in] signature The signature of the basis file. Must outlive the encoder.
+	\param[in] file The new file opened to read. Must outlive the encoder.
+	*/
+	DeltaEncoder(const DeltaSignature &signature, File &file);
+
+	/*!
+	Deallocates the buffer.
+	*/
+	~DeltaEncoder();
+
+	/*!
+	Encodes the next part of the file.
+	\param[out] frame The operations, about DELTA_FRAME_SIZE bytes. The last frame ends with DELTAEND.
+	\return FALSE if the file is encoded.
+	*/
+	bool Next(std::vector<byte> *frame);
+
+	/*!
+	\return The size of the literal data encoded so far.
+	*/
+	size_lt GetLiteralSize();
+
+private:
+	/*!
+	Moves the unsent data to the beginning of the buffer and reads the file after it.
+	*/
+	void Fill();
+
+	/*!
+	Appends the data from the literal start to the current position as DELTALITERAL.
+	*/
+	void FlushLiteral(std::vector<byte> *frame);
+
+	/*!
+	Appends DELTACOPY of the block or extends the previous one.
+	*/
+	void AppendCopy(std::vector<byte> *frame, size_lt index);
+
+	const DeltaSignature &_signature;	///< The signature of the basis file
+	File *_file;						///< The new file, NULL if it is mapped
+	byte *_buffer;						///< The buffer of the file
+	size_lt _bufferSize;				///< The size of the buffer
+	const byte *_data;					///< The data being encoded
+	size_lt _size;						///< The size of the data
+	size_lt _pos;						///< The start of the window
+	size_lt _literal;					///< The start of the literal data not yet appended
+	bool _eof;							///< Nothing more to read from the file
+	bool _finished;						///< DELTAEND is appended
+	RollingChecksum _rolling;			///< The checksum of the window
+	bool _rollingValid;					///< The checksum corresponds to the window at _pos
+	size_lt _lastCopy;					///< The offset of the last DELTACOPY in the frame or SIZE_MAX
+	size_lt _literalSize;				///< The size of the literal data encoded
+	size_lt _total;						///< The size of the data encoded
+	Sha256 _hash;						///< The hash of the new file
+};
+
+/*!
+\class DeltaDecoder delta.h "server\desktop\src\common\delta.h"
+\brief  The receiver side of the delta: rebuilds the new file from the basis file and the delta frames.
+*/
+class DeltaDecoder
+{
+public:
+	/*!
+	Prepares the decoding.
+	\param[in] signature The signature sent to the encoder. Must outlive the decoder.
+	\param[in] basis The basis file opened to read or NULL if there is no basis. Must outlive the decoder.
+	\param[in] output The new file opened to write. Must outlive the decoder.
+	*/
+	DeltaDecoder(const DeltaSignature &signature, File *basis, File &output);
+
+	/*!
+	Applies the frame of the operations.
+	Throws FileException if the frame is damaged or the rebuilt file doesn't match its hash.
+	\param[in] data The frame.
+	\param[in] size The size of the frame.
+	\return TRUE if the frame ended with DELTAEND and the new file is complete.
+	*/
+	bool Apply(const byte *data, size_lt size);
+
+private:
+	/*!
+	Copies the basis blocks to the output.
+	*/
+	void Copy(size_lt index, size_lt count);
+
+	const DeltaSignature &_signature;	///< The signature of the basis file
+	File *_basis;						///< The basis file
+	File *_output;						///< The new file
+	std::vector<byte> _block;			///< The buffer of the basis block
+	size_lt _total;						///< The size of the data written
+	Sha256 _hash;						///< The hash of the new file
+	bool _finished;						///< DELTAEND is applied
+};
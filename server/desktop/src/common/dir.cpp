@@ -1,10 +1,13 @@
-#include "stdafx.h"
-#include "../stdafx.h"
 #include "dir.h"
+#include "dirindex.h"
+#include "dirwatcher.h"
+#include <limits>
 
 Dir::Dir()
 {
 	this->dir = new OSDir();
+	this->index = NULL;
+	this->watcher = NULL;
 	if(!this->dir)
 	{
 		ThrowException("Can't allocate memory!");
@@ -15,6 +18,8 @@ Dir::Dir()
 Dir::Dir(const char *path)
 {
 	this->dir = new OSDir(path);
+	this->index = NULL;
+	this->watcher = NULL;
 	if(!this->dir)
 	{
 		ThrowException("Can't allocate memory!");
@@ -24,17 +29,26 @@ Dir::Dir(const char *path)
 
 Dir::~Dir()
 {
+	delete this->watcher;
 	delete this->dir;
-	delete[] &this->workingDir;
+	delete this->index;
 }
 
 void Dir::SetWorkingDir(const char *path)
 {
+	this->Unwatch();
 	strcpy(this->workingDir, path);
+	delete this->index;
+	this->index = NULL;
+	this->watcher = NULL;
 }
 
 size_lt Dir::GetDirSize()
 {
+	if (this->watcher)
+	{
+		return this->index->GetSize();
+	}
 	return this->GetDirSize(this->workingDir);
 }
 
@@ -45,6 +59,10 @@ size_lt Dir::GetDirSize(const char *path)
 
 size_lt Dir::GetNumberOfFiles()
 {
+	if (this->watcher)
+	{
+		return this->index->GetCount();
+	}
 	return this->GetNumberOfFiles(this->workingDir);
 }
 
@@ -53,34 +71,105 @@ size_lt Dir::GetNumberOfFiles(const char *path)
 	return OSDir::GetNumberOfFiles(path);
 }
 
-File& Dir::SearchFileName(const char *fileName)
+vector<string> Dir::SearchFileName(const char *fileName)
+{
+	return this->GetIndex().SearchName(fileName);
+}
+
+vector<string> Dir::SearchFileName(const char *path, const char *fileName)
+{
+	DirIndex index(path);
+	index.Open();
+	return index.SearchName(fileName);
+}
+
+vector<string> Dir::SearchFileExt(const char *fileExtention)
 {
-	return this->SearchFileName(this->workingDir, fileName);
+	return this->GetIndex().SearchExt(fileExtention);
 }
 
-File& Dir::SearchFileName(const char *path, const char *fileName)
+vector<string> Dir::SearchFileExt(const char *path, const char *fileExtention)
 {
-	return OSDir::SearchFileName(path, fileName);
+	DirIndex index(path);
+	index.Open();
+	return index.SearchExt(fileExtention);
 }
 
-vector<File&> Dir::SearchFileExt(const char * filextention)
+vector<string> Dir::SearchFileTime(time_t fileTime)
 {
-	return this->SearchFileExt(this->workingDir, filextention);
+	return this->GetIndex().SearchTime(fileTime, numeric_limits<time_t>::max());
 }
 
-vector<File&> Dir::SearchFileExt(const char *path, const char *fileExtention)
+vector<string> Dir::SearchFileTime(const char *path, time_t fileTime)
 {
-	return OSDir::SearchFileExt(path, fileExtention);
+	return Dir::SearchFileTimeRange(path, fileTime, numeric_limits<time_t>::max());
 }
 
-vector<File&> Dir::SearchFileTime(time_t fileTime)
+vector<string> Dir::SearchFileTimeRange(time_t from, time_t to)
 {
-	return this->SearchFileTime(this->workingDir, fileTime);
+	return this->GetIndex().SearchTime(from, to);
 }
 
-vector<File&> Dir::SearchFileTime(const char * path, time_t fileTime)
+vector<string> Dir::SearchFileTimeRange(const char *path, time_t from, time_t to)
 {
-	return OSDir::SearchFileTime(path, fileTime);
+	DirIndex index(path);
+	index.Open();
+	return index.SearchTime(from, to);
+}
+
+DirIndex& Dir::GetIndex()
+{
+	if (!this->index)
+	{
+		this->index = new DirIndex(this->workingDir);
+		if (!this->index)
+		{
+			ThrowException("Can't allocate memory!");
+		}
+		this->index->Open();
+	}
+	return *this->index;
+}
+
+void Dir::Watch()
+{
+	if (this->watcher)
+	{
+		return;
+	}
+
+	// The stored index isn't loaded: it misses the changes made while nobody watched the tree
+	if (!this->index)
+	{
+		this->index = new DirIndex(this->workingDir);
+		if (!this->index)
+		{
+			ThrowException("Can't allocate memory!");
+		}
+	}
+	this->watcher = new DirWatcher();
+	if (!this->watcher)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+	try
+	{
+		this->watcher->Start(this->workingDir, this->index);
+		// Walked after the watcher started, so no change falls in between
+		this->index->Build();
+	}
+	catch (...)
+	{
+		delete this->watcher;
+		this->watcher = NULL;
+		throw;
+	}
+}
+
+void Dir::Unwatch()
+{
+	delete this->watcher;
+	this->watcher = NULL;
 }
 
 void Dir::MakeDir()
@@ -95,10 +184,20 @@ void Dir::MakeDir(const char *path)
 
 bool Dir::Exists()
 {
-	this->Exists(this->workingDir);
+	return this->Exists(this->workingDir);
 }
 
 bool Dir::Exists(const char *path)
 {
 	return OSDir::Exists(path);
 }
+
+DirStats Dir::Walk(const DirVisitor &visitor, bool withSizes)
+{
+	return this->Walk(this->workingDir, visitor, withSizes);
+}
+
+DirStats Dir::Walk(const char *path, const DirVisitor &visitor, bool withSizes)
+{
+	return OSDir::Walk(path, visitor, withSizes);
+}
@@ -3,13 +3,16 @@
 #ifdef _WIN32
 #include "../cross/windows/windir.h"
 typedef WinDir OSDir;
-#elif _unix_
+#elif __unix__
 #include "../cross/unix/unixdir.h"
 typedef UnixDir OSDir;
 #endif
 
 using namespace std;
 
+class DirIndex;
+class DirWatcher;
+
 class Dir
 {
 public:
@@ -27,14 +30,26 @@ public:
 	size_lt GetNumberOfFiles();
 	static size_lt GetNumberOfFiles(const char *path);
 
-	File& SearchFileName(const char *fileName);
-	static File& SearchFileName(const char *path, const char *fileName);
+	// The searches use the stored DirIndex of the directory (built on the first search) and return the full paths
+	vector<string> SearchFileName(const char *fileName);
+	static vector<string> SearchFileName(const char *path, const char *fileName);
+
+	vector<string> SearchFileExt(const char* fileExtention);
+	static vector<string> SearchFileExt(const char *path, const char* fileExtention);
+
+	// The files modified at fileTime or later
+	vector<string> SearchFileTime(time_t fileTime);
+	static vector<string> SearchFileTime(const char *path, time_t fileTime);
 
-	vector<File&> SearchFileExt(const char* fileExtention);	//std::reference_wrapper? http://artlang.net/article/view/7/
-	static vector<File&> SearchFileExt(const char *path, const char* fileExtention);
-	
-	vector<File&> SearchFileTime(time_t fileTime);
-	static vector<File&> SearchFileTime(const char *path, time_t fileTime);
+	vector<string> SearchFileTimeRange(time_t from, time_t to);
+	static vector<string> SearchFileTimeRange(const char *path, time_t from, time_t to);
+
+	DirIndex& GetIndex();
+
+	// Keeps the index, the size and the number of the files up to date without rescanning.
+	// The index is rebuilt from the tree when the watching starts, the stored one may be out of date
+	void Watch();
+	void Unwatch();
 
 	void MakeDir();
 	static void MakeDir(const char *path);
@@ -42,6 +57,11 @@ public:
 	bool Exists();
 	static bool Exists(const char *path);
 
+	DirStats Walk(const DirVisitor &visitor, bool withSizes = true);
+	static DirStats Walk(const char *path, const DirVisitor &visitor, bool withSizes = true);
+
 private:
 	IDir* dir;
+	DirIndex* index;
+	DirWatcher* watcher;
 };
\ No newline at end of file
@@ -0,0 +1,695 @@
+#include "dirindex.h"
+#include <algorithm>
+
+/*!
+Appends the record: the path length, the path, the size and the time.
+*/
+static void PutRecord(std::vector<byte> &out, const std::string &path, size_lt size, time_t modTime)
+{
+	unsigned int pathSize = (unsigned int)path.size();
+	unsigned long long fileSize = size;
+	long long fileTime = modTime;
+	out.insert(out.end(), (byte*)&pathSize, (byte*)&pathSize + sizeof(pathSize));
+	out.insert(out.end(), path.begin(), path.end());
+	out.insert(out.end(), (byte*)&fileSize, (byte*)&fileSize + sizeof(fileSize));
+	out.insert(out.end(), (byte*)&fileTime, (byte*)&fileTime + sizeof(fileTime));
+}
+
+/*!
+Reads the record written by PutRecord.
+\return FALSE if the record is cut.
+*/
+static bool GetRecord(ByteSpan data, size_lt *pos, std::string *path, size_lt *size, time_t *modTime)
+{
+	unsigned int pathSize;
+	unsigned long long fileSize;
+	long long fileTime;
+	if (data.size - *pos < sizeof(pathSize))
+	{
+		return false;
+	}
+	memcpy(&pathSize, data.data + *pos, sizeof(pathSize));
+	if (data.size - *pos - sizeof(pathSize) < pathSize + sizeof(fileSize) + sizeof(fileTime))
+	{
+		return false;
+	}
+	*pos += sizeof(pathSize);
+	path->assign((const char*)data.data + *pos, pathSize);
+	*pos += pathSize;
+	memcpy(&fileSize, data.data + *pos, sizeof(fileSize));
+	*pos += sizeof(fileSize);
+	memcpy(&fileTime, data.data + *pos, sizeof(fileTime));
+	*pos += sizeof(fileTime);
+	*size = (size_lt)fileSize;
+	*modTime = (time_t)fileTime;
+	return true;
+}
+
+DirIndex::DirIndex(const char *root) : _root(root), _size(0), _journalOpened(false), _journalRecords(0), _rebuilt(false)
+{
+	while (_root.size() > 1 && (_root.back() == '/' || _root.back() == PATH_SEPARATOR))
+	{
+		_root.pop_back();
+	}
+	_snapshotName = _root + PATH_SEPARATOR + DIRINDEX_FILE_NAME;
+	_journalName = _root + PATH_SEPARATOR + DIRINDEX_JOURNAL_NAME;
+}
+
+DirIndex::~DirIndex()
+{
+	if (_journalOpened)
+	{
+		_journal.Close();
+	}
+}
+
+void DirIndex::Open()
+{
+	if (!Load())
+	{
+		Build();
+	}
+}
+
+void DirIndex::Build()
+{
+	std::vector<Entry> found;
+	std::mutex foundMutex;
+	Dir::Walk(_root.c_str(), [&found, &foundMutex](const DirEntry &entry)
+	{
+		if (entry.directory || (entry.dirPath[0] == '\0' && IsIndexFile(entry.name)))
+		{
+			return;
+		}
+
+		Entry file;
+		file.path = entry.dirPath;
+		if (!file.path.empty())
+		{
+			file.path += PATH_SEPARATOR;
+		}
+		file.path += entry.name;
+		file.size = entry.size;
+		file.modTime = entry.modTime;
+
+		std::lock_guard<std::mutex> guard(foundMutex);
+		found.push_back(std::move(file));
+	});
+
+	std::lock_guard<std::mutex> guard(_mutex);
+	Clear();
+	_entries.reserve(found.size());
+	for (size_lt i = 0; i < found.size(); i++)
+	{
+		Put(found[i].path, found[i].size, found[i].modTime);
+	}
+	SaveLocked();
+	Publish();
+}
+
+bool DirIndex::Load()
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	if (!File::Exist(_snapshotName.c_str()))
+	{
+		return false;
+	}
+
+	Clear();
+	if (!ReadSnapshot())
+	{
+		// The damaged or foreign snapshot is rebuilt from the tree
+		Clear();
+		return false;
+	}
+
+	ReplayJournal();
+	Publish();
+	return true;
+}
+
+bool DirIndex::ReadSnapshot()
+{
+	File snapshot;
+	snapshot.Open(_snapshotName.c_str(), MAPPED);
+	ByteSpan data = snapshot.GetView();
+
+	unsigned long long magic;
+	unsigned int version;
+	unsigned long long count;
+	size_lt pos = sizeof(magic) + sizeof(version) + sizeof(count);
+	if (data.size < pos)
+	{
+		return false;
+	}
+	memcpy(&magic, data.data, sizeof(magic));
+	memcpy(&version, data.data + sizeof(magic), sizeof(version));
+	memcpy(&count, data.data + sizeof(magic) + sizeof(version), sizeof(count));
+	// Every record takes more than a byte: the count beyond the size is garbage
+	if (magic != DIRINDEX_MAGIC || version != DIRINDEX_VERSION || count > data.size)
+	{
+		return false;
+	}
+
+	_entries.reserve((size_lt)count);
+	std::string path;
+	size_lt size;
+	time_t modTime;
+	for (unsigned long long i = 0; i < count; i++)
+	{
+		if (!GetRecord(data, &pos, &path, &size, &modTime))
+		{
+			return false;
+		}
+		Put(path, size, modTime);
+	}
+	return true;
+}
+
+void DirIndex::ReplayJournal()
+{
+	_journalRecords = 0;
+	if (!File::Exist(_journalName.c_str()) || File::FileSize(_journalName.c_str()) == 0)
+	{
+		return;
+	}
+
+	bool torn = false;
+	{
+		File journal;
+		journal.Open(_journalName.c_str(), MAPPED);
+		ByteSpan data = journal.GetView();
+		size_lt pos = 0;
+		std::string path;
+		size_lt size;
+		time_t modTime;
+		while (pos < data.size)
+		{
+			byte operation = data.data[pos++];
+			if (!GetRecord(data, &pos, &path, &size, &modTime))
+			{
+				// Torn by the crash during the append
+				torn = true;
+				break;
+			}
+
+			if (operation == DIRINDEXUPDATE)
+			{
+				Put(path, size, modTime);
+			}
+			else if (operation == DIRINDEXREMOVE)
+			{
+				Erase(path);
+			}
+			else if (operation == DIRINDEXREMOVEDIR)
+			{
+				EraseDir(path);
+			}
+			_journalRecords++;
+		}
+	}
+
+	// The records appended after the garbage would be lost on the next replay
+	if (torn)
+	{
+		SaveLocked();
+	}
+}
+
+void DirIndex::Save()
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	SaveLocked();
+}
+
+void DirIndex::SaveLocked()
+{
+	std::vector<byte> out;
+	unsigned long long magic = DIRINDEX_MAGIC;
+	unsigned int version = DIRINDEX_VERSION;
+	unsigned long long count = _byPath.size();
+	out.insert(out.end(), (byte*)&magic, (byte*)&magic + sizeof(magic));
+	out.insert(out.end(), (byte*)&version, (byte*)&version + sizeof(version));
+	out.insert(out.end(), (byte*)&count, (byte*)&count + sizeof(count));
+	for (size_lt i = 0; i < _entries.size(); i++)
+	{
+		if (!_entries[i].path.empty())
+		{
+			PutRecord(out, _entries[i].path, _entries[i].size, _entries[i].modTime);
+		}
+	}
+
+	// The new snapshot replaces the old one only when it is on the disk: the journal goes next
+	File::ReplaceAllBytes(_snapshotName.c_str(), out.data(), out.size());
+
+	if (_journalOpened)
+	{
+		_journal.Close();
+		_journalOpened = false;
+	}
+	if (File::Exist(_journalName.c_str()))
+	{
+		File::Delete(_journalName.c_str());
+	}
+	_journalRecords = 0;
+}
+
+void DirIndex::Update(const char *path, size_lt size, time_t modTime)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	Put(path, size, modTime);
+	Journal(DIRINDEXUPDATE, path, size, modTime);
+	Publish();
+}
+
+void DirIndex::Remove(const char *path)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	Erase(path);
+	Journal(DIRINDEXREMOVE, path, 0, 0);
+	Publish();
+}
+
+void DirIndex::RemoveDir(const char *path)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	EraseDir(path);
+	Journal(DIRINDEXREMOVEDIR, path, 0, 0);
+	Publish();
+}
+
+void DirIndex::OnDirChange(const DirChange &change)
+{
+	if (change.type == DIRCHANGEOVERFLOW)
+	{
+		Build();
+		return;
+	}
+	if (IsIndexFile(change.path))
+	{
+		return;
+	}
+
+	if (change.type == DIRCHANGEREMOVED)
+	{
+		// The entry of the unknown kind is reported as the directory (see DirChange)
+		if (change.directory)
+		{
+			RemoveDir(change.path);
+		}
+		else
+		{
+			Remove(change.path);
+		}
+	}
+	else if (!change.directory)
+	{
+		Update(change.path, change.size, change.modTime);
+	}
+	else if (change.type == DIRCHANGEADDED)
+	{
+		// Moved in with the contents or filled before it was watched
+		std::string prefix = change.path;
+		std::vector<Entry> found;
+		std::mutex foundMutex;
+		Dir::Walk((_root + PATH_SEPARATOR + prefix).c_str(), [&found, &foundMutex, &prefix](const DirEntry &entry)
+		{
+			if (entry.directory)
+			{
+				return;
+			}
+
+			Entry file;
+			file.path = prefix + PATH_SEPARATOR;
+			if (entry.dirPath[0] != '\0')
+			{
+				file.path += entry.dirPath;
+				file.path += PATH_SEPARATOR;
+			}
+			file.path += entry.name;
+			file.size = entry.size;
+			file.modTime = entry.modTime;
+
+			std::lock_guard<std::mutex> guard(foundMutex);
+			found.push_back(std::move(file));
+		});
+
+		// One publication for the whole directory
+		std::lock_guard<std::mutex> guard(_mutex);
+		for (size_lt i = 0; i < found.size(); i++)
+		{
+			Put(found[i].path, found[i].size, found[i].modTime);
+			Journal(DIRINDEXUPDATE, found[i].path, found[i].size, found[i].modTime);
+		}
+		Publish();
+	}
+}
+
+void DirIndex::Journal(DirIndexOperation operation, const std::string &path, size_lt size, time_t modTime)
+{
+	if (_journalRecords >= DIRINDEX_JOURNAL_MIN && _journalRecords >= _byPath.size())
+	{
+		SaveLocked();
+		return;
+	}
+
+	if (!_journalOpened)
+	{
+		_journal.Open(_journalName.c_str(), WRITEATTHEEND);
+		_journalOpened = true;
+	}
+
+	std::vector<byte> out;
+	out.push_back((byte)operation);
+	PutRecord(out, path, size, modTime);
+	_journal.WriteBlock(out.data(), out.size());
+	_journal.Flush();
+	_journalRecords++;
+}
+
+bool DirIndex::Find(const char *path, size_lt *size, time_t *modTime)
+{
+	std::string key = path;
+	MSIYBCore::EpochGuard guard;
+	ViewTable *table = _view.Get();
+	if (!table)
+	{
+		return false;
+	}
+	View *view = table->shards[GetShard(key, table->shards.size())].Get();
+	if (!view)
+	{
+		return false;
+	}
+	auto found = view->find(key);
+	if (found == view->end())
+	{
+		return false;
+	}
+	*size = found->second.size;
+	*modTime = found->second.modTime;
+	return true;
+}
+
+vector<string> DirIndex::SearchName(const char *name)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	vector<string> result;
+	auto found = _byName.find(name);
+	if (found != _byName.end())
+	{
+		for (size_lt i = 0; i < found->second.size(); i++)
+		{
+			result.push_back(FullPath(found->second[i]));
+		}
+	}
+	return result;
+}
+
+vector<string> DirIndex::SearchExt(const char *extension)
+{
+	std::string ext = extension;
+	if (!ext.empty() && ext[0] == '.')
+	{
+		ext.erase(0, 1);
+	}
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+	std::lock_guard<std::mutex> guard(_mutex);
+	vector<string> result;
+	auto found = _byExt.find(ext);
+	if (found != _byExt.end())
+	{
+		for (size_lt i = 0; i < found->second.size(); i++)
+		{
+			result.push_back(FullPath(found->second[i]));
+		}
+	}
+	return result;
+}
+
+vector<string> DirIndex::SearchTime(time_t from, time_t to)
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	vector<string> result;
+	for (auto it = _byTime.lower_bound(from); it != _byTime.end() && it->first <= to; ++it)
+	{
+		result.push_back(FullPath(it->second));
+	}
+	return result;
+}
+
+size_lt DirIndex::GetCount()
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	return _byPath.size();
+}
+
+size_lt DirIndex::GetSize()
+{
+	std::lock_guard<std::mutex> guard(_mutex);
+	return _size;
+}
+
+void DirIndex::Clear()
+{
+	_entries.clear();
+	_free.clear();
+	_byPath.clear();
+	_byName.clear();
+	_byExt.clear();
+	_byTime.clear();
+	_size = 0;
+	_changed.clear();
+	_rebuilt = true;
+}
+
+void DirIndex::Put(const std::string &path, size_lt size, time_t modTime)
+{
+	if (!_rebuilt)
+	{
+		_changed.push_back(path);
+	}
+
+	auto found = _byPath.find(path);
+	if (found != _byPath.end())
+	{
+		Entry &entry = _entries[found->second];
+		_size = _size - entry.size + size;
+		entry.size = size;
+		if (entry.modTime != modTime)
+		{
+			auto range = _byTime.equal_range(entry.modTime);
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				if (it->second == found->second)
+				{
+					_byTime.erase(it);
+					break;
+				}
+			}
+			entry.modTime = modTime;
+			_byTime.insert(std::make_pair(modTime, found->second));
+		}
+		return;
+	}
+
+	size_lt index;
+	if (_free.empty())
+	{
+		index = _entries.size();
+		_entries.push_back(Entry());
+	}
+	else
+	{
+		index = _free.back();
+		_free.pop_back();
+	}
+
+	Entry &entry = _entries[index];
+	entry.path = path;
+	entry.size = size;
+	entry.modTime = modTime;
+	_size += size;
+	_byPath[path] = index;
+	_byName[GetName(path)].push_back(index);
+	_byExt[GetExt(path)].push_back(index);
+	_byTime.insert(std::make_pair(modTime, index));
+}
+
+void DirIndex::Erase(const std::string &path)
+{
+	auto found = _byPath.find(path);
+	if (found == _byPath.end())
+	{
+		return;
+	}
+
+	if (!_rebuilt)
+	{
+		_changed.push_back(path);
+	}
+
+	size_lt index = found->second;
+	Entry &entry = _entries[index];
+	EraseIndex(_byName, GetName(path), index);
+	EraseIndex(_byExt, GetExt(path), index);
+	auto range = _byTime.equal_range(entry.modTime);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == index)
+		{
+			_byTime.erase(it);
+			break;
+		}
+	}
+	_size -= entry.size;
+	_byPath.erase(found);
+
+	entry.path.clear();
+	entry.size = 0;
+	_free.push_back(index);
+}
+
+void DirIndex::EraseDir(const std::string &path)
+{
+	std::string prefix = path + PATH_SEPARATOR;
+	std::vector<std::string> paths;
+	paths.push_back(path);
+	for (auto it = _byPath.lower_bound(prefix); it != _byPath.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+	{
+		paths.push_back(it->first);
+	}
+
+	for (size_lt i = 0; i < paths.size(); i++)
+	{
+		Erase(paths[i]);
+	}
+}
+
+void DirIndex::Publish()
+{
+	ViewTable *table = _view.Get();
+	size_lt count = _byPath.size();
+	if (_rebuilt || !table || count > table->shards.size() * DIRINDEX_VIEW_SHARD_SIZE)
+	{
+		// The parts are doubled with the index, so the copy of the whole view is paid once per doubling
+		size_lt shards = DIRINDEX_VIEW_SHARDS;
+		while (count > shards * DIRINDEX_VIEW_SHARD_SIZE)
+		{
+			shards *= 2;
+		}
+		std::vector<View*> views(shards);
+		for (size_lt i = 0; i < shards; i++)
+		{
+			views[i] = new View();
+		}
+		for (auto it = _byPath.begin(); it != _byPath.end(); ++it)
+		{
+			Entry &entry = _entries[it->second];
+			ViewEntry &viewEntry = (*views[GetShard(it->first, shards)])[it->first];
+			viewEntry.size = entry.size;
+			viewEntry.modTime = entry.modTime;
+		}
+		table = new ViewTable(shards);
+		for (size_lt i = 0; i < shards; i++)
+		{
+			table->shards[i].Publish(views[i]);
+		}
+		// The old parts are retired with the old table
+		_view.Publish(table);
+		_rebuilt = false;
+	}
+	else if (!_changed.empty())
+	{
+		// Only the parts with the changes are copied, each once
+		std::map<size_lt, View*> views;
+		for (size_lt i = 0; i < _changed.size(); i++)
+		{
+			const std::string &path = _changed[i];
+			size_lt shard = GetShard(path, table->shards.size());
+			View *&view = views[shard];
+			if (!view)
+			{
+				View *current = table->shards[shard].Get();
+				view = current ? new View(*current) : new View();
+			}
+
+			auto found = _byPath.find(path);
+			if (found == _byPath.end())
+			{
+				view->erase(path);
+			}
+			else
+			{
+				ViewEntry &viewEntry = (*view)[path];
+				viewEntry.size = _entries[found->second].size;
+				viewEntry.modTime = _entries[found->second].modTime;
+			}
+		}
+		for (auto it = views.begin(); it != views.end(); ++it)
+		{
+			table->shards[it->first].Publish(it->second);
+		}
+	}
+	_changed.clear();
+}
+
+size_lt DirIndex::GetShard(const std::string &path, size_lt count)
+{
+	return std::hash<std::string>()(path) % count;
+}
+
+bool DirIndex::IsIndexFile(const char *path)
+{
+	return strncmp(path, DIRINDEX_FILE_NAME, strlen(DIRINDEX_FILE_NAME)) == 0 || strcmp(path, DIRINDEX_JOURNAL_NAME) == 0;
+}
+
+void DirIndex::EraseIndex(std::unordered_map<std::string, std::vector<size_lt> > &map, const std::string &key, size_lt index)
+{
+	auto found = map.find(key);
+	if (found == map.end())
+	{
+		return;
+	}
+
+	std::vector<size_lt> &indexes = found->second;
+	for (size_lt i = 0; i < indexes.size(); i++)
+	{
+		if (indexes[i] == index)
+		{
+			indexes[i] = indexes.back();
+			indexes.pop_back();
+			break;
+		}
+	}
+	if (indexes.empty())
+	{
+		map.erase(found);
+	}
+}
+
+std::string DirIndex::FullPath(size_lt index)
+{
+	return _root + PATH_SEPARATOR + _entries[index].path;
+}
+
+std::string DirIndex::GetName(const std::string &path)
+{
+	size_lt separator = path.find_last_of(PATH_SEPARATOR);
+	return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+std::string DirIndex::GetExt(const std::string &path)
+{
+	std::string name = GetName(path);
+	size_lt dot = name.find_last_of('.');
+	if (dot == std::string::npos || dot == 0)
+	{
+		return std::string();
+	}
+
+	std::string ext = name.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext;
+}
@@ -0,0 +1,274 @@
+/*!
+\file dirindex.h "server\desktop\src\common\dirindex.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 11 September 2017
+*/
+
+#pragma once
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "dir.h"
+#include "epoch.h"
+#include "../cross/idirwatcher.h"
+
+#define DIRINDEX_MAGIC 0x584449425949534DULL	///< "MSIYBIDX" stamp of the snapshot
+#define DIRINDEX_VERSION 1
+#define DIRINDEX_JOURNAL_MIN 1024				///< The journal is never compacted before this number of the records
+#define DIRINDEX_VIEW_SHARDS 64				///< The least number of the parts of the lookup view copied separately on the change
+#define DIRINDEX_VIEW_SHARD_SIZE 64			///< The average number of the files in the part after which the parts are doubled
+
+/// The operations recorded in the journal
+typedef enum DirIndexOperation_
+{
+	DIRINDEXUPDATE = 1,		///< The file is added or changed
+	DIRINDEXREMOVE = 2,		///< The file is removed
+	DIRINDEXREMOVEDIR = 3	///< All the files under the directory are removed
+} DirIndexOperation;
+
+/*!
+\class DirIndex dirindex.h "server\desktop\src\common\dirindex.h"
+\brief  The persistent metadata index of the directory tree.
+Keeps the path, size and modification time of every file with the hash lookups by the name
+and the extension and the ordered lookup by the time, so the searches never scan the disk.
+Is stored in the root as the snapshot (DIRINDEX_FILE_NAME) and the journal of the changes made
+after it (DIRINDEX_JOURNAL_NAME). The journal is folded into the snapshot when it outgrows the index.
+All the methods may be called from many threads. Find takes no lock: it reads the immutable view
+of the metadata by the path, each change publishes the new copy of the part of the view it touched.
+The number of the parts grows with the index, so the change copies about DIRINDEX_VIEW_SHARD_SIZE files
+whatever the size of the index (the whole view is copied when the index doubles).
+Is kept up to date by DirWatcher through OnDirChange.
+*/
+class DirIndex : public IDirWatcherHandler
+{
+public:
+	/*!
+	\param[in] root The indexed directory.
+	*/
+	DirIndex(const char *root);
+
+	/*!
+	Closes the journal.
+	*/
+	~DirIndex();
+
+	/*!
+	Loads the stored index or builds and stores it if there is none.
+	*/
+	void Open();
+
+	/*!
+	Walks the tree, replaces the index and stores it.
+	*/
+	void Build();
+
+	/*!
+	Reads the snapshot and replays the journal. A torn record at the end of the journal is dropped
+	and the index is stored again, so the journal is appended after the valid records.
+	\return FALSE if there is no stored index or it is damaged.
+	*/
+	bool Load();
+
+	/*!
+	Writes the snapshot and clears the journal.
+	*/
+	void Save();
+
+	/*!
+	Adds the file or changes its metadata. The change is journaled.
+	\param[in] path The path of the file relative to the root.
+	\param[in] size The size of the file.
+	\param[in] modTime The time of the last modification.
+	*/
+	void Update(const char *path, size_lt size, time_t modTime);
+
+	/*!
+	Removes the file. The change is journaled.
+	\param[in] path The path of the file relative to the root.
+	*/
+	void Remove(const char *path);
+
+	/*!
+	Removes the entry and all the files under it. The change is journaled.
+	Costs O(k log n) for the k files under the directory.
+	\param[in] path The path of the directory (or the entry of the unknown kind) relative to the root.
+	*/
+	void RemoveDir(const char *path);
+
+	/*!
+	Applies the change reported by the watcher. The added directories are walked,
+	the overflow rebuilds the index.
+	\param[in] change The change.
+	*/
+	virtual void OnDirChange(const DirChange &change) override;
+
+	/*!
+	Looks up the metadata of the file without the locks. The result may miss the change being made at the same time.
+	\param[in] path The path of the file relative to the root.
+	\param[out] size The size of the file.
+	\param[out] modTime The time of the last modification.
+	\return FALSE if the file isn't indexed.
+	*/
+	bool Find(const char *path, size_lt *size, time_t *modTime);
+
+	/*!
+	\param[in] name The name of the file.
+	\return The full paths of the files with the name.
+	*/
+	vector<string> SearchName(const char *name);
+
+	/*!
+	\param[in] extension The extension without the dot, case-insensitive.
+	\return The full paths of the files with the extension.
+	*/
+	vector<string> SearchExt(const char *extension);
+
+	/*!
+	\param[in] from The earliest modification time.
+	\param[in] to The latest modification time.
+	\return The full paths of the files modified within the range, the oldest first.
+	*/
+	vector<string> SearchTime(time_t from, time_t to);
+
+	/*!
+	\return The number of the indexed files.
+	*/
+	size_lt GetCount();
+
+	/*!
+	\return The total size of the indexed files.
+	*/
+	size_lt GetSize();
+
+	/*!
+	\param[in] path The path relative to the root.
+	\return TRUE if the path is one of the files of the index itself.
+	*/
+	static bool IsIndexFile(const char *path);
+
+private:
+	/// The indexed file
+	typedef struct Entry_
+	{
+		std::string path;	///< The path relative to the root, empty for the free slots
+		size_lt size;		///< The size of the file
+		time_t modTime;		///< The time of the last modification
+	} Entry;
+
+	/// The metadata of the file in the lookup view
+	typedef struct ViewEntry_
+	{
+		size_lt size;		///< The size of the file
+		time_t modTime;		///< The time of the last modification
+	} ViewEntry;
+
+	/// The part of the lookup view: the files by the relative path, never changed after the publication
+	typedef std::unordered_map<std::string, ViewEntry> View;
+
+	/// The lookup view: the parts by the hash of the path, their number is never changed after the publication
+	typedef struct ViewTable_
+	{
+		ViewTable_(size_lt count) : shards(count)
+		{
+
+		}
+
+		std::vector<MSIYBCore::RcuPointer<View> > shards;	///< The parts, published again one by one on the changes
+	} ViewTable;
+
+	/*!
+	Drops all the entries.
+	*/
+	void Clear();
+
+	/*!
+	Adds or changes the entry without journaling.
+	*/
+	void Put(const std::string &path, size_lt size, time_t modTime);
+
+	/*!
+	Removes the entry without journaling.
+	*/
+	void Erase(const std::string &path);
+
+	/*!
+	Removes the entry and the entries under it without journaling.
+	*/
+	void EraseDir(const std::string &path);
+
+	/*!
+	Publishes the new copies of the parts of the view changed since the last publication. The lock must be held.
+	*/
+	void Publish();
+
+	/*!
+	\param[in] path The relative path.
+	\param[in] count The number of the parts of the view.
+	\return The part of the view holding the path.
+	*/
+	static size_lt GetShard(const std::string &path, size_lt count);
+
+	/*!
+	Appends the record to the journal and folds the journal if it outgrew the index.
+	*/
+	void Journal(DirIndexOperation operation, const std::string &path, size_lt size, time_t modTime);
+
+	/*!
+	Writes the snapshot and clears the journal. The lock must be held.
+	*/
+	void SaveLocked();
+
+	/*!
+	Reads the entries of the snapshot. The lock must be held.
+	\return FALSE if the snapshot is damaged or has unknown format.
+	*/
+	bool ReadSnapshot();
+
+	/*!
+	Replays the journal. The lock must be held.
+	*/
+	void ReplayJournal();
+
+	/*!
+	\return The full path of the entry.
+	*/
+	std::string FullPath(size_lt index);
+
+	/*!
+	\return The name of the file in the path.
+	*/
+	static std::string GetName(const std::string &path);
+
+	/*!
+	\return The lower-case extension of the file in the path without the dot.
+	*/
+	static std::string GetExt(const std::string &path);
+
+	/*!
+	Removes the value from the list of the indexes.
+	*/
+	static void EraseIndex(std::unordered_map<std::string, std::vector<size_lt> > &map, const std::string &key, size_lt index);
+
+	std::string _root;											///< The indexed directory
+	std::string _snapshotName;									///< The full name of the snapshot
+	std::string _journalName;									///< The full name of the journal
+	std::vector<Entry> _entries;								///< The files
+	std::vector<size_lt> _free;									///< The free slots of _entries
+	std::map<std::string, size_lt> _byPath;					///< The files ordered by the relative path, the files of a directory are adjacent
+	std::unordered_map<std::string, std::vector<size_lt> > _byName;	///< The files by the name
+	std::unordered_map<std::string, std::vector<size_lt> > _byExt;	///< The files by the extension
+	std::multimap<time_t, size_lt> _byTime;						///< The files ordered by the modification time
+	size_lt _size;												///< The total size of the files
+	File _journal;												///< The journal opened for the appending
+	bool _journalOpened;										///< TRUE after the first change
+	size_lt _journalRecords;									///< The number of the records in the journal
+	std::mutex _mutex;											///< Guards the index
+	MSIYBCore::RcuPointer<ViewTable> _view;						///< The lookup view read by Find
+	std::vector<std::string> _changed;							///< The paths changed since the last publication
+	bool _rebuilt;												///< TRUE if the whole view has to be published again
+};
@@ -0,0 +1,92 @@
+#include "dirwalk.h"
+
+using MSIYBCore::DirWalk;
+using MSIYBCore::ThreadPool;
+
+DirWalk::DirWalk(const Scanner &scanner, const DirVisitor &visitor, bool withSizes, ThreadPool *pool) :
+	_scanner(scanner), _visitor(visitor), _withSizes(withSizes), _pool(pool ? *pool : GetPool()),
+	_size(0), _files(0), _dirs(0), _pending(0), _error(0), _done(false)
+{
+}
+
+DirStats DirWalk::Run()
+{
+	Enqueue(std::string());
+
+	{
+		std::unique_lock<std::mutex> guard(_doneMutex);
+		_doneCondition.wait(guard, [this]() { return _done; });
+	}
+
+	if (_error != 0)
+	{
+		ThrowDirExceptionWithCode("Can't read the directory!", _error);
+	}
+
+	DirStats stats;
+	stats.size = _size;
+	stats.files = _files;
+	stats.dirs = _dirs;
+	return stats;
+}
+
+void DirWalk::Enqueue(const std::string &path)
+{
+	// Counted before the task is queued, so the counter can't drop to zero while the tree is being read
+	_pending++;
+	_pool.Execute([this, path]() { Scan(path); });
+}
+
+void DirWalk::Scan(const std::string &path)
+{
+	try
+	{
+		_scanner(*this, path);
+	}
+	catch (std::exception &)
+	{
+		SetError(-1);
+	}
+
+	if (--_pending == 0)
+	{
+		// Notified under the lock: Run can't return and destroy the walk before the worker leaves it
+		std::lock_guard<std::mutex> guard(_doneMutex);
+		_done = true;
+		_doneCondition.notify_all();
+	}
+}
+
+void DirWalk::Add(const DirStats &stats)
+{
+	_size += stats.size;
+	_files += stats.files;
+	_dirs += stats.dirs;
+}
+
+void DirWalk::Visit(const DirEntry &entry)
+{
+	_visitor(entry);
+}
+
+void DirWalk::SetError(long code)
+{
+	long expected = 0;
+	_error.compare_exchange_strong(expected, code);
+}
+
+bool DirWalk::IsVisiting()
+{
+	return (bool)_visitor;
+}
+
+bool DirWalk::IsWithSizes()
+{
+	return _withSizes;
+}
+
+ThreadPool& DirWalk::GetPool()
+{
+	static ThreadPool pool;
+	return pool;
+}
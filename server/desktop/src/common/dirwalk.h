@@ -0,0 +1,113 @@
+/*!
+\file dirwalk.h "server\desktop\src\common\dirwalk.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 08 September 2017
+*/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include "threadpool.h"
+#include "../cross/idir.h"
+
+namespace MSIYBCore
+{
+	/*!
+	\class DirWalk dirwalk.h "server\desktop\src\common\dirwalk.h"
+	\brief  The parallel traversal of the directory tree.
+	Every directory is a task of the pool: the OS-dependent scanner reads it,
+	queues the subdirectories back and adds the totals of its files.
+	No thread is created per directory, the recursion spreads over the workers by stealing.
+	*/
+	class DirWalk
+	{
+	public:
+		/*!
+		Reads one directory. Calls Enqueue for the subdirectories and Add for the totals.
+		\param[in] walk The walk the directory belongs to.
+		\param[in] path The path of the directory relative to the root ("" for the root).
+		*/
+		typedef std::function<void(DirWalk &walk, const std::string &path)> Scanner;
+
+		/*!
+		\param[in] scanner The OS-dependent reader of the directories.
+		\param[in] visitor Receives every entry. May be empty.
+		\param[in] withSizes FALSE if only the numbers of the entries are needed (the files are not stat-ed).
+		\param[in] pool The pool to run the scanners on. NULL means GetPool().
+		*/
+		DirWalk(const Scanner &scanner, const DirVisitor &visitor = DirVisitor(), bool withSizes = true, ThreadPool *pool = NULL);
+
+		/*!
+		Walks the tree and waits for all the directories to be read.
+		Throws DirException with the first error met (the entries removed during the walk are skipped).
+		\return The totals of the tree.
+		*/
+		DirStats Run();
+
+		/*!
+		Queues the subdirectory to be read.
+		\param[in] path The path of the subdirectory relative to the root.
+		*/
+		void Enqueue(const std::string &path);
+
+		/*!
+		Adds the totals of one directory.
+		\param[in] stats The totals.
+		*/
+		void Add(const DirStats &stats);
+
+		/*!
+		Passes the entry to the visitor.
+		\param[in] entry The entry.
+		*/
+		void Visit(const DirEntry &entry);
+
+		/*!
+		Remembers the error. Only the first one is reported by Run.
+		\param[in] code The OS error code.
+		*/
+		void SetError(long code);
+
+		/*!
+		\return TRUE if there is a visitor to be called.
+		*/
+		bool IsVisiting();
+
+		/*!
+		\return TRUE if the sizes of the files are needed.
+		*/
+		bool IsWithSizes();
+
+		/*!
+		\return The pool shared by the directory walks. Is not used for anything else,
+		so a walk started from a worker of another pool never waits for itself.
+		*/
+		static ThreadPool& GetPool();
+
+	private:
+		/*!
+		Reads the directory and marks it done.
+		\param[in] path The path of the directory relative to the root.
+		*/
+		void Scan(const std::string &path);
+
+		Scanner _scanner;					///< The OS-dependent reader of the directories
+		DirVisitor _visitor;				///< Receives every entry
+		bool _withSizes;					///< The sizes of the files are needed
+		ThreadPool &_pool;					///< Runs the scanners
+		std::atomic<size_lt> _size;			///< The size of the files read so far
+		std::atomic<size_lt> _files;		///< The number of the files read so far
+		std::atomic<size_lt> _dirs;			///< The number of the directories read so far
+		std::atomic<size_lt> _pending;		///< The number of the directories queued and not read yet
+		std::atomic<long> _error;			///< The first error met
+		bool _done;							///< All the directories are read
+		std::mutex _doneMutex;				///< Guards _done
+		std::condition_variable _doneCondition;	///< Signalled when the last directory is read
+	};
+
+}
@@ -0,0 +1,25 @@
+#include "dirwatcher.h"
+
+DirWatcher::DirWatcher()
+{
+	watcher = new OSDirWatcher();
+	if (!watcher)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+}
+
+DirWatcher::~DirWatcher()
+{
+	delete watcher;
+}
+
+void DirWatcher::Start(const char *path, IDirWatcherHandler *handler)
+{
+	watcher->Start(path, handler);
+}
+
+void DirWatcher::Stop()
+{
+	watcher->Stop();
+}
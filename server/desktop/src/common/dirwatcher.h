@@ -0,0 +1,19 @@
+#pragma once
+#include "../cross/idirwatcher.h"
+#ifdef _WIN32
+#include "../cross/windows/windirwatcher.h"
+typedef WinDirWatcher OSDirWatcher;
+#elif __unix__
+#include "../cross/unix/unixdirwatcher.h"
+typedef UnixDirWatcher OSDirWatcher;
+#endif
+
+class DirWatcher : public IDirWatcher
+{
+	IDirWatcher *watcher;
+public:
+	DirWatcher();
+	~DirWatcher();
+	void Start(const char *path, IDirWatcherHandler *handler);
+	void Stop();
+};
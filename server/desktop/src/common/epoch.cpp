@@ -0,0 +1,242 @@
+#include "epoch.h"
+#include <vector>
+#include "adaptivelock.h"
+#include "futex.h"
+#include "locker.h"
+#include "thread.h"
+
+using MSIYBCore::Epoch;
+using MSIYBCore::EpochRecord;
+using MSIYBCore::EpochRetired;
+using MSIYBCore::AdaptiveLock;
+using MSIYBCore::EventCount;
+using MSIYBCore::Locker;
+
+std::atomic<unsigned long long> Epoch::_epoch(1);
+std::atomic<EpochRecord*> Epoch::_records(NULL);
+
+/// The retired objects and the background thread
+typedef struct EpochReclaimer_
+{
+	EpochReclaimer_() : lock("epoch"), thread(NULL), stopping(false), interval(EPOCH_RECLAIM_INTERVAL)
+	{
+
+	}
+
+	AdaptiveLock lock;					///< Guards the retired objects
+	std::vector<EpochRetired> retired;	///< The objects waiting to be freed
+	Thread *thread;						///< The background thread or NULL
+	std::atomic<bool> stopping;			///< TRUE when the background thread has to stop
+	EventCount wakeUp;					///< Wakes up the background thread to stop it
+	unsigned long interval;				///< The milliseconds between the background reclaims
+} EpochReclaimer;
+
+/*!
+\return The reclaimer. Created on the first use and never destroyed:
+the static objects may retire their data in the destructors.
+*/
+static EpochReclaimer& GetReclaimer()
+{
+	static EpochReclaimer *reclaimer = new EpochReclaimer();
+	return *reclaimer;
+}
+
+namespace MSIYBCore
+{
+	/*!
+	\class EpochThread
+	\brief  Holds the record of the thread and gives it back when the thread exits.
+	*/
+	class EpochThread
+	{
+	public:
+		EpochThread()
+		{
+			record = Epoch::TakeRecord();
+		}
+
+		~EpochThread()
+		{
+			record->nesting = 0;
+			record->state.store(0, std::memory_order_release);
+			record->used.store(false, std::memory_order_release);
+		}
+
+		EpochRecord *record;	///< The record of the thread
+	};
+}
+
+void Epoch::Enter()
+{
+	EpochRecord *record = GetRecord();
+	if (record->nesting++ == 0)
+	{
+		// Announced before the shared pointers are read: the reclaimer either sees the reader
+		// or the reader sees the pointers published after the unlinking of the retired objects
+		// (the exchange is the full barrier, cheaper than the store and the fence)
+		record->state.exchange((_epoch.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_seq_cst);
+	}
+}
+
+void Epoch::Exit()
+{
+	EpochRecord *record = GetRecord();
+	if (--record->nesting == 0)
+	{
+		record->state.store(0, std::memory_order_release);
+	}
+}
+
+void Epoch::Retire(void *object, void(*destroy)(void *object))
+{
+	EpochReclaimer &reclaimer = GetReclaimer();
+	EpochRetired retired;
+	retired.object = object;
+	retired.destroy = destroy;
+	bool reclaim;
+	{
+		Locker locker(reclaimer.lock);
+		// Read after the object was unlinked: the readers of the later epochs can't find it
+		retired.epoch = _epoch.load();
+		reclaimer.retired.push_back(retired);
+		reclaim = !reclaimer.thread && reclaimer.retired.size() % EPOCH_RETIRE_THRESHOLD == 0;
+	}
+	if (reclaim)
+	{
+		Reclaim();
+	}
+}
+
+size_lt Epoch::Reclaim()
+{
+	unsigned long long epoch = _epoch.load();
+	bool advance = true;
+	for (EpochRecord *record = _records.load(); record; record = record->next)
+	{
+		unsigned long long state = record->state.load();
+		if ((state & 1) && (state >> 1) != epoch)
+		{
+			advance = false;
+			break;
+		}
+	}
+	if (advance)
+	{
+		// Every reader inside has seen the epoch: the readers of the next one can't see its retired objects
+		_epoch.compare_exchange_strong(epoch, epoch + 1);
+		epoch = _epoch.load();
+	}
+
+	EpochReclaimer &reclaimer = GetReclaimer();
+	std::vector<EpochRetired> ready;
+	{
+		Locker locker(reclaimer.lock);
+		size_lt kept = 0;
+		for (size_lt i = 0; i < reclaimer.retired.size(); i++)
+		{
+			if (reclaimer.retired[i].epoch + 2 <= epoch)
+			{
+				ready.push_back(reclaimer.retired[i]);
+			}
+			else
+			{
+				reclaimer.retired[kept++] = reclaimer.retired[i];
+			}
+		}
+		reclaimer.retired.resize(kept);
+	}
+
+	// Out of the lock: the destructors may retire too
+	for (size_lt i = 0; i < ready.size(); i++)
+	{
+		ready[i].destroy(ready[i].object);
+	}
+	return ready.size();
+}
+
+/*!
+The thread function of the background reclaimer.
+\param[in] args The reclaimer.
+*/
+static THREADFUNC ReclaimFunc(void *args)
+{
+	EpochReclaimer &reclaimer = *(EpochReclaimer*)args;
+	while (!reclaimer.stopping)
+	{
+		int key = reclaimer.wakeUp.PrepareWait();
+		if (reclaimer.stopping)
+		{
+			reclaimer.wakeUp.CancelWait();
+			break;
+		}
+		reclaimer.wakeUp.Wait(key, reclaimer.interval);
+		Epoch::Reclaim();
+	}
+	return 0;
+}
+
+void Epoch::StartReclaimer(unsigned long interval)
+{
+	EpochReclaimer &reclaimer = GetReclaimer();
+	if (reclaimer.thread)
+	{
+		return;
+	}
+	reclaimer.interval = interval;
+	reclaimer.stopping = false;
+	reclaimer.thread = new Thread();
+	reclaimer.thread->SetName("epoch");
+	reclaimer.thread->Start((void*)&ReclaimFunc, &reclaimer);
+}
+
+void Epoch::StopReclaimer()
+{
+	EpochReclaimer &reclaimer = GetReclaimer();
+	if (reclaimer.thread)
+	{
+		reclaimer.stopping = true;
+		reclaimer.wakeUp.NotifyAll();
+		reclaimer.thread->WaitToComplete();
+		delete reclaimer.thread;
+		reclaimer.thread = NULL;
+	}
+
+	// The retired objects are freed two epochs later: the epoch is moved on twice if nobody reads
+	for (int i = 0; i < 3; i++)
+	{
+		Reclaim();
+	}
+}
+
+unsigned long long Epoch::GetEpoch()
+{
+	return _epoch.load();
+}
+
+EpochRecord* Epoch::GetRecord()
+{
+	static thread_local EpochThread thread;
+	return thread.record;
+}
+
+EpochRecord* Epoch::TakeRecord()
+{
+	for (EpochRecord *record = _records.load(); record; record = record->next)
+	{
+		bool used = false;
+		if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(used, true))
+		{
+			return record;
+		}
+	}
+
+	EpochRecord *record = new EpochRecord();
+	record->state.store(0, std::memory_order_relaxed);
+	record->used.store(true, std::memory_order_relaxed);
+	record->nesting = 0;
+	record->next = _records.load();
+	while (!_records.compare_exchange_weak(record->next, record))
+	{
+	}
+	return record;
+}
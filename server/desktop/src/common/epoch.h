@@ -0,0 +1,206 @@
+/*!
+\file epoch.h "server\desktop\src\common\epoch.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 16 October 2017
+*/
+
+#pragma once
+#include <atomic>
+#include "../defines.h"
+
+#define EPOCH_RECLAIM_INTERVAL 10		///< The milliseconds between the reclaims of the background thread
+#define EPOCH_RETIRE_THRESHOLD 64		///< The retired objects after which the retiring thread reclaims itself
+#define EPOCH_CACHE_LINE 64				///< The padding of the thread records
+
+namespace MSIYBCore
+{
+	/// The state of the thread taking part in the reclamation
+	typedef struct EpochRecord_
+	{
+		std::atomic<unsigned long long> state;	///< The epoch seen on the entry shifted left by one, the low bit is set inside the critical region
+		std::atomic<bool> used;					///< TRUE while the record belongs to the thread
+		EpochRecord_ *next;						///< The next record (the records are never freed, but reused)
+		int nesting;							///< The depth of the nested critical regions (the owner only)
+		char padding[EPOCH_CACHE_LINE];			///< Keeps the records of the different threads out of one cache line
+	} EpochRecord;
+
+	/// The object waiting for the readers to leave
+	typedef struct EpochRetired_
+	{
+		void *object;					///< The object
+		void(*destroy)(void *object);	///< Frees the object
+		unsigned long long epoch;		///< The epoch the object was retired in
+	} EpochRetired;
+
+	/*!
+	\class Epoch epoch.h "server\desktop\src\common\epoch.h"
+	\brief  The epoch-based reclamation: the lock-free readers and the deferred freeing of the unlinked objects.
+	The reader reads the shared pointers only inside the critical region (Enter and Exit, or EpochGuard):
+	it takes no lock and writes only its own cache line. The writer unlinks the object (ex. publishes
+	the new version by RcuPointer) and retires the old one instead of deleting it. The global epoch moves on
+	when every reader inside is in the current epoch, the object retired two epochs ago can't be seen
+	by anybody and is freed. The readers must not block inside, the long critical region delays all the freeing.
+	Static: one domain for the process. Reclaim is called by the retiring threads and the background thread.
+	*/
+	class Epoch
+	{
+	public:
+		/*!
+		Enters the critical region of the calling thread. May be nested.
+		*/
+		static void Enter();
+
+		/*!
+		Exits the critical region of the calling thread.
+		*/
+		static void Exit();
+
+		/*!
+		Frees the object when no reader can see it. The object must be unlinked already.
+		\param[in] object The object.
+		\param[in] destroy Frees the object.
+		*/
+		static void Retire(void *object, void(*destroy)(void *object));
+
+		/*!
+		Deletes the object when no reader can see it. The object must be unlinked already.
+		\param[in] object The object created by new.
+		*/
+		template <typename T> static void Retire(T *object)
+		{
+			Retire(object, &Delete<T>);
+		}
+
+		/*!
+		Moves the epoch on if every reader inside is in the current epoch and frees the objects nobody can see.
+		Must not be called inside the critical region with the hope to free the objects seen there.
+		\return The number of the freed objects.
+		*/
+		static size_lt Reclaim();
+
+		/*!
+		Starts the background thread reclaiming the objects periodically. Not thread-safe.
+		\param[in] interval The milliseconds between the reclaims.
+		*/
+		static void StartReclaimer(unsigned long interval = EPOCH_RECLAIM_INTERVAL);
+
+		/*!
+		Stops the background thread and frees all the retired objects which are not in use. Not thread-safe.
+		*/
+		static void StopReclaimer();
+
+		/*!
+		\return The global epoch.
+		*/
+		static unsigned long long GetEpoch();
+
+	private:
+		template <typename T> static void Delete(void *object)
+		{
+			delete (T*)object;
+		}
+
+		/*!
+		\return The record of the calling thread, taken on the first call.
+		*/
+		static EpochRecord* GetRecord();
+
+		/*!
+		\return The record not used by any thread, the new one if there is none.
+		*/
+		static EpochRecord* TakeRecord();
+
+		friend class EpochThread;
+
+		static std::atomic<unsigned long long> _epoch;		///< The global epoch
+		static std::atomic<EpochRecord*> _records;			///< The records of the threads (the last one first)
+	};
+
+	/*!
+	\class EpochGuard epoch.h "server\desktop\src\common\epoch.h"
+	\brief  RAII for the critical region of the reader: the pointers read inside stay valid until the destruction.
+	*/
+	class EpochGuard
+	{
+	public:
+		/*!
+		Enters the critical region.
+		*/
+		EpochGuard()
+		{
+			Epoch::Enter();
+		}
+
+		/*!
+		Exits the critical region.
+		*/
+		~EpochGuard()
+		{
+			Epoch::Exit();
+		}
+
+		EpochGuard(const EpochGuard& other) = delete;
+		EpochGuard& operator=(const EpochGuard& other) = delete;
+	};
+
+	/*!
+	\class RcuPointer epoch.h "server\desktop\src\common\epoch.h"
+	\brief  The pointer to the immutable version of the data: the readers get it without the locks,
+	the writer publishes the new version at once and the old one is deleted when the readers leave it.
+	The writers must be serialized by the caller.
+	*/
+	template <typename T> class RcuPointer
+	{
+	public:
+		/*!
+		\param[in] value The first version created by new or NULL.
+		*/
+		RcuPointer(T *value = NULL) : _value(value)
+		{
+
+		}
+
+		/*!
+		Retires the current version.
+		*/
+		~RcuPointer()
+		{
+			T *value = _value.load(std::memory_order_relaxed);
+			if (value)
+			{
+				Epoch::Retire(value);
+			}
+		}
+
+		RcuPointer(const RcuPointer& other) = delete;
+		RcuPointer& operator=(const RcuPointer& other) = delete;
+
+		/*!
+		\return The current version, valid until the end of the critical region of the caller (or NULL).
+		The writer may read it outside the region.
+		*/
+		T* Get()
+		{
+			return _value.load(std::memory_order_acquire);
+		}
+
+		/*!
+		Makes the new version visible to the readers and retires the old one.
+		\param[in] value The new version created by new. Must not be changed after.
+		*/
+		void Publish(T *value)
+		{
+			T *old = _value.exchange(value, std::memory_order_acq_rel);
+			if (old)
+			{
+				Epoch::Retire(old);
+			}
+		}
+
+	private:
+		std::atomic<T*> _value;		///< The current version
+	};
+}
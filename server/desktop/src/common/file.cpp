@@ -1,86 +1,107 @@
 #include "file.h"
 #include "stringmethods.h"
+#include "linereader.h"
+#include <atomic>
 
 File::File()
 {
-	_opened = false;
-	_bufferSize = FILE_BUFFER_SIZE;
+	Init(NULL, FILE_BUFFER_SIZE, NULL);
+}
 
-	_fileName = new char[MAX_PATH];
-	if (!_fileName)
-	{
-		ThrowException("Can't allocate memory!")
-	}
+File::File(const char* fileName, size_lt bufferSize)
+{
+	Init(fileName, bufferSize, NULL);
+}
 
-	_cacheReaded = new byte[_bufferSize];
-	if (!_cacheReaded)
+File::File(const char* fileName, MSIYBCore::Arena *arena, size_lt bufferSize)
+{
+	Init(fileName, bufferSize, arena);
+}
+
+File::~File()
+{
+	if (_opened)
 	{
-		ThrowException("Can't allocate memory!");
+		Close();
 	}
-	_bytesInCacheReaded = 0;
-	_posInCacheReaded = 0;
 
-	_cacheToWrite = new byte[_bufferSize];
-	if (!_cacheToWrite)
+	FreeBytes(_cacheReaded, _readCacheSize);
+	FreeBytes(_cacheToWrite, _writeCacheSize);
+	FreeBytes((byte*)_fileName, MAX_PATH);
+	if (_arena)
 	{
-		ThrowException("Can't allocate memory!");
+		// The memory is released by the arena
+		_file->~IFile();
 	}
-	_bytesInCacheToWrite = 0;
-	_posInCacheToWrite = 0;
-
-	_file = new OSFile();
-	if (!_file)
+	else
 	{
-		ThrowException("Can't allocate memory!");
+		delete _file;
 	}
 }
 
-File::File(const char* fileName, size_lt bufferSize)
+void File::Init(const char *fileName, size_lt bufferSize, MSIYBCore::Arena *arena)
 {
-	_fileName = new char[MAX_PATH];
-	if (!_fileName)
-	{
-		ThrowException("Can't allocate memory!")
-	}
-
-	strcpy(_fileName, fileName);
+	_arena = arena;
 	_opened = false;
-
+	_mapped = false;
+	_hasher = NULL;
 	_bufferSize = bufferSize;
 
-	_cacheReaded = new byte[_bufferSize];
-	if (!_cacheReaded)
+	_fileName = (char*)AllocateBytes(MAX_PATH);
+	if (fileName)
 	{
-		ThrowException("Can't allocate memory!");
+		strcpy(_fileName, fileName);
+	}
+	else
+	{
+		_fileName[0] = '\0';
 	}
+
+	_cacheReaded = AllocateBytes(_bufferSize);
 	_bytesInCacheReaded = 0;
 	_posInCacheReaded = 0;
 
-	_cacheToWrite = new byte[_bufferSize];
-	if (!_cacheToWrite)
-	{
-		ThrowException("Can't allocate memory!");
-	}
+	_cacheToWrite = AllocateBytes(_bufferSize);
 	_bytesInCacheToWrite = 0;
 	_posInCacheToWrite = 0;
 
-	_file = new OSFile(fileName);
+	_cachePolicy = CACHEADAPTIVE;
+	_maxBufferSize = FILE_BUFFER_MAX_SIZE;
+	_readCacheSize = _bufferSize;
+	_writeCacheSize = _bufferSize;
+	_sequentialReads = 0;
+	_sequentialWrites = 0;
+	_readOffset = 0;
+	_accessPattern = FILEACCESSNORMAL;
+
+	if (_arena)
+	{
+		void *memory = _arena->Allocate(sizeof(OSFile));
+		_file = fileName ? ::new (memory) OSFile(fileName) : ::new (memory) OSFile();
+		return;
+	}
+	_file = fileName ? new OSFile(fileName) : new OSFile();
 	if (!_file)
 	{
 		ThrowException("Can't allocate memory!");
 	}
 }
 
-File::~File()
+byte* File::AllocateBytes(size_lt size)
 {
-	if (_opened)
+	if (_arena)
 	{
-		Close();
+		return _arena->AllocateBytes(size);
 	}
+	return MSIYBCore::Pool::Allocate(size);
+}
 
-	delete[] _cacheReaded;
-	delete[] _cacheToWrite;
-	delete _file;
+void File::FreeBytes(byte *memory, size_lt size)
+{
+	if (!_arena)
+	{
+		MSIYBCore::Pool::Free(memory, size);
+	}
 }
 
 void File::Open(FileOpenMode mode)
@@ -92,13 +113,18 @@ void File::Open(FileOpenMode mode)
 	}
 	if (mode == FileOpenMode::WRITEATTHEEND)
 	{
-		_file->Open(FileOpenMode::READWRITE);
+		_file->Open(FileOpenMode::WRITEATTHEEND);
 		_file->Seek(0, SeekReference::END);
 	}
 	else
 	{
 		_file->Open(mode);
 	}
+	_opened = true;
+	_mapped = mode == FileOpenMode::MAPPED;
+	_sequentialReads = 0;
+	_sequentialWrites = 0;
+	_accessPattern = FILEACCESSNORMAL;
 }
 
 void File::Open(const char *fileName, FileOpenMode mode)
@@ -112,7 +138,7 @@ void File::Open(const char *fileName, FileOpenMode mode)
 
 	if (mode == FileOpenMode::WRITEATTHEEND)
 	{
-		_file->Open(fileName, FileOpenMode::READWRITE);
+		_file->Open(fileName, FileOpenMode::WRITEATTHEEND);
 		_file->Seek(0, SeekReference::END);
 	}
 	else
@@ -120,6 +146,10 @@ void File::Open(const char *fileName, FileOpenMode mode)
 		_file->Open(fileName, mode);
 	}
 	_opened = true;
+	_mapped = mode == FileOpenMode::MAPPED;
+	_sequentialReads = 0;
+	_sequentialWrites = 0;
+	_accessPattern = FILEACCESSNORMAL;
 }
 
 void File::Close()
@@ -128,8 +158,12 @@ void File::Close()
 	{
 		Flush();
 	}
+	_bytesInCacheReaded = 0;
+	_posInCacheReaded = 0;
 
 	_file->Close();
+	_opened = false;
+	_mapped = false;
 }
 
 void File::Rename(const char *newFileName)
@@ -142,6 +176,17 @@ void File::Rename(const char *fileName, const char *newFileName)
 	OSFile::Rename(fileName, newFileName);
 }
 
+void File::Sync()
+{
+	Flush();
+	_file->Sync();
+}
+
+void File::Replace(const char *fileName, const char *newFileName)
+{
+	OSFile::Replace(fileName, newFileName);
+}
+
 bool File::Exist()
 {
 	return _file->Exist();
@@ -173,22 +218,125 @@ void File::Delete(const char *fileName)
 	OSFile::Delete(fileName);
 }
 
+void File::SetCachePolicy(FileCachePolicy policy, size_lt maxBufferSize)
+{
+	_cachePolicy = policy;
+	_maxBufferSize = maxBufferSize < _bufferSize ? _bufferSize : maxBufferSize;
+}
+
 bool File::CheckCache()
 {
 	if (_bytesInCacheReaded == 0)
 	{
-		_bytesInCacheReaded = _file->ReadBlock(_cacheReaded, _bufferSize);
-		if (_bytesInCacheReaded == 0)
+		return FillCache() > 0;
+	}
+	return true;
+}
+
+size_lt File::FillCache()
+{
+	if (_cachePolicy == CACHEADAPTIVE && _sequentialReads >= FILE_SEQUENTIAL_THRESHOLD && _readCacheSize < _maxBufferSize)
+	{
+		ResizeCache(&_cacheReaded, &_readCacheSize, _readCacheSize * 2 > _maxBufferSize ? _maxBufferSize : _readCacheSize * 2);
+	}
+	_bytesInCacheReaded = _file->ReadBlock(_cacheReaded, _readCacheSize);
+	_posInCacheReaded = 0;
+	OnRead(_bytesInCacheReaded);
+	return _bytesInCacheReaded;
+}
+
+void File::OnRead(size_lt readed)
+{
+	if (_cachePolicy != CACHEADAPTIVE || readed == 0)
+	{
+		return;
+	}
+
+	_sequentialReads++;
+	if (_sequentialReads < FILE_SEQUENTIAL_THRESHOLD)
+	{
+		return;
+	}
+	if (_sequentialReads == FILE_SEQUENTIAL_THRESHOLD)
+	{
+		_readOffset = _file->Seek(0, SeekReference::CURRENT);
+		if (_accessPattern != FILEACCESSSEQUENTIAL)
 		{
-			return false;
+			_accessPattern = FILEACCESSSEQUENTIAL;
+			_file->SetAccessPattern(_accessPattern);
 		}
-		_posInCacheReaded = 0;
 	}
-	return true;
+	else
+	{
+		_readOffset += readed;
+	}
+	// The next refill will find the data in the OS cache
+	_file->Prefetch(_readOffset, _readCacheSize * 2 > _maxBufferSize ? _maxBufferSize : _readCacheSize * 2);
+}
+
+void File::OnWrite()
+{
+	if (_cachePolicy != CACHEADAPTIVE)
+	{
+		return;
+	}
+
+	_sequentialWrites++;
+	if (_sequentialWrites >= FILE_SEQUENTIAL_THRESHOLD && _bytesInCacheToWrite == 0 && _writeCacheSize < _maxBufferSize)
+	{
+		ResizeCache(&_cacheToWrite, &_writeCacheSize, _writeCacheSize * 2 > _maxBufferSize ? _maxBufferSize : _writeCacheSize * 2);
+	}
+}
+
+void File::ResizeCache(byte **cache, size_lt *cacheSize, size_lt newSize)
+{
+	byte *newCache = AllocateBytes(newSize);
+	FreeBytes(*cache, *cacheSize);
+	*cache = newCache;
+	*cacheSize = newSize;
+}
+
+void File::SetHasher(Hasher *hasher)
+{
+	_hasher = hasher;
+}
+
+inline size_lt File::Hashed(const byte *data, size_lt size)
+{
+	if (_hasher)
+	{
+		_hasher->Update(data, size);
+	}
+	return size;
+}
+
+size_lt File::HashedV(const IOBuffer *buffers, size_lt count, size_lt size)
+{
+	if (_hasher)
+	{
+		size_lt left = size;
+		for (size_lt i = 0; i < count && left > 0; i++)
+		{
+			size_lt part = buffers[i].size < left ? buffers[i].size : left;
+			_hasher->Update(buffers[i].data, part);
+			left -= part;
+		}
+	}
+	return size;
 }
 
 int File::ReadByte()
 {
+	if (_mapped)
+	{
+		int b = _file->ReadByte();
+		if (b >= 0 && _hasher)
+		{
+			byte value = (byte)b;
+			_hasher->Update(&value, 1);
+		}
+		return b;
+	}
 	if (!CheckCache())
 	{
 		return -1;
@@ -196,88 +344,159 @@ int File::ReadByte()
 	byte b = _cacheReaded[_posInCacheReaded];
 	_posInCacheReaded++;
 	_bytesInCacheReaded--;
+	Hashed(&b, 1);
 	return b;
 }
 
 size_lt File::ReadBlock(byte *block, size_lt blockSize)
 {
-	if (blockSize > _bufferSize)
+	if (_mapped)
 	{
-		/*
-		If our size of block is bigger then max cache size:
-		1) If our cache isn't empty: we put our cache in block
-		2) Size of readed block: data which was in cache (maybe 0) + data readed from file (we read block size - data in cache)
-		*/
-		if (_bytesInCacheReaded > 0)
-		{
-			memcpy(block, _cacheReaded + _posInCacheReaded, _bytesInCacheReaded);
-		}
-		int size = _bytesInCacheReaded + _file->ReadBlock(block + _bytesInCacheReaded, blockSize - _bytesInCacheReaded);
-		_bytesInCacheReaded = 0;
-		_posInCacheReaded = 0;
-		return size;
+		// The mapped memory is the cache
+		return Hashed(block, _file->ReadBlock(block, blockSize));
 	}
-	else
+
+	/*
+	1) The bytes left in the cache go first.
+	2) If the rest of the block is bigger than the cache, it is read from the file directly.
+	3) Otherwise the cache is filled and the rest of the block is taken from it
+	(less than requested if the file ends).
+	*/
+	size_lt readed = blockSize < _bytesInCacheReaded ? blockSize : _bytesInCacheReaded;
+	memcpy(block, _cacheReaded + _posInCacheReaded, readed);
+	_posInCacheReaded += readed;
+	_bytesInCacheReaded -= readed;
+	if (readed == blockSize)
 	{
-		/*
-		If our size of block is less then max cache size:
-		1) If size of block is bigger then amount of bytes in cache:
-		1. We put our bytes from cache in block
-		2. We fill cache from file
-		3. We put remaining amount of bytes in block from just filled cache
-		4. If our block requires more bytes our file contains, size will be previous bytes amount in cache + size value readed from file.
-		Else size = blockSize
-		2) If size of block is less then amount of bytes in cache we just fill block from cache
-		*/
-		if (blockSize > _bytesInCacheReaded)
-		{
-			memcpy(block, _cacheReaded + _posInCacheReaded, _bytesInCacheReaded);
-			_posInCacheReaded = 0;
-			size_lt tempReadedBytes = _bytesInCacheReaded;
-			_bytesInCacheReaded = _file->ReadBlock(_cacheReaded, _bufferSize);
-			memcpy(block + tempReadedBytes, _cacheReaded + _posInCacheReaded, blockSize - tempReadedBytes);
-			if (blockSize - tempReadedBytes > _bytesInCacheReaded)
-			{
-				tempReadedBytes += _bytesInCacheReaded;
-				_bytesInCacheReaded = 0;
-				_posInCacheReaded = 0;
-				return tempReadedBytes;
-			}
-			else
-			{
-				_bytesInCacheReaded = _bufferSize - (blockSize - tempReadedBytes);
-				_posInCacheReaded = blockSize - tempReadedBytes;
-				return blockSize;
-			}
-		}
-		else
-		{
-			memcpy(block, _cacheReaded + _posInCacheReaded, blockSize);
-			_bytesInCacheReaded -= blockSize;
-			_posInCacheReaded += blockSize;
-			return blockSize;
-		}
+		return Hashed(block, readed);
 	}
+
+	if (blockSize - readed >= _readCacheSize)
+	{
+		size_lt direct = _file->ReadBlock(block + readed, blockSize - readed);
+		OnRead(direct);
+		return Hashed(block, readed + direct);
+	}
+
+	size_lt part = FillCache();
+	if (part > blockSize - readed)
+	{
+		part = blockSize - readed;
+	}
+	memcpy(block + readed, _cacheReaded, part);
+	_posInCacheReaded += part;
+	_bytesInCacheReaded -= part;
+	return Hashed(block, readed + part);
 }
 
 void File::WriteByte(byte b)
 {
-	if (_bytesInCacheToWrite == _bufferSize)
+	Hashed(&b, 1);
+	if (_bytesInCacheToWrite == _writeCacheSize)
 	{
 		Flush(); // After this operation write buffer is empty
+		OnWrite();
 	}
-	if (_bytesInCacheToWrite < _bufferSize)
-	{
-		_cacheToWrite[_posInCacheToWrite] = b;
-		_posInCacheToWrite++;
-		_bytesInCacheToWrite++;
-	}
+	_cacheToWrite[_posInCacheToWrite] = b;
+	_posInCacheToWrite++;
+	_bytesInCacheToWrite++;
 }
 
 void File::WriteBlock(byte *block, size_lt blockSize)
 {
+	Hashed(block, blockSize);
+	if (_bytesInCacheReaded > 0)
+	{
+		Flush();
+	}
+	if (blockSize <= _writeCacheSize - _bytesInCacheToWrite)
+	{
+		// Write-behind: the small blocks are joined in the cache
+		memcpy(_cacheToWrite + _posInCacheToWrite, block, blockSize);
+		_posInCacheToWrite += blockSize;
+		_bytesInCacheToWrite += blockSize;
+		return;
+	}
 	Flush();
 	_file->WriteBlock(block, blockSize);
+	OnWrite();
+}
+
+size_lt File::ReadBlockV(IOBuffer *buffers, size_lt count)
+{
+	if (_mapped)
+	{
+		return HashedV(buffers, count, _file->ReadBlockV(buffers, count));
+	}
+
+	size_lt readed = 0;
+	size_lt index = 0;
+	size_lt skip = 0;
+	AdvanceIOBuffers(buffers, count, &index, &skip, 0);
+	while (index < count && _bytesInCacheReaded > 0)
+	{
+		size_lt part = buffers[index].size - skip;
+		if (part > _bytesInCacheReaded)
+		{
+			part = _bytesInCacheReaded;
+		}
+		memcpy(buffers[index].data + skip, _cacheReaded + _posInCacheReaded, part);
+		_posInCacheReaded += part;
+		_bytesInCacheReaded -= part;
+		readed += part;
+		AdvanceIOBuffers(buffers, count, &index, &skip, part);
+	}
+	if (index == count)
+	{
+		return HashedV(buffers, count, readed);
+	}
+
+	// The first buffer may be partly filled from the cache, read the rest of it
+	IOBuffer first = buffers[index];
+	buffers[index].data += skip;
+	buffers[index].size -= skip;
+	size_lt direct = _file->ReadBlockV(buffers + index, count - index);
+	buffers[index] = first;
+	OnRead(direct);
+	return HashedV(buffers, count, readed + direct);
+}
+
+void File::WriteBlockV(IOBuffer *buffers, size_lt count)
+{
+	HashedV(buffers, count, IOBuffersSize(buffers, count));
+	if (_bytesInCacheReaded > 0)
+	{
+		Flush();
+	}
+	if (IOBuffersSize(buffers, count) <= _writeCacheSize - _bytesInCacheToWrite)
+	{
+		for (size_lt i = 0; i < count; i++)
+		{
+			memcpy(_cacheToWrite + _posInCacheToWrite, buffers[i].data, buffers[i].size);
+			_posInCacheToWrite += buffers[i].size;
+			_bytesInCacheToWrite += buffers[i].size;
+		}
+		return;
+	}
+	Flush();
+	_file->WriteBlockV(buffers, count);
+	OnWrite();
+}
+
+void File::WriteSlices(const MSIYBCore::BufferSlice *slices, size_lt count)
+{
+	IOBuffer buffers[IOBUFFER_MAX_COUNT];
+	while (count > 0)
+	{
+		size_lt part = count < IOBUFFER_MAX_COUNT ? count : IOBUFFER_MAX_COUNT;
+		for (size_lt i = 0; i < part; i++)
+		{
+			buffers[i] = slices[i].ToIOBuffer();
+		}
+		WriteBlockV(buffers, part);
+		slices += part;
+		count -= part;
+	}
 }
 
 void File::Flush()
@@ -287,14 +506,43 @@ void File::Flush()
 		_bytesInCacheReaded = 0;
 		_posInCacheReaded = 0;
 	}
-	_file->WriteBlock(_cacheToWrite, _bytesInCacheToWrite);
-	//this->file->WriteBlock(this->cacheToWrite + this->posInCacheToWrite, this->bytesInCacheToWrite);
+	if (_bytesInCacheToWrite > 0)
+	{
+		_file->WriteBlock(_cacheToWrite, _bytesInCacheToWrite);
+	}
 	_bytesInCacheToWrite = 0;
 	_posInCacheToWrite = 0;
 }
 
 size_lt File::Seek(size_lt offset, SeekReference move)
 {
+	if (move == SeekReference::CURRENT)
+	{
+		// The OS file is ahead of the reader by the bytes left in the cache
+		offset -= _bytesInCacheReaded;
+	}
+	Flush();
+
+	if (_cachePolicy == CACHEADAPTIVE)
+	{
+		// Two seeks in a row look like the random access
+		FileAccessPattern pattern = _sequentialReads + _sequentialWrites == 0 ? FILEACCESSRANDOM : FILEACCESSNORMAL;
+		if (pattern != _accessPattern)
+		{
+			_accessPattern = pattern;
+			_file->SetAccessPattern(_accessPattern);
+		}
+		if (_readCacheSize > _bufferSize)
+		{
+			ResizeCache(&_cacheReaded, &_readCacheSize, _bufferSize);
+		}
+		if (_writeCacheSize > _bufferSize)
+		{
+			ResizeCache(&_cacheToWrite, &_writeCacheSize, _bufferSize);
+		}
+		_sequentialReads = 0;
+		_sequentialWrites = 0;
+	}
 	return _file->Seek(offset, move);
 }
 
@@ -303,6 +551,32 @@ size_lt File::FileSize()
 	return _file->FileSize();
 }
 
+const char* File::GetName()
+{
+	return _fileName;
+}
+
+t_filehandle File::GetHandle()
+{
+	if (_bytesInCacheToWrite > 0)
+	{
+		Flush();
+	}
+	_bytesInCacheReaded = 0;
+	_posInCacheReaded = 0;
+	return _file->GetHandle();
+}
+
+ByteSpan File::GetView()
+{
+	return _file->GetView();
+}
+
+bool File::IsMapped()
+{
+	return _mapped;
+}
+
 size_lt File::FileSize(const char *fileName)
 {
 	return OSFile::FileSize(fileName);
@@ -319,47 +593,56 @@ size_lt File::ReadAllBytes(const char *fileName, byte **byteArr)
 
 size_lt File::ReadAllCharStrings(const char *fileName, char*** charStrings)
 {
-	byte *buf;
-	size_lt sizeBuf = File::ReadAllBytes(fileName, &buf);
-	size_lt sizeStringArray = MIN_STRING_ARRAY_SIZE;
+	File file;
+	file.Open(fileName, MAPPED);
+	StringView line;
+
+	LineReader counter(file);
+	while (counter.Next(&line));
+	size_lt countStrings = counter.GetLineNumber();
 
-	char **stringArray = new char*[sizeStringArray];
+	char **stringArray = new char*[countStrings > 0 ? countStrings : 1];
 	if (!stringArray)
 	{
 		ThrowException("Can't allocate memory for string!");
 	}
 
-	size_lt posInBuf = 0;
-	size_lt countStrings = 0;
-	int rCoef = 2;
-	while (posInBuf < sizeBuf)
+	LineReader reader(file);
+	for (size_lt i = 0; i < countStrings && reader.Next(&line); i++)
 	{
-		char *str;
-		ReadStringFromBuffer(&str, buf, &posInBuf, sizeBuf);
-		if (countStrings == sizeStringArray)
+		char *str = new char[line.size + 1];
+		if (!str)
 		{
-			ResizeStringArray(&stringArray, &sizeStringArray, rCoef);
+			ThrowException("Cant alloc memory for str");
 		}
-		stringArray[countStrings++] = str;
+		memcpy(str, line.data, line.size);
+		str[line.size] = '\0';
+		stringArray[i] = str;
 	}
 	*charStrings = stringArray;
-	delete[] buf;
 	return countStrings;
 }
 
 size_lt File::ReadAllStrings(const char *fileName, string** stringArray)
 {
-	char **charStrings;
-	size_lt cnt = File::ReadAllCharStrings(fileName, &charStrings);
+	File file;
+	file.Open(fileName, MAPPED);
+	StringView line;
+
+	LineReader counter(file);
+	while (counter.Next(&line));
+	size_lt cnt = counter.GetLineNumber();
+
 	string *strings = new string[cnt];
 	if (!strings)
 	{
 		ThrowException("Cant Alloc strings");
 	}
 
-	for (size_lt i = 0; i < cnt; i++)
+	LineReader reader(file);
+	for (size_lt i = 0; i < cnt && reader.Next(&line); i++)
 	{
-		strings[i] = charStrings[i];
+		strings[i].assign(line.data, line.size);
 	}
 
 	*stringArray = strings;
@@ -368,43 +651,21 @@ size_lt File::ReadAllStrings(const char *fileName, string** stringArray)
 
 size_lt File::ReadStringFromBuffer(char **string, byte *buf, size_lt *startPos, size_lt sizeBuf)
 {
-	size_lt stringNotReaded = 1;
-	size_lt sizeString = MIN_STRING_SIZE;
-	char *str = new char[sizeString];
-	int idx = 0;
-	int pos = *startPos;
-	int rCoef = 2;
+	size_lt pos = *startPos;
+	byte *end = (byte*)memchr(buf + pos, '\n', sizeBuf - pos);
+	size_lt sizeLine = end ? end - buf - pos : sizeBuf - pos;
 
+	char *str = new char[sizeLine + 1];
 	if (!str)
 	{
 		ThrowException("Cant alloc memory for str");
 	}
 
-	for (int i = pos; i < sizeBuf && stringNotReaded; i++)
-	{
-		if (idx == sizeString)
-		{
-			Resize(&str, &sizeString, sizeString * rCoef);
-		}
-
-		if (buf[i] != '\n')
-			str[idx++] = buf[i];
-
-		if (buf[i] == '\n' || buf[i] == '\0' || i == sizeBuf - 1)
-		{
-			stringNotReaded = 0;
-			*startPos = i + 1;
-		}
-	}
-
-	if (idx == sizeString)
-	{
-		Resize(&str, &sizeString, sizeString + 1);
-	}
-
-	str[idx] = '\0';
+	memcpy(str, buf + pos, sizeLine);
+	str[sizeLine] = '\0';
+	*startPos = end ? pos + sizeLine + 1 : sizeBuf;
 	*string = str;
-	return sizeString;
+	return sizeLine + 1;
 }
 
 void File::WriteAllBytes(const char *fileName, byte* data, size_lt size, FileOpenMode mode)
@@ -412,18 +673,63 @@ void File::WriteAllBytes(const char *fileName, byte* data, size_lt size, FileOpe
 	OSFile::WriteAllBytes(fileName, data, size, mode);
 }
 
+void File::ReplaceAllBytes(const char *fileName, byte* data, size_lt size)
+{
+	// Unique per call: the same file may be replaced by several threads at once
+	static std::atomic<unsigned long> sequence(0);
+	string tempName = string(fileName) + FILE_TEMP_SUFFIX + to_string(sequence++);
+	try
+	{
+		File file;
+		file.Open(tempName.c_str(), WRITENEWFILE);
+		file.WriteBlock(data, size);
+		file.Sync();
+		file.Close();
+		Replace(tempName.c_str(), fileName);
+	}
+	catch (...)
+	{
+		if (Exist(tempName.c_str()))
+		{
+			Delete(tempName.c_str());
+		}
+		throw;
+	}
+}
+
 void File::WriteAllCharStrings(const char *fileName, char** charStrings, size_lt countStrings, FileOpenMode mode)
 {
-	byte* data;
-	size_lt size = ConvertCharStringArrayToByte(&data, charStrings, countStrings);
-	File::WriteAllBytes(fileName, data, size, mode);
+	// The strings are gathered by the OS, they are not joined into one buffer
+	vector<IOBuffer> buffers(countStrings);
+	for (size_lt i = 0; i < countStrings; i++)
+	{
+		buffers[i].data = (byte*)charStrings[i];
+		buffers[i].size = strlen(charStrings[i]);
+	}
+	WriteAllBlocksV(fileName, buffers, mode);
 }
 
 void File::WriteAllStrings(const char *fileName, string *strings, size_lt countStrings, FileOpenMode mode)
 {
-	byte* data;
-	size_lt size = ConvertStringArrayToByte(&data, strings, countStrings);
-	File::WriteAllBytes(fileName, data, size, mode);
+	vector<IOBuffer> buffers(countStrings);
+	for (size_lt i = 0; i < countStrings; i++)
+	{
+		buffers[i].data = (byte*)strings[i].c_str();
+		buffers[i].size = strings[i].length();
+	}
+	WriteAllBlocksV(fileName, buffers, mode);
+}
+
+void File::WriteAllBlocksV(const char *fileName, vector<IOBuffer> &buffers, FileOpenMode mode)
+{
+	File file(fileName);
+	file.Open(mode);
+	if (!buffers.empty())
+	{
+		file.Flush();
+		file._file->WriteBlockV(&buffers[0], buffers.size());
+	}
+	file.Close();
 }
 
 FileMeta File::LastModified(const char *fileName)
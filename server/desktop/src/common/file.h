@@ -9,24 +9,36 @@
 
 #pragma once
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include "../cross/windows/winfile.h"
 typedef WinFile OSFile;
-#elif _unix_
-typedef UnixFile OSFile;
+#elif __unix__
 #include "../cross/unix/unixfile.h"
+typedef UnixFile OSFile;
 #endif
+#include "hasher.h"
+#include "arena.h"
+#include "pool.h"
+#include "buffer.h"
 
 using namespace std;
 
+/// The sizing rule of the file caches
+typedef enum
+{
+	CACHEFIXED,		///< The caches always have the initial size
+	CACHEADAPTIVE	///< The caches grow while the file is accessed sequentially and shrink after seeking
+} FileCachePolicy;
+
 /*!
 \class File file.h "server\desktop\src\common\file.h"
 \brief  The file interface.
 Provides an interface for a common file structure and its actions.
 The factory(?) for the unix/bsd/windows structure of the file.
 */
-class File
+class File : public MSIYBCore::Pooled
 {
 	/// \todo File(const File &file); operator = (); GetInfo();
 
@@ -39,10 +51,20 @@ public:
 	/*!
 	Initialises cache buffers and the OS-dependent file structure.
 	\param[in] fileName The name of the file to be used.
-	\param[in] bufferSize The maximum size of a cache buffer.
+	\param[in] bufferSize The initial size of a cache buffer.
 	*/
 	File(const char* fileName, size_lt bufferSize = FILE_BUFFER_SIZE);
 
+	/*!
+	Initialises cache buffers and the OS-dependent file structure in the arena (no heap allocations).
+	The file is normally created there too: arena.New<File>(name, &arena). The adaptive caches
+	leave their old buffers in the arena until its rewind, so the arena suits the short-lived files.
+	\param[in] fileName The name of the file to be used.
+	\param[in] arena The arena of the memory. Must outlive the file.
+	\param[in] bufferSize The initial size of a cache buffer.
+	*/
+	File(const char* fileName, MSIYBCore::Arena *arena, size_lt bufferSize = FILE_BUFFER_SIZE);
+
 	/*!
 	Deallocates memory of the cache buffers and the OS-dependent file structure.
 	*/
@@ -80,6 +102,19 @@ public:
 	*/
 	static void Rename(const char *fileName, const char *newFileName);
 
+	/*!
+	Flushes the cache of the written bytes and writes the data of the file through the OS cache to the disk.
+	*/
+	void Sync();
+
+	/*!
+	Renames the file over the existing one in one step and writes the rename to the disk. Static.
+	After a crash the new name has either the old file or the whole new one.
+	\param[in] fileName The current name of the file.
+	\param[in] newFileName The name to be replaced.
+	*/
+	static void Replace(const char *fileName, const char *newFileName);
+
 	/*!
 	Checks if the file exists.
 	\return TRUE if the file exists, FALSE otherwise.
@@ -118,6 +153,22 @@ public:
 	*/
 	static void Delete(const char *fileName);
 
+	/*!
+	Sets the sizing rule of the caches. CACHEADAPTIVE is the default.
+	The adaptive caches double on every refill (flush) after FILE_SEQUENTIAL_THRESHOLD sequential ones,
+	up to maxBufferSize, and the OS is asked to read ahead. Seek returns them to the initial size.
+	\param[in] policy The sizing rule.
+	\param[in] maxBufferSize The biggest size of a cache buffer.
+	*/
+	void SetCachePolicy(FileCachePolicy policy, size_lt maxBufferSize = FILE_BUFFER_MAX_SIZE);
+
+	/*!
+	Sets the hash to be updated with the data read from the file or written to it, in the order of the calls.
+	The checksum is computed on the way, without the second pass over the file.
+	\param[in] hasher The hash or NULL to stop hashing. Not owned.
+	*/
+	void SetHasher(Hasher *hasher);
+
 	/*!
 	Checks if all the data from the buffer is already read and fills it with new data.
 	\return TRUE if the cache (buffer?) is filled with the new data, FALSE otherwise (ex. EOF).
@@ -138,6 +189,32 @@ public:
 	*/
 	size_lt ReadBlock(byte *block, size_lt sizeBlock);
 
+	/*!
+	Fills the empty cache of the read bytes, growing it if the reading is sequential.
+	\return The number of the bytes in the cache.
+	*/
+	size_lt FillCache();
+
+	/*!
+	Accounts the read from the OS file for the sequential access detection.
+	\param[in] readed The number of the bytes read.
+	*/
+	void OnRead(size_lt readed);
+
+	/*!
+	Accounts the write to the OS file for the sequential access detection.
+	Grows the empty cache of the written bytes if the writing is sequential.
+	*/
+	void OnWrite();
+
+	/*!
+	Reallocates the cache buffer. The cache must be empty.
+	\param[in,out] cache The cache buffer.
+	\param[in,out] cacheSize The current size of the buffer.
+	\param[in] newSize The new size of the buffer.
+	*/
+	void ResizeCache(byte **cache, size_lt *cacheSize, size_lt newSize);
+
 	/*!
 	Saves one byte in the cache.
 	Will be written into the file after the cache fills up or after the Flush method is called.
@@ -148,12 +225,38 @@ public:
 
 	/*!
 	Writes a block into the file.
+	The small blocks are saved in the cache, the big ones are written directly.
 	Clears the cache of the read bytes.
 	\param[in] block An array of bytes to be written.
 	\param[in] blockSize The number of bytes to be written.
 	*/
 	void WriteBlock(byte *block, size_lt sizeBlock);
 
+	/*!
+	Reads the file into the several buffers one after another.
+	The cached bytes go first, the rest is read with one vectored call.
+	\param[in] buffers The buffers to be filled.
+	\param[in] count The number of the buffers.
+	\return The number of the bytes read.
+	*/
+	size_lt ReadBlockV(IOBuffer *buffers, size_lt count);
+
+	/*!
+	Writes the several buffers into the file one after another without joining them.
+	The small total goes to the cache, otherwise the buffers are written with one vectored call.
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	void WriteBlockV(IOBuffer *buffers, size_lt count);
+
+	/*!
+	Writes the received slices into the file without copying them into one block.
+	Goes through WriteBlockV by IOBUFFER_MAX_COUNT slices.
+	\param[in] slices The slices to be written.
+	\param[in] count The number of the slices.
+	*/
+	void WriteSlices(const MSIYBCore::BufferSlice *slices, size_lt count);
+
 	/*!
 	Writes into the file cache of the written bytes.(?)
 	Clears the cache of the read bytes.
@@ -180,6 +283,30 @@ public:
 	*/
 	static size_lt FileSize(const char *fileName);
 
+	/*!
+	Flushes the cache of the written bytes and returns the OS handle of the opened file.
+	The cache of the read bytes is dropped, the file pointer is left where the OS handle has it.
+	\return The handle of the file.
+	*/
+	t_filehandle GetHandle();
+
+	/*!
+	\return The path to the file (including its name).
+	*/
+	const char* GetName();
+
+	/*!
+	Returns the memory of the file opened in the MAPPED mode.
+	The reads of the mapped file don't use the cache, the view may be sent or hashed without copying.
+	\return The view of the whole file, valid until the file is closed.
+	*/
+	ByteSpan GetView();
+
+	/*!
+	\return TRUE if the file is opened in the MAPPED mode.
+	*/
+	bool IsMapped();
+
 
 
 	/////////////////////////////////////////////////////////////////////////////
@@ -196,6 +323,7 @@ public:
 
 	/*!
 	Reads the full file and parses it into strings. Static.
+	The file is mapped and split with LineReader, each string is allocated once with its exact size.
 	\param[in] fileName The name of the file to be read.
 	\param[out] byteArr The data to be read from the file.
 	\return A number of the strings read.
@@ -216,7 +344,7 @@ public:
 	\param[in] buf The buffer to be read.
 	\param[in] startPos The position in the buffer from which the reading starts.
 	\param[in] sizeBuf The size of the buffer.
-	\return A number of the strings read.
+	\return The size of the allocated string.
 	*/
 	static size_lt ReadStringFromBuffer(char **string, byte *buf, size_lt *startPos, size_lt sizeBuf);
 
@@ -229,6 +357,17 @@ public:
 	*/
 	static void WriteAllBytes(const char *fileName, byte* data, size_lt size, FileOpenMode mode = WRITENEWFILE);
 
+	/*!
+	Replaces the content of the file with the data. Static.
+	The data is written into the temporary file next to it, synced and renamed over the file (Replace),
+	so the crash leaves either the old content or the new one, never a part.
+	The temporary name is unique, the same file may be replaced by several threads at once.
+	\param[in] fileName The name of the file to be replaced.
+	\param[in] data The data to be written into the file.
+	\param[in] size The size of the data buffer.
+	*/
+	static void ReplaceAllBytes(const char *fileName, byte* data, size_lt size);
+
 	/*!
 	Opens the file and writes all the data (char string format) into it. Static.
 	\param[in] string fileName The name of the file to be read.
@@ -256,12 +395,60 @@ public:
 	static FileMeta LastModified(const char *fileName);
 
 private:
+	/*!
+	Opens the file and writes all the buffers into it with the vectored calls. Static.
+	\param[in] fileName The name of the file.
+	\param[in] buffers The buffers to be written.
+	\param[in] mode Opens the file mode.
+	*/
+	static void WriteAllBlocksV(const char *fileName, vector<IOBuffer> &buffers, FileOpenMode mode);
+
+	/*!
+	Initialises the members, the buffers are allocated in the arena if it is set.
+	*/
+	void Init(const char *fileName, size_lt bufferSize, MSIYBCore::Arena *arena);
+
+	/*!
+	Allocates the buffer in the arena or in the pool.
+	*/
+	byte* AllocateBytes(size_lt size);
+
+	/*!
+	Returns the buffer to the pool unless it is in the arena.
+	\param[in] memory The buffer.
+	\param[in] size The size the buffer was allocated with.
+	*/
+	void FreeBytes(byte *memory, size_lt size);
+
+	/*!
+	Updates the hash with the data if it is set.
+	\return The size of the data.
+	*/
+	inline size_lt Hashed(const byte *data, size_lt size);
+
+	/*!
+	Updates the hash with the first bytes of the buffers if it is set.
+	\return The number of the bytes.
+	*/
+	size_lt HashedV(const IOBuffer *buffers, size_lt count, size_lt size);
+
 	IFile *_file;					///< the OS-dependent file structure 
 
 	char *_fileName;				///< The path to a file (including its name)
 	bool _opened;					///< The descriptor opening status
+	bool _mapped;					///< The file is opened in the MAPPED mode
+	Hasher *_hasher;				///< The hash of the passing data, NULL if it is not hashed
+	MSIYBCore::Arena *_arena;		///< The arena of the buffers, NULL if they are on the heap
 
 	size_lt _bufferSize;			///< The Determined size of the cache buffer
+	FileCachePolicy _cachePolicy;	///< The sizing rule of the caches
+	size_lt _maxBufferSize;			///< The biggest size of the adaptive caches
+	size_lt _readCacheSize;			///< The current size of the cache of the read bytes
+	size_lt _writeCacheSize;		///< The current size of the cache of the written bytes
+	size_lt _sequentialReads;		///< The number of the reads from the OS file since the last seek
+	size_lt _sequentialWrites;		///< The number of the writes to the OS file since the last seek
+	size_lt _readOffset;			///< The offset of the OS file after the last read (valid in the sequential reading)
+	FileAccessPattern _accessPattern;	///< The last hint given to the OS
 
 	/*read-read-read, please rewrite the variables accordingly*/ byte *_cacheReaded;				///< The cache of the bytes read from the file    
 	size_lt _posInCacheReaded;		///< The pointer to a position in the cache of the read bytes
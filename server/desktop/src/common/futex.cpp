@@ -0,0 +1,168 @@
+#include "futex.h"
+#include <algorithm>
+#include <chrono>
+#include "cpu.h"
+
+using MSIYBCore::EventCount;
+using MSIYBCore::FutexLock;
+using MSIYBCore::Futex;
+using MSIYBCore::Cpu;
+
+#define EVENTCOUNT_WAITER 1ULL				///< One registered waiter in the state
+#define EVENTCOUNT_SIGNAL (1ULL << 32)		///< One notification in the state
+#define EVENTCOUNT_WAITERS_MASK (EVENTCOUNT_SIGNAL - 1)
+
+EventCount::EventCount() : _epoch(0), _state(0)
+{
+
+}
+
+int EventCount::PrepareWait()
+{
+	// Registered before the condition is checked again, so the notifier either sees the waiter
+	// or made the condition true before the check
+	_state.fetch_add(EVENTCOUNT_WAITER, std::memory_order_seq_cst);
+	return _epoch.load(std::memory_order_seq_cst);
+}
+
+void EventCount::CancelWait()
+{
+	Leave();
+}
+
+bool EventCount::Wait(int key, unsigned long timeout)
+{
+	bool result = Futex::Wait(&_epoch, key, timeout);
+	Leave();
+	return result;
+}
+
+void EventCount::Leave()
+{
+	// Every waiter leaves once: with the notification taken for it or with its registration
+	unsigned long long state = _state.load(std::memory_order_seq_cst);
+	unsigned long long next;
+	do
+	{
+		next = state >= EVENTCOUNT_SIGNAL ? state - EVENTCOUNT_SIGNAL : state - EVENTCOUNT_WAITER;
+	} while (!_state.compare_exchange_weak(state, next, std::memory_order_seq_cst));
+}
+
+void EventCount::NotifyOne()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	unsigned long long state = _state.load(std::memory_order_seq_cst);
+	do
+	{
+		if ((state & EVENTCOUNT_WAITERS_MASK) == 0)
+		{
+			// Nobody waits or all the waiters are already notified
+			return;
+		}
+	} while (!_state.compare_exchange_weak(state, state - EVENTCOUNT_WAITER + EVENTCOUNT_SIGNAL, std::memory_order_seq_cst));
+	_epoch.fetch_add(1, std::memory_order_seq_cst);
+	Futex::WakeOne(&_epoch);
+}
+
+void EventCount::NotifyAll()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	unsigned long long state = _state.load(std::memory_order_seq_cst);
+	unsigned long long waiters;
+	do
+	{
+		waiters = state & EVENTCOUNT_WAITERS_MASK;
+		if (waiters == 0)
+		{
+			return;
+		}
+	} while (!_state.compare_exchange_weak(state, state - waiters * EVENTCOUNT_WAITER + waiters * EVENTCOUNT_SIGNAL, std::memory_order_seq_cst));
+	_epoch.fetch_add(1, std::memory_order_seq_cst);
+	Futex::WakeAll(&_epoch);
+}
+
+bool EventCount::HasWaiters()
+{
+	return (_state.load(std::memory_order_seq_cst) & EVENTCOUNT_WAITERS_MASK) != 0;
+}
+
+FutexLock::FutexLock() : _state(0), _averageSpins(0)
+{
+
+}
+
+bool FutexLock::TryLock()
+{
+	int expected = 0;
+	return _state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+bool FutexLock::LockContended(unsigned long timeout, unsigned long long *spins, unsigned long long *sleeps)
+{
+	unsigned long long spun = 0;
+	unsigned long long slept = 0;
+	bool taken = false;
+
+	if (Cpu::GetCount() > 1)
+	{
+		int average = _averageSpins.load(std::memory_order_relaxed);
+		int limit = std::min(average * 2 + FUTEXLOCK_SPIN_MIN, FUTEXLOCK_SPIN_MAX);
+		int spin = 0;
+		for (; spin < limit; spin++)
+		{
+			int state = _state.load(std::memory_order_relaxed);
+			if (state == 0 && _state.compare_exchange_weak(state, 1, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				taken = true;
+				break;
+			}
+			Cpu::Pause();
+		}
+		spun = spin;
+		// The next threads spin about as long as it took, and less if spinning didn't help (the lock is held long)
+		_averageSpins.store(taken ? average + (spin - average) / 8 : average - average / 8, std::memory_order_relaxed);
+	}
+
+	if (!taken)
+	{
+		// The lock is taken as contended (2): the unlock has to wake up the sleepers, this thread may be one of them
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout == INFINITE ? 0 : timeout);
+		taken = true;
+		while (_state.exchange(2, std::memory_order_acquire) != 0)
+		{
+			unsigned long wait = INFINITE;
+			if (timeout != INFINITE)
+			{
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				if (now >= deadline)
+				{
+					taken = false;
+					break;
+				}
+				wait = (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+			}
+			Futex::Wait(&_state, 2, wait);
+			slept++;
+		}
+	}
+
+	if (spins)
+	{
+		*spins = spun;
+	}
+	if (sleeps)
+	{
+		*sleeps = slept;
+	}
+	return taken;
+}
+
+bool FutexLock::Unlock()
+{
+	int state = _state.exchange(0, std::memory_order_release);
+	if (state == 2)
+	{
+		Futex::WakeOne(&_state);
+	}
+	return state != 0;
+}
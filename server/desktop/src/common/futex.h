@@ -0,0 +1,133 @@
+/*!
+\file futex.h "server\desktop\src\common\futex.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 12 October 2017
+*/
+
+#pragma once
+#include <atomic>
+
+#ifdef _WIN32
+#include "../cross/windows/threadlock/winfutex.h"
+#elif __unix__
+#include "../cross/unix/unixfutex.h"
+#endif
+
+#define FUTEXLOCK_SPIN_MIN 16		///< The spins tried even if the lock was never taken by spinning
+#define FUTEXLOCK_SPIN_MAX 1000		///< The limit of the spins before the thread sleeps
+
+namespace MSIYBCore
+{
+#ifdef _WIN32
+	typedef WinFutex Futex;
+#elif __unix__
+	typedef UnixFutex Futex;
+#endif
+
+	/*!
+	\class EventCount futex.h "server\desktop\src\common\futex.h"
+	\brief  Parks the threads waiting for a condition of the lock-free structure.
+	The waiter registers with PrepareWait, checks its condition once more and then calls Wait
+	(or CancelWait if the condition is met). The notifier makes the condition true and calls Notify,
+	which costs a fence and a load while nobody waits. A notification between PrepareWait and Wait
+	is not lost: Wait returns at once. The notification takes one registered waiter with it,
+	so a burst of notifications wakes each waiter once instead of calling the kernel every time.
+	*/
+	class EventCount
+	{
+	public:
+		EventCount();
+
+		/*!
+		Registers the calling thread as the waiter.
+		\return The key to be passed to Wait.
+		*/
+		int PrepareWait();
+
+		/*!
+		Unregisters the waiter which found its condition met.
+		*/
+		void CancelWait();
+
+		/*!
+		Sleeps until the notification after PrepareWait and unregisters the waiter.
+		May return spuriously, the caller checks its condition again.
+		\param[in] key The key returned by PrepareWait.
+		\param[in] timeout The timeout in milliseconds or INFINITE.
+		\return FALSE if the timeout expired, TRUE otherwise.
+		*/
+		bool Wait(int key, unsigned long timeout = INFINITE);
+
+		/*!
+		Wakes up one waiter if there is any.
+		*/
+		void NotifyOne();
+
+		/*!
+		Wakes up all the waiters.
+		*/
+		void NotifyAll();
+
+		/*!
+		Tells if the notification would wake up anybody. The notifier which made its condition true
+		by the sequentially consistent atomic operation checks it to skip the fence of Notify while nobody waits.
+		\return TRUE if there are the registered waiters not notified yet.
+		*/
+		bool HasWaiters();
+
+	private:
+		/*!
+		Unregisters the leaving waiter: takes the notification left for it or removes the registration.
+		*/
+		void Leave();
+
+		std::atomic<int> _epoch;					///< The futex word, changed by each notification of the waiters
+		std::atomic<unsigned long long> _state;		///< The registered waiters (low half) and the notifications not taken yet (high half)
+	};
+
+	/*!
+	\class FutexLock futex.h "server\desktop\src\common\futex.h"
+	\brief  The core of the exclusive locks: the lock word which spins and then sleeps on the futex.
+	The free lock is taken by one CAS, the unlock without the sleepers is one exchange: no system calls.
+	The contended lock spins first (not on the single processor), the number of the spins follows
+	the average number it took to get the lock before, so the lock held long stops wasting the processor.
+	Then the thread marks the lock as having sleepers and sleeps on the futex until the unlock.
+	Not recursive, the owner isn't tracked.
+	*/
+	class FutexLock
+	{
+	public:
+		FutexLock();
+
+		FutexLock(const FutexLock& other) = delete;
+		FutexLock& operator=(const FutexLock& other) = delete;
+
+		/*!
+		Takes the free lock.
+		\return TRUE if the lock is taken and FALSE if it is already locked.
+		*/
+		bool TryLock();
+
+		/*!
+		Spins and then sleeps until the lock is taken. Called after the failed TryLock.
+		\param[in] timeout The timeout in milliseconds or INFINITE.
+		\param[out] spins The spin iterations or NULL.
+		\param[out] sleeps The number of the sleeps on the futex or NULL.
+		\return TRUE if the lock is taken and FALSE if the timeout expired.
+		*/
+		bool LockContended(unsigned long timeout = INFINITE, unsigned long long *spins = NULL, unsigned long long *sleeps = NULL);
+
+		/*!
+		Unlocks the lock and wakes up one sleeping thread if there is any.
+		\return TRUE if succeed and FALSE if the lock isn't locked.
+		*/
+		bool Unlock();
+
+	private:
+		std::atomic<int> _state;			///< 0 - unlocked; 1 - locked; 2 - locked and the threads may sleep on it.
+		std::atomic<int> _averageSpins;		///< The average number of the spins it took to get the lock.
+	};
+}
@@ -0,0 +1,29 @@
+#include "hasher.h"
+#include "crc32c.h"
+#include "xxhash64.h"
+#include "sha256.h"
+
+Hasher* Hasher::Create(HashType type)
+{
+	switch (type)
+	{
+	case HASHCRC32C:
+		return new Crc32c();
+	case HASHXXH64:
+		return new XxHash64();
+	case HASHSHA256:
+		return new Sha256();
+	}
+	ThrowException("Unknown hash type!");
+}
+
+void Hasher::ToHex(const byte *digest, size_lt size, char *hex)
+{
+	static const char digits[] = "0123456789abcdef";
+	for (size_lt i = 0; i < size; i++)
+	{
+		hex[i * 2] = digits[digest[i] >> 4];
+		hex[i * 2 + 1] = digits[digest[i] & 0x0F];
+	}
+	hex[size * 2] = '\0';
+}
@@ -0,0 +1,71 @@
+/*!
+\file hasher.h "server\desktop\src\common\hasher.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 29 September 2017
+*/
+
+#pragma once
+#include "../defines.h"
+#include "../tools/exception.h"
+
+#define HASH_MAX_SIZE 32	///< The size of the longest digest (SHA-256)
+
+/// The supported hashes
+typedef enum HashType_
+{
+	HASHCRC32C,		///< CRC-32C (Castagnoli), the hardware one where SSE4.2 is present
+	HASHXXH64,		///< xxHash64, the fast non-cryptographic one
+	HASHSHA256		///< SHA-256, the cryptographic one
+} HashType;
+
+/*!
+\class Hasher hasher.h "server\desktop\src\common\hasher.h"
+\brief  The interface of the streaming hashes.
+Is updated by File and StreamReader with the data passing through them, so the checksum needs no second pass.
+*/
+class Hasher
+{
+public:
+	virtual ~Hasher() {}
+
+	/*!
+	Starts the new hash.
+	*/
+	virtual void Reset() = 0;
+
+	/*!
+	Hashes the next part of the data.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	*/
+	virtual void Update(const byte *data, size_lt size) = 0;
+
+	/*!
+	Finishes the hash. Reset must be called before the next Update.
+	\param[out] digest The hash, GetSize bytes in the canonical (big-endian) order.
+	*/
+	virtual void Final(byte *digest) = 0;
+
+	/*!
+	\return The size of the digest.
+	*/
+	virtual size_lt GetSize() = 0;
+
+	/*!
+	Creates the hash of the type. Static.
+	\param[in] type The type of the hash.
+	\return The new hash, the caller owns it.
+	*/
+	static Hasher* Create(HashType type);
+
+	/*!
+	Converts the digest to the lowercase hex string. Static.
+	\param[in] digest The digest.
+	\param[in] size The size of the digest.
+	\param[out] hex The string, size * 2 + 1 chars.
+	*/
+	static void ToHex(const byte *digest, size_lt size, char *hex);
+};
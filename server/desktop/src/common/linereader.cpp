@@ -0,0 +1,118 @@
+#include "linereader.h"
+
+LineReader::LineReader(File &file, size_lt bufferSize)
+{
+	_pos = 0;
+	_scanned = 0;
+	_lines = 0;
+	if (file.IsMapped())
+	{
+		ByteSpan view = file.GetView();
+		_file = NULL;
+		_buffer = NULL;
+		_bufferSize = 0;
+		_data = view.data;
+		_size = view.size;
+		_eof = true;
+		return;
+	}
+
+	_file = &file;
+	_bufferSize = bufferSize;
+	_buffer = new byte[_bufferSize];
+	if (!_buffer)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+	_data = _buffer;
+	_size = 0;
+	_eof = false;
+}
+
+LineReader::LineReader(ByteSpan data)
+{
+	_file = NULL;
+	_buffer = NULL;
+	_bufferSize = 0;
+	_data = data.data;
+	_size = data.size;
+	_pos = 0;
+	_scanned = 0;
+	_eof = true;
+	_lines = 0;
+}
+
+LineReader::~LineReader()
+{
+	delete[] _buffer;
+}
+
+bool LineReader::Next(StringView *line)
+{
+	while (true)
+	{
+		const byte *start = _data + _pos;
+		size_lt left = _size - _pos;
+		const byte *end = (const byte*)memchr(start + _scanned, '\n', left - _scanned);
+		if (end)
+		{
+			line->data = (const char*)start;
+			line->size = end - start;
+			_pos += line->size + 1;
+			_scanned = 0;
+			_lines++;
+			return true;
+		}
+
+		if (_eof)
+		{
+			if (left == 0)
+			{
+				return false;
+			}
+			// The last line without the separator
+			line->data = (const char*)start;
+			line->size = left;
+			_pos = _size;
+			_scanned = 0;
+			_lines++;
+			return true;
+		}
+
+		_scanned = left;
+		Fill();
+	}
+}
+
+size_lt LineReader::GetLineNumber()
+{
+	return _lines;
+}
+
+void LineReader::Fill()
+{
+	size_lt left = _size - _pos;
+	if (left == _bufferSize)
+	{
+		// The line is longer than the buffer
+		byte *buffer = new byte[_bufferSize * 2];
+		if (!buffer)
+		{
+			ThrowException("Can't allocate memory!");
+		}
+		memcpy(buffer, _buffer + _pos, left);
+		delete[] _buffer;
+		_buffer = buffer;
+		_bufferSize *= 2;
+	}
+	else if (left > 0 && _pos > 0)
+	{
+		memmove(_buffer, _buffer + _pos, left);
+	}
+
+	size_lt readed = _file->ReadBlock(_buffer + left, _bufferSize - left);
+	_eof = readed == 0;
+	_data = _buffer;
+	_size = left + readed;
+	_pos = 0;
+}
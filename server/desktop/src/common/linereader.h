@@ -0,0 +1,68 @@
+/*!
+\file linereader.h "server\desktop\src\common\linereader.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 06 September 2017
+*/
+
+#pragma once
+#include "file.h"
+
+/*!
+\class LineReader linereader.h "server\desktop\src\common\linereader.h"
+\brief  The streaming reader of the text lines.
+Yields the lines as the views into its buffer (or into the mapped file), nothing is allocated per line.
+The line ends are found with memchr, which the C runtimes implement with SIMD.
+The lines are separated by '\n', the separator is not included.
+*/
+class LineReader
+{
+public:
+	/*!
+	Reads the lines of the opened file. The mapped file (MAPPED mode) is read without copying.
+	\param[in] file The file opened to read. Not owned, must outlive the reader.
+	\param[in] bufferSize The initial size of the buffer. It grows only for the longer lines.
+	*/
+	LineReader(File &file, size_lt bufferSize = LINEREADER_BUFFER_SIZE);
+
+	/*!
+	Reads the lines of the memory block.
+	\param[in] data The text. Must outlive the reader.
+	*/
+	LineReader(ByteSpan data);
+
+	/*!
+	Deallocates the buffer.
+	*/
+	~LineReader();
+
+	/*!
+	Returns the next line.
+	\param[out] line The line, valid until the next call.
+	\return FALSE if there are no more lines.
+	*/
+	bool Next(StringView *line);
+
+	/*!
+	\return The number of the lines returned.
+	*/
+	size_lt GetLineNumber();
+
+private:
+	/*!
+	Moves the incomplete line to the beginning of the buffer and reads the file after it.
+	*/
+	void Fill();
+
+	File *_file;			///< The streamed file, NULL for the memory block
+	byte *_buffer;			///< The buffer of the streamed file
+	size_lt _bufferSize;	///< The size of the buffer
+	const byte *_data;		///< The text being read
+	size_lt _size;			///< The size of the text
+	size_lt _pos;			///< The start of the next line
+	size_lt _scanned;		///< The number of the bytes after _pos known to have no separator
+	bool _eof;				///< Nothing more to read from the file
+	size_lt _lines;			///< The number of the lines returned
+};
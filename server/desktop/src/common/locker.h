@@ -11,7 +11,7 @@
 
 #ifdef _WIN32
 #include "../cross/windows/winlocker.h"
-#elif _unix_
+#elif __unix__
 #include "../cross/unix/unixlocker.h"
 #endif
 
@@ -0,0 +1,122 @@
+#include "pool.h"
+#include <atomic>
+
+using namespace MSIYBCore;
+
+/// The free block, the link is kept in the block itself
+typedef struct PoolNode_
+{
+	PoolNode_ *next;	///< The next free block of the class
+} PoolNode;
+
+/// The free lists of the thread
+class PoolCache
+{
+public:
+	PoolCache()
+	{
+		memset(heads, 0, sizeof(heads));
+		memset(counts, 0, sizeof(counts));
+		cached = 0;
+	}
+
+	~PoolCache()
+	{
+		for (int i = 0; i < POOL_CLASS_COUNT; i++)
+		{
+			while (heads[i])
+			{
+				PoolNode *next = heads[i]->next;
+				delete[] (byte*)heads[i];
+				heads[i] = next;
+			}
+		}
+	}
+
+	PoolNode *heads[POOL_CLASS_COUNT];	///< The free blocks of the classes
+	size_lt counts[POOL_CLASS_COUNT];	///< The number of the free blocks of the classes
+	size_lt cached;						///< The bytes in the free lists
+};
+
+static thread_local PoolCache cache;
+static std::atomic<bool> recycling(true);		///< FALSE if the blocks go to the heap and back
+
+static inline int SizeClass(size_lt size)
+{
+	int sizeClass = 0;
+	size_lt classSize = POOL_MIN_BLOCK_SIZE;
+	while (classSize < size)
+	{
+		classSize <<= 1;
+		sizeClass++;
+	}
+	return sizeClass;
+}
+
+static inline size_lt ClassSize(int sizeClass)
+{
+	return (size_lt)POOL_MIN_BLOCK_SIZE << sizeClass;
+}
+
+byte* Pool::Allocate(size_lt size)
+{
+	byte *memory;
+	if (size > POOL_MAX_BLOCK_SIZE)
+	{
+		memory = new byte[size];
+	}
+	else
+	{
+		int sizeClass = SizeClass(size);
+		PoolNode *node = recycling.load(std::memory_order_relaxed) ? cache.heads[sizeClass] : NULL;
+		if (node)
+		{
+			cache.heads[sizeClass] = node->next;
+			cache.counts[sizeClass]--;
+			cache.cached -= ClassSize(sizeClass);
+			return (byte*)node;
+		}
+		memory = new byte[ClassSize(sizeClass)];
+	}
+	if (!memory)
+	{
+		ThrowException("Can't allocate memory!");
+	}
+	return memory;
+}
+
+void Pool::Free(byte *memory, size_lt size)
+{
+	if (!memory)
+	{
+		return;
+	}
+	if (size > POOL_MAX_BLOCK_SIZE)
+	{
+		delete[] memory;
+		return;
+	}
+
+	int sizeClass = SizeClass(size);
+	size_lt limit = POOL_CLASS_CACHE_SIZE / ClassSize(sizeClass);
+	if (cache.counts[sizeClass] >= (limit > POOL_CLASS_MIN_COUNT ? limit : POOL_CLASS_MIN_COUNT) || !recycling.load(std::memory_order_relaxed))
+	{
+		delete[] memory;
+		return;
+	}
+	PoolNode *node = (PoolNode*)memory;
+	node->next = cache.heads[sizeClass];
+	cache.heads[sizeClass] = node;
+	cache.counts[sizeClass]++;
+	cache.cached += ClassSize(sizeClass);
+}
+
+size_lt Pool::GetCached()
+{
+	return cache.cached;
+}
+
+void Pool::SetRecycling(bool recycle)
+{
+	recycling.store(recycle, std::memory_order_relaxed);
+}
@@ -0,0 +1,78 @@
+/*!
+\file pool.h "server\desktop\src\common\pool.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 09 October 2017
+*/
+
+#pragma once
+#include "../defines.h"
+#include "../tools/exception.h"
+
+#define POOL_MIN_BLOCK_SIZE 64					///< The size of the smallest class of the blocks
+#define POOL_MAX_BLOCK_SIZE (1024 * 1024)		///< The bigger blocks go to the heap directly
+#define POOL_CLASS_COUNT 15						///< The number of the power of two classes from POOL_MIN_BLOCK_SIZE to POOL_MAX_BLOCK_SIZE
+#define POOL_CLASS_CACHE_SIZE (1024 * 1024)		///< The bytes kept free per class and thread
+#define POOL_CLASS_MIN_COUNT 4					///< The number of the blocks kept free per class and thread at least
+
+namespace MSIYBCore
+{
+	/*!
+	\class Pool pool.h "server\desktop\src\common\pool.h"
+	\brief  The recycling allocator of the short-lived objects and buffers.
+	The sizes are rounded up to the power of two, each thread keeps the free lists of the classes,
+	so the allocation after the warm-up pops the list without the lock and the global heap.
+	The block freed on another thread joins the list of that thread.
+	The free blocks are returned to the heap when the thread exits.
+	*/
+	class Pool
+	{
+	public:
+		/*!
+		Allocates the memory. Static.
+		\param[in] size The size of the memory.
+		\return The memory. Must be freed by Free with the same size.
+		*/
+		static byte* Allocate(size_lt size);
+
+		/*!
+		Puts the memory to the free list of the thread (to the heap if the list is full). Static.
+		\param[in] memory The memory returned by Allocate or NULL.
+		\param[in] size The size given to Allocate.
+		*/
+		static void Free(byte *memory, size_lt size);
+
+		/*!
+		\return The number of the bytes in the free lists of the calling thread. Static.
+		*/
+		static size_lt GetCached();
+
+		/*!
+		Turns the recycling on or off for all the threads (on by default). Off, every block is taken from the heap
+		and returned to it as if there were no pool, so the benchmarks compare both. May be switched at any time. Static.
+		\param[in] recycle TRUE to recycle the blocks.
+		*/
+		static void SetRecycling(bool recycle);
+	};
+
+	/*!
+	\class Pooled pool.h "server\desktop\src\common\pool.h"
+	\brief  The base of the classes created with new and deleted with delete through Pool.
+	Placement new of the derived class must be written as ::new.
+	*/
+	class Pooled
+	{
+	public:
+		static void* operator new(size_t size)
+		{
+			return Pool::Allocate(size);
+		}
+
+		static void operator delete(void *memory, size_t size)
+		{
+			Pool::Free((byte*)memory, size);
+		}
+	};
+}
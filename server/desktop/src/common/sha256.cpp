@@ -0,0 +1,142 @@
+#include "sha256.h"
+#include <string.h>
+
+static const unsigned int K[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+Sha256::Sha256()
+{
+	Reset();
+}
+
+void Sha256::Reset()
+{
+	_state[0] = 0x6a09e667;
+	_state[1] = 0xbb67ae85;
+	_state[2] = 0x3c6ef372;
+	_state[3] = 0xa54ff53a;
+	_state[4] = 0x510e527f;
+	_state[5] = 0x9b05688c;
+	_state[6] = 0x1f83d9ab;
+	_state[7] = 0x5be0cd19;
+	_buffered = 0;
+	_length = 0;
+}
+
+void Sha256::Update(const byte *data, size_lt size)
+{
+	_length += size;
+	if (_buffered > 0)
+	{
+		size_lt part = SHA256_BLOCK_SIZE - _buffered;
+		if (part > size)
+		{
+			part = size;
+		}
+		memcpy(_buffer + _buffered, data, part);
+		_buffered += part;
+		data += part;
+		size -= part;
+		if (_buffered < SHA256_BLOCK_SIZE)
+		{
+			return;
+		}
+		Transform(_buffer, 1);
+		_buffered = 0;
+	}
+
+	size_lt blocks = size / SHA256_BLOCK_SIZE;
+	Transform(data, blocks);
+	data += blocks * SHA256_BLOCK_SIZE;
+	size -= blocks * SHA256_BLOCK_SIZE;
+
+	memcpy(_buffer, data, size);
+	_buffered = size;
+}
+
+void Sha256::Final(byte *digest)
+{
+	unsigned long long bits = _length * 8;
+	byte padding[SHA256_BLOCK_SIZE * 2] = { 0x80 };
+	size_lt padSize = (_buffered < 56 ? 56 : 120) - _buffered;
+	for (int i = 0; i < 8; i++)
+	{
+		padding[padSize + i] = (byte)(bits >> (56 - i * 8));
+	}
+	Update(padding, padSize + 8);
+
+	for (int i = 0; i < 8; i++)
+	{
+		digest[i * 4] = (byte)(_state[i] >> 24);
+		digest[i * 4 + 1] = (byte)(_state[i] >> 16);
+		digest[i * 4 + 2] = (byte)(_state[i] >> 8);
+		digest[i * 4 + 3] = (byte)_state[i];
+	}
+}
+
+size_lt Sha256::GetSize()
+{
+	return SHA256_SIZE;
+}
+
+void Sha256::Hash(const byte *data, size_lt size, byte *digest)
+{
+	Sha256 hash;
+	hash.Update(data, size);
+	hash.Final(digest);
+}
+
+void Sha256::Transform(const byte *blocks, size_lt count)
+{
+	unsigned int w[64];
+	for (; count > 0; count--, blocks += SHA256_BLOCK_SIZE)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = ((unsigned int)blocks[i * 4] << 24) | ((unsigned int)blocks[i * 4 + 1] << 16) |
+				((unsigned int)blocks[i * 4 + 2] << 8) | blocks[i * 4 + 3];
+		}
+		for (int i = 16; i < 64; i++)
+		{
+			unsigned int s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			unsigned int s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		unsigned int a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+		unsigned int e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+		for (int i = 0; i < 64; i++)
+		{
+			unsigned int t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+			unsigned int t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		_state[0] += a;
+		_state[1] += b;
+		_state[2] += c;
+		_state[3] += d;
+		_state[4] += e;
+		_state[5] += f;
+		_state[6] += g;
+		_state[7] += h;
+	}
+}
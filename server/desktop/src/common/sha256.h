@@ -0,0 +1,72 @@
+/*!
+\file sha256.h "server\desktop\src\common\sha256.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 15 September 2017
+*/
+
+#pragma once
+#include "hasher.h"
+
+#define SHA256_SIZE 32
+#define SHA256_BLOCK_SIZE 64
+
+/*!
+\class Sha256 sha256.h "server\desktop\src\common\sha256.h"
+\brief  The SHA-256 hash (FIPS 180-4).
+Used as the strong hash where the collisions must be impossible in practice (ex. the chunk keys).
+*/
+class Sha256 : public Hasher
+{
+public:
+	/*!
+	Starts the new hash.
+	*/
+	Sha256();
+
+	/*!
+	Starts the new hash.
+	*/
+	void Reset();
+
+	/*!
+	Hashes the next part of the data.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	*/
+	void Update(const byte *data, size_lt size);
+
+	/*!
+	Finishes the hash. Reset must be called before the next Update.
+	\param[out] digest The hash, SHA256_SIZE bytes.
+	*/
+	void Final(byte *digest);
+
+	/*!
+	\return SHA256_SIZE.
+	*/
+	size_lt GetSize();
+
+	/*!
+	Hashes the whole data at once. Static.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	\param[out] digest The hash, SHA256_SIZE bytes.
+	*/
+	static void Hash(const byte *data, size_lt size, byte *digest);
+
+private:
+	/*!
+	Hashes the blocks.
+	\param[in] blocks The blocks, SHA256_BLOCK_SIZE bytes each.
+	\param[in] count The number of the blocks.
+	*/
+	void Transform(const byte *blocks, size_lt count);
+
+	unsigned int _state[8];				///< The intermediate hash
+	byte _buffer[SHA256_BLOCK_SIZE];	///< The incomplete block
+	size_lt _buffered;					///< The number of the bytes in the incomplete block
+	unsigned long long _length;			///< The number of the hashed bytes
+};
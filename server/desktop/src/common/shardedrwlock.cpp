@@ -0,0 +1,174 @@
+#include "shardedrwlock.h"
+#include <cstdint>
+#include <new>
+#include "cpu.h"
+
+using MSIYBCore::ShardedRWLock;
+using MSIYBCore::ShardedRWLockShard;
+using MSIYBCore::Cpu;
+
+static std::atomic<unsigned int> nextShard(0);		///< Spreads the threads over the shards
+
+/*!
+\return The address unique for the calling thread.
+*/
+static inline const void* CurrentThread()
+{
+	static thread_local char tag;
+	return &tag;
+}
+
+ShardedRWLock::ShardedRWLock(int shards) : _writer(0), _owner(NULL), _writers("sharded writers")
+{
+	if (shards <= 0)
+	{
+		shards = Cpu::GetCount();
+	}
+	int count = 1;
+	while (count < shards && count < SHARDEDRWLOCK_MAX_SHARDS)
+	{
+		count <<= 1;
+	}
+	_mask = count - 1;
+	// One line more to move the shards to the start of the line
+	_memory = new char[(count + 1) * sizeof(ShardedRWLockShard)];
+	uintptr_t start = ((uintptr_t)_memory + SHARDEDRWLOCK_CACHE_LINE - 1) & ~(uintptr_t)(SHARDEDRWLOCK_CACHE_LINE - 1);
+	_shards = (ShardedRWLockShard*)start;
+	for (int i = 0; i < count; i++)
+	{
+		new (&_shards[i]) ShardedRWLockShard;
+		_shards[i].readers.store(0, std::memory_order_relaxed);
+	}
+}
+
+ShardedRWLock::~ShardedRWLock()
+{
+	for (int i = 0; i <= _mask; i++)
+	{
+		_shards[i].~ShardedRWLockShard();
+	}
+	delete[] _memory;
+}
+
+bool ShardedRWLock::Lock()
+{
+	_writers.Lock();
+	// Sequentially consistent with the readers: either the reader sees the flag or the writer sees the reader
+	_writer.store(1);
+	while (!IsDrained())
+	{
+		int key = _drained.PrepareWait();
+		if (IsDrained())
+		{
+			_drained.CancelWait();
+			break;
+		}
+		_drained.Wait(key);
+	}
+	_owner.store(CurrentThread(), std::memory_order_relaxed);
+	return true;
+}
+
+bool ShardedRWLock::LockShared()
+{
+	ShardedRWLockShard &shard = GetShard();
+	while (!EnterShard(shard))
+	{
+		int key = _released.PrepareWait();
+		if (_writer.load() == 0)
+		{
+			_released.CancelWait();
+			continue;
+		}
+		_released.Wait(key);
+	}
+	return true;
+}
+
+bool ShardedRWLock::TryLock()
+{
+	if (!_writers.TryLock())
+	{
+		return false;
+	}
+	_writer.store(1);
+	if (!IsDrained())
+	{
+		ReleaseWriter();
+		_writers.Unlock();
+		return false;
+	}
+	_owner.store(CurrentThread(), std::memory_order_relaxed);
+	return true;
+}
+
+bool ShardedRWLock::TryLockShared()
+{
+	return EnterShard(GetShard());
+}
+
+bool ShardedRWLock::Unlock()
+{
+	if (_owner.load(std::memory_order_relaxed) == CurrentThread())
+	{
+		_owner.store(NULL, std::memory_order_relaxed);
+		ReleaseWriter();
+		_writers.Unlock();
+	}
+	else
+	{
+		LeaveShard(GetShard());
+	}
+	return true;
+}
+
+int ShardedRWLock::GetShardCount()
+{
+	return _mask + 1;
+}
+
+ShardedRWLockShard& ShardedRWLock::GetShard()
+{
+	// The shard of the thread, not of the processor: the thread may move to another processor
+	// between the lock and the unlock, and the unlock must leave the shard the lock entered
+	static thread_local unsigned int index = nextShard.fetch_add(1, std::memory_order_relaxed);
+	return _shards[index & _mask];
+}
+
+bool ShardedRWLock::EnterShard(ShardedRWLockShard &shard)
+{
+	shard.readers.fetch_add(1);
+	if (_writer.load() == 0)
+	{
+		return true;
+	}
+	LeaveShard(shard);
+	return false;
+}
+
+void ShardedRWLock::LeaveShard(ShardedRWLockShard &shard)
+{
+	shard.readers.fetch_sub(1);
+	if (_writer.load() != 0)
+	{
+		_drained.NotifyOne();
+	}
+}
+
+bool ShardedRWLock::IsDrained()
+{
+	for (int i = 0; i <= _mask; i++)
+	{
+		if (_shards[i].readers.load() != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ShardedRWLock::ReleaseWriter()
+{
+	_writer.store(0);
+	_released.NotifyAll();
+}
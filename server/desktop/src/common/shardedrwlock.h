@@ -0,0 +1,129 @@
+/*!
+\file shardedrwlock.h "server\desktop\src\common\shardedrwlock.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 15 October 2017
+*/
+
+#pragma once
+#include <atomic>
+#include "futex.h"
+#include "adaptivelock.h"
+#include "../cross/ilocker.h"
+
+#define SHARDEDRWLOCK_CACHE_LINE 64		///< The distance between the counters of the shards
+#define SHARDEDRWLOCK_MAX_SHARDS 64		///< The limit of the shards
+
+namespace MSIYBCore
+{
+	/// The reader counter of the shard, alone in its cache line (the array of the shards must start on the line)
+	typedef struct alignas(SHARDEDRWLOCK_CACHE_LINE) ShardedRWLockShard_
+	{
+		std::atomic<int> readers;											///< The readers in the shard
+		char padding[SHARDEDRWLOCK_CACHE_LINE - sizeof(std::atomic<int>)];	///< Keeps the next counter out of the line
+	} ShardedRWLockShard;
+
+	/*!
+	\class ShardedRWLock shardedrwlock.h "server\desktop\src\common\shardedrwlock.h"
+	\brief  The reader-writer lock for the read-mostly data: the readers don't share the cache line.
+	Every thread counts its shared locks in its own shard (the threads are spread over the shards
+	as many as the processors), so the readers on the different processors don't bounce a line.
+	The writer raises the flag and waits until every shard is empty. The reader which sees the flag
+	leaves its shard and sleeps until the writer is done, so the writers don't starve.
+	The writer pays for a pass over all the shards: use it where the writes are rare.
+	Not recursive.
+	*/
+	class ShardedRWLock : public ILocker
+	{
+	public:
+		/*!
+		\param[in] shards The number of the shards (0 for the number of the processors). Rounded up to the power of two.
+		*/
+		ShardedRWLock(int shards = 0);
+
+		ShardedRWLock(const ShardedRWLock& other) = delete;
+		ShardedRWLock& operator=(const ShardedRWLock& other) = delete;
+
+		/*!
+		Frees the shards. The lock must be unlocked.
+		*/
+		~ShardedRWLock();
+
+		/*!
+		Enter the lock. Exclusive lock. (For writers).
+		Waits for the other writers and then for the readers to leave.
+		\return always TRUE.
+		*/
+		bool Lock() override;
+
+		/*!
+		Locks the locker object in shared mode
+		so other reader thread can use it as well. Touches only the shard of the thread.
+		\return always TRUE.
+		*/
+		bool LockShared() override;
+
+		/*!
+		Try to lock the locker object exclusively.
+		\return TRUE if the lock is taken and FALSE if it is already locked.
+		*/
+		bool TryLock() override;
+
+		/*!
+		Try to lock the locker object in shared mode.
+		\return TRUE if the lock is taken and FALSE if the writer owns it.
+		*/
+		bool TryLockShared() override;
+
+		/*!
+		Releases the exclusive or the shared lock taken by the calling thread.
+		\return always TRUE.
+		*/
+		bool Unlock() override;
+
+		/*!
+		\return The number of the shards.
+		*/
+		int GetShardCount();
+
+	private:
+		/*!
+		\return The shard of the calling thread.
+		*/
+		ShardedRWLockShard& GetShard();
+
+		/*!
+		Enters the shard if there is no writer.
+		\param[in] shard The shard of the calling thread.
+		\return TRUE if the shared lock is taken.
+		*/
+		bool EnterShard(ShardedRWLockShard &shard);
+
+		/*!
+		Leaves the shard and wakes up the writer waiting for the readers.
+		\param[in] shard The shard of the calling thread.
+		*/
+		void LeaveShard(ShardedRWLockShard &shard);
+
+		/*!
+		\return TRUE if there are no readers in the shards.
+		*/
+		bool IsDrained();
+
+		/*!
+		Drops the writer flag and wakes up the readers waiting for it.
+		*/
+		void ReleaseWriter();
+
+		char *_memory;						///< The memory of the shards (new doesn't align past the fundamental alignment)
+		ShardedRWLockShard *_shards;		///< The counters of the readers, constructed in the memory on the cache line
+		int _mask;							///< The number of the shards minus one
+		std::atomic<int> _writer;			///< 1 while the writer owns or waits for the lock
+		std::atomic<const void*> _owner;	///< The thread of the writer owning the lock
+		AdaptiveLock _writers;				///< Lets in one writer at a time
+		EventCount _drained;				///< The writer waiting for the readers to leave
+		EventCount _released;				///< The readers waiting for the writer
+	};
+}
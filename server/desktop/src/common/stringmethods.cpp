@@ -2,37 +2,46 @@
 
 using namespace std;
 
-void ResizeStringArray(char ***arrayStrings, size_lt *oldSize, int rCoeff)
+void ResizeStringArray(char ***arrayStrings, size_lt *oldSize, int rCoeff, MSIYBCore::Arena *arena)
 {
 	int newSize = *oldSize * rCoeff;
 	char **oldPtr = *arrayStrings;
-	char **newPtr = new char*[newSize];
+	char **newPtr = arena ? (char**)arena->Allocate(newSize * sizeof(*newPtr)) : new char*[newSize];
 	if (!newPtr) ThrowException("Can't resize string array!");
 	memcpy(newPtr, oldPtr, *oldSize * sizeof(*newPtr));
-	delete[] oldPtr;
+	if (!arena)
+	{
+		delete[] oldPtr;
+	}
 	*oldSize = newSize;
 	*arrayStrings = newPtr;
 }
 
-void ResizeString(char **string, size_lt *oldSize, int rCoeff)
+void ResizeString(char **string, size_lt *oldSize, int rCoeff, MSIYBCore::Arena *arena)
 {
 	int newSize = *oldSize * rCoeff;
 	char *oldPtr = *string;
-	char *newPtr = new char[newSize];
+	char *newPtr = arena ? (char*)arena->Allocate(newSize) : new char[newSize];
 	if (!newPtr) ThrowException("Can't resize string!");
 	memcpy(newPtr, oldPtr, *oldSize * sizeof(*newPtr));
-	delete[] oldPtr;
+	if (!arena)
+	{
+		delete[] oldPtr;
+	}
 	*oldSize = newSize;
 	*string = newPtr;
 }
 
-void Resize(char **string, size_lt *oldSize, size_lt newSize)
+void Resize(char **string, size_lt *oldSize, size_lt newSize, MSIYBCore::Arena *arena)
 {
 	char *oldPtr = *string;
-	char *newPtr = new char[newSize];
+	char *newPtr = arena ? (char*)arena->Allocate(newSize) : new char[newSize];
 	if (!newPtr) ThrowException("Can't resize string!");
 	memcpy(newPtr, oldPtr, *oldSize);
-	delete[] oldPtr;
+	if (!arena)
+	{
+		delete[] oldPtr;
+	}
 	*oldSize = newSize;
 	*string = newPtr;
 }
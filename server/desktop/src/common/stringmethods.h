@@ -10,6 +10,7 @@
 #pragma once
 #include "../defines.h"
 #include "../tools/exception.h"
+#include "arena.h"
 #include <string>
 
 using std::string;
@@ -19,24 +20,27 @@ Reallocates memory for a char string array.
 \param[out] arrayStrings The allocated block for a string array.
 \param[in] oldSize The current array size.
 \param[in] rCoeff The new size will be calculated by multiplying rCoef and oldSize.
+\param[in] arena The arena to allocate the new block in (the old one is left there), NULL for the heap.
 */
-void ResizeStringArray(char ***arrayStrings, size_lt *oldSize, int rCoeff);
+void ResizeStringArray(char ***arrayStrings, size_lt *oldSize, int rCoeff, MSIYBCore::Arena *arena = NULL);
 
 /*!
 Reallocates memory for a char string.
 \param[out] string The allocated block for a string.
 \param[in] oldSize The current string size.
 \param[in] rCoeff The new size will be calculated by multiplying rCoef and oldSize.
+\param[in] arena The arena to allocate the new block in (the old one is left there), NULL for the heap.
 */
-void ResizeString(char **string, size_lt *oldSize, int rCoeff);
+void ResizeString(char **string, size_lt *oldSize, int rCoeff, MSIYBCore::Arena *arena = NULL);
 
 /*!
 Reallocates memory for a char string with the constant size.
 \param[out] arrayStrings The allocated block for a string.
 \param[in] oldSize The current string size.
 \param[in] newSize The new string size.
+\param[in] arena The arena to allocate the new block in (the old one is left there), NULL for the heap.
 */
-void Resize(char **string, size_lt *oldSize, size_lt newSize);
+void Resize(char **string, size_lt *oldSize, size_lt newSize, MSIYBCore::Arena *arena = NULL);
 
 /*!
 Converts a char string array into a byte array.
@@ -2,11 +2,10 @@
 
 Thread::Thread()
 {
+	_id = 0;
+	_result = nullptr;
+	_stackSize = 0;
 	_thread = new OSThread();
-	if (!_thread)
-	{
-		ThrowThreadExceptionWithCode("Can't allocate memory for OS thread!", GetLastError());
-	}
 }
 
 Thread::~Thread()
@@ -14,9 +13,9 @@ Thread::~Thread()
 	delete _thread;
 }
 
-int Thread::Start(void *threadFunc, void *threadFuncArgs, void *result)
+int Thread::Start(void *threadFunc, void *threadFuncArgs, void * /*result*/)
 {
-	_thread->Init(threadFunc, threadFuncArgs, 0, t_flags::RUNIMMEDIATLY, t_secattr::ENULL);
+	_thread->Init(threadFunc, threadFuncArgs, _stackSize, t_flags::RUNIMMEDIATLY, t_secattr::ENULL);
 	_thread->Start();
 	_id = _thread->GetThreadID();
 	return _id;
@@ -32,7 +31,37 @@ bool Thread::IsCompleted()
 	return !_thread->CheckActive(_result);
 }
 
+void Thread::WaitToComplete()
+{
+	_thread->WaitToComplete();
+}
+
 int Thread::GetMaxThreadCount()
 {
 	return OSThread::GetMaxThreadCount();
 }
+
+int Thread::GetProcessor(int index)
+{
+	return OSThread::GetProcessor(index);
+}
+
+void Thread::SetAffinity(int processor)
+{
+	_thread->SetAffinity(processor);
+}
+
+void Thread::SetNumaNode(int node)
+{
+	_thread->SetNumaNode(node);
+}
+
+void Thread::SetName(const char *name)
+{
+	_thread->SetName(name);
+}
+
+void Thread::SetStackSize(size_t stackSize)
+{
+	_stackSize = stackSize;
+}
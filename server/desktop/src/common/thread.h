@@ -12,7 +12,7 @@
 #ifdef _WIN32
 #include "../cross/windows/winthread.h"
 typedef WinThread OSThread;
-#elif _unix_
+#elif __unix__
 #include "../cross/unix/unixthread.h"
 typedef UnixThread OSThread;
 #endif
@@ -56,14 +56,51 @@ public:
 	*/
 	bool IsCompleted();
 
+	/*!
+	Blocks until the thread completes its work.
+	*/
+	void WaitToComplete();
+
 	/*!
 	Returns the maximum number of the threads that can be started. Static.
 	\return The maximum amount of the threads can be started.
 	*/
 	static int GetMaxThreadCount();
 
+	/*!
+	Returns the processor the process may run on by its number. Static.
+	\param[in] index The number of the allowed processor, wraps around.
+	\return The index of the logical processor for SetAffinity.
+	*/
+	static int GetProcessor(int index);
+
+	/*!
+	Pins the thread to the logical processor. May be called before or after the start.
+	\param[in] processor The index of the logical processor or THREAD_ANY_PROCESSOR.
+	*/
+	void SetAffinity(int processor);
+
+	/*!
+	Keeps the thread on the processors of the NUMA node. May be called before or after the start.
+	\param[in] node The index of the NUMA node or THREAD_ANY_NODE.
+	*/
+	void SetNumaNode(int node);
+
+	/*!
+	Names the thread for the debuggers and the profilers. May be called before or after the start.
+	\param[in] name The name of the thread.
+	*/
+	void SetName(const char *name);
+
+	/*!
+	Sets the stack size of the thread started next.
+	\param[in] stackSize The size of the stack, in bytes (0 for the default of the system).
+	*/
+	void SetStackSize(size_t stackSize);
+
 private:
 	int _id;				///< The current thread ID.
 	void *_result;			///< The value returned from the thread function.
+	size_t _stackSize;		///< The stack size of the thread started next.
 	OSThread *_thread;		///< The OS-dependent thread structure.
 };
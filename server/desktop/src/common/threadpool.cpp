@@ -0,0 +1,131 @@
+#include "threadpool.h"
+
+using MSIYBCore::ThreadPool;
+using MSIYBCore::Worker;
+using MSIYBCore::Task;
+using MSIYBCore::Locker;
+
+ThreadPool::ThreadPool(int threadCount, const char *name, int firstProcessor)
+	: _name(name), _firstProcessor(firstProcessor), _next(0), _pending(0), _stopping(false), _incoming(THREADPOOL_QUEUE_SIZE),
+	_failureLock("pool failure")
+{
+	if (threadCount <= 0)
+	{
+		threadCount = Thread::GetMaxThreadCount();
+	}
+	if (threadCount <= 0)
+	{
+		threadCount = 1;
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		_workers.push_back(new Worker(*this, i));
+	}
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		_workers[i]->Start();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	_stopping = true;
+	_idle.NotifyAll();
+
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		_workers[i]->WaitToComplete();
+	}
+	for (size_t i = 0; i < _workers.size(); i++)
+	{
+		delete _workers[i];
+	}
+}
+
+void ThreadPool::Execute(Task task)
+{
+	// Counted before the push, so a worker never sees the task without the counter
+	_pending++;
+
+	Worker *current = Worker::Current();
+	if (current && &current->_pool == this)
+	{
+		current->Push(std::move(task));
+	}
+	else if (!_incoming.TryPush(std::move(task)))
+	{
+		// The queue is full: the task goes to the deque of a worker to be stolen from there
+		_workers[_next++ % _workers.size()]->Push(std::move(task));
+	}
+
+	// Costs a fence while all the workers are busy
+	_idle.NotifyOne();
+}
+
+int ThreadPool::GetThreadCount()
+{
+	return (int)_workers.size();
+}
+
+bool ThreadPool::GetTask(Worker &worker, Task &task)
+{
+	while (true)
+	{
+		if (worker.Pop(task) || _incoming.TryPop(task) || StealTask(worker.GetIndex(), task))
+		{
+			_pending--;
+			return true;
+		}
+
+		// The counter is checked after the registration, so the task queued meanwhile wakes the worker up
+		int key = _idle.PrepareWait();
+		if (_pending > 0)
+		{
+			_idle.CancelWait();
+			continue;
+		}
+		if (_stopping)
+		{
+			_idle.CancelWait();
+			return false;
+		}
+		_idle.Wait(key);
+	}
+}
+
+bool ThreadPool::StealTask(int thief, Task &task)
+{
+	size_t count = _workers.size();
+	for (size_t i = 1; i < count; i++)
+	{
+		if (_workers[(thief + i) % count]->Steal(task))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::RethrowFailure()
+{
+	std::exception_ptr failure;
+	{
+		Locker locker(_failureLock);
+		failure = _failure;
+		_failure = nullptr;
+	}
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+}
+
+void ThreadPool::SetFailure(std::exception_ptr failure)
+{
+	Locker locker(_failureLock);
+	if (!_failure)
+	{
+		_failure = failure;
+	}
+}
@@ -8,21 +8,117 @@
 */
 
 #pragma once
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <vector>
+#include "worker.h"
+#include "boundedqueue.h"
 
+#define THREADPOOL_QUEUE_SIZE 1024	///< The capacity of the queue of the tasks coming from outside the pool
+#define THREADPOOL_NAME_SIZE 16		///< The limit of the worker thread name with the terminating zero
 
 namespace MSIYBCore
 {
 	/*!
 	\class ThreadPool threadpool.h "server\desktop\src\common\threadpool.h"
 	\brief  The thread pool.
-	Allocates threads and controls them.
+	Allocates threads and controls them. Every worker has its own deque of tasks,
+	idle workers steal from the busy ones, so recursive tasks (ex. directory traversal)
+	spread over all the cores without a shared queue. The tasks coming from outside the pool
+	go through the lock-free queue taken by any worker, the idle workers are parked on the futex.
 	*/
 	class ThreadPool
 	{
 	public:
+		/*!
+		Starts the workers.
+		\param[in] threadCount The number of the workers. Zero means Thread::GetMaxThreadCount().
+		\param[in] name The prefix of the worker thread names ("name-index"), the string must outlive the pool.
+		\param[in] firstProcessor The number of the allowed processor (Thread::GetProcessor) of the first worker,
+		the next ones take the next allowed processors (wrapping around); THREAD_ANY_PROCESSOR leaves the workers to the scheduler.
+		*/
+		ThreadPool(int threadCount = 0, const char *name = "worker", int firstProcessor = THREAD_ANY_PROCESSOR);
 
-		
+		/*!
+		Executes all the queued tasks and stops the workers.
+		*/
+		~ThreadPool();
 
+		/*!
+		Queues the callable and returns the future of its result.
+		Exceptions thrown by the callable are passed to the future.
+		\param[in] func The callable to be executed.
+		\param[in] args The arguments to be passed to the callable.
+		\return The future of the result.
+		*/
+		template<class Func, class... Args>
+		std::future<typename std::result_of<Func(Args...)>::type> Submit(Func &&func, Args&&... args)
+		{
+			typedef typename std::result_of<Func(Args...)>::type Result;
+			std::shared_ptr<std::packaged_task<Result()> > task =
+				std::make_shared<std::packaged_task<Result()> >(std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
+			std::future<Result> result = task->get_future();
+			Execute([task]() { (*task)(); });
+			return result;
+		}
+
+		/*!
+		Queues the task without a result.
+		Called from a worker, puts the task into the own deque of the worker.
+		The exception thrown by the task is kept by the pool (see RethrowFailure).
+		\param[in] task The task to be executed.
+		*/
+		void Execute(Task task);
+
+		/*!
+		Rethrows the first exception thrown by the tasks queued by Execute and forgets it,
+		does nothing if no task failed. The tasks queued by Submit pass theirs to the futures.
+		*/
+		void RethrowFailure();
+
+		/*!
+		\return The number of the workers.
+		*/
+		int GetThreadCount();
+
+	private:
+		friend class Worker;
+
+		/*!
+		Looks for a task: the own deque first, then the queue of the outside tasks, then steals from the others.
+		Parks the worker if there is nothing to do.
+		\param[in] worker The worker looking for a task.
+		\param[out] task The task found.
+		\return TRUE if the task was found, FALSE if the pool is stopping.
+		*/
+		bool GetTask(Worker &worker, Task &task);
+
+		/*!
+		Tries to steal a task from the other workers.
+		\param[in] thief The index of the stealing worker.
+		\param[out] task The task stolen.
+		\return TRUE if the task was stolen.
+		*/
+		bool StealTask(int thief, Task &task);
+
+		/*!
+		Remembers the exception of the failed task. Only the first one is kept.
+		\param[in] failure The exception.
+		*/
+		void SetFailure(std::exception_ptr failure);
+
+		std::vector<Worker*> _workers;			///< The workers
+		const char *_name;						///< The prefix of the worker thread names
+		int _firstProcessor;					///< The allowed processor of the first worker or THREAD_ANY_PROCESSOR
+		std::atomic<unsigned int> _next;		///< The round-robin index for the tasks queued from outside
+		std::atomic<size_lt> _pending;			///< The number of the queued tasks
+		std::atomic<bool> _stopping;			///< TRUE after the destructor is called
+		MpmcQueue<Task> _incoming;				///< The tasks queued from outside the pool
+		EventCount _idle;						///< Parks the workers without tasks
+		std::exception_ptr _failure;			///< The first exception thrown by the tasks
+		AdaptiveLock _failureLock;				///< Guards _failure
 	};
 
 }
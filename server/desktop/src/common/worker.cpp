@@ -0,0 +1,108 @@
+#include <cstdio>
+#include "worker.h"
+#include "threadpool.h"
+
+using MSIYBCore::Worker;
+using MSIYBCore::ThreadPool;
+using MSIYBCore::Task;
+using MSIYBCore::Locker;
+
+static thread_local Worker* currentWorker = nullptr;
+
+Worker::Worker(ThreadPool &pool, int index) : _pool(pool), _index(index), _lock("worker")
+{
+
+}
+
+Worker::~Worker()
+{
+
+}
+
+void Worker::Start()
+{
+	char name[THREADPOOL_NAME_SIZE];
+	snprintf(name, sizeof(name), "%s-%d", _pool._name, _index);
+	_thread.SetName(name);
+	if (_pool._firstProcessor != THREAD_ANY_PROCESSOR)
+	{
+		// A worker per processor: its deque and its tasks stay in the caches of the processor
+		_thread.SetAffinity(Thread::GetProcessor(_pool._firstProcessor + _index));
+	}
+	_thread.Start((void*)&Worker::ThreadFunc, this);
+}
+
+void Worker::WaitToComplete()
+{
+	_thread.WaitToComplete();
+}
+
+void Worker::Push(Task &&task)
+{
+	Locker locker(_lock);
+	_tasks.push_back(std::move(task));
+}
+
+bool Worker::Pop(Task &task)
+{
+	Locker locker(_lock);
+	if (_tasks.empty())
+	{
+		return false;
+	}
+	task = std::move(_tasks.back());
+	_tasks.pop_back();
+	return true;
+}
+
+bool Worker::Steal(Task &task)
+{
+	// Don't wait for the busy victim, the thief will try the next one
+	if (!_lock.TryLock())
+	{
+		return false;
+	}
+
+	bool stolen = !_tasks.empty();
+	if (stolen)
+	{
+		task = std::move(_tasks.front());
+		_tasks.pop_front();
+	}
+	_lock.Unlock();
+	return stolen;
+}
+
+int Worker::GetIndex()
+{
+	return _index;
+}
+
+Worker* Worker::Current()
+{
+	return currentWorker;
+}
+
+THREADFUNC Worker::ThreadFunc(void *args)
+{
+	Worker *worker = (Worker*)args;
+	currentWorker = worker;
+
+	Task task;
+	while (worker->_pool.GetTask(*worker, task))
+	{
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			// The worker goes on, the owner of the pool gets the exception
+			worker->_pool.SetFailure(std::current_exception());
+		}
+		task = nullptr;
+	}
+
+	currentWorker = nullptr;
+	return 0;
+}
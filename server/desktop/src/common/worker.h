@@ -8,24 +8,92 @@
 */
 
 #pragma once
+#include <deque>
+#include <functional>
 #include "locker.h"
+#include "adaptivelock.h"
+#include "thread.h"
 
 namespace MSIYBCore
 {
+	typedef std::function<void()> Task;
+
+	class ThreadPool;
+
 	/*!
 	\class Worker worker.h "server\desktop\src\common\worker.h"
 	\brief  The working thread.
+	Owns a deque of tasks: the owner pushes and pops at the back (LIFO, cache-warm),
+	other workers steal from the front (FIFO, the oldest and usually the biggest tasks).
 	*/
 	class Worker
 	{
 	public:
-		Worker();
+		/*!
+		\param[in] pool The pool the worker takes tasks from.
+		\param[in] index The index of the worker in the pool.
+		*/
+		Worker(ThreadPool &pool, int index);
 
+		/*!
+		Empty. The pool stops the thread before deleting the worker.
+		*/
 		~Worker();
 
+		/*!
+		Launches the thread of the worker.
+		*/
+		void Start();
+
+		/*!
+		Blocks until the thread of the worker exits.
+		*/
+		void WaitToComplete();
+
+		/*!
+		Puts a task at the back of the deque.
+		\param[in] task The task to be executed.
+		*/
+		void Push(Task &&task);
+
+		/*!
+		Takes the newest task from the back of the deque. Called by the owner.
+		\param[out] task The task taken.
+		\return TRUE if the task was taken, FALSE if the deque is empty.
+		*/
+		bool Pop(Task &task);
+
+		/*!
+		Takes the oldest task from the front of the deque. Called by the other workers.
+		\param[out] task The task taken.
+		\return TRUE if the task was taken, FALSE if the deque is empty or busy.
+		*/
+		bool Steal(Task &task);
+
+		/*!
+		\return The index of the worker in the pool.
+		*/
+		int GetIndex();
+
+		/*!
+		\return The worker running on the calling thread or nullptr for the threads out of the pools.
+		*/
+		static Worker* Current();
 
+	private:
+		friend class ThreadPool;
 
+		/*!
+		The thread function. Runs the tasks until the pool stops.
+		\param[in] args The worker.
+		*/
+		static THREADFUNC ThreadFunc(void *args);
 
+		ThreadPool &_pool;		///< The pool the worker belongs to
+		int _index;				///< The index of the worker in the pool
+		Thread _thread;			///< The thread of the worker
+		std::deque<Task> _tasks;	///< The local tasks
+		AdaptiveLock _lock;		///< Guards the local tasks
 	};
 
 }
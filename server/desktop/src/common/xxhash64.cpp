@@ -0,0 +1,174 @@
+#include "xxhash64.h"
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+static inline unsigned long long RotateLeft(unsigned long long value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline unsigned long long Load64(const byte *data)
+{
+	unsigned long long word;
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+static inline unsigned int Load32(const byte *data)
+{
+	unsigned int word;
+	memcpy(&word, data, sizeof(word));
+	return word;
+}
+
+static inline unsigned long long Round(unsigned long long lane, unsigned long long input)
+{
+	lane += input * PRIME2;
+	lane = RotateLeft(lane, 31);
+	return lane * PRIME1;
+}
+
+static inline unsigned long long Merge(unsigned long long hash, unsigned long long lane)
+{
+	hash ^= Round(0, lane);
+	return hash * PRIME1 + PRIME4;
+}
+
+/*!
+Hashes the whole stripes.
+\return The number of the hashed bytes.
+*/
+static size_lt Stripes(unsigned long long *lanes, const byte *data, size_lt size)
+{
+	unsigned long long v1 = lanes[0];
+	unsigned long long v2 = lanes[1];
+	unsigned long long v3 = lanes[2];
+	unsigned long long v4 = lanes[3];
+	size_lt hashed = 0;
+	for (; size - hashed >= XXHASH64_STRIPE_SIZE; hashed += XXHASH64_STRIPE_SIZE)
+	{
+		v1 = Round(v1, Load64(data + hashed));
+		v2 = Round(v2, Load64(data + hashed + 8));
+		v3 = Round(v3, Load64(data + hashed + 16));
+		v4 = Round(v4, Load64(data + hashed + 24));
+	}
+	lanes[0] = v1;
+	lanes[1] = v2;
+	lanes[2] = v3;
+	lanes[3] = v4;
+	return hashed;
+}
+
+XxHash64::XxHash64(unsigned long long seed)
+{
+	_seed = seed;
+	Reset();
+}
+
+void XxHash64::Reset()
+{
+	_lanes[0] = _seed + PRIME1 + PRIME2;
+	_lanes[1] = _seed + PRIME2;
+	_lanes[2] = _seed;
+	_lanes[3] = _seed - PRIME1;
+	_buffered = 0;
+	_length = 0;
+}
+
+void XxHash64::Update(const byte *data, size_lt size)
+{
+	_length += size;
+	if (_buffered > 0)
+	{
+		size_lt part = XXHASH64_STRIPE_SIZE - _buffered;
+		if (part > size)
+		{
+			part = size;
+		}
+		memcpy(_buffer + _buffered, data, part);
+		_buffered += part;
+		data += part;
+		size -= part;
+		if (_buffered < XXHASH64_STRIPE_SIZE)
+		{
+			return;
+		}
+		Stripes(_lanes, _buffer, XXHASH64_STRIPE_SIZE);
+		_buffered = 0;
+	}
+
+	size_lt hashed = Stripes(_lanes, data, size);
+	memcpy(_buffer, data + hashed, size - hashed);
+	_buffered = size - hashed;
+}
+
+void XxHash64::Final(byte *digest)
+{
+	unsigned long long hash = GetValue();
+	for (int i = 0; i < XXHASH64_SIZE; i++)
+	{
+		digest[i] = (byte)(hash >> (56 - i * 8));
+	}
+}
+
+size_lt XxHash64::GetSize()
+{
+	return XXHASH64_SIZE;
+}
+
+unsigned long long XxHash64::GetValue()
+{
+	unsigned long long hash;
+	if (_length >= XXHASH64_STRIPE_SIZE)
+	{
+		hash = RotateLeft(_lanes[0], 1) + RotateLeft(_lanes[1], 7) + RotateLeft(_lanes[2], 12) + RotateLeft(_lanes[3], 18);
+		for (int i = 0; i < 4; i++)
+		{
+			hash = Merge(hash, _lanes[i]);
+		}
+	}
+	else
+	{
+		hash = _seed + PRIME5;
+	}
+	hash += _length;
+
+	// The tail of less than a stripe
+	const byte *data = _buffer;
+	size_lt size = _buffered;
+	for (; size >= 8; size -= 8, data += 8)
+	{
+		hash ^= Round(0, Load64(data));
+		hash = RotateLeft(hash, 27) * PRIME1 + PRIME4;
+	}
+	if (size >= 4)
+	{
+		hash ^= (unsigned long long)Load32(data) * PRIME1;
+		hash = RotateLeft(hash, 23) * PRIME2 + PRIME3;
+		size -= 4;
+		data += 4;
+	}
+	for (; size > 0; size--, data++)
+	{
+		hash ^= *data * PRIME5;
+		hash = RotateLeft(hash, 11) * PRIME1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+unsigned long long XxHash64::Hash(const byte *data, size_lt size, unsigned long long seed)
+{
+	XxHash64 hash(seed);
+	hash.Update(data, size);
+	return hash.GetValue();
+}
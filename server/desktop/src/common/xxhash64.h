@@ -0,0 +1,54 @@
+/*!
+\file xxhash64.h "server\desktop\src\common\xxhash64.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 29 September 2017
+*/
+
+#pragma once
+#include "hasher.h"
+
+#define XXHASH64_SIZE 8
+#define XXHASH64_STRIPE_SIZE 32		///< The four 64-bit lanes hashed in parallel
+
+/*!
+\class XxHash64 xxhash64.h "server\desktop\src\common\xxhash64.h"
+\brief  xxHash64 (XXH64 of Yann Collet), the fast non-cryptographic hash.
+Four independent lanes keep the multipliers busy, so it runs near the memory speed without SIMD.
+*/
+class XxHash64 : public Hasher
+{
+public:
+	/*!
+	\param[in] seed The seed of the hash.
+	*/
+	XxHash64(unsigned long long seed = 0);
+
+	void Reset();
+	void Update(const byte *data, size_lt size);
+	void Final(byte *digest);
+	size_lt GetSize();
+
+	/*!
+	\return The hash of the data hashed so far.
+	*/
+	unsigned long long GetValue();
+
+	/*!
+	Hashes the whole data at once. Static.
+	\param[in] data The data.
+	\param[in] size The size of the data.
+	\param[in] seed The seed of the hash.
+	\return The hash.
+	*/
+	static unsigned long long Hash(const byte *data, size_lt size, unsigned long long seed = 0);
+
+private:
+	unsigned long long _seed;						///< The seed of the hash
+	unsigned long long _lanes[4];					///< The accumulators of the lanes
+	byte _buffer[XXHASH64_STRIPE_SIZE];				///< The incomplete stripe
+	size_lt _buffered;								///< The number of the bytes in the incomplete stripe
+	unsigned long long _length;						///< The number of the hashed bytes
+};
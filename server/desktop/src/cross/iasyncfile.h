@@ -0,0 +1,84 @@
+/*!
+\file iasyncfile.h "server\desktop\src\cross\iasyncfile.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 01 September 2017
+*/
+
+#pragma once
+#include "../defines.h"
+#include "isocket.h"
+
+/// The operation of the asynchronous file request
+typedef enum AsyncFileOperation_
+{
+	ASYNCFILEREAD,		///< Reads the block from the file
+	ASYNCFILEWRITE,		///< Writes the block into the file
+	ASYNCFILEJOB		///< Runs the blocking call (ex. hashing and writing the whole file), the thread pool engine only
+} AsyncFileOperation;
+
+class IAsyncFileHandler;
+
+/// The asynchronous block read or write, owned by the submitter until it is completed
+typedef struct AsyncFileRequest_
+{
+	AsyncFileOperation operation;	///< What to do
+	t_filehandle file;				///< The OS handle of the opened file
+	byte *buffer;					///< The data, must stay valid until the request is completed
+	size_lt size;					///< The number of the bytes to be read or written
+	size_lt offset;					///< The offset in the file
+	IAsyncFileHandler *handler;		///< The receiver of the completion
+	long long result;				///< The number of the transferred bytes or the negative error code
+	long long (*job)(AsyncFileRequest_ *request);	///< The call of ASYNCFILEJOB, returns the result
+	void *context;					///< The data of the submitter, the engine doesn't touch it
+} AsyncFileRequest;
+
+/*!
+\class IAsyncFileHandler iasyncfile.h "server\desktop\src\cross\iasyncfile.h"
+\brief  The receiver of the asynchronous file completions.
+*/
+class IAsyncFileHandler
+{
+public:
+	virtual ~IAsyncFileHandler() {}
+
+	/*!
+	Handles the completed request. Called on the thread which calls Complete (the loop thread).
+	The handler may submit new requests inside this call.
+	\param[in] request The completed request with the result set.
+	*/
+	virtual void OnFileComplete(AsyncFileRequest *request) = 0;
+};
+
+/*!
+\class IAsyncFile iasyncfile.h "server\desktop\src\cross\iasyncfile.h"
+\brief  The class-interface for the OS-dependent asynchronous file engines.
+The requests are submitted and completed on the same thread, so the disk completions
+are handled by the event loop together with the network events.
+*/
+class IAsyncFile
+{
+public:
+	virtual ~IAsyncFile() {}
+
+	/*!
+	Starts the request. The result may be shorter than the size (ex. EOF), like with ReadBlock.
+	\param[in] request The request. Must stay valid until its handler is called.
+	*/
+	virtual void Submit(AsyncFileRequest *request) = 0;
+
+	/*!
+	Calls the handlers of the completed requests. Doesn't wait.
+	\return The number of the completed requests.
+	*/
+	virtual int Complete() = 0;
+
+	/*!
+	Returns the descriptor which becomes readable when there are completed requests.
+	It is watched by the event loop.
+	\return The descriptor.
+	*/
+	virtual t_descriptor GetDescriptor() = 0;
+};
@@ -2,16 +2,35 @@
 
 #include "../tools/exceptions/direxception.h"
 #include "../common/file.h"
+#include <functional>
+
+/// The totals of the directory tree
+typedef struct DirStats_
+{
+	size_lt size;		///< The size of the regular files in bytes
+	size_lt files;		///< The number of the entries which are not directories
+	size_lt dirs;		///< The number of the subdirectories
+} DirStats;
+
+/// The entry met during the directory walk
+typedef struct DirEntry_
+{
+	const char *dirPath;	///< The path of the parent directory relative to the walked one ("" for the walked one)
+	const char *name;		///< The name of the entry
+	size_lt size;			///< The size of the file in bytes
+	time_t modTime;			///< The time of the last modification
+	bool directory;			///< TRUE for the subdirectories
+} DirEntry;
+
+/// Receives the entries during the walk. Is called from many threads at once.
+typedef std::function<void(const DirEntry &entry)> DirVisitor;
 
 class IDir
 {
 public:
-	~IDir() {}
+	virtual ~IDir() {}
 	virtual size_lt GetDirSize() = 0;
 	virtual size_lt GetNumberOfFiles() = 0;
-	virtual File& SearchFileName(const char *fileName) = 0;
-	virtual vector<File&> SearchFileExt(const char *extention) = 0;
-	virtual vector<File&> SearchFileTime(time_t modTime) = 0;
 	virtual void MakeDir() = 0;
 	virtual bool Exists() = 0;
 };
\ No newline at end of file
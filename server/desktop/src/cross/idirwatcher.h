@@ -0,0 +1,74 @@
+/*!
+\file idirwatcher.h "server\desktop\src\cross\idirwatcher.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 September 2017
+*/
+
+#pragma once
+
+#include <time.h>
+#include "../defines.h"
+#include "../tools/exceptions/direxception.h"
+
+/// The kinds of the changes in the watched tree
+typedef enum DirChangeType_
+{
+	DIRCHANGEADDED,		///< The entry is created or moved into the tree
+	DIRCHANGEMODIFIED,	///< The file is written
+	DIRCHANGEREMOVED,	///< The entry is deleted or moved out of the tree
+	DIRCHANGEOVERFLOW	///< The OS dropped some events, everything may have changed
+} DirChangeType;
+
+/// The change in the watched tree
+typedef struct DirChange_
+{
+	DirChangeType type;		///< The kind of the change
+	const char *path;		///< The path of the entry relative to the watched directory
+	bool directory;			///< TRUE for the directories and for the removed entries if the watcher can't tell their kind
+	size_lt size;			///< The size of the file (ADDED and MODIFIED only)
+	time_t modTime;			///< The time of the last modification (ADDED and MODIFIED only)
+} DirChange;
+
+/*!
+\class IDirWatcherHandler idirwatcher.h "server\desktop\src\cross\idirwatcher.h"
+\brief  The receiver of the changes in the watched tree.
+Is called on the thread of the watcher, one change at a time.
+*/
+class IDirWatcherHandler
+{
+public:
+	virtual ~IDirWatcherHandler() {}
+
+	/*!
+	Handles the change.
+	The directory moved into the tree is reported once, its contents are not.
+	\param[in] change The change.
+	*/
+	virtual void OnDirChange(const DirChange &change) = 0;
+};
+
+/*!
+\class IDirWatcher idirwatcher.h "server\desktop\src\cross\idirwatcher.h"
+\brief  The class-interface for the OS-dependent watchers of the directory trees.
+Watches the whole tree recursively on its own thread.
+*/
+class IDirWatcher
+{
+public:
+	virtual ~IDirWatcher() {}
+
+	/*!
+	Starts watching the tree. The changes made before the call are not reported.
+	\param[in] path The watched directory.
+	\param[in] handler The receiver of the changes. Must outlive the watching.
+	*/
+	virtual void Start(const char *path, IDirWatcherHandler *handler) = 0;
+
+	/*!
+	Stops watching and waits for the thread of the watcher. No change is reported after the call.
+	*/
+	virtual void Stop() = 0;
+};
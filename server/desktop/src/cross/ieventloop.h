@@ -0,0 +1,105 @@
+/*!
+\file ieventloop.h "server\desktop\src\cross\ieventloop.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 14 August 2017
+*/
+
+#pragma once
+
+#include "isocket.h"
+
+/// The readiness events the loop can wait for (may be combined)
+typedef enum EventType_
+{
+	EVENTNONE = 0,		///< No events
+	EVENTREAD = 1,		///< The socket has data to read (or a connection to accept)
+	EVENTWRITE = 2,		///< The socket can accept more data to send
+	EVENTERROR = 4,		///< An error occured on the socket
+	EVENTHANGUP = 8		///< The peer closed the connection
+} EventType;
+
+/*!
+\class IEventHandler ieventloop.h "server\desktop\src\cross\ieventloop.h"
+\brief  The receiver of the readiness events.
+Is registered in the event loop together with the socket it serves.
+*/
+class IEventHandler
+{
+public:
+	virtual ~IEventHandler() {}
+
+	/*!
+	Handles the readiness events of the registered socket.
+	The loop is edge-triggered: the handler must drain the socket until it would block.
+	The handler may remove itself from the loop (and delete itself) inside this call.
+	\param[in] events The combination of EventType flags.
+	*/
+	virtual void HandleEvents(int events) = 0;
+};
+
+/*!
+\class IEventLoop ieventloop.h "server\desktop\src\cross\ieventloop.h"
+\brief  The class-interface for the OS-dependent event loops (reactors).
+Waits for the readiness of many non-blocking sockets at once and dispatches the events to their handlers.
+*/
+class IEventLoop
+{
+public:
+	virtual ~IEventLoop() {}
+
+	/*!
+	Registers the socket in the loop. The socket should be switched to the non-blocking mode.
+	\param[in] socket The socket to be watched.
+	\param[in] handler The handler to be called on the socket events.
+	\param[in] events The combination of EventType flags to wait for.
+	*/
+	virtual void Add(ISocket *socket, IEventHandler *handler, int events) = 0;
+
+	/*!
+	Changes the events the loop waits for on the registered socket.
+	\param[in] socket The registered socket.
+	\param[in] handler The handler to be called on the socket events.
+	\param[in] events The combination of EventType flags to wait for.
+	*/
+	virtual void Modify(ISocket *socket, IEventHandler *handler, int events) = 0;
+
+	/*!
+	Removes the socket from the loop. Must be called before the socket is closed.
+	\param[in] socket The registered socket.
+	*/
+	virtual void Remove(ISocket *socket) = 0;
+
+	/*!
+	Registers the descriptor which is not a socket (ex. the notification of the file completions).
+	\param[in] descriptor The non-blocking descriptor to be watched.
+	\param[in] handler The handler to be called on the descriptor events.
+	\param[in] events The combination of EventType flags to wait for.
+	*/
+	virtual void AddDescriptor(t_descriptor descriptor, IEventHandler *handler, int events) = 0;
+
+	/*!
+	Removes the descriptor from the loop. Must be called before the descriptor is closed.
+	\param[in] descriptor The registered descriptor.
+	*/
+	virtual void RemoveDescriptor(t_descriptor descriptor) = 0;
+
+	/*!
+	Waits for the events and dispatches them to the handlers once.
+	\param[in] timeout The time to wait in milliseconds (INFINITE to wait forever).
+	\return The number of the dispatched events.
+	*/
+	virtual int Poll(unsigned long timeout = INFINITE) = 0;
+
+	/*!
+	Dispatches the events until Stop is called.
+	*/
+	virtual void Run() = 0;
+
+	/*!
+	Stops the loop. May be called from any thread or from a handler.
+	*/
+	virtual void Stop() = 0;
+};
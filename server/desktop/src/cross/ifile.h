@@ -8,9 +8,13 @@
 */
 
 #pragma once
-#include "..\defines.h"
-#include "windows\unicodeconverter.h"
-#include "..\tools\exceptions\fileexception.h"
+#include <time.h>
+#include "../defines.h"
+#include "iobuffer.h"
+#ifdef _WIN32
+#include "windows/unicodeconverter.h"
+#endif
+#include "../tools/exceptions/fileexception.h"
 
 /// The file meta data structure
 typedef struct
@@ -28,9 +32,18 @@ typedef enum
 	WRITENEWFILE,	///< Creates a new file 
 	WRITE,			///< Opens the existing file to write into(or truncate the existing file to write into later)
 	READWRITE,		///< Opens the file for both reading and writing (will truncate the existing file)
-	WRITEATTHEEND	///< Writes in the end of the existing file or creates a new file
+	WRITEATTHEEND,	///< Writes in the end of the existing file or creates a new file
+	MAPPED			///< Opens the existing file in the READ ONLY mode and maps it into the memory
 } FileOpenMode;
 
+/// The expected order of the file accesses (the hint for the OS cache)
+typedef enum
+{
+	FILEACCESSNORMAL,		///< No special order
+	FILEACCESSSEQUENTIAL,	///< The file is read from the beginning to the end, read ahead aggressively
+	FILEACCESSRANDOM		///< The file is accessed at random offsets, don't read ahead
+} FileAccessPattern;
+
 /// The position used as a reference for the offset
 typedef enum 
 { 
@@ -76,6 +89,12 @@ public:
 	*/
 	virtual void Rename(const char *newFileName) = 0;
 
+	/*!
+	Writes the data of the opened file through the OS cache to the disk.
+	Returns when the data survives the crash of the machine.
+	*/
+	virtual void Sync() = 0;
+
 	/*!
 	Checks if the file exists.
 	\return TRUE if the file exists, FALSE otherwise.
@@ -129,4 +148,45 @@ public:
 	*/
 	virtual void WriteBlock(byte *block, size_lt sizeBlock) = 0;
 
+	/*!
+	Reads the file into the several buffers one after another (scatter), in one call if the OS can.
+	\param[in] buffers The buffers to be filled.
+	\param[in] count The number of the buffers.
+	\return The number of the bytes read (less than the size of the buffers at the end of the file).
+	*/
+	virtual size_lt ReadBlockV(IOBuffer *buffers, size_lt count) = 0;
+
+	/*!
+	Writes the several buffers into the file one after another (gather), in one call if the OS can.
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	virtual void WriteBlockV(IOBuffer *buffers, size_lt count) = 0;
+
+	/*!
+	Returns the OS handle of the opened file (ex. to send it with the socket).
+	\return The handle of the file.
+	*/
+	virtual t_filehandle GetHandle() = 0;
+
+	/*!
+	Returns the memory of the file opened in the MAPPED mode.
+	The view is valid until the file is closed.
+	\return The view of the whole file (empty for the empty file).
+	*/
+	virtual ByteSpan GetView() = 0;
+
+	/*!
+	Tells the OS how the opened file is going to be accessed. The hint may be ignored.
+	\param[in] pattern The expected order of the accesses.
+	*/
+	virtual void SetAccessPattern(FileAccessPattern pattern) = 0;
+
+	/*!
+	Asks the OS to start reading the region into its cache without waiting for it. The hint may be ignored.
+	\param[in] offset The offset of the region.
+	\param[in] length The length of the region.
+	*/
+	virtual void Prefetch(size_lt offset, size_lt length) = 0;
+
 };
@@ -0,0 +1,56 @@
+/*!
+\file iobuffer.h "server\desktop\src\cross\iobuffer.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 04 September 2017
+*/
+
+#pragma once
+#include "../defines.h"
+
+/// The number of the buffers passed to the OS in one scatter/gather call
+#define IOBUFFER_MAX_COUNT 64
+
+/// The buffer of the scatter/gather (vectored) I/O
+typedef struct
+{
+	byte *data;		///< The first byte
+	size_lt size;	///< The number of the bytes
+} IOBuffer;
+
+/*!
+Moves the position in the buffer list forward after a (partial) vectored transfer.
+The empty buffers at the position are skipped.
+\param[in] buffers The buffers.
+\param[in] count The number of the buffers.
+\param[in,out] index The current buffer.
+\param[in,out] skip The number of the bytes of the current buffer already transferred.
+\param[in] done The number of the bytes transferred.
+*/
+inline void AdvanceIOBuffers(IOBuffer *buffers, size_lt count, size_lt *index, size_lt *skip, size_lt done)
+{
+	while (*index < count && done >= buffers[*index].size - *skip)
+	{
+		done -= buffers[*index].size - *skip;
+		*skip = 0;
+		(*index)++;
+	}
+	*skip += done;
+}
+
+/*!
+\param[in] buffers The buffers.
+\param[in] count The number of the buffers.
+\return The number of the bytes in all the buffers.
+*/
+inline size_lt IOBuffersSize(const IOBuffer *buffers, size_lt count)
+{
+	size_lt size = 0;
+	for (size_lt i = 0; i < count; i++)
+	{
+		size += buffers[i].size;
+	}
+	return size;
+}
@@ -1,9 +1,23 @@
 #pragma once
 
 #include "../defines.h"
+#include "iobuffer.h"
 #include "../tools/exceptions/socketexception.h"
 
 
+#ifdef _WIN32
+typedef unsigned long long t_descriptor;
+#elif __unix__
+typedef int t_descriptor;
+#endif
+
+#define SOCKET_WOULDBLOCK -1
+
+namespace MSIYBCore
+{
+	class Buffer;
+}
+
 typedef enum End { SHUTRECV, SHUTSEND, SHUTBOTH } How;
 typedef enum SocketFamily_
 {
@@ -36,8 +50,14 @@ public:
 	virtual ISocket* Accept() = 0;
 	virtual void SetDirectPort(short port) = 0;
 	virtual int Recv(char *buf, int size) = 0;
+	virtual int RecvBuffer(MSIYBCore::Buffer *buffer) = 0; // appends to the free tail, returns like Recv
 	virtual int Send(char *buf, int size) = 0;
+	virtual int SendV(IOBuffer *buffers, size_lt count) = 0;
 	virtual int RecvFrom() = 0;
 	virtual int SendTo() = 0;
 	virtual void ShutDown(How shutHow) = 0;
+	virtual void SetNonBlocking(bool nonBlocking) = 0;
+	virtual t_descriptor GetDescriptor() = 0;
+	virtual int SendFilePart(t_filehandle file, size_lt offset, int size) = 0;
+	virtual size_lt SendFile(t_filehandle file, size_lt offset, size_lt length) = 0;
 };
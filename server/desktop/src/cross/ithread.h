@@ -20,6 +20,16 @@ typedef enum
 	RESERVESTACK		///< Specifies the initial reserve size of the stack
 } t_flags;
 
+#define THREAD_ANY_PROCESSOR -1		///< The thread may run on any processor
+#define THREAD_ANY_NODE -1			///< The thread may run on any NUMA node
+
+/// The return type and calling convention of the function executed by the thread
+#ifdef _WIN32
+#define THREADFUNC unsigned long __stdcall
+#elif __unix__
+#define THREADFUNC void*
+#endif
+
 /*!
 \class IThread ithread.h "server\desktop\src\cross\ithread.h"
 \brief  The class-interface for the OS-dependent classes.
@@ -28,6 +38,7 @@ The defined methods for the threads should be realized in the OS-dependent class
 class IThread
 {
 public:
+	virtual ~IThread() {}
 
 	/*!
 	Sets up a thread before the launch.
@@ -58,4 +69,29 @@ public:
 	\return TRUE if still active and FALSE otherwise.
 	*/
 	virtual bool CheckActive(void *result = nullptr) = 0;
+
+	/*!
+	Blocks until the thread function returns.
+	*/
+	virtual void WaitToComplete() = 0;
+
+	/*!
+	Pins the thread to the logical processor: its caches stay warm and the scheduler doesn't move it.
+	Called before Start, the thread never runs on the other processors. Takes precedence over the NUMA node.
+	\param[in] processor The index of the logical processor or THREAD_ANY_PROCESSOR.
+	*/
+	virtual void SetAffinity(int processor) = 0;
+
+	/*!
+	Keeps the thread on the processors of the NUMA node, so the memory it touches first is allocated there.
+	A hint: ignored if the system has no such node.
+	\param[in] node The index of the NUMA node or THREAD_ANY_NODE.
+	*/
+	virtual void SetNumaNode(int node) = 0;
+
+	/*!
+	Names the thread for the debuggers and the profilers. The name may be truncated (15 characters on Linux).
+	\param[in] name The name of the thread.
+	*/
+	virtual void SetName(const char *name) = 0;
 };
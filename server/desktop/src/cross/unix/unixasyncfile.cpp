@@ -0,0 +1,291 @@
+#include "unixasyncfile.h"
+#ifdef __unix__
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <string.h>
+
+/*
+	No liburing: the three syscalls and the ring layout are all we need.
+	The ring indexes are shared with the kernel, they are read with acquire and written with release.
+*/
+static unsigned LoadAcquire(unsigned *value)
+{
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static void StoreRelease(unsigned *value, unsigned newValue)
+{
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+}
+
+UnixAsyncFile::UnixAsyncFile(unsigned int queueSize)
+{
+	_inFlight = 0;
+	_sqMemory = MAP_FAILED;
+	_cqMemory = MAP_FAILED;
+	_sqes = (io_uring_sqe*)MAP_FAILED;
+	_wakeUp = -1;
+
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	_ring = (int)syscall(__NR_io_uring_setup, queueSize, &params);
+	if (_ring == -1)
+	{
+		ThrowFileExceptionWithCode("Error io_uring_setup, errno ", errno);
+	}
+	_entries = params.sq_entries;
+	// IORING_OP_READ/WRITE came in 5.6 together with this flag, the older kernels get the thread pool
+	if (!(params.features & IORING_FEAT_RW_CUR_POS))
+	{
+		Release();
+		ThrowFileException("io_uring is too old, no IORING_OP_READ/WRITE");
+	}
+
+	_sqMemorySize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cqMemorySize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMemory = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMemory && _cqMemorySize > _sqMemorySize)
+	{
+		_sqMemorySize = _cqMemorySize;
+	}
+
+	_sqMemory = mmap(NULL, _sqMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQ_RING);
+	_cqMemory = singleMemory ? _sqMemory :
+		mmap(NULL, _cqMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_CQ_RING);
+	_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	_sqes = (io_uring_sqe*)mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring, IORING_OFF_SQES);
+	if (_sqMemory == MAP_FAILED || _cqMemory == MAP_FAILED || _sqes == MAP_FAILED)
+	{
+		int error = errno;
+		Release();
+		ThrowFileExceptionWithCode("Error mmap io_uring, errno ", error);
+	}
+
+	byte *sq = (byte*)_sqMemory;
+	_sqHead = (unsigned*)(sq + params.sq_off.head);
+	_sqTail = (unsigned*)(sq + params.sq_off.tail);
+	_sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+	_sqArray = (unsigned*)(sq + params.sq_off.array);
+	byte *cq = (byte*)_cqMemory;
+	_cqHead = (unsigned*)(cq + params.cq_off.head);
+	_cqTail = (unsigned*)(cq + params.cq_off.tail);
+	_cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+	_cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	_wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeUp == -1 || syscall(__NR_io_uring_register, _ring, IORING_REGISTER_EVENTFD, &_wakeUp, 1) == -1)
+	{
+		int error = errno;
+		Release();
+		ThrowFileExceptionWithCode("Error io_uring_register eventfd, errno ", error);
+	}
+}
+
+UnixAsyncFile::~UnixAsyncFile()
+{
+	Release();
+}
+
+void UnixAsyncFile::Release()
+{
+	if (_sqes != MAP_FAILED)
+	{
+		munmap(_sqes, _sqesSize);
+	}
+	if (_cqMemory != MAP_FAILED && _cqMemory != _sqMemory)
+	{
+		munmap(_cqMemory, _cqMemorySize);
+	}
+	if (_sqMemory != MAP_FAILED)
+	{
+		munmap(_sqMemory, _sqMemorySize);
+	}
+	_sqes = (io_uring_sqe*)MAP_FAILED;
+	_cqMemory = MAP_FAILED;
+	_sqMemory = MAP_FAILED;
+
+	if (_wakeUp != -1)
+	{
+		close(_wakeUp);
+		_wakeUp = -1;
+	}
+	if (_ring != -1)
+	{
+		close(_ring);
+		_ring = -1;
+	}
+}
+
+void UnixAsyncFile::Submit(AsyncFileRequest *request)
+{
+	if (request->operation == ASYNCFILEJOB)
+	{
+		ThrowFileException("io_uring can't run the jobs!");
+	}
+	_waiting.push_back(request);
+	Flush();
+}
+
+void UnixAsyncFile::Flush()
+{
+	// The completion ring is twice as big as the submission one, so it never overflows
+	unsigned tail = *_sqTail;
+	unsigned submitted = 0;
+	while (!_waiting.empty() && _inFlight < _entries && tail - LoadAcquire(_sqHead) < _entries)
+	{
+		AsyncFileRequest *request = _waiting.front();
+		_waiting.pop_front();
+
+		unsigned index = tail & *_sqMask;
+		io_uring_sqe *sqe = &_sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = request->operation == ASYNCFILEREAD ? IORING_OP_READ : IORING_OP_WRITE;
+		sqe->fd = request->file;
+		sqe->addr = (unsigned long long)request->buffer;
+		sqe->len = request->size > MAX_INT ? MAX_INT : (unsigned)request->size;
+		sqe->off = request->offset;
+		sqe->user_data = (unsigned long long)request;
+		_sqArray[index] = index;
+
+		tail++;
+		submitted++;
+		_inFlight++;
+	}
+	if (submitted > 0)
+	{
+		StoreRelease(_sqTail, tail);
+	}
+	Enter();
+}
+
+void UnixAsyncFile::Enter()
+{
+	useconds_t backoff = ASYNCFILE_BACKOFF_MIN;
+	while (true)
+	{
+		// Without SQPOLL the kernel moves the head only inside io_uring_enter
+		unsigned unconsumed = *_sqTail - LoadAcquire(_sqHead);
+		if (unconsumed == 0 || syscall(__NR_io_uring_enter, _ring, unconsumed, 0, 0, NULL, 0) != -1)
+		{
+			return;
+		}
+		if (errno == EINTR)
+		{
+			continue;
+		}
+		if (errno != EAGAIN && errno != EBUSY)
+		{
+			ThrowFileExceptionWithCode("Error io_uring_enter, errno ", errno);
+		}
+		// The kernel is short of the memory or waits for the completions to be reaped:
+		// the completion of a taken request wakes the loop up and Complete comes here again
+		if (_inFlight > unconsumed || LoadAcquire(_cqTail) != *_cqHead)
+		{
+			return;
+		}
+		// Nothing can wake the loop up: wait for the kernel
+		usleep(backoff);
+		backoff = backoff * 2 > ASYNCFILE_BACKOFF_MAX ? ASYNCFILE_BACKOFF_MAX : backoff * 2;
+	}
+}
+
+int UnixAsyncFile::Complete()
+{
+	// Drain the notification first: a completion after this read signals it again
+	eventfd_t value;
+	eventfd_read(_wakeUp, &value);
+
+	int count = 0;
+	unsigned head = *_cqHead;
+	while (head != LoadAcquire(_cqTail))
+	{
+		io_uring_cqe *cqe = &_cqes[head & *_cqMask];
+		AsyncFileRequest *request = (AsyncFileRequest*)cqe->user_data;
+		request->result = cqe->res;
+		head++;
+		StoreRelease(_cqHead, head);
+		_inFlight--;
+		count++;
+
+		request->handler->OnFileComplete(request);
+	}
+
+	Flush();
+	return count;
+}
+
+t_descriptor UnixAsyncFile::GetDescriptor()
+{
+	return _wakeUp;
+}
+#endif
+
+UnixPooledAsyncFile::UnixPooledAsyncFile(int threadCount)
+	: _completed(ASYNCFILE_QUEUE_SIZE)
+{
+	_wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeUp == -1)
+	{
+		ThrowFileExceptionWithCode("Error eventfd, errno ", errno);
+	}
+	_pool = new MSIYBCore::ThreadPool(threadCount, "disk", ASYNCFILE_FIRST_PROCESSOR);
+}
+
+UnixPooledAsyncFile::~UnixPooledAsyncFile()
+{
+	// The threads signal the eventfd, stop them before it is closed (those blocked on the full queue give up)
+	_completed.Close();
+	delete _pool;
+	close(_wakeUp);
+}
+
+void UnixPooledAsyncFile::Submit(AsyncFileRequest *request)
+{
+	_pool->Execute([this, request]()
+	{
+		if (request->operation == ASYNCFILEJOB)
+		{
+			request->result = request->job(request);
+		}
+		else
+		{
+			ssize_t result;
+			do
+			{
+				result = request->operation == ASYNCFILEREAD ?
+					pread(request->file, request->buffer, request->size, (off_t)request->offset) :
+					pwrite(request->file, request->buffer, request->size, (off_t)request->offset);
+			} while (result == -1 && errno == EINTR);
+			request->result = result == -1 ? -errno : result;
+		}
+
+		// Waits only if the loop is ASYNCFILE_QUEUE_SIZE completions behind
+		_completed.Push(request);
+		eventfd_write(_wakeUp, 1);
+	});
+}
+
+int UnixPooledAsyncFile::Complete()
+{
+	eventfd_t value;
+	eventfd_read(_wakeUp, &value);
+
+	// Only the completions queued so far: the handlers may submit the new requests
+	int count = 0;
+	AsyncFileRequest *request;
+	while (count < (int)_completed.GetCapacity() && _completed.TryPop(request))
+	{
+		request->handler->OnFileComplete(request);
+		count++;
+	}
+	return count;
+}
+
+t_descriptor UnixPooledAsyncFile::GetDescriptor()
+{
+	return _wakeUp;
+}
+
+#endif
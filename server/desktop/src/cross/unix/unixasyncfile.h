@@ -0,0 +1,127 @@
+/*!
+\file unixasyncfile.h "server\desktop\src\cross\unix\unixasyncfile.h"
+\authors Alexandr Barulev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 01 September 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <deque>
+#include <vector>
+#include "../iasyncfile.h"
+#include "../../common/threadpool.h"
+#include "../../common/boundedqueue.h"
+#include "../../tools/exceptions/fileexception.h"
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+#define ASYNCFILE_QUEUE_SIZE 256
+#define ASYNCFILE_BACKOFF_MIN 50			///< The first pause (us) before io_uring_enter is retried with nothing in flight
+#define ASYNCFILE_BACKOFF_MAX 10000		///< The longest pause (us) before io_uring_enter is retried
+#define ASYNCFILE_THREADS 4
+#define ASYNCFILE_FIRST_PROCESSOR THREAD_ANY_PROCESSOR		///< The processor of the first I/O thread of the pool (THREAD_ANY_PROCESSOR - not pinned)
+
+#ifdef __linux__
+/*!
+\class UnixAsyncFile unixasyncfile.h "server\desktop\src\cross\unix\unixasyncfile.h"
+\brief  The io_uring asynchronous file engine (Linux 5.1+).
+The requests go to the kernel submission ring, the completions are signalled through the eventfd.
+Throws FileException from the constructor if the kernel has no io_uring.
+The jobs (ASYNCFILEJOB) are not run by the kernel, AsyncFile passes them to the thread pool engine.
+*/
+class UnixAsyncFile : public IAsyncFile
+{
+public:
+	/*!
+	Sets up the rings and registers the eventfd for the completions.
+	\param[in] queueSize The number of the requests in the kernel at once.
+	*/
+	UnixAsyncFile(unsigned int queueSize = ASYNCFILE_QUEUE_SIZE);
+
+	/*!
+	Unmaps the rings and closes the descriptors. The requests in flight are dropped.
+	*/
+	~UnixAsyncFile();
+
+	virtual void Submit(AsyncFileRequest *request) override;
+	virtual int Complete() override;
+	virtual t_descriptor GetDescriptor() override;
+
+private:
+	/*!
+	Unmaps the rings and closes the descriptors.
+	*/
+	void Release();
+
+	/*!
+	Moves the waiting requests to the submission ring and enters the kernel.
+	*/
+	void Flush();
+
+	/*!
+	Passes the entries of the submission ring the kernel hasn't taken yet.
+	If the kernel is busy (EAGAIN, EBUSY) the entries stay in the ring: the next completion
+	submits them, or the loop backs off and retries if there is nothing in flight to complete.
+	*/
+	void Enter();
+
+	int _ring;									///< The io_uring descriptor
+	int _wakeUp;								///< The eventfd signalled on the completions
+	void *_sqMemory;							///< The mapped submission ring
+	size_lt _sqMemorySize;						///< The size of the mapped submission ring
+	void *_cqMemory;							///< The mapped completion ring (may be the same as _sqMemory)
+	size_lt _cqMemorySize;						///< The size of the mapped completion ring
+	io_uring_sqe *_sqes;						///< The submission entries
+	size_lt _sqesSize;							///< The size of the submission entries
+	unsigned *_sqHead;							///< The first entry consumed by the kernel
+	unsigned *_sqTail;							///< The next entry to be filled
+	unsigned *_sqMask;							///< The index mask of the submission ring
+	unsigned *_sqArray;							///< The indexes of the submitted entries
+	unsigned *_cqHead;							///< The first completion not yet handled
+	unsigned *_cqTail;							///< The next completion to be filled by the kernel
+	unsigned *_cqMask;							///< The index mask of the completion ring
+	io_uring_cqe *_cqes;						///< The completion entries
+	unsigned _entries;							///< The size of the submission ring
+	unsigned _inFlight;							///< The number of the requests in the kernel
+	std::deque<AsyncFileRequest*> _waiting;		///< The requests which don't fit into the rings
+};
+#endif
+
+/*!
+\class UnixPooledAsyncFile unixasyncfile.h "server\desktop\src\cross\unix\unixasyncfile.h"
+\brief  The asynchronous file engine for the systems without io_uring.
+The blocking pread/pwrite calls (and the ASYNCFILEJOB calls) run on the thread pool, the completions
+are queued and signalled through the eventfd, so they are still handled on the loop thread.
+*/
+class UnixPooledAsyncFile : public IAsyncFile
+{
+public:
+	/*!
+	Starts the threads.
+	\param[in] threadCount The number of the threads doing the I/O.
+	*/
+	UnixPooledAsyncFile(int threadCount = ASYNCFILE_THREADS);
+
+	/*!
+	Waits for the requests in flight and closes the eventfd. Their handlers are not called.
+	*/
+	~UnixPooledAsyncFile();
+
+	virtual void Submit(AsyncFileRequest *request) override;
+	virtual int Complete() override;
+	virtual t_descriptor GetDescriptor() override;
+
+private:
+	int _wakeUp;									///< The eventfd signalled on the completions
+	MSIYBCore::MpmcQueue<AsyncFileRequest*> _completed;	///< The requests done by the threads
+	MSIYBCore::ThreadPool *_pool;					///< The threads doing the blocking I/O
+};
+
+#endif
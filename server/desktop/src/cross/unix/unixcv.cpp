@@ -0,0 +1,34 @@
+#include "unixcv.h"
+#ifdef __unix__
+
+using MSIYBCore::UnixCV;
+
+UnixCV::UnixCV()
+{
+}
+
+UnixCV::~UnixCV()
+{
+}
+
+bool UnixCV::Wait(ILocker &locker, unsigned long timeout)
+{
+	// Registered under the lock: the signal of the thread which took the lock after the unlock sees the waiter
+	int key = _event.PrepareWait();
+	locker.Unlock();
+	bool result = _event.Wait(key, timeout);
+	locker.Lock();
+	return result;
+}
+
+void UnixCV::Signal()
+{
+	_event.NotifyOne();
+}
+
+void UnixCV::Broadcast()
+{
+	_event.NotifyAll();
+}
+
+#endif
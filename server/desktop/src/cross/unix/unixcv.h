@@ -0,0 +1,63 @@
+/*!
+\file unixcv.h "server\desktop\src\cross\unix\unixcv.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 October 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include "../../common/futex.h"
+#include "../ilocker.h"
+
+namespace MSIYBCore
+{
+	/*!
+	\class UnixCV unixcv.h "server\desktop\src\cross\unix\unixcv.h"
+	\brief  The condition variable on the futex.
+	The waiter registers in the event count under the lock, unlocks and sleeps:
+	the signal after the unlock finds the registration, so it is never lost.
+	Signal and Broadcast make no system call while nobody waits or all the waiters are already woken up.
+	*/
+	class UnixCV
+	{
+	public:
+		/*!
+		Constructor. Empty.
+		*/
+		UnixCV();
+
+		UnixCV(const UnixCV& other) = delete;
+		UnixCV& operator=(const UnixCV& other) = delete;
+
+		/*!
+		Empty. Nobody must wait.
+		*/
+		~UnixCV();
+
+		/*!
+		Unlocks the locker, sleeps until the signal and locks the locker again.
+		May return spuriously, the caller checks its condition again.
+		\param[in] locker The exclusive locker taken once by the calling thread.
+		\param[in] timeout The timeout in milliseconds or INFINITE.
+		\return FALSE if the timeout expired, TRUE otherwise.
+		*/
+		bool Wait(ILocker &locker, unsigned long timeout = INFINITE);
+
+		/*!
+		Wakes up one waiting thread.
+		*/
+		void Signal();
+
+		/*!
+		Wakes up all the waiting threads.
+		*/
+		void Broadcast();
+
+	private:
+		EventCount _event;		///< The waiting threads.
+	};
+}
+#endif
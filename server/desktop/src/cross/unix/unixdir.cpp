@@ -0,0 +1,187 @@
+#include "unixdir.h"
+#ifdef __unix__
+#include <dirent.h>
+#include <sys/syscall.h>
+
+/// The entry filled by getdents64
+typedef struct UnixDirent64_
+{
+	unsigned long long d_ino;	///< The inode number
+	long long d_off;			///< The offset of the next entry
+	unsigned short d_reclen;	///< The size of this entry
+	unsigned char d_type;		///< The type of the entry (DT_*)
+	char d_name[1];				///< The null-terminated name
+} UnixDirent64;
+
+using MSIYBCore::DirWalk;
+
+UnixDir::UnixDir()
+{
+	strcpy(this->workingDir, "/");
+}
+
+UnixDir::UnixDir(const char *path)
+{
+	strcpy(this->workingDir, path);
+}
+
+UnixDir::~UnixDir()
+{
+}
+
+size_lt UnixDir::GetDirSize()
+{
+	return UnixDir::GetDirSize(this->workingDir);
+}
+
+size_lt UnixDir::GetDirSize(const char *path)
+{
+	return UnixDir::Walk(path).size;
+}
+
+size_lt UnixDir::GetNumberOfFiles()
+{
+	return UnixDir::GetNumberOfFiles(this->workingDir);
+}
+
+size_lt UnixDir::GetNumberOfFiles(const char *path)
+{
+	return UnixDir::Walk(path, DirVisitor(), false).files;
+}
+
+void UnixDir::MakeDir()
+{
+	UnixDir::MakeDir(this->workingDir);
+}
+
+void UnixDir::MakeDir(const char *path)
+{
+	if (mkdir(path, 0755) < 0 && errno != EEXIST)
+	{
+		ThrowDirExceptionWithCode("Can't make the directory!", errno);
+	}
+}
+
+bool UnixDir::Exists()
+{
+	return UnixDir::Exists(this->workingDir);
+}
+
+bool UnixDir::Exists(const char *path)
+{
+	struct stat st;
+	return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+DirStats UnixDir::Walk(const char *path, const DirVisitor &visitor, bool withSizes)
+{
+	int root = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (root < 0)
+	{
+		ThrowDirExceptionWithCode("Can't open the directory!", errno);
+	}
+
+	DirWalk walk([root](DirWalk &walk, const std::string &path) { UnixDir::ScanDir(walk, root, path); }, visitor, withSizes);
+	try
+	{
+		DirStats stats = walk.Run();
+		close(root);
+		return stats;
+	}
+	catch (...)
+	{
+		close(root);
+		throw;
+	}
+}
+
+void UnixDir::ScanDir(DirWalk &walk, int root, const std::string &path)
+{
+	int dir = openat(root, path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+	if (dir < 0)
+	{
+		// Removed (or replaced by a link) after it was listed
+		if (errno != ENOENT && errno != ENOTDIR && errno != ELOOP)
+		{
+			walk.SetError(errno);
+		}
+		return;
+	}
+
+	DirStats stats = { 0, 0, 0 };
+	bool visiting = walk.IsVisiting();
+	bool withStat = visiting || walk.IsWithSizes();
+	std::string subPath;
+
+	char buffer[DIR_BUFFER_SIZE];
+	long readed;
+	while ((readed = syscall(SYS_getdents64, dir, buffer, sizeof(buffer))) > 0)
+	{
+		for (long pos = 0; pos < readed;)
+		{
+			UnixDirent64 *dirent = (UnixDirent64*)(buffer + pos);
+			pos += dirent->d_reclen;
+			const char *name = dirent->d_name;
+			unsigned char type = dirent->d_type;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+			{
+				continue;
+			}
+
+			struct stat st;
+			if (type == DT_UNKNOWN || (withStat && (type == DT_REG || visiting)))
+			{
+				if (fstatat(dir, name, &st, AT_SYMLINK_NOFOLLOW) < 0)
+				{
+					if (errno != ENOENT)
+					{
+						walk.SetError(errno);
+					}
+					continue;
+				}
+				type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+			}
+
+			bool directory = type == DT_DIR;
+			if (directory)
+			{
+				subPath = path;
+				if (!subPath.empty())
+				{
+					subPath += '/';
+				}
+				subPath += name;
+				walk.Enqueue(subPath);
+				stats.dirs++;
+			}
+			else
+			{
+				stats.files++;
+				if (type == DT_REG && withStat)
+				{
+					stats.size += st.st_size;
+				}
+			}
+
+			if (visiting)
+			{
+				DirEntry entry;
+				entry.dirPath = path.c_str();
+				entry.name = name;
+				entry.size = type == DT_REG ? st.st_size : 0;
+				entry.modTime = st.st_mtime;
+				entry.directory = directory;
+				walk.Visit(entry);
+			}
+		}
+	}
+
+	if (readed < 0)
+	{
+		walk.SetError(errno);
+	}
+	close(dir);
+	walk.Add(stats);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*!
+\file unixdir.h "server\desktop\src\cross\unix\unixdir.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 08 September 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../idir.h"
+#include "../../common/dirwalk.h"
+
+/*!
+\class UnixDir unixdir.h "server\desktop\src\cross\unix\unixdir.h"
+\brief  The Unix dependent directory.
+The tree is read in parallel with DirWalk. Every directory is opened with openat
+relative to the walked one and read with getdents64 into one buffer per directory.
+*/
+class UnixDir : public IDir
+{
+public:
+	char workingDir[PATH_MAX];
+
+	UnixDir();
+	UnixDir(const char *path);
+	~UnixDir();
+
+	virtual size_lt GetDirSize() override;
+	static size_lt GetDirSize(const char *path);
+
+	virtual size_lt GetNumberOfFiles() override;
+	static size_lt GetNumberOfFiles(const char *path);
+
+	virtual void MakeDir() override;
+	static void MakeDir(const char *path);
+
+	virtual bool Exists() override;
+	static bool Exists(const char *path);
+
+	/*!
+	Walks the directory tree in parallel.
+	\param[in] path The directory to be walked.
+	\param[in] visitor Receives every entry from many threads at once. May be empty.
+	\param[in] withSizes FALSE if only the numbers of the entries are needed.
+	\return The totals of the tree.
+	*/
+	static DirStats Walk(const char *path, const DirVisitor &visitor = DirVisitor(), bool withSizes = true);
+
+private:
+	/*!
+	Reads one directory of the walk.
+	\param[in] walk The walk.
+	\param[in] root The descriptor of the walked directory.
+	\param[in] path The path of the directory relative to the root.
+	*/
+	static void ScanDir(MSIYBCore::DirWalk &walk, int root, const std::string &path);
+};
+
+#endif
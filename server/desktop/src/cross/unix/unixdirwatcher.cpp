@@ -0,0 +1,293 @@
+#include "unixdirwatcher.h"
+#ifdef __unix__
+#include <sys/stat.h>
+#include <mutex>
+#include <vector>
+#include "unixdir.h"
+
+#define DIRWATCHER_MASK (IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+
+UnixDirWatcher::UnixDirWatcher() : _handler(NULL), _running(false)
+{
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotify < 0)
+	{
+		ThrowDirExceptionWithCode("Can't create the inotify instance!", errno);
+	}
+
+	_wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeUp < 0)
+	{
+		int error = errno;
+		close(_inotify);
+		ThrowDirExceptionWithCode("Can't create the wake up descriptor!", error);
+	}
+}
+
+UnixDirWatcher::~UnixDirWatcher()
+{
+	Stop();
+	close(_wakeUp);
+	close(_inotify);
+}
+
+void UnixDirWatcher::Start(const char *path, IDirWatcherHandler *handler)
+{
+	if (_running)
+	{
+		ThrowDirException("The watcher is already started!");
+	}
+
+	_root = path;
+	while (_root.size() > 1 && _root.back() == '/')
+	{
+		_root.pop_back();
+	}
+	_handler = handler;
+	AddWatches(std::string());
+
+	// Throws if the thread can't be created; the returned ID is of no use here
+	try
+	{
+		_running = true;
+		_thread.Start((void*)&UnixDirWatcher::ThreadFunc, this);
+	}
+	catch (...)
+	{
+		_running = false;
+		ClearWatches();
+		throw;
+	}
+}
+
+void UnixDirWatcher::Stop()
+{
+	if (!_running)
+	{
+		return;
+	}
+
+	uint64_t one = 1;
+	write(_wakeUp, &one, sizeof(one));
+	_thread.WaitToComplete();
+	_running = false;
+
+	uint64_t counter;
+	read(_wakeUp, &counter, sizeof(counter));
+	ClearWatches();
+}
+
+THREADFUNC UnixDirWatcher::ThreadFunc(void *args)
+{
+	((UnixDirWatcher*)args)->Run();
+	return 0;
+}
+
+void UnixDirWatcher::Run()
+{
+	alignas(inotify_event) char buffer[DIRWATCHER_BUFFER_SIZE];
+	pollfd descriptors[2];
+	descriptors[0].fd = _inotify;
+	descriptors[0].events = POLLIN;
+	descriptors[1].fd = _wakeUp;
+	descriptors[1].events = POLLIN;
+
+	while (true)
+	{
+		if (poll(descriptors, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		if (descriptors[1].revents)
+		{
+			break;
+		}
+
+		ssize_t readed;
+		while ((readed = read(_inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for (char *pos = buffer; pos < buffer + readed;)
+			{
+				const inotify_event *event = (const inotify_event*)pos;
+				pos += sizeof(inotify_event) + event->len;
+				try
+				{
+					Handle(event);
+				}
+				catch (std::exception &)
+				{
+					// The handler failed on this change, the next ones are still delivered
+				}
+			}
+		}
+	}
+}
+
+void UnixDirWatcher::AddWatches(const std::string &path)
+{
+	std::string fullPath = path.empty() ? _root : _root + '/' + path;
+	int watch = inotify_add_watch(_inotify, fullPath.c_str(), DIRWATCHER_MASK);
+	if (watch < 0)
+	{
+		if (path.empty())
+		{
+			ThrowDirExceptionWithCode("Can't watch the directory!", errno);
+		}
+		// Removed before it was watched
+		return;
+	}
+	_watches[watch] = path;
+
+	std::vector<std::string> dirs;
+	std::mutex dirsMutex;
+	UnixDir::Walk(fullPath.c_str(), [&dirs, &dirsMutex, &path](const DirEntry &entry)
+	{
+		if (entry.directory)
+		{
+			std::string dir = path;
+			if (!dir.empty())
+			{
+				dir += '/';
+			}
+			if (entry.dirPath[0] != '\0')
+			{
+				dir += entry.dirPath;
+				dir += '/';
+			}
+			dir += entry.name;
+
+			std::lock_guard<std::mutex> guard(dirsMutex);
+			dirs.push_back(std::move(dir));
+		}
+	}, false);
+
+	for (size_lt i = 0; i < dirs.size(); i++)
+	{
+		watch = inotify_add_watch(_inotify, (_root + '/' + dirs[i]).c_str(), DIRWATCHER_MASK);
+		if (watch < 0)
+		{
+			if (errno == ENOSPC)
+			{
+				ThrowDirExceptionWithCode("Too many directories to watch!", errno);
+			}
+			continue;
+		}
+		_watches[watch] = dirs[i];
+	}
+}
+
+void UnixDirWatcher::ClearWatches()
+{
+	for (auto it = _watches.begin(); it != _watches.end(); ++it)
+	{
+		inotify_rm_watch(_inotify, it->first);
+	}
+	_watches.clear();
+}
+
+void UnixDirWatcher::RemoveWatches(const std::string &path)
+{
+	std::string prefix = path + '/';
+	for (auto it = _watches.begin(); it != _watches.end();)
+	{
+		if (it->second == path || it->second.compare(0, prefix.size(), prefix) == 0)
+		{
+			inotify_rm_watch(_inotify, it->first);
+			it = _watches.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void UnixDirWatcher::Handle(const inotify_event *event)
+{
+	if (event->mask & IN_Q_OVERFLOW)
+	{
+		// The lost events may have created or moved the directories: the tree is watched anew
+		ClearWatches();
+		AddWatches(std::string());
+		DirChange change = { DIRCHANGEOVERFLOW, "", true, 0, 0 };
+		_handler->OnDirChange(change);
+		return;
+	}
+
+	auto watch = _watches.find(event->wd);
+	if (watch == _watches.end())
+	{
+		return;
+	}
+	if (event->mask & IN_IGNORED)
+	{
+		// The directory is gone, its removal is reported by the parent
+		_watches.erase(watch);
+		return;
+	}
+	if (event->len == 0)
+	{
+		return;
+	}
+
+	std::string path = watch->second;
+	if (!path.empty())
+	{
+		path += '/';
+	}
+	path += event->name;
+	bool directory = (event->mask & IN_ISDIR) != 0;
+
+	if (event->mask & (IN_CREATE | IN_MOVED_TO))
+	{
+		if (directory)
+		{
+			AddWatches(path);
+		}
+		Report(DIRCHANGEADDED, path, directory);
+	}
+	else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+	{
+		if (directory)
+		{
+			RemoveWatches(path);
+		}
+		Report(DIRCHANGEREMOVED, path, directory);
+	}
+	else if (event->mask & IN_CLOSE_WRITE)
+	{
+		Report(DIRCHANGEMODIFIED, path, false);
+	}
+}
+
+void UnixDirWatcher::Report(DirChangeType type, const std::string &path, bool directory)
+{
+	DirChange change;
+	change.type = type;
+	change.path = path.c_str();
+	change.directory = directory;
+	change.size = 0;
+	change.modTime = 0;
+
+	if (type != DIRCHANGEREMOVED)
+	{
+		struct stat st;
+		if (lstat((_root + '/' + path).c_str(), &st) < 0)
+		{
+			return;
+		}
+		if (!directory && S_ISREG(st.st_mode))
+		{
+			change.size = st.st_size;
+		}
+		change.modTime = st.st_mtime;
+	}
+
+	_handler->OnDirChange(change);
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*!
+\file unixdirwatcher.h "server\desktop\src\cross\unix\unixdirwatcher.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 September 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string>
+#include <unordered_map>
+#include "../idirwatcher.h"
+#include "../../common/thread.h"
+
+#define DIRWATCHER_BUFFER_SIZE (64 * 1024)
+
+/*!
+\class UnixDirWatcher unixdirwatcher.h "server\desktop\src\cross\unix\unixdirwatcher.h"
+\brief  The inotify watcher of the directory tree (Linux).
+inotify is not recursive: every directory has its own watch, the new directories are watched as they appear.
+The files are reported modified when they are closed after writing, not on every write.
+The number of the directories is limited by /proc/sys/fs/inotify/max_user_watches.
+*/
+class UnixDirWatcher : public IDirWatcher
+{
+public:
+	/*!
+	Creates the inotify instance and the wake up descriptor used by Stop.
+	*/
+	UnixDirWatcher();
+
+	/*!
+	Stops watching and closes the descriptors.
+	*/
+	~UnixDirWatcher();
+
+	virtual void Start(const char *path, IDirWatcherHandler *handler) override;
+	virtual void Stop() override;
+
+private:
+	/*!
+	The thread function. Reads the events until Stop is called.
+	\param[in] args The watcher.
+	*/
+	static THREADFUNC ThreadFunc(void *args);
+
+	/*!
+	Reads and dispatches the events until Stop is called.
+	*/
+	void Run();
+
+	/*!
+	Watches the directory and all its subdirectories.
+	\param[in] path The path of the directory relative to the root.
+	*/
+	void AddWatches(const std::string &path);
+
+	/*!
+	Drops all the watches.
+	*/
+	void ClearWatches();
+
+	/*!
+	Drops the watches of the directory and all its subdirectories.
+	\param[in] path The path of the directory relative to the root.
+	*/
+	void RemoveWatches(const std::string &path);
+
+	/*!
+	Translates the inotify event into the changes.
+	\param[in] event The event.
+	*/
+	void Handle(const inotify_event *event);
+
+	/*!
+	Passes the change to the handler. Stat-s the added and modified files, the files already gone are skipped.
+	*/
+	void Report(DirChangeType type, const std::string &path, bool directory);
+
+	int _inotify;									///< The inotify descriptor
+	int _wakeUp;									///< The eventfd signalled by Stop
+	std::string _root;								///< The watched directory
+	IDirWatcherHandler *_handler;					///< The receiver of the changes
+	std::unordered_map<int, std::string> _watches;	///< The relative paths of the watched directories
+	Thread _thread;									///< Reads the events
+	bool _running;									///< TRUE between Start and Stop
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "unixeventloop.h"
+#ifdef __linux__
+
+UnixEventLoop::UnixEventLoop()
+{
+	_running = false;
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll == -1)
+		ThrowSocketExceptionWithCode("Error epoll_create1, errno ", errno);
+
+	_wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeUp == -1)
+	{
+		close(_epoll);
+		ThrowSocketExceptionWithCode("Error eventfd, errno ", errno);
+	}
+
+	// Wake up descriptor is marked with the NULL handler
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeUp, &ev) == -1)
+	{
+		close(_wakeUp);
+		close(_epoll);
+		ThrowSocketExceptionWithCode("Error epoll_ctl, errno ", errno);
+	}
+}
+
+UnixEventLoop::~UnixEventLoop()
+{
+	close(_wakeUp);
+	close(_epoll);
+}
+
+unsigned int UnixEventLoop::ToEpollEvents(int events)
+{
+	unsigned int epollEvents = EPOLLET | EPOLLRDHUP;
+	if (events & EVENTREAD)
+		epollEvents |= EPOLLIN;
+	if (events & EVENTWRITE)
+		epollEvents |= EPOLLOUT;
+	return epollEvents;
+}
+
+int UnixEventLoop::FromEpollEvents(unsigned int epollEvents)
+{
+	int events = EVENTNONE;
+	if (epollEvents & EPOLLIN)
+		events |= EVENTREAD;
+	if (epollEvents & EPOLLOUT)
+		events |= EVENTWRITE;
+	if (epollEvents & EPOLLERR)
+		events |= EVENTERROR;
+	if (epollEvents & (EPOLLHUP | EPOLLRDHUP))
+		events |= EVENTHANGUP;
+	return events;
+}
+
+void UnixEventLoop::Add(ISocket *socket, IEventHandler *handler, int events)
+{
+	AddDescriptor(socket->GetDescriptor(), handler, events);
+}
+
+void UnixEventLoop::Modify(ISocket *socket, IEventHandler *handler, int events)
+{
+	epoll_event ev;
+	ev.events = ToEpollEvents(events);
+	ev.data.ptr = handler;
+	if (epoll_ctl(_epoll, EPOLL_CTL_MOD, socket->GetDescriptor(), &ev) == -1)
+		ThrowSocketExceptionWithCode("Error epoll_ctl mod, errno ", errno);
+}
+
+void UnixEventLoop::Remove(ISocket *socket)
+{
+	RemoveDescriptor(socket->GetDescriptor());
+}
+
+void UnixEventLoop::AddDescriptor(t_descriptor descriptor, IEventHandler *handler, int events)
+{
+	epoll_event ev;
+	ev.events = ToEpollEvents(events);
+	ev.data.ptr = handler;
+	if (epoll_ctl(_epoll, EPOLL_CTL_ADD, descriptor, &ev) == -1)
+		ThrowSocketExceptionWithCode("Error epoll_ctl add, errno ", errno);
+}
+
+void UnixEventLoop::RemoveDescriptor(t_descriptor descriptor)
+{
+	epoll_event ev;
+	if (epoll_ctl(_epoll, EPOLL_CTL_DEL, descriptor, &ev) == -1)
+		ThrowSocketExceptionWithCode("Error epoll_ctl del, errno ", errno);
+}
+
+int UnixEventLoop::Poll(unsigned long timeout)
+{
+	int waitTimeout = timeout == INFINITE ? -1 : (int)timeout;
+	int count = epoll_wait(_epoll, _events, EVENTLOOP_MAX_EVENTS, waitTimeout);
+	if (count == -1)
+	{
+		if (errno == EINTR)
+			return 0;
+		ThrowSocketExceptionWithCode("Error epoll_wait, errno ", errno);
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		IEventHandler *handler = (IEventHandler*)_events[i].data.ptr;
+		if (!handler)
+		{
+			eventfd_t value;
+			eventfd_read(_wakeUp, &value);
+			continue;
+		}
+		handler->HandleEvents(FromEpollEvents(_events[i].events));
+	}
+	return count;
+}
+
+void UnixEventLoop::Run()
+{
+	_running = true;
+	while (_running)
+	{
+		Poll(INFINITE);
+	}
+}
+
+void UnixEventLoop::Stop()
+{
+	_running = false;
+	eventfd_write(_wakeUp, 1);
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*!
+\file unixeventloop.h "server\desktop\src\cross\unix\unixeventloop.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 14 August 2017
+*/
+
+#pragma once
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <atomic>
+#include "../ieventloop.h"
+
+#define EVENTLOOP_MAX_EVENTS 1024
+
+/*!
+\class UnixEventLoop unixeventloop.h "server\desktop\src\cross\unix\unixeventloop.h"
+\brief  Linux dependent event loop.
+Edge-triggered epoll reactor: one thread can watch tens of thousands of idle connections.
+*/
+class UnixEventLoop : public IEventLoop
+{
+public:
+	/*!
+	Creates the epoll instance and the wake up descriptor used by Stop.
+	*/
+	UnixEventLoop();
+
+	/*!
+	Closes the epoll instance. Registered sockets are not closed.
+	*/
+	~UnixEventLoop();
+
+	virtual void Add(ISocket *socket, IEventHandler *handler, int events) override;
+	virtual void Modify(ISocket *socket, IEventHandler *handler, int events) override;
+	virtual void Remove(ISocket *socket) override;
+	virtual void AddDescriptor(t_descriptor descriptor, IEventHandler *handler, int events) override;
+	virtual void RemoveDescriptor(t_descriptor descriptor) override;
+	virtual int Poll(unsigned long timeout = INFINITE) override;
+	virtual void Run() override;
+	virtual void Stop() override;
+
+private:
+	/*!
+	Converts EventType flags into the edge-triggered epoll flags.
+	\param[in] events The combination of EventType flags.
+	\return The epoll flags.
+	*/
+	static unsigned int ToEpollEvents(int events);
+
+	/*!
+	Converts epoll flags into EventType flags.
+	\param[in] epollEvents The epoll flags.
+	\return The combination of EventType flags.
+	*/
+	static int FromEpollEvents(unsigned int epollEvents);
+
+	int _epoll;									///< The epoll descriptor
+	int _wakeUp;								///< The eventfd descriptor to interrupt epoll_wait
+	std::atomic<bool> _running;					///< FALSE after Stop is called
+	epoll_event _events[EVENTLOOP_MAX_EVENTS];	///< The events returned by the last epoll_wait
+};
+
+#endif
@@ -0,0 +1,518 @@
+#include "unixfile.h"
+#ifdef __unix__
+
+UnixFile::UnixFile()
+{
+	_fileName = (char*)MSIYBCore::Pool::Allocate(PATH_MAX);
+	_fileName[0] = '\0';
+	_hFile = -1;
+	_opened = false;
+	_mapped = false;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
+}
+
+UnixFile::UnixFile(const char *fileName)
+{
+	_fileName = (char*)MSIYBCore::Pool::Allocate(PATH_MAX);
+	if (!_fileName)
+	{
+		ThrowException("Can't allocate memory on fileName");
+	}
+
+	strcpy(_fileName, fileName);
+	_hFile = -1;
+	_opened = false;
+	_mapped = false;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
+}
+
+UnixFile::~UnixFile()
+{
+	if (_opened)
+	{
+		Close();
+	}
+
+	MSIYBCore::Pool::Free((byte*)_fileName, PATH_MAX);
+}
+
+void UnixFile::Open(FileOpenMode mode)
+{
+	_hFile = OpenFile(_fileName, mode);
+	_opened = true;
+	if (mode == FileOpenMode::MAPPED)
+	{
+		try
+		{
+			Map();
+		}
+		catch (FileException &)
+		{
+			// The file which can't be mapped is not opened: the handle is not left to the destructor
+			Close();
+			throw;
+		}
+	}
+}
+
+void UnixFile::Open(const char *fileName, FileOpenMode mode)
+{
+	strcpy(_fileName, fileName);
+	Open(mode);
+}
+
+int UnixFile::OpenFile(const char *fileName, FileOpenMode mode)
+{
+	int flags = O_RDONLY;
+	switch (mode)
+	{
+	case FileOpenMode::READONLY:
+	case FileOpenMode::MAPPED:
+		flags = O_RDONLY;
+		break;
+	case FileOpenMode::WRITE:
+		flags = O_WRONLY;
+		break;
+	case FileOpenMode::READWRITE:
+		flags = O_RDWR | O_CREAT | O_TRUNC;
+		break;
+	case FileOpenMode::WRITENEWFILE:
+		flags = O_RDWR | O_CREAT | O_TRUNC;
+		break;
+	case FileOpenMode::WRITEATTHEEND:
+		flags = O_RDWR | O_CREAT;
+		break;
+	}
+
+	int hFile = open(fileName, flags | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (hFile == -1)
+	{
+		ThrowFileExceptionWithCode("Error occured while opening file.", errno);
+	}
+	return hFile;
+}
+
+void UnixFile::Close()
+{
+	Unmap();
+	Close(_hFile);
+	_hFile = -1;
+	_opened = false;
+}
+
+void UnixFile::Close(int hFile)
+{
+	if (hFile != -1)
+	{
+		if (close(hFile) == -1)
+		{
+			ThrowFileExceptionWithCode("Error occured while closing file!", errno);
+		}
+	}
+}
+
+void UnixFile::Rename(const char *newFileName)
+{
+	Rename(_fileName, newFileName);
+	strcpy(_fileName, newFileName);
+}
+
+void UnixFile::Rename(const char *fileName, const char *newFileName)
+{
+	if (rename(fileName, newFileName) == -1)
+	{
+		ThrowFileExceptionWithCode("Can't rename file", errno);
+	}
+}
+
+void UnixFile::Sync()
+{
+	if (fsync(_hFile) == -1)
+	{
+		ThrowFileExceptionWithCode("Can't write file to disk!", errno);
+	}
+}
+
+void UnixFile::Replace(const char *fileName, const char *newFileName)
+{
+	// rename() replaces the target atomically
+	Rename(fileName, newFileName);
+
+	// The new entry is durable only after the directory is synced
+	char directory[PATH_MAX];
+	strncpy(directory, newFileName, PATH_MAX - 1);
+	directory[PATH_MAX - 1] = '\0';
+	char *slash = strrchr(directory, '/');
+	if (slash)
+	{
+		slash[slash == directory ? 1 : 0] = '\0';
+	}
+	else
+	{
+		strcpy(directory, ".");
+	}
+	int hDirectory = open(directory, O_RDONLY | O_DIRECTORY);
+	if (hDirectory == -1)
+	{
+		ThrowFileExceptionWithCode("Can't write file to disk!", errno);
+	}
+	int error = fsync(hDirectory) == -1 ? errno : 0;
+	close(hDirectory);
+	if (error)
+	{
+		ThrowFileExceptionWithCode("Can't write file to disk!", error);
+	}
+}
+
+bool UnixFile::Exist()
+{
+	return Exist(_fileName);
+}
+
+bool UnixFile::Exist(const char *fileName)
+{
+	struct stat st;
+	return stat(fileName, &st) == 0;
+}
+
+void UnixFile::Delete()
+{
+	if (_opened)
+	{
+		Close();
+	}
+	Delete(_fileName);
+}
+
+void UnixFile::Delete(const char *fileName)
+{
+	if (unlink(fileName) == -1)
+	{
+		ThrowFileExceptionWithCode("Can't delete file!", errno);
+	}
+}
+
+size_lt UnixFile::FileSize()
+{
+	return _opened ? FileSize(_hFile) : FileSize(_fileName);
+}
+
+size_lt UnixFile::FileSize(int hFile)
+{
+	struct stat st;
+	if (fstat(hFile, &st) == -1)
+	{
+		ThrowFileExceptionWithCode("Can't get file size!", errno);
+	}
+	return st.st_size;
+}
+
+size_lt UnixFile::FileSize(const char *fileName)
+{
+	struct stat st;
+	if (stat(fileName, &st) == -1)
+	{
+		ThrowFileExceptionWithCode("Can't get file size!", errno);
+	}
+	return st.st_size;
+}
+
+size_lt UnixFile::Seek(size_lt offset, SeekReference move)
+{
+	if (_mapped)
+	{
+		size_lt base = move == SeekReference::START ? 0 : move == SeekReference::CURRENT ? _viewPos : _viewSize;
+		_viewPos = base + offset;
+		return _viewPos;
+	}
+
+	int whence = SEEK_SET;
+	switch (move)
+	{
+	case SeekReference::START:
+		whence = SEEK_SET;
+		break;
+	case SeekReference::CURRENT:
+		whence = SEEK_CUR;
+		break;
+	case SeekReference::END:
+		whence = SEEK_END;
+		break;
+	}
+
+	off_t pos = lseek(_hFile, (off_t)offset, whence);
+	if (pos == (off_t)-1)
+	{
+		ThrowFileExceptionWithCode("Can't set pointer in file on new position!", errno);
+	}
+	return pos;
+}
+
+int UnixFile::ReadByte()
+{
+	if (_mapped)
+	{
+		return _viewPos < _viewSize ? (int)_view[_viewPos++] : -1;
+	}
+
+	byte b;
+	if (ReadBlock(_hFile, &b, 1) == 0)
+	{
+		return -1;
+	}
+	return (int)b;
+}
+
+size_lt UnixFile::ReadBlock(byte *block, size_lt blockSize)
+{
+	if (_mapped)
+	{
+		size_lt left = _viewPos < _viewSize ? _viewSize - _viewPos : 0;
+		size_lt readed = blockSize < left ? blockSize : left;
+		memcpy(block, _view + _viewPos, readed);
+		_viewPos += readed;
+		return readed;
+	}
+	return ReadBlock(_hFile, block, blockSize);
+}
+
+size_lt UnixFile::ReadBlock(int hFile, byte *block, size_lt blockSize)
+{
+	size_lt readedBytes = 0;
+	while (readedBytes < blockSize)
+	{
+		ssize_t readed = read(hFile, block + readedBytes, blockSize - readedBytes);
+		if (readed == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (readed == -1)
+		{
+			ThrowFileExceptionWithCode("Can't read data from file!", errno);
+		}
+		if (readed == 0)
+		{
+			break;
+		}
+		readedBytes += readed;
+	}
+	return readedBytes;
+}
+
+void UnixFile::WriteByte(byte b)
+{
+	WriteBlock(&b, 1);
+}
+
+void UnixFile::WriteBlock(byte *block, size_lt sizeBlock)
+{
+	WriteBlock(_hFile, block, sizeBlock);
+}
+
+void UnixFile::WriteBlock(int hFile, byte *block, size_lt sizeBlock)
+{
+	size_lt writed = 0;
+	while (writed < sizeBlock)
+	{
+		ssize_t res = write(hFile, block + writed, sizeBlock - writed);
+		if (res == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (res == -1)
+		{
+			ThrowFileExceptionWithCode("Can't write data into file!", errno);
+		}
+		writed += res;
+	}
+}
+
+size_lt UnixFile::ReadBlockV(IOBuffer *buffers, size_lt count)
+{
+	if (_mapped)
+	{
+		size_lt readed = 0;
+		for (size_lt i = 0; i < count; i++)
+		{
+			size_lt part = ReadBlock(buffers[i].data, buffers[i].size);
+			readed += part;
+			if (part < buffers[i].size)
+			{
+				break;
+			}
+		}
+		return readed;
+	}
+
+	iovec iov[IOBUFFER_MAX_COUNT];
+	size_lt readed = 0;
+	size_lt index = 0;
+	size_lt skip = 0;
+	AdvanceIOBuffers(buffers, count, &index, &skip, 0);
+	while (index < count)
+	{
+		int iovCount = 0;
+		for (size_lt i = index; i < count && iovCount < IOBUFFER_MAX_COUNT; i++, iovCount++)
+		{
+			iov[iovCount].iov_base = buffers[i].data + (i == index ? skip : 0);
+			iov[iovCount].iov_len = buffers[i].size - (i == index ? skip : 0);
+		}
+
+		ssize_t res = readv(_hFile, iov, iovCount);
+		if (res == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (res == -1)
+		{
+			ThrowFileExceptionWithCode("Can't read data from file!", errno);
+		}
+		if (res == 0)
+		{
+			break;
+		}
+		readed += res;
+		AdvanceIOBuffers(buffers, count, &index, &skip, res);
+	}
+	return readed;
+}
+
+void UnixFile::WriteBlockV(IOBuffer *buffers, size_lt count)
+{
+	WriteBlockV(_hFile, buffers, count);
+}
+
+void UnixFile::WriteBlockV(int hFile, IOBuffer *buffers, size_lt count)
+{
+	iovec iov[IOBUFFER_MAX_COUNT];
+	size_lt index = 0;
+	size_lt skip = 0;
+	AdvanceIOBuffers(buffers, count, &index, &skip, 0);
+	while (index < count)
+	{
+		int iovCount = 0;
+		for (size_lt i = index; i < count && iovCount < IOBUFFER_MAX_COUNT; i++, iovCount++)
+		{
+			iov[iovCount].iov_base = buffers[i].data + (i == index ? skip : 0);
+			iov[iovCount].iov_len = buffers[i].size - (i == index ? skip : 0);
+		}
+
+		ssize_t res = writev(hFile, iov, iovCount);
+		if (res == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		if (res == -1)
+		{
+			ThrowFileExceptionWithCode("Can't write data into file!", errno);
+		}
+		AdvanceIOBuffers(buffers, count, &index, &skip, res);
+	}
+}
+
+t_filehandle UnixFile::GetHandle()
+{
+	return _hFile;
+}
+
+ByteSpan UnixFile::GetView()
+{
+	if (!_mapped)
+	{
+		ThrowFileException("File isn't opened in the MAPPED mode!");
+	}
+	ByteSpan view = { _view, _viewSize };
+	return view;
+}
+
+void UnixFile::SetAccessPattern(FileAccessPattern pattern)
+{
+	int advice = POSIX_FADV_NORMAL;
+	switch (pattern)
+	{
+	case FileAccessPattern::FILEACCESSSEQUENTIAL:
+		advice = POSIX_FADV_SEQUENTIAL;
+		break;
+	case FileAccessPattern::FILEACCESSRANDOM:
+		advice = POSIX_FADV_RANDOM;
+		break;
+	default:
+		break;
+	}
+	// Only a hint, the errors are not interesting
+	posix_fadvise(_hFile, 0, 0, advice);
+}
+
+void UnixFile::Prefetch(size_lt offset, size_lt length)
+{
+#ifdef __linux__
+	readahead(_hFile, (off_t)offset, length);
+#else
+	posix_fadvise(_hFile, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+#endif
+}
+
+void UnixFile::Map()
+{
+	_viewSize = FileSize(_hFile);
+	_viewPos = 0;
+	_view = NULL;
+	// mmap can't map 0 bytes, the empty file has the empty view
+	if (_viewSize > 0)
+	{
+		void *view = mmap(NULL, _viewSize, PROT_READ, MAP_SHARED, _hFile, 0);
+		if (view == MAP_FAILED)
+		{
+			ThrowFileExceptionWithCode("Can't map file into memory!", errno);
+		}
+		_view = (byte*)view;
+	}
+	_mapped = true;
+}
+
+void UnixFile::Unmap()
+{
+	if (_view)
+	{
+		munmap(_view, _viewSize);
+	}
+	_mapped = false;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
+}
+
+size_lt UnixFile::ReadAllBytes(const char *fileName, byte **block)
+{
+	int hFile = OpenFile(fileName, FileOpenMode::READONLY);
+	size_lt fSize = FileSize(hFile);
+	byte *blockT = new byte[fSize];
+	if (!blockT)
+	{
+		ThrowFileExceptionWithCode("Cant allocate memory for block array", errno);
+	}
+
+	fSize = ReadBlock(hFile, blockT, fSize);
+	*block = blockT;
+	Close(hFile);
+	return fSize;
+}
+
+void UnixFile::WriteAllBytes(const char *fileName, byte *data, size_lt size, FileOpenMode mode)
+{
+	int hFile = OpenFile(fileName, mode);
+	WriteBlock(hFile, data, size);
+	Close(hFile);
+}
+
+FileMeta UnixFile::LastModified(const char *fileName)
+{
+	FileMeta meta;
+	return meta;
+}
+
+#endif
@@ -1,336 +1,299 @@
-#ifndef UNIXFILE_H
-#define UNIXFILE_H
+/*!
+\file unixfile.h "server\desktop\src\cross\unix\unixfile.h"
+\authors Alexandr Barulev, Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 0.2
+\date 21 August 2017
+*/
+
+#pragma once
 #ifdef __unix__
-#include "Ifile.h"
+#include "../ifile.h"
+#include "../../common/pool.h"
 #include <fcntl.h>
 #include <stdio.h>
+#include <errno.h>
 #include <sys/stat.h>
-#include <linux/limits.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <unistd.h>
 
-typedef int HANDLE;
-
-class UnixFile: public IFile
-{
-    int _hFile;
-    char *_fileName;
-    byte *cacheBuffer;
-    int sizeCacheBuffer;
-    int cacheBufferPos;
-    bool opened;
-    struct stat fStat;
-
-    /////////////////////////////////////////
-    static void ParseMode(int *flags, mode_t *mode, FileMode fMode)
-    {
-        *mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-        *flags = O_RDONLY; // open read
-        if (fMode == FileMode::OpenWrite) *flags = O_RDWR;
-        if (fMode == FileMode::OpenWriteIfExist) *flags = O_RDWR | O_CREAT;
-    }
-
-    static void ParseAcess()
-    {
-
-    }
-
-    static HANDLE OpenFile_(const char *fileName, FileMode fMode)
-    {
-        int flags;
-        mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-        ParseMode(&flags, &mode, fMode);
-
-        HANDLE hFile = open(fileName, flags, mode);
-        if (hFile == -1)
-            ThrowFileException("Error: open , errno ", errno);
-
-        return hFile;
-    }
-
-    static unsigned long long ReadBlock_(HANDLE hFile,  byte* buf, unsigned long long sizeBuf = MIN_BUFFER_SIZE)
-    {
-        unsigned long long readedT = 0;
-        long long readed = 1;
-
-        while (readed > 0)
-        {
-            readed = read(hFile, buf + readedT, sizeBuf - readedT);
-            readedT += readed;
-        }
-
-        if (readed == -1)
-            ThrowFileException("Error: read, errno :", errno);
-        return readedT;
-    }
-
-    static void WriteBlock_(HANDLE hFile,  byte *buf, unsigned long long size)
-    {
-         long long writed = 1;
-        unsigned long long writedT = 0;
-
-        while (writed > 0 && size)
-        {
-            writed = write(hFile, buf + writedT, size);
-            size -= writed;
-            writedT += writed;
-        }
-        if (writed == -1)
-            ThrowFileException("Error write, errno: ", errno);
-    }
-
-    unsigned long long SetFilePointer(HANDLE hFile, unsigned long long pos, MoveMethod move)
-    {
-
-    }
-
-    unsigned long long SetFilePointer_(unsigned long long pos, MoveMethod move)
-    {
-
-//        int err = lseek()
-//        LARGE_INTEGER ps, FilePos;
-//        ps.QuadPart = (unsigned long long)pos;
-//        long res = SetFilePointerEx(_hFile, ps, (PLARGE_INTEGER)&FilePos, move);
-//        if (res == INVALID_SET_FILE_POINTER)
-//        {
-//            char message[128];
-//            sprintf(message, "%s %d", "Error InvalidSetFilePointer, GetLastError: ", GetLastError());
-//            ThrowException(message);
-//        }
-//        return FilePos.QuadPart;
-    }
-
-    static void Close(HANDLE hFile)
-    {
-        if (close(hFile) == -1)
-            ThrowExceptionWithCode("Error close, errno: ", errno);
-    }
-
-/*    public:
-    static DWORD GetFileType_(HANDLE hFile)
-    {
-        DWORD res = GetFileType(hFile);
-        return res;
-    }
+/*!
+\class UnixFile unixfile.h "server\desktop\src\cross\unix\unixfile.h"
+\brief  The Unix dependent structure of the file.
+Provides the POSIX access to the file methods.
 */
-    static void GetFileInfo_(HANDLE hFile)
-    {
-        /*LPVOID *FileStruct;
-        DWORD type = GetFileType(hFile);
-        if (type == 0)
-            FileStruct = (LPVOID*)(PFILE_BASIC_INFO)malloc(sizeof(FILE_BASIC_INFO));
-        if (type == )
-        GetFileInformationByHandleEx(hFile, type, );*/
-    }
+class UnixFile : public IFile, public MSIYBCore::Pooled
+{
 public:
-    UnixFile() : _fileName(NULL), sizeCacheBuffer(MIN_BUFFER_SIZE), cacheBufferPos(0) {}
-
-    UnixFile(const char *fileName, FileMode mode = OpenRead)
-    {
-        try
-        {
-            _fileName = new char[PATH_MAX];
-            if (!_fileName)
-                ThrowException("Cant alloc memory for fileName");
-
-            sizeCacheBuffer = MIN_BUFFER_SIZE;
-            cacheBuffer = new byte[MIN_BUFFER_SIZE];
-            cacheBufferPos = 0;
-
-            strcpy(_fileName, fileName);
-            _fileName[strlen(fileName) - 1] = '\0';
-            opened = 0;
-            //_hFile = OpenFile_(_fileName, mode);
-        }
-        catch (Exception &e)
-        {
-            throw e;
-        }
-    }
-
-    ~UnixFile()
-    {
-        if (opened) Close();
-        if (_fileName) delete _fileName;
-        if (cacheBuffer) delete cacheBuffer;
-    }
-
-    static char* GetFileInfo()
-    {
-
-    }
-
-
-
-    static bool Exist(const char *fileName)
-    {
-        struct stat st;
-        int result = stat(fileName, &st);
-        return result == 0;
-    }
-
-    bool Exist()
-    {
-        return Exist(_fileName);
-    }
-
-    void Delete()
-    {
-        Delete(_fileName);
-    }
-
-    static void Delete(const char *fileName)
-    {
-        if(remove(fileName) == -1)
-            ThrowFileException("error remove, errno", errno);
-    }
-
-
-    void Open(const char *fileName, FileMode mode)
-    {
-        //try
-        //{
-			_hFile = OpenFile_(fileName, mode);
-			if (!_fileName) _fileName = new char[PATH_MAX];
-			if (!_fileName) ThrowException("Cant alloc memory fileName");
-			strcpy(_fileName, fileName);
-			opened = 1;
-//			return FileState::FileOk;
-        //}
-        //catch (FileException &e)
-        //{
-
-        //}
-    }
-
-    void Close()
-    {
-        Close(_hFile);
-    }
-
-    static void Rename(const char *oldFileName, const char *newFileName)
-    {
-        if (rename(oldFileName, newFileName) == -1)
-            ThrowFileException("Error rename, errno :", errno);
-    }
-
-    void Rename(const char *newFileName)
-    {
-        Rename(_fileName, newFileName);
-        strcpy(_fileName, newFileName);
-    }
-
-
-
-
-
-
-    unsigned long long Seek()
-    {
-      //  unsigned long long FilePos = SetFilePosition(0, MoveMethod::Current);
-        return 0;//FilePos;
-    }
-
-    unsigned long long FileSize()
-    {
-        return FileSize(this->_fileName);
-    }
-
-    void SetOffset(unsigned long long distance, MoveMethod move)
-    {
-    //    SetFilePointer_(distance, move);
-    }
-
-
-
-
-    int ReadByte()
-    {
-        byte c;
-        ReadBlock_(_hFile, &c, 1);
-        return (int)c;
-    }
-
-    unsigned long long ReadFromFile(byte* byteArr, unsigned long long size)
-    {
-        return ReadBlock_(_hFile,  byteArr, size);
-    }
-
-
-
-    void WriteToFile(byte *data, unsigned long long size)
-    {
-        WriteBlock_(_hFile, data, size);
-    }
-
-    void WriteByte(byte b)
-    {
-        WriteBlock_(_hFile, &b, 1);
-    }
-
-    ///////////////
-    // Static
-
-    static unsigned long long ReadAllBytes(byte **block, const char *fileName)
-    {
-        HANDLE hFile = OpenFile_(fileName, FileMode::OpenRead);
-        unsigned long long fSize = FileSize(fileName);
-        byte *blockArr = new byte[fSize];
-        if (!blockArr)
-            ThrowException("Cant Aloc memory for block arr");
-
-        ReadBlock_(hFile, blockArr, fSize);
-        *block = blockArr;
-        return fSize;
-    }
-
-    static void WriteAllBytes(byte* data, unsigned long long size, const char* fileName, FileMode mode = OpenWrite)
-    {
-        HANDLE hFile = OpenFile_(fileName, mode);
-        WriteBlock_(hFile, data, size);
-    }
-
-    static unsigned long long FileSize(const char *fileName)
-    {
-        struct stat st;
-        int err = stat(fileName, &st);
-        if (err == -1)
-            ThrowFileException("Error stat, errno", errno);
-        return st.st_size;
-    }
+	/*!
+	Initializes a filename with null values.
+	*/
+	UnixFile();
+
+	/*!
+	Sets a fileName with the determined value.
+	\param[in] fileName The name of the file.
+	*/
+	UnixFile(const char *fileName);
+
+	/*!
+	Deallocates memory and closes the file descriptor.
+	*/
+	~UnixFile();
+
+	/*!
+	Opens the file in the predetermined mode.
+	\param[in] mode The mode to open the file in (the list of the possible modes is defined in ifile.h).
+	*/
+	virtual void Open(FileOpenMode mode) override;
+
+	/*!
+	Opens the file.
+	\param[in] fileName The name of the file to be opened.
+	\param[in] mode The mode to open the file in.
+	*/
+	virtual void Open(const char *fileName, FileOpenMode mode) override;
+
+	/*!
+	Opens the file. Static.
+	\param[in] fileName The name of the file to be opened.
+	\param[in] mode The mode to open the file in.
+	\return The descriptor of the file.
+	*/
+	static int OpenFile(const char *fileName, FileOpenMode mode);
+
+	/*!
+	Closes the file descriptor.
+	*/
+	virtual void Close() override;
+
+	/*!
+	Closes the file. Static.
+	\param[in] hFile The descriptor of the opened file.
+	*/
+	static void Close(int hFile);
+
+	/*!
+	Sets a new file name.
+	\param[in] newFileName The name to be associated with the current file.
+	*/
+	virtual void Rename(const char *newFileName) override;
+
+	/*!
+	Sets a new file name. Static.
+	\param[in] fileName The current name of the file.
+	\param[in] newFileName The name to be associated with the current file.
+	*/
+	static void Rename(const char *fileName, const char *newFileName);
+
+	/*!
+	Writes the data of the opened file through the OS cache to the disk.
+	*/
+	virtual void Sync() override;
+
+	/*!
+	Renames the file over the existing one in one step: the new name has either the old file or the new one. Static.
+	The rename is written to the disk before the return.
+	\param[in] fileName The current name of the file.
+	\param[in] newFileName The name to be replaced.
+	*/
+	static void Replace(const char *fileName, const char *newFileName);
+
+	/*!
+	Checks if the file exists.
+	\return TRUE if the file exists, FALSE otherwise.
+	*/
+	virtual bool Exist() override;
+
+	/*!
+	Checks if the file exists. Static.
+	\param[in] fileName The name of the file.
+	\return TRUE if the file exists, FALSE otherwise.
+	*/
+	static bool Exist(const char *fileName);
+
+	/*!
+	Deletes the file.
+	*/
+	virtual void Delete() override;
+
+	/*!
+	Deletes the file. Static.
+	\param[in] fileName The name of the file.
+	*/
+	static void Delete(const char *fileName);
+
+	/*!
+	Returns the size of the file.
+	\return The size of the file.
+	*/
+	virtual size_lt FileSize() override;
+
+	/*!
+	Returns the size of the file. Static.
+	\param[in] hFile The descriptor of the opened file.
+	\return The size of the file.
+	*/
+	static size_lt FileSize(int hFile);
+
+	/*!
+	Returns the size of the file. Static.
+	\param[in] fileName The name of the file.
+	\return The size of the file.
+	*/
+	static size_lt FileSize(const char *fileName);
+
+	/*!
+	Moves the file pointer of the specified file.
+	\param[in] offset The offset of a new pointer position.
+	\param[in] move The position used as a reference for the offset.
+	\return A new pointer position.
+	*/
+	virtual size_lt Seek(size_lt offset, SeekReference move) override;
+
+	/*!
+	Reads one byte from the file.
+	\return The value of the read byte or -1 if it can't be read (ex. EOF).
+	*/
+	virtual int ReadByte() override;
+
+	/*!
+	Reads a block from the file.
+	\param[out] block The array of bytes from the file.
+	\param[in] sizeBlock The number of bytes to be read.
+	\return The number of the bytes read from the file.
+	*/
+	virtual size_lt ReadBlock(byte *block, size_lt blockSize = MIN_BUFFER_SIZE) override;
+
+	/*!
+	Reads a block from the file. Static.
+	Reads until the block is full or the end of the file is reached.
+	\param[in] hFile The descriptor of the opened file.
+	\param[out] block The array of bytes from the file.
+	\param[in] sizeBlock The number of bytes to be read.
+	\return The number of the bytes read from the file.
+	*/
+	static size_lt ReadBlock(int hFile, byte *block, size_lt blockSize = MIN_BUFFER_SIZE);
+
+	/*!
+	Writes one byte into the file.
+	\param[in] b The byte to be saved.
+	*/
+	virtual void WriteByte(byte b) override;
+
+	/*!
+	Writes a block into the file.
+	\param[in] block The array of bytes to be written.
+	\param[in] blockSize The number of bytes to be written.
+	*/
+	virtual void WriteBlock(byte *block, size_lt sizeBlock) override;
+
+	/*!
+	Writes a block into the file. Static.
+	\param[in] hFile The descriptor of the opened file.
+	\param[in] block The array of bytes to be written.
+	\param[in] blockSize The number of bytes to be written.
+	*/
+	static void WriteBlock(int hFile, byte *block, size_lt sizeBlock);
+
+	/*!
+	Returns the descriptor of the opened file.
+	\return The descriptor of the file.
+	*/
+	virtual t_filehandle GetHandle() override;
+
+	/*!
+	Reads the file into the several buffers with one readv call (per IOBUFFER_MAX_COUNT buffers).
+	\param[in] buffers The buffers to be filled.
+	\param[in] count The number of the buffers.
+	\return The number of the bytes read.
+	*/
+	virtual size_lt ReadBlockV(IOBuffer *buffers, size_lt count) override;
+
+	/*!
+	Writes the several buffers into the file with one writev call (per IOBUFFER_MAX_COUNT buffers).
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	virtual void WriteBlockV(IOBuffer *buffers, size_lt count) override;
+
+	/*!
+	Writes the several buffers into the file. Static.
+	\param[in] hFile The descriptor of the opened file.
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	static void WriteBlockV(int hFile, IOBuffer *buffers, size_lt count);
+
+	/*!
+	Returns the memory of the file opened in the MAPPED mode.
+	\return The view of the whole file.
+	*/
+	virtual ByteSpan GetView() override;
+
+	/*!
+	Tells the OS how the opened file is going to be accessed.
+	\param[in] pattern The expected order of the accesses.
+	*/
+	virtual void SetAccessPattern(FileAccessPattern pattern) override;
+
+	/*!
+	Asks the OS to start reading the region into its cache.
+	\param[in] offset The offset of the region.
+	\param[in] length The length of the region.
+	*/
+	virtual void Prefetch(size_lt offset, size_lt length) override;
+
+	/////////////////////////////////////////////////////////////////////////////
+	////////////////////           STATIC METHODS            ////////////////////
+	/////////////////////////////////////////////////////////////////////////////
+
+	/*!
+	Reads the full file. Static.
+	\param[in] fileName The name of the file to be read.
+	\param[out] byteArr Data read from the file.
+	\return The number of the bytes read.
+	*/
+	static size_lt ReadAllBytes(const char *fileName, byte **block);
+
+	/*!
+	Opens the file and writes all data into it. Static.
+	\param[in] fileName The name of the file to be read.
+	\param[in] data The data to be written into the file.
+	\param[in] size The size of the data buffer.
+	\param[in] mode Opens the file mode.
+	*/
+	static void WriteAllBytes(const char *fileName, byte* data, size_lt size, FileOpenMode mode = WRITENEWFILE);
+
+	/*!
+	\TODO
+	Gets the latest file modified. Static.
+	\param[in] string fileName The name of the file to be read.
+	\return Info about the latest file modified.
+	*/
+	static FileMeta LastModified(const char *fileName);
+
+private:
+	/*!
+	Maps the opened file into the memory (the MAPPED mode).
+	*/
+	void Map();
+
+	/*!
+	Unmaps the file if it is mapped.
+	*/
+	void Unmap();
+
+	int _hFile;				///< The descriptor of the opened file
+	char *_fileName;		///< The name of the file
+	bool _opened;			///< Determines if the file is opened
+	bool _mapped;			///< Determines if the file is opened in the MAPPED mode
+	byte *_view;			///< The memory of the mapped file (NULL for the empty file)
+	size_lt _viewSize;		///< The size of the mapped memory
+	size_lt _viewPos;		///< The read position in the mapped memory
 };
 
 #endif
-#endif // UNIXFILE_H
-
-/*
-    int ReadByte_()
-    {
-        char readedByte;
-        int readed;
-        BOOL res = ReadFile(_hFile, (LPVOID)&readedByte, 1, (LPDWORD)&readed, NULL);
-        if (!res)
-        {
-            char message[128];
-            sprintf(message, "%s %d", "Error: GetLatError:", GetLastError());
-            ThrowException(message);
-        }
-        if (readed == 0) return 0;
-        return (int)readedByte;
-    }
-
-    int ReadBlock_()
-    {
-        int readedBytes;
-        BOOL res = ReadFile(_hFile, (LPVOID)cacheBuffer, MIN_BUFFER_SIZE, (LPDWORD)&readedBytes, NULL);
-        if (!res)
-        {
-            char message[128];
-            sprintf(message, "%s %d", "Error: GetLatError:", GetLastError());
-            ThrowException(message);
-        }
-        if (readedBytes < sizeCacheBuffer) sizeCacheBuffer = readedBytes;
-        return readedBytes;
-    }
-
-    */
-    //
@@ -0,0 +1,39 @@
+#include "unixfutex.h"
+#ifdef __unix__
+
+using MSIYBCore::UnixFutex;
+
+static inline long Futex(std::atomic<int> *address, int operation, int value, const timespec *timeout)
+{
+	return syscall(SYS_futex, (int*)address, operation | FUTEX_PRIVATE_FLAG, value, timeout, NULL, 0);
+}
+
+bool UnixFutex::Wait(std::atomic<int> *address, int expected, unsigned long timeout)
+{
+	timespec relative;
+	timespec *limit = NULL;
+	if (timeout != INFINITE)
+	{
+		relative.tv_sec = timeout / 1000;
+		relative.tv_nsec = (timeout % 1000) * 1000000;
+		limit = &relative;
+	}
+	if (Futex(address, FUTEX_WAIT, expected, limit) == 0)
+	{
+		return true;
+	}
+	// EAGAIN: the word was changed before the sleep, EINTR: the signal
+	return errno != ETIMEDOUT;
+}
+
+void UnixFutex::WakeOne(std::atomic<int> *address)
+{
+	Futex(address, FUTEX_WAKE, 1, NULL);
+}
+
+void UnixFutex::WakeAll(std::atomic<int> *address)
+{
+	Futex(address, FUTEX_WAKE, MAX_INT, NULL);
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*!
+\file unixfutex.h "server\desktop\src\cross\unix\unixfutex.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 12 October 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <atomic>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "../../defines.h"
+
+namespace MSIYBCore
+{
+	/*!
+	\class UnixFutex unixfutex.h "server\desktop\src\cross\unix\unixfutex.h"
+	\brief  Parks the threads on the 32-bit word with the futex system call.
+	The kernel checks the word under its own lock, so the wake-up between the check of the caller
+	and the sleep is never lost. Only the threads of the process are parked (FUTEX_PRIVATE_FLAG).
+	*/
+	class UnixFutex
+	{
+	public:
+		/*!
+		Sleeps while the word is equal to the expected value. Static.
+		Returns on the wake-up, the timeout, the signal or at once if the word was changed.
+		\param[in] address The word.
+		\param[in] expected The value the word had when the caller decided to sleep.
+		\param[in] timeout The timeout in milliseconds or INFINITE.
+		\return FALSE if the timeout expired, TRUE otherwise (the caller checks its condition again).
+		*/
+		static bool Wait(std::atomic<int> *address, int expected, unsigned long timeout = INFINITE);
+
+		/*!
+		Wakes up one thread sleeping on the word. Static.
+		\param[in] address The word.
+		*/
+		static void WakeOne(std::atomic<int> *address);
+
+		/*!
+		Wakes up all the threads sleeping on the word. Static.
+		\param[in] address The word.
+		*/
+		static void WakeAll(std::atomic<int> *address);
+	};
+}
+#endif
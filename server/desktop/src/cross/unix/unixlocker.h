@@ -0,0 +1,22 @@
+/*!
+\file unixlocker.h "server\desktop\src\cross\unix\unixlocker.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 October 2017
+*/
+
+#pragma once
+
+#include "unixmutex.h"
+#include "unixrwlock.h"
+#include "unixcv.h"
+
+namespace MSIYBCore
+{
+	typedef UnixMutex DefaultLock;
+	typedef UnixMutex Mutex;
+	typedef UnixRWLock RWLock;
+	typedef UnixCV ConditionVariable;
+}
@@ -0,0 +1,80 @@
+#include "unixmutex.h"
+#ifdef __unix__
+using MSIYBCore::UnixMutex;
+
+static inline int CurrentThread()
+{
+	static thread_local int id = (int)syscall(SYS_gettid);
+	return id;
+}
+
+UnixMutex::UnixMutex(unsigned long timeout) : _owner(0)
+{
+	_recursion = 0;
+	_timeout = timeout;
+}
+
+UnixMutex::~UnixMutex()
+{
+}
+
+bool UnixMutex::Lock()
+{
+	int self = CurrentThread();
+	if (_owner.load(std::memory_order_relaxed) == self)
+	{
+		_recursion++;
+		return true;
+	}
+	if (!_lock.TryLock() && !_lock.LockContended(_timeout))
+	{
+		return false;
+	}
+	_owner.store(self, std::memory_order_relaxed);
+	_recursion = 1;
+	return true;
+}
+
+bool UnixMutex::LockShared()
+{
+	return false;
+}
+
+bool UnixMutex::TryLock()
+{
+	int self = CurrentThread();
+	if (_owner.load(std::memory_order_relaxed) == self)
+	{
+		_recursion++;
+		return true;
+	}
+	if (!_lock.TryLock())
+	{
+		return false;
+	}
+	_owner.store(self, std::memory_order_relaxed);
+	_recursion = 1;
+	return true;
+}
+
+bool UnixMutex::TryLockShared()
+{
+	return false;
+}
+
+bool UnixMutex::Unlock()
+{
+	if (_owner.load(std::memory_order_relaxed) != CurrentThread())
+	{
+		return false;
+	}
+	if (--_recursion > 0)
+	{
+		return true;
+	}
+	_owner.store(0, std::memory_order_relaxed);
+	_lock.Unlock();
+	return true;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*!
+\file unixmutex.h "server\desktop\src\cross\unix\unixmutex.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 October 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <atomic>
+#include "../../common/futex.h"
+#include "../ilocker.h"
+
+namespace MSIYBCore
+{
+	/*!
+	\class UnixMutex unixmutex.h "server\desktop\src\cross\unix\unixmutex.h"
+	\brief  The recursive mutex on the futex (the critical section of Linux).
+	The lock word is FutexLock: no system calls without the contention, spins and then sleeps with it.
+	*/
+	class UnixMutex : public ILocker
+	{
+	public:
+		/*!
+		Constructor. Set timeout.
+		\param[in] timeout Timeout after which Lock stops waiting for the mutex (INFINITE by default).
+		*/
+		UnixMutex(unsigned long timeout = INFINITE);
+
+		UnixMutex(const UnixMutex& other) = delete;
+		UnixMutex& operator=(const UnixMutex& other) = delete;
+
+		/*!
+		Empty. The mutex must be unlocked.
+		*/
+		~UnixMutex();
+
+		/*!
+		Locks the mutex. The thread owning the mutex locks it again (it is unlocked the same number of times).
+		If another thread has already locked the mutex,
+		a call to lock will block execution until the lock is acquired or the timeout expires.
+		\return TRUE if the mutex is locked and FALSE in other case (timeout).
+		*/
+		bool Lock() override;
+
+		/*!
+		Unavailable for mutex object.
+		\return FALSE
+		*/
+		bool LockShared() override;
+
+		/*!
+		Try to lock the mutex object.
+		If another thread has already locked the mutex,
+		function returns false immediatly.
+		\return TRUE if the mutex is locked and FALSE if another thread owns it.
+		*/
+		bool TryLock() override;
+
+		/*!
+		Unavailable for mutex object.
+		\return FALSE
+		*/
+		bool TryLockShared() override;
+
+		/*!
+		Unlocks the mutex and wakes up one sleeping thread if there is any.
+		\return TRUE if succeed and FALSE if the calling thread doesn't own the mutex.
+		*/
+		bool Unlock() override;
+
+	private:
+		FutexLock _lock;				///< The lock word
+		std::atomic<int> _owner;		///< The id of the owning thread (0 if unlocked).
+		unsigned long _recursion;		///< The number of the locks by the owner.
+		unsigned long _timeout;			///< Timeout after which Lock stops waiting for the mutex.
+	};
+}
+#endif
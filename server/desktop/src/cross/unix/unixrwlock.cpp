@@ -0,0 +1,149 @@
+#include "unixrwlock.h"
+#ifdef __unix__
+#include "../../common/cpu.h"
+
+using MSIYBCore::UnixRWLock;
+using MSIYBCore::Cpu;
+
+UnixRWLock::UnixRWLock() : _state(0), _writersWaiting(0)
+{
+}
+
+UnixRWLock::~UnixRWLock()
+{
+}
+
+bool UnixRWLock::Lock()
+{
+	if (TryLock())
+	{
+		return true;
+	}
+	if (Cpu::GetCount() > 1)
+	{
+		for (int spin = 0; spin < RWLOCK_SPIN_COUNT; spin++)
+		{
+			Cpu::Pause();
+			if (_state.load(std::memory_order_relaxed) == 0 && TryLock())
+			{
+				return true;
+			}
+		}
+	}
+
+	// Registered before the try: the unlock after the failed try sees the writer and wakes it up
+	_writersWaiting.fetch_add(1);
+	while (!TryLock())
+	{
+		int key = _writers.PrepareWait();
+		if (TryLock())
+		{
+			_writers.CancelWait();
+			break;
+		}
+		_writers.Wait(key);
+	}
+	_writersWaiting.fetch_sub(1);
+	return true;
+}
+
+bool UnixRWLock::LockShared()
+{
+	if (TryEnterShared())
+	{
+		return true;
+	}
+	if (Cpu::GetCount() > 1)
+	{
+		for (int spin = 0; spin < RWLOCK_SPIN_COUNT; spin++)
+		{
+			Cpu::Pause();
+			if (TryEnterShared())
+			{
+				return true;
+			}
+		}
+	}
+
+	while (!TryEnterShared())
+	{
+		int key = _readers.PrepareWait();
+		if (TryEnterShared())
+		{
+			_readers.CancelWait();
+			break;
+		}
+		_readers.Wait(key);
+	}
+	return true;
+}
+
+bool UnixRWLock::TryLock()
+{
+	int expected = 0;
+	return _state.compare_exchange_strong(expected, RWLOCK_WRITER);
+}
+
+bool UnixRWLock::TryLockShared()
+{
+	int state = _state.load(std::memory_order_relaxed);
+	while (!(state & RWLOCK_WRITER))
+	{
+		if (_state.compare_exchange_weak(state, state + 1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UnixRWLock::Unlock()
+{
+	int state = _state.load(std::memory_order_relaxed);
+	if (state & RWLOCK_WRITER)
+	{
+		_state.store(0);
+		WakeUp();
+		return true;
+	}
+	if ((state & RWLOCK_READERS) == 0)
+	{
+		return false;
+	}
+	if (_state.fetch_sub(1) == 1)
+	{
+		// The last reader: only the writers can wait for the lock held by the readers
+		WakeUp();
+	}
+	return true;
+}
+
+bool UnixRWLock::TryEnterShared()
+{
+	// Sequentially consistent: the check after PrepareWait sees the unlock
+	// or the unlocking writer sees the waiter and wakes it up
+	int state = _state.load();
+	while (!(state & RWLOCK_WRITER) && _writersWaiting.load() == 0)
+	{
+		if (_state.compare_exchange_weak(state, state + 1))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UnixRWLock::WakeUp()
+{
+	// The state was changed by the sequentially consistent operation: the waiters are seen without the fence
+	if (_writersWaiting.load() > 0)
+	{
+		_writers.NotifyOne();
+	}
+	else if (_readers.HasWaiters())
+	{
+		_readers.NotifyAll();
+	}
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*!
+\file unixrwlock.h "server\desktop\src\cross\unix\unixrwlock.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 October 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <atomic>
+#include "../../common/futex.h"
+#include "../ilocker.h"
+
+#define RWLOCK_WRITER 0x40000000		///< The bit of the state set while the writer owns the lock
+#define RWLOCK_READERS 0x3FFFFFFF		///< The bits of the state counting the readers
+#define RWLOCK_SPIN_COUNT 100			///< The spins before the thread sleeps
+
+namespace MSIYBCore
+{
+	/*!
+	\class UnixRWLock unixrwlock.h "server\desktop\src\cross\unix\unixrwlock.h"
+	\brief  The reader-writer lock on the futexes (the SRW lock of Linux).
+	One word holds the writer bit and the number of the readers: the free lock is taken
+	and released by one atomic operation. The writers waiting stop the new readers, so the writers don't starve.
+	The readers and the writers sleep in the separate event counts: the unlock wakes up one writer or all the readers,
+	and makes no system call while the woken up thread hasn't run yet.
+	Not recursive.
+	*/
+	class UnixRWLock : public ILocker
+	{
+	public:
+		/*!
+		Constructor. Empty.
+		*/
+		UnixRWLock();
+
+		UnixRWLock(const UnixRWLock& other) = delete;
+		UnixRWLock& operator=(const UnixRWLock& other) = delete;
+
+		/*!
+		Empty. The lock must be unlocked.
+		*/
+		~UnixRWLock();
+
+		/*!
+		Enter the lock. Exclusive lock. (For writers).
+		If another thread has already locked the lock,
+		a call to lock will block execution until the lock is acquired.
+		\return always TRUE.
+		*/
+		bool Lock() override;
+
+		/*!
+		Locks the locker object in shared mode
+		so other reader thread can use it as well.
+		\return always TRUE.
+		*/
+		bool LockShared() override;
+
+		/*!
+		Try to lock the locker object exclusively.
+		\return TRUE if the lock is taken and FALSE if it is already locked.
+		*/
+		bool TryLock() override;
+
+		/*!
+		Try to lock the locker object in shared mode.
+		\return TRUE if the lock is taken and FALSE if the writer owns it.
+		*/
+		bool TryLockShared() override;
+
+		/*!
+		Releases the exclusive or the shared lock taken by the calling thread.
+		\return TRUE if succeed and FALSE if the lock isn't locked.
+		*/
+		bool Unlock() override;
+
+	private:
+		/*!
+		Takes the shared lock if neither the writer owns it nor the writers wait for it.
+		\return TRUE if the lock is taken.
+		*/
+		bool TryEnterShared();
+
+		/*!
+		Wakes up one waiting writer, or all the waiting readers if there are no writers.
+		*/
+		void WakeUp();
+
+		std::atomic<int> _state;			///< The writer bit and the number of the readers.
+		std::atomic<int> _writersWaiting;	///< The number of the writers waiting for the lock (the new readers wait for them).
+		EventCount _readers;				///< The sleeping readers.
+		EventCount _writers;				///< The sleeping writers.
+	};
+}
+#endif
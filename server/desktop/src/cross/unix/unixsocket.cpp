@@ -1,4 +1,3 @@
-#include "stdafx.h"
 #include "unixsocket.h"
 #ifdef __unix__
 UnixSocket::UnixSocket()
@@ -54,7 +53,7 @@ void UnixSocket::SetSocketPort(short port, int srvAddr, int aFamily)
 int UnixSocket::RecvAll(char *buf)
 {
 	int sizeBuffer = 0;
-	int lenght = 0;
+	long lenght = 0;
 	int init = 1;
 
 	while (sizeBuffer < SIZE_FIRST_MESSAGE && init)
@@ -82,45 +81,83 @@ int UnixSocket::RecvAll(char *buf)
 int UnixSocket::Recv(char *buf, int size)
 {
 	int recieved = recv(sock, buf, size, 0);
+	if (recieved < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return SOCKET_WOULDBLOCK;
 	if (recieved < 0)
 		ThrowSocketExceptionWithCode("Error recv, errno ", errno);
 
 	return recieved;
 }
 
+int UnixSocket::RecvBuffer(MSIYBCore::Buffer *buffer)
+{
+	size_lt free;
+	byte *tail = buffer->GetTail(&free);
+	int recieved = Recv((char*)tail, free > MAX_INT ? MAX_INT : (int)free);
+	if (recieved > 0)
+	{
+		buffer->Commit(recieved);
+	}
+	return recieved;
+}
+
 int UnixSocket::Send(char *buf, int size)
 {
-	int sended = send(sock, buf, size, 0);
+	int sended = send(sock, buf, size, MSG_NOSIGNAL);
+	if (sended < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return SOCKET_WOULDBLOCK;
 	if (sended < 0)
 		ThrowSocketExceptionWithCode("Error recv, errno ", errno);
 
 	return sended;
 }
 
-int UnixSocket::SendAll(char *buf, int bufLen)
+int UnixSocket::SendV(IOBuffer *buffers, size_lt count)
 {
-	int sizeBuffer = 0;
-	int lenght = bufLen;
-
-	while (sizeBuffer < SIZE_FIRST_MESSAGE)
+	// One sendmsg per IOBUFFER_MAX_COUNT buffers, the caller sends the rest after the partial result
+	iovec iov[IOBUFFER_MAX_COUNT];
+	msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = iov;
+	for (size_lt i = 0; i < count && message.msg_iovlen < IOBUFFER_MAX_COUNT; i++)
 	{
-		int sended = send(sock, (char*)&lenght + sizeBuffer, SIZE_FIRST_MESSAGE - sizeBuffer, 0);
-		if (sended < 0)
-			ThrowSocketExceptionWithCode("Error recv, errno ", errno);
-		sizeBuffer += sended;
+		iov[message.msg_iovlen].iov_base = buffers[i].data;
+		iov[message.msg_iovlen].iov_len = buffers[i].size;
+		message.msg_iovlen++;
 	}
 
-	sizeBuffer = 0;
-	while (sizeBuffer < lenght)
+	ssize_t sended = sendmsg(sock, &message, MSG_NOSIGNAL);
+	if (sended < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return SOCKET_WOULDBLOCK;
+	if (sended < 0)
+		ThrowSocketExceptionWithCode("Error sendmsg, errno ", errno);
+
+	return (int)sended;
+}
+
+int UnixSocket::SendAll(char *buf, int bufLen)
+{
+	// The header and the payload go out in one call
+	long lenght = bufLen;
+	IOBuffer buffers[2] = { { (byte*)&lenght, SIZE_FIRST_MESSAGE }, { (byte*)buf, (size_lt)bufLen } };
+	size_lt index = 0;
+	size_lt skip = 0;
+	while (index < 2)
 	{
-		int sended = send(sock, buf + sizeBuffer, bufLen - sizeBuffer, 0);
+		IOBuffer rest[2];
+		size_lt count = 0;
+		for (size_lt i = index; i < 2; i++, count++)
+		{
+			rest[count].data = buffers[i].data + (i == index ? skip : 0);
+			rest[count].size = buffers[i].size - (i == index ? skip : 0);
+		}
+		int sended = SendV(rest, count);
 		if (sended < 0)
-			ThrowSocketExceptionWithCode("Error recv, errno ", errno);
-
-		sizeBuffer += sended;
+			ThrowSocketExceptionWithCode("Error send, errno ", errno);
+		AdvanceIOBuffers(buffers, 2, &index, &skip, sended);
 	}
 
-	return sizeBuffer;
+	return bufLen;
 }
 
 void UnixSocket::Connect()
@@ -156,14 +193,20 @@ void UnixSocket::Listen(int len)
 }
 
 ISocket* UnixSocket::Accept()
+{
+	return Accept(NULL);
+}
+
+ISocket* UnixSocket::Accept(MSIYBCore::Arena *arena)
 {
 	socklen_t sizeSAddr = sizeof(sAddr);
 	int newS = accept(sock, (sockaddr*)&sAddr, &sizeSAddr);
-	if (!newS) return NULL;
+	if (newS < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return NULL;
 	if (newS < 0)
 		ThrowSocketExceptionWithCode("Error accept, errno ", errno);
 
-	UnixSocket *newSocket = new UnixSocket(newS);
+	UnixSocket *newSocket = arena ? arena->New<UnixSocket>(newS) : new UnixSocket(newS);
 	newSocket->sAddr = sAddr;
 	return (ISocket*)newSocket;
 }
@@ -178,4 +221,60 @@ int UnixSocket::SendTo()
 	return NoError;
 }
 
+void UnixSocket::SetNonBlocking(bool nonBlocking)
+{
+	int flags = fcntl(sock, F_GETFL, 0);
+	if (flags == -1)
+		ThrowSocketExceptionWithCode("Error fcntl, errno ", errno);
+
+	flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+	if (fcntl(sock, F_SETFL, flags) == -1)
+		ThrowSocketExceptionWithCode("Error fcntl, errno ", errno);
+}
+
+t_descriptor UnixSocket::GetDescriptor()
+{
+	return sock;
+}
+
+int UnixSocket::SendFilePart(t_filehandle file, size_lt offset, int size)
+{
+	off_t fileOffset = (off_t)offset;
+	ssize_t sended = sendfile(sock, file, &fileOffset, size);
+	if (sended < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return SOCKET_WOULDBLOCK;
+	if (sended < 0)
+		ThrowSocketExceptionWithCode("Error sendfile, errno ", errno);
+
+	return (int)sended;
+}
+
+size_lt UnixSocket::SendFile(t_filehandle file, size_lt offset, size_lt length)
+{
+	int sizeBuffer = 0;
+	long lenght = (long)length;
+
+	// MSG_MORE keeps the prefix in the socket until the file data follows it
+	while (sizeBuffer < (int)SIZE_FIRST_MESSAGE)
+	{
+		int sended = send(sock, (char*)&lenght + sizeBuffer, SIZE_FIRST_MESSAGE - sizeBuffer, MSG_NOSIGNAL | MSG_MORE);
+		if (sended < 0)
+			ThrowSocketExceptionWithCode("Error send, errno ", errno);
+		sizeBuffer += sended;
+	}
+
+	off_t fileOffset = (off_t)offset;
+	size_lt sendedT = 0;
+	while (sendedT < length)
+	{
+		ssize_t sended = sendfile(sock, file, &fileOffset, length - sendedT);
+		if (sended < 0)
+			ThrowSocketExceptionWithCode("Error sendfile, errno ", errno);
+		if (sended == 0)
+			ThrowSocketException("Error sendfile, file is shorter than length");
+		sendedT += sended;
+	}
+	return sendedT;
+}
+
 #endif
\ No newline at end of file
@@ -1,14 +1,19 @@
 #pragma once
 #ifdef  __unix__
 #include <sys/socket.h>
-#include "socket.h"
-#include "exeption.h"
+#include <sys/sendfile.h>
+#include "../isocket.h"
+#include "../../common/arena.h"
+#include "../../common/pool.h"
+#include "../../common/buffer.h"
 #include <netinet/in.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <arpa/inet.h>
 
 #define SIZE_FIRST_MESSAGE sizeof(long)
-class UnixSocket : public ISocket
+class UnixSocket : public ISocket, public MSIYBCore::Pooled
 {
 	int sock;
 	sockaddr_in sAddr;
@@ -23,7 +28,9 @@ public:
 	void SetSocketPort(short port, int srvAddr, int aFamily = AF_INET);
 	int RecvAll(char *buf);
 	int Recv(char *buf, int size);
+	int RecvBuffer(MSIYBCore::Buffer *buffer);
 	int Send(char *buf, int size);
+	int SendV(IOBuffer *buffers, size_lt count);
 	int SendAll(char *buf, int bufLen);
 	void Connect();
 	void ShutDown(How shutHow);
@@ -31,8 +38,13 @@ public:
 	void Bind();
 	void Listen(int len);
 	ISocket* Accept();
+	ISocket* Accept(MSIYBCore::Arena *arena);
 	int RecvFrom();
 	int SendTo();
+	void SetNonBlocking(bool nonBlocking);
+	t_descriptor GetDescriptor();
+	int SendFilePart(t_filehandle file, size_lt offset, int size);
+	size_lt SendFile(t_filehandle file, size_lt offset, size_lt length);
 };
 
 
@@ -0,0 +1,246 @@
+#include "unixthread.h"
+#ifdef __unix__
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+
+UnixThread::UnixThread()
+{
+	_started = false;
+	_joined = false;
+	_threadFunc = NULL;
+	_threadFuncArgs = NULL;
+	_threadStackSize = 0;
+	_processor = THREAD_ANY_PROCESSOR;
+	_node = THREAD_ANY_NODE;
+	_name[0] = '\0';
+	_exitCode = NULL;
+}
+
+UnixThread::~UnixThread()
+{
+	if (_started && !_joined)
+	{
+		pthread_detach(_thread);
+	}
+}
+
+void UnixThread::Init(void *threadFunc, void *threadFuncArgs, size_t threadStackSize, t_flags threadFlags, t_secattr /*threadSecurityAttributes*/)
+{
+	if (threadFlags == CREATESUSPENDED)
+	{
+		ThrowThreadException("The thread can't be created suspended!");
+	}
+	_threadFunc = (void*(*)(void*))threadFunc;
+	_threadFuncArgs = threadFuncArgs;
+	_threadStackSize = threadStackSize;
+}
+
+int UnixThread::GetMaxThreadCount()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int)count : 1;
+}
+
+int UnixThread::GetProcessor(int index)
+{
+	// The affinity of the main thread is the one the process was started with
+	cpu_set_t processors;
+	int count = sched_getaffinity(getpid(), sizeof(processors), &processors) ? 0 : CPU_COUNT(&processors);
+	if (count <= 0)
+	{
+		return index % GetMaxThreadCount();
+	}
+	index %= count;
+	for (int i = 0; i < (int)CPU_SETSIZE; i++)
+	{
+		if (CPU_ISSET(i, &processors) && index-- == 0)
+		{
+			return i;
+		}
+	}
+	return THREAD_ANY_PROCESSOR;
+}
+
+void UnixThread::Start()
+{
+	pthread_attr_t attr;
+	int error = pthread_attr_init(&attr);
+	if (error)
+	{
+		ThrowThreadExceptionWithCode("Could not create new thread!", error);
+	}
+
+	if (_threadStackSize)
+	{
+		// The stack is mapped in whole pages and can't be smaller than the minimum
+		size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		size_t size = _threadStackSize < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : _threadStackSize;
+		error = pthread_attr_setstacksize(&attr, (size + page - 1) / page * page);
+	}
+
+	// Set in the attributes, so the thread doesn't touch its stack on a foreign node first
+	cpu_set_t processors;
+	if (!error && GetProcessors(&processors))
+	{
+		error = pthread_attr_setaffinity_np(&attr, sizeof(processors), &processors);
+	}
+
+	if (!error)
+	{
+		error = pthread_create(&_thread, &attr, _threadFunc, _threadFuncArgs);
+	}
+	pthread_attr_destroy(&attr);
+	if (error)
+	{
+		ThrowThreadExceptionWithCode("Could not create new thread!", error);
+	}
+
+	_started = true;
+	_joined = false;
+	ApplyName();
+}
+
+long UnixThread::GetThreadID()
+{
+	return (long)_thread;
+}
+
+bool UnixThread::CheckActive(void * /*result*/)
+{
+	if (!_started || _joined)
+	{
+		return false;
+	}
+	int error = pthread_tryjoin_np(_thread, &_exitCode);
+	if (error == EBUSY)
+	{
+		return true;
+	}
+	if (error)
+	{
+		ThrowThreadExceptionWithCode("Can not check thread status!", error);
+	}
+	_joined = true;
+	return false;
+}
+
+void UnixThread::WaitToComplete()
+{
+	if (!_started || _joined)
+	{
+		return;
+	}
+	int error = pthread_join(_thread, &_exitCode);
+	if (error)
+	{
+		ThrowThreadExceptionWithCode("Can not wait for thread!", error);
+	}
+	_joined = true;
+}
+
+void UnixThread::SetAffinity(int processor)
+{
+	_processor = processor;
+	ApplyAffinity();
+}
+
+void UnixThread::SetNumaNode(int node)
+{
+	_node = node;
+	ApplyAffinity();
+}
+
+void UnixThread::SetName(const char *name)
+{
+	strncpy(_name, name, UNIXTHREAD_NAME_SIZE - 1);
+	_name[UNIXTHREAD_NAME_SIZE - 1] = '\0';
+	ApplyName();
+}
+
+bool UnixThread::GetProcessors(cpu_set_t *set)
+{
+	CPU_ZERO(set);
+	if (_processor != THREAD_ANY_PROCESSOR)
+	{
+		if (_processor < 0 || _processor >= (int)CPU_SETSIZE)
+		{
+			ThrowThreadExceptionWithCode("Wrong processor!", _processor);
+		}
+		CPU_SET(_processor, set);
+		return true;
+	}
+	if (_node == THREAD_ANY_NODE)
+	{
+		return false;
+	}
+
+	// The list of the ranges, ex. "0-3,8-11"
+	char path[PATH_MAX];
+	sprintf(path, "/sys/devices/system/node/node%d/cpulist", _node);
+	FILE *list = fopen(path, "r");
+	if (!list)
+	{
+		return false;
+	}
+	int first, last;
+	while (fscanf(list, "%d", &first) == 1)
+	{
+		last = first;
+		int separator = fgetc(list);
+		if (separator == '-')
+		{
+			if (fscanf(list, "%d", &last) != 1)
+			{
+				break;
+			}
+			separator = fgetc(list);
+		}
+		for (int i = first; i <= last && i < (int)CPU_SETSIZE; i++)
+		{
+			CPU_SET(i, set);
+		}
+		if (separator != ',')
+		{
+			break;
+		}
+	}
+	fclose(list);
+	// The node without the processors (the memory only) gives no hint
+	return CPU_COUNT(set) > 0;
+}
+
+void UnixThread::ApplyAffinity()
+{
+	if (!_started || _joined)
+	{
+		return;
+	}
+	cpu_set_t processors;
+	if (!GetProcessors(&processors))
+	{
+		// Unpinned: any processor of the process (the main thread), not the mask this thread was pinned to
+		if (sched_getaffinity(getpid(), sizeof(processors), &processors))
+		{
+			ThrowThreadExceptionWithCode("Can not set thread affinity!", errno);
+		}
+	}
+	int error = pthread_setaffinity_np(_thread, sizeof(processors), &processors);
+	if (error)
+	{
+		ThrowThreadExceptionWithCode("Can not set thread affinity!", error);
+	}
+}
+
+void UnixThread::ApplyName()
+{
+	if (!_started || _joined || !_name[0])
+	{
+		return;
+	}
+	// Only a hint for the tools: the thread works on without the name
+	(void)pthread_setname_np(_thread, _name);
+}
+#endif
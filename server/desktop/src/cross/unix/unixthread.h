@@ -0,0 +1,138 @@
+/*!
+\file unixthread.h "server\desktop\src\cross\unix\unixthread.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 17 October 2017
+*/
+
+#pragma once
+#ifdef __unix__
+#include <pthread.h>
+#include <sched.h>
+#include "../ithread.h"
+
+#define UNIXTHREAD_NAME_SIZE 16		///< The limit of the thread name with the terminating zero (the kernel keeps 15 characters)
+
+/*!
+\class UnixThread unixthread.h "server\desktop\src\cross\unix\unixthread.h"
+\brief  Unix depended structure of thread.
+Provides the pthread-based thread creation (and handle it). The affinity and the stack size
+are set in the attributes, so the thread starts on its processors with its stack;
+the settings changed after the start are applied to the running thread.
+*/
+class UnixThread : public IThread
+{
+public:
+	/*!
+	Empty.
+	*/
+	UnixThread();
+
+	/*!
+	Detaches the thread if nobody waited for it: the thread runs on and frees itself.
+	*/
+	~UnixThread();
+
+	UnixThread(const UnixThread& other) = delete;
+	UnixThread& operator=(const UnixThread& other) = delete;
+
+	/*!
+	Set up thread before launch. Cross platform call.
+	\param[in] threadFunc Pointer to a function to be executed by the thread.
+	\param[in] threadFuncArgs A pointer to a variable to be passed to the thread.
+	\param[in] threadStackSize The initial size of the stack, in bytes (0 for the default). The stack is always reserved.
+	\param[in] threadFlags The flags that control the creation of the thread. The threads can't be created suspended.
+	\param[in] threadSecurityAttributes Ignored: the thread has the rights of the process.
+	*/
+	virtual void Init(void* threadFunc, void* threadFuncArgs, size_t threadStackSize, t_flags threadFlags, t_secattr threadSecurityAttributes) override;
+
+	/*!
+	Returns maximum amount of threads can be launched. Static.
+	\return The number of the online processors.
+	*/
+	static int GetMaxThreadCount();
+
+	/*!
+	Returns the processor the process may run on by its number: the processors outside the affinity
+	of the process (ex. the cpuset of the container) are skipped. Static.
+	\param[in] index The number of the allowed processor, wraps around.
+	\return The index of the logical processor for SetAffinity.
+	*/
+	static int GetProcessor(int index);
+
+	/*!
+	Launch thread with setted parameters.
+	*/
+	virtual void Start() override;
+
+	/*!
+	Returns launched thread system ID.
+	\return Launched thread system ID.
+	*/
+	virtual long GetThreadID() override;
+
+	/*!
+	Check if thread comleted his work. Joins the completed thread.
+	\param[out] result Ignored, the value returned from the thread function is kept by the thread.
+	\return TRUE if still active and FALSE in other case
+	*/
+	virtual bool CheckActive(void *result = nullptr) override;
+
+	/*!
+	Blocks until the thread function returns.
+	*/
+	virtual void WaitToComplete() override;
+
+	/*!
+	Pins the thread to the logical processor.
+	\param[in] processor The index of the logical processor or THREAD_ANY_PROCESSOR.
+	*/
+	virtual void SetAffinity(int processor) override;
+
+	/*!
+	Keeps the thread on the processors of the NUMA node (read from sysfs).
+	\param[in] node The index of the NUMA node or THREAD_ANY_NODE.
+	*/
+	virtual void SetNumaNode(int node) override;
+
+	/*!
+	Names the thread (pthread_setname_np), truncated to 15 characters.
+	\param[in] name The name of the thread.
+	*/
+	virtual void SetName(const char *name) override;
+
+private:
+	/*!
+	Fills the processors the thread may run on.
+	\param[out] set The processors.
+	\return TRUE if the thread is limited, FALSE if it may run anywhere.
+	*/
+	bool GetProcessors(cpu_set_t *set);
+
+	/*!
+	Applies the affinity to the running thread.
+	*/
+	void ApplyAffinity();
+
+	/*!
+	Applies the name to the running thread.
+	*/
+	void ApplyName();
+
+	pthread_t _thread;					///< The thread
+	bool _started;						///< TRUE after the start
+	bool _joined;						///< TRUE after the thread is joined
+
+	/* Thread creation parameters */
+	void* (*_threadFunc)(void*);		///< Pointer to a function to be executed by the thread.
+	void *_threadFuncArgs;				///< A pointer to a variable to be passed to the thread.
+	size_t _threadStackSize;			///< The initial size of the stack, in bytes.
+	int _processor;						///< The processor the thread is pinned to
+	int _node;							///< The NUMA node of the thread
+	char _name[UNIXTHREAD_NAME_SIZE];	///< The name of the thread
+
+	void *_exitCode;					///< The value returned from the thread function
+};
+#endif
@@ -0,0 +1,64 @@
+#include "winfutex.h"
+
+using MSIYBCore::WinFutex;
+using MSIYBCore::WaitOnAddressFn;
+using MSIYBCore::WakeByAddressFn;
+
+WaitOnAddressFn WinFutex::_wait = NULL;
+WakeByAddressFn WinFutex::_wakeOne = NULL;
+WakeByAddressFn WinFutex::_wakeAll = NULL;
+
+bool WinFutex::Load()
+{
+	// The static is initialised once even if the first calls race
+	static const bool available = Resolve();
+	return available;
+}
+
+bool WinFutex::Resolve()
+{
+	HMODULE module = LoadLibraryA("api-ms-win-core-synch-l1-2-0.dll");
+	if (!module)
+	{
+		return false;
+	}
+	_wait = (WaitOnAddressFn)GetProcAddress(module, "WaitOnAddress");
+	_wakeOne = (WakeByAddressFn)GetProcAddress(module, "WakeByAddressSingle");
+	_wakeAll = (WakeByAddressFn)GetProcAddress(module, "WakeByAddressAll");
+	return _wait && _wakeOne && _wakeAll;
+}
+
+bool WinFutex::Wait(std::atomic<int> *address, int expected, unsigned long timeout)
+{
+	if (!Load())
+	{
+		// Polling: the wake-up is the change of the word itself
+		if (address->load() == expected)
+		{
+			SwitchToThread();
+			Sleep(timeout == 0 ? 0 : 1);
+		}
+		return timeout == INFINITE || address->load() != expected;
+	}
+	if (_wait((volatile VOID*)address, &expected, sizeof(int), timeout))
+	{
+		return true;
+	}
+	return GetLastError() != ERROR_TIMEOUT;
+}
+
+void WinFutex::WakeOne(std::atomic<int> *address)
+{
+	if (Load())
+	{
+		_wakeOne((PVOID)address);
+	}
+}
+
+void WinFutex::WakeAll(std::atomic<int> *address)
+{
+	if (Load())
+	{
+		_wakeAll((PVOID)address);
+	}
+}
@@ -0,0 +1,70 @@
+/*!
+\file winfutex.h "server\desktop\src\cross\windows\threadlock\winfutex.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 12 October 2017
+*/
+
+#pragma once
+
+#include <atomic>
+#include <windows.h>
+#include "../../../defines.h"
+
+namespace MSIYBCore
+{
+	// WaitOnAddress appeared in Windows 8, so we search for these functions.
+	typedef BOOL(WINAPI *WaitOnAddressFn)(volatile VOID*, PVOID, SIZE_T, DWORD);
+	typedef VOID(WINAPI *WakeByAddressFn)(PVOID);
+
+	/*!
+	\class WinFutex winfutex.h "server\desktop\src\cross\windows\threadlock\winfutex.h"
+	\brief  Parks the threads on the 32-bit word with WaitOnAddress.
+	Without WaitOnAddress (before Windows 8) the waiting thread yields and sleeps
+	for a millisecond between the checks of the word, the wake-ups do nothing.
+	*/
+	class WinFutex
+	{
+	public:
+		/*!
+		Sleeps while the word is equal to the expected value. Static.
+		Returns on the wake-up, the timeout or at once if the word was changed (may return spuriously).
+		\param[in] address The word.
+		\param[in] expected The value the word had when the caller decided to sleep.
+		\param[in] timeout The timeout in milliseconds or INFINITE.
+		\return FALSE if the timeout expired, TRUE otherwise (the caller checks its condition again).
+		*/
+		static bool Wait(std::atomic<int> *address, int expected, unsigned long timeout = INFINITE);
+
+		/*!
+		Wakes up one thread sleeping on the word. Static.
+		\param[in] address The word.
+		*/
+		static void WakeOne(std::atomic<int> *address);
+
+		/*!
+		Wakes up all the threads sleeping on the word. Static.
+		\param[in] address The word.
+		*/
+		static void WakeAll(std::atomic<int> *address);
+
+	private:
+		/*!
+		Looks for the functions once. Static.
+		\return TRUE if WaitOnAddress is available.
+		*/
+		static bool Load();
+
+		/*!
+		Loads the functions. Static.
+		\return TRUE if all of them were found.
+		*/
+		static bool Resolve();
+
+		static WaitOnAddressFn _wait;		///< WaitOnAddress or NULL
+		static WakeByAddressFn _wakeOne;	///< WakeByAddressSingle or NULL
+		static WakeByAddressFn _wakeAll;	///< WakeByAddressAll or NULL
+	};
+}
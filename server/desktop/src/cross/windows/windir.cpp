@@ -1,19 +1,22 @@
-#include "stdafx.h"
-#include "../../stdafx.h"
 #include "windir.h"
-#include "../../common/thread.h"
-#include "../../common/stringmethods.h"
+#include "unicodeconverter.h"
+
+using MSIYBCore::DirWalk;
 
 WinDir::WinDir()
 {
 	strcpy(this->workingDir, "/");
-	ctow(this->workingDir, this->wWorkingDir);
+	ConvertCharToTCHAR(this->workingDir, this->wWorkingDir);
 }
 
 WinDir::WinDir(const char *path)
 {
 	strcpy(this->workingDir, path);
-	ctow(this->workingDir, this->wWorkingDir);
+	ConvertCharToTCHAR(this->workingDir, this->wWorkingDir);
+}
+
+WinDir::~WinDir()
+{
 }
 
 size_lt WinDir::GetDirSize()
@@ -24,60 +27,167 @@ size_lt WinDir::GetDirSize()
 size_lt WinDir::GetDirSize(const char *path)
 {
 	wchar_t wPath[PATH_MAX];
-	ctow(path, wPath);
+	ConvertCharToTCHAR(path, wPath);
 	return WinDir::GetDirSize(wPath);
 }
 
 size_lt WinDir::GetDirSize(const wchar_t *wPath)
 {
-	WIN32_FIND_DATA fdFindData;
-	HANDLE hFind;
-	size_lt size = 0;
+	return WinDir::Walk(wPath, DirVisitor(), true).size;
+}
 
-	size_lt (*GDS)(const wchar_t *) = WinDir::GetDirSize;
+size_lt WinDir::GetNumberOfFiles()
+{
+	return WinDir::GetNumberOfFiles(this->wWorkingDir);
+}
 
-	hFind = FindFirstFile(wPath, &fdFindData);
-	if (hFind == INVALID_HANDLE_VALUE)
+size_lt WinDir::GetNumberOfFiles(const char *path)
+{
+	wchar_t wPath[PATH_MAX];
+	ConvertCharToTCHAR(path, wPath);
+	return WinDir::GetNumberOfFiles(wPath);
+}
+
+size_lt WinDir::GetNumberOfFiles(const wchar_t *wPath)
+{
+	return WinDir::Walk(wPath, DirVisitor(), false).files;
+}
+
+void WinDir::MakeDir()
+{
+	WinDir::MakeDir(this->workingDir);
+}
+
+void WinDir::MakeDir(const char *path)
+{
+	wchar_t wPath[PATH_MAX];
+	ConvertCharToTCHAR(path, wPath);
+	if (!CreateDirectory(wPath, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		ThrowDirExceptionWithCode("Can't make the directory!", GetLastError());
+	}
+}
+
+bool WinDir::Exists()
+{
+	return WinDir::Exists(this->workingDir);
+}
+
+bool WinDir::Exists(const char *path)
+{
+	wchar_t wPath[PATH_MAX];
+	ConvertCharToTCHAR(path, wPath);
+	DWORD attributes = GetFileAttributes(wPath);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+DirStats WinDir::Walk(const char *path, const DirVisitor &visitor, bool withSizes)
+{
+	wchar_t wPath[PATH_MAX];
+	ConvertCharToTCHAR(path, wPath);
+	return WinDir::Walk(wPath, visitor, withSizes);
+}
+
+DirStats WinDir::Walk(const wchar_t *wPath, const DirVisitor &visitor, bool withSizes)
+{
+	std::wstring root = wPath;
+	while (!root.empty() && (root.back() == L'\\' || root.back() == L'/'))
+	{
+		root.pop_back();
+	}
+
+	DWORD attributes = GetFileAttributes(root.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		ThrowDirExceptionWithCode("Can't open the directory!", GetLastError());
+	}
+
+	DirWalk walk([root](DirWalk &walk, const std::string &path) { WinDir::ScanDir(walk, root, path); }, visitor, withSizes);
+	return walk.Run();
+}
+
+void WinDir::ScanDir(DirWalk &walk, const std::wstring &root, const std::string &path)
+{
+	wchar_t wName[PATH_MAX];
+	std::wstring pattern = root;
+	if (!path.empty())
 	{
-		ThrowDirExceptionWithCode("Can not find first file!", GetLastError());
+		ConvertCharToTCHAR(path.c_str(), wName);
+		pattern += L'\\';
+		pattern += wName;
 	}
+	pattern += L"\\*";
 
-	vector<size_lt> results;
-	int resultCount = 0;
+	// The sizes come with the entries, the files are never opened
+	WIN32_FIND_DATA fdFindData;
+	HANDLE hFind = FindFirstFileEx(pattern.c_str(), FindExInfoBasic, &fdFindData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if (hFind == INVALID_HANDLE_VALUE)
+	{
+		DWORD error = GetLastError();
+		// Removed after it was listed
+		if (error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND)
+		{
+			walk.SetError(error);
+		}
+		return;
+	}
 
-	Thread* thr = new Thread();
+	DirStats stats = { 0, 0, 0 };
+	bool visiting = walk.IsVisiting();
+	char name[PATH_MAX];
+	std::string subPath;
 	do
 	{
 		if (lstrcmp(fdFindData.cFileName, TEXT(".")) == 0 || lstrcmp(fdFindData.cFileName, TEXT("..")) == 0)
 		{
 			continue;
 		}
-		
-		LPWSTR filePath;
-		wcscpy(filePath, wPath);
-		lstrcatW(filePath, fdFindData.cFileName);
+		ConvertTCHARToChar(fdFindData.cFileName, name);
 
-		if (fdFindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		// The links are not followed
+		bool directory = (fdFindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+			!(fdFindData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT);
+		size_lt size = 0;
+		if (directory)
 		{
-			lstrcatW(filePath, TEXT("\\"));
-			
-			size_lt res = 0;
-			Thread::CheckListCompleted();
-			if (!thr || thr->Start(GDS, filePath, &res) < 0)
+			subPath = path;
+			if (!subPath.empty())
 			{
-				size += WinDir::GetDirSize(filePath);
+				subPath += '\\';
 			}
+			subPath += name;
+			walk.Enqueue(subPath);
+			stats.dirs++;
 		}
 		else
 		{
-			char path[PATH_MAX];
-			wcstombs(path, wPath, (size_t)PATH_MAX);
-			size += File::FileSize(path);
+			size = ((size_lt)fdFindData.nFileSizeHigh << 32) | fdFindData.nFileSizeLow;
+			stats.files++;
+			stats.size += size;
+		}
+
+		if (visiting)
+		{
+			ULARGE_INTEGER modTime;
+			modTime.LowPart = fdFindData.ftLastWriteTime.dwLowDateTime;
+			modTime.HighPart = fdFindData.ftLastWriteTime.dwHighDateTime;
+
+			DirEntry entry;
+			entry.dirPath = path.c_str();
+			entry.name = name;
+			entry.size = size;
+			// FILETIME counts 100 ns intervals from 1601
+			entry.modTime = (time_t)((modTime.QuadPart - 116444736000000000ULL) / 10000000ULL);
+			entry.directory = directory;
+			walk.Visit(entry);
 		}
 	} while (FindNextFile(hFind, &fdFindData));
-	thr->WaitToComplete();
-	delete thr;
+
+	DWORD error = GetLastError();
+	if (error != ERROR_NO_MORE_FILES)
+	{
+		walk.SetError(error);
+	}
 	FindClose(hFind);
-	return size;
+	walk.Add(stats);
 }
-
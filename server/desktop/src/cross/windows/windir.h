@@ -1,6 +1,8 @@
 #pragma once
 
+#include <string>
 #include "../idir.h"
+#include "../../common/dirwalk.h"
 
 class WinDir : public IDir
 {
@@ -20,19 +22,28 @@ public:
 	static size_lt GetNumberOfFiles(const char *path);
 	static size_lt GetNumberOfFiles(const wchar_t *wPath); 
 
-	virtual File& SearchFileName(const char *fileName) override;
-	static File& SearchFileName(const char *path, const char *fileName);
-
-	virtual vector<File&> SearchFileExt(const char* fileExtention) override;
-	static vector<File&> SearchFileExt(const char *path, const char* fileExtention);
-
-	virtual vector<File&> SearchFileTime(time_t fileTime) override;
-	static vector<File&> SearchFileTime(const char *path, time_t fileTime);
-
 	virtual void MakeDir() override;
 	static void MakeDir(const char *path);
 
 	virtual bool Exists() override;
 	static bool Exists(const char *path);
 
+	/*!
+	Walks the directory tree in parallel.
+	\param[in] path The directory to be walked.
+	\param[in] visitor Receives every entry from many threads at once. May be empty.
+	\param[in] withSizes FALSE if only the numbers of the entries are needed.
+	\return The totals of the tree.
+	*/
+	static DirStats Walk(const char *path, const DirVisitor &visitor = DirVisitor(), bool withSizes = true);
+	static DirStats Walk(const wchar_t *wPath, const DirVisitor &visitor = DirVisitor(), bool withSizes = true);
+
+private:
+	/*!
+	Reads one directory of the walk with FindFirstFileEx.
+	\param[in] walk The walk.
+	\param[in] root The walked directory.
+	\param[in] path The path of the directory relative to the root.
+	*/
+	static void ScanDir(MSIYBCore::DirWalk &walk, const std::wstring &root, const std::string &path);
 };
@@ -0,0 +1,216 @@
+#include "windirwatcher.h"
+#ifdef _WIN32
+#include "unicodeconverter.h"
+
+#define DIRWATCHER_FILTER (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+WinDirWatcher::WinDirWatcher() : _hDir(INVALID_HANDLE_VALUE), _handler(NULL), _running(false)
+{
+	_hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!_hStop)
+	{
+		ThrowDirExceptionWithCode("Can't create the stop event!", GetLastError());
+	}
+}
+
+WinDirWatcher::~WinDirWatcher()
+{
+	Stop();
+	CloseHandle(_hStop);
+}
+
+void WinDirWatcher::Start(const char *path, IDirWatcherHandler *handler)
+{
+	if (_running)
+	{
+		ThrowDirException("The watcher is already started!");
+	}
+
+	wchar_t wPath[PATH_MAX];
+	ConvertCharToTCHAR(path, wPath);
+	_root = wPath;
+	while (!_root.empty() && (_root.back() == L'\\' || _root.back() == L'/'))
+	{
+		_root.pop_back();
+	}
+
+	_hDir = CreateFile(_root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (_hDir == INVALID_HANDLE_VALUE)
+	{
+		ThrowDirExceptionWithCode("Can't watch the directory!", GetLastError());
+	}
+
+	_handler = handler;
+	ResetEvent(_hStop);
+	_thread.SetName("dirwatcher");
+	// Throws if the thread can't be created; the returned ID is of no use here
+	try
+	{
+		_running = true;
+		_thread.Start((void*)&WinDirWatcher::ThreadFunc, this);
+	}
+	catch (...)
+	{
+		_running = false;
+		CloseHandle(_hDir);
+		_hDir = INVALID_HANDLE_VALUE;
+		throw;
+	}
+}
+
+void WinDirWatcher::Stop()
+{
+	if (!_running)
+	{
+		return;
+	}
+
+	SetEvent(_hStop);
+	_thread.WaitToComplete();
+	_running = false;
+	CloseHandle(_hDir);
+	_hDir = INVALID_HANDLE_VALUE;
+}
+
+THREADFUNC WinDirWatcher::ThreadFunc(void *args)
+{
+	((WinDirWatcher*)args)->Run();
+	return 0;
+}
+
+void WinDirWatcher::Run()
+{
+	// FILE_NOTIFY_INFORMATION must be DWORD-aligned
+	DWORD buffer[DIRWATCHER_BUFFER_SIZE / sizeof(DWORD)];
+	wchar_t wPath[PATH_MAX];
+	OVERLAPPED overlapped;
+	ZeroMemory(&overlapped, sizeof(overlapped));
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!overlapped.hEvent)
+	{
+		return;
+	}
+	HANDLE events[2] = { overlapped.hEvent, _hStop };
+
+	while (true)
+	{
+		ResetEvent(overlapped.hEvent);
+		if (!ReadDirectoryChangesW(_hDir, buffer, sizeof(buffer), TRUE, DIRWATCHER_FILTER, NULL, &overlapped, NULL))
+		{
+			break;
+		}
+
+		if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+		{
+			CancelIo(_hDir);
+			GetOverlappedResult(_hDir, &overlapped, NULL, TRUE);
+			break;
+		}
+
+		DWORD readed = 0;
+		if (!GetOverlappedResult(_hDir, &overlapped, &readed, FALSE))
+		{
+			break;
+		}
+
+		if (readed == 0)
+		{
+			// The buffer overflowed, the changes are lost
+			try
+			{
+				DirChange change = { DIRCHANGEOVERFLOW, "", true, 0, 0 };
+				_handler->OnDirChange(change);
+			}
+			catch (std::exception &)
+			{
+				// The handler failed on this change, the next ones are still delivered
+			}
+			continue;
+		}
+
+		for (byte *pos = (byte*)buffer;;)
+		{
+			FILE_NOTIFY_INFORMATION *info = (FILE_NOTIFY_INFORMATION*)pos;
+			size_lt length = info->FileNameLength / sizeof(wchar_t);
+			if (length >= PATH_MAX)
+			{
+				length = PATH_MAX - 1;
+			}
+			wcsncpy(wPath, info->FileName, length);
+			wPath[length] = L'\0';
+
+			try
+			{
+				switch (info->Action)
+				{
+				case FILE_ACTION_ADDED:
+				case FILE_ACTION_RENAMED_NEW_NAME:
+					Report(DIRCHANGEADDED, wPath);
+					break;
+				case FILE_ACTION_REMOVED:
+				case FILE_ACTION_RENAMED_OLD_NAME:
+					Report(DIRCHANGEREMOVED, wPath);
+					break;
+				case FILE_ACTION_MODIFIED:
+					Report(DIRCHANGEMODIFIED, wPath);
+					break;
+				}
+			}
+			catch (std::exception &)
+			{
+				// The handler failed on this record, the rest of the batch is still delivered
+			}
+
+			if (info->NextEntryOffset == 0)
+			{
+				break;
+			}
+			pos += info->NextEntryOffset;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+void WinDirWatcher::Report(DirChangeType type, const wchar_t *wPath)
+{
+	char path[PATH_MAX];
+	ConvertTCHARToChar((TCHAR*)wPath, path);
+
+	DirChange change;
+	change.type = type;
+	change.path = path;
+	// The removed entry can't be examined: it may have been a directory
+	change.directory = type == DIRCHANGEREMOVED;
+	change.size = 0;
+	change.modTime = 0;
+
+	if (type != DIRCHANGEREMOVED)
+	{
+		std::wstring fullPath = _root + L'\\' + wPath;
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesEx(fullPath.c_str(), GetFileExInfoStandard, &data))
+		{
+			return;
+		}
+
+		change.directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		if (change.directory && type == DIRCHANGEMODIFIED)
+		{
+			// The contents of the directory changed, the entries are reported on their own
+			return;
+		}
+
+		ULARGE_INTEGER modTime;
+		modTime.LowPart = data.ftLastWriteTime.dwLowDateTime;
+		modTime.HighPart = data.ftLastWriteTime.dwHighDateTime;
+		change.size = change.directory ? 0 : ((size_lt)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		// FILETIME counts 100 ns intervals from 1601
+		change.modTime = (time_t)((modTime.QuadPart - 116444736000000000ULL) / 10000000ULL);
+	}
+
+	_handler->OnDirChange(change);
+}
+
+#endif
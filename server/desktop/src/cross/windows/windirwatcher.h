@@ -0,0 +1,67 @@
+/*!
+\file windirwatcher.h "server\desktop\src\cross\windows\windirwatcher.h"
+\authors Dmitry Zaitsev
+\copyright  MSiYB 2017
+\license GPL license
+\version 1.0
+\date 13 September 2017
+*/
+
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#include <string>
+#include "../idirwatcher.h"
+#include "../../common/thread.h"
+
+#define DIRWATCHER_BUFFER_SIZE (64 * 1024)
+
+/*!
+\class WinDirWatcher windirwatcher.h "server\desktop\src\cross\windows\windirwatcher.h"
+\brief  The ReadDirectoryChangesW watcher of the directory tree.
+One overlapped request watches the whole subtree. The removed entries are reported as files:
+Windows doesn't tell whether they were directories.
+*/
+class WinDirWatcher : public IDirWatcher
+{
+public:
+	/*!
+	Creates the event used by Stop.
+	*/
+	WinDirWatcher();
+
+	/*!
+	Stops watching and closes the handles.
+	*/
+	~WinDirWatcher();
+
+	virtual void Start(const char *path, IDirWatcherHandler *handler) override;
+	virtual void Stop() override;
+
+private:
+	/*!
+	The thread function. Reads the changes until Stop is called.
+	\param[in] args The watcher.
+	*/
+	static THREADFUNC ThreadFunc(void *args);
+
+	/*!
+	Reads and dispatches the changes until Stop is called.
+	*/
+	void Run();
+
+	/*!
+	Passes the change to the handler. Reads the attributes of the added and modified entries,
+	the entries already gone are skipped.
+	*/
+	void Report(DirChangeType type, const wchar_t *wPath);
+
+	HANDLE _hDir;						///< The watched directory
+	HANDLE _hStop;						///< The event signalled by Stop
+	std::wstring _root;					///< The watched directory
+	IDirWatcherHandler *_handler;		///< The receiver of the changes
+	Thread _thread;						///< Reads the changes
+	bool _running;						///< TRUE between Start and Stop
+};
+
+#endif
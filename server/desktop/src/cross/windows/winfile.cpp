@@ -3,20 +3,25 @@
 
 WinFile::WinFile()
 {
-	_fileName = new char[MAX_PATH];
-	_tFileName = new TCHAR[MAX_PATH];
+	_fileName = (char*)MSIYBCore::Pool::Allocate(MAX_PATH);
+	_tFileName = (TCHAR*)MSIYBCore::Pool::Allocate(MAX_PATH * sizeof(TCHAR));
 	_opened = false;
+	_mapped = false;
+	_hMapping = NULL;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
 }
 
 WinFile::WinFile(const char *fileName)
 {
-	_fileName = new char[MAX_PATH];
+	_fileName = (char*)MSIYBCore::Pool::Allocate(MAX_PATH);
 	if (!_fileName)
 	{
 		ThrowException("Can't allocate memory on fileName");
 	}
 
-	_tFileName = new TCHAR[MAX_PATH];
+	_tFileName = (TCHAR*)MSIYBCore::Pool::Allocate(MAX_PATH * sizeof(TCHAR));
 	if (!_tFileName)
 	{
 		ThrowException("Can't allocate memory on tFileName");
@@ -25,6 +30,11 @@ WinFile::WinFile(const char *fileName)
 	strcpy(_fileName, fileName);
 	ConvertCharToTCHAR(fileName, _tFileName);
 	_opened = false;
+	_mapped = false;
+	_hMapping = NULL;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
 }
 
 WinFile::~WinFile()
@@ -34,8 +44,8 @@ WinFile::~WinFile()
 		Close();
 	}
 
-	delete[] _fileName;
-	delete[] _tFileName;
+	MSIYBCore::Pool::Free((byte*)_fileName, MAX_PATH);
+	MSIYBCore::Pool::Free((byte*)_tFileName, MAX_PATH * sizeof(TCHAR));
 }
 
 void WinFile::Open(FileOpenMode mode)
@@ -43,14 +53,25 @@ void WinFile::Open(FileOpenMode mode)
 	ConvertCharToTCHAR(_fileName, _tFileName);
 	_hFile = tOpen(_tFileName, mode);
 	_opened = true;
+	if (mode == FileOpenMode::MAPPED)
+	{
+		try
+		{
+			Map();
+		}
+		catch (FileException &)
+		{
+			// The file which can't be mapped is not opened: the handle is not left to the destructor
+			Close();
+			throw;
+		}
+	}
 }
 
 void WinFile::Open(const char *fileName, FileOpenMode mode)
 {
 	strcpy(_fileName, fileName);
-	ConvertCharToTCHAR(_fileName, _tFileName);
-	_hFile = tOpen(_tFileName, mode);
-	_opened = true;
+	Open(mode);
 }
 
 HANDLE WinFile::tOpen(const TCHAR *fileName, FileOpenMode mode)
@@ -60,6 +81,7 @@ HANDLE WinFile::tOpen(const TCHAR *fileName, FileOpenMode mode)
 	switch (mode)
 	{
 	case FileOpenMode::READONLY:
+	case FileOpenMode::MAPPED:
 		desiredAccess = GENERIC_READ;
 		break;
 	case FileOpenMode::WRITE:
@@ -73,6 +95,10 @@ HANDLE WinFile::tOpen(const TCHAR *fileName, FileOpenMode mode)
 		desiredAccess = GENERIC_WRITE | GENERIC_READ;
 		creationDisposition = CREATE_ALWAYS;
 		break;
+	case FileOpenMode::WRITEATTHEEND:
+		desiredAccess = GENERIC_WRITE | GENERIC_READ;
+		creationDisposition = OPEN_ALWAYS;
+		break;
 	}
 
 	HANDLE hfile = CreateFile(fileName, desiredAccess, FILE_SHARE_READ, NULL,
@@ -87,6 +113,7 @@ HANDLE WinFile::tOpen(const TCHAR *fileName, FileOpenMode mode)
 
 void WinFile::Close()
 {
+	Unmap();
 	Close(_hFile);
 	_opened = false;
 }
@@ -124,6 +151,28 @@ void WinFile::Rename(const char *fileName, const char * newFileName)
 	}
 }
 
+void WinFile::Sync()
+{
+	if (!FlushFileBuffers(_hFile))
+	{
+		ThrowFileExceptionWithCode("Can't write file to disk!", GetLastError());
+	}
+}
+
+void WinFile::Replace(const char *fileName, const char *newFileName)
+{
+	TCHAR tFileName[MAX_PATH];
+	TCHAR tNewFileName[MAX_PATH];
+	ConvertCharToTCHAR(fileName, tFileName);
+	ConvertCharToTCHAR(newFileName, tNewFileName);
+
+	// Without MOVEFILE_COPY_ALLOWED: the copy isn't atomic
+	if (!MoveFileEx(tFileName, tNewFileName, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		ThrowFileExceptionWithCode("Can't rename file", GetLastError());
+	}
+}
+
 bool WinFile::Exist()
 {
 	return tExist(_tFileName);
@@ -152,6 +201,7 @@ void WinFile::Delete()
 {
 	if (_opened)
 	{
+		Unmap();
 		Close(_hFile);
 	}
 	tDelete(_tFileName);
@@ -199,6 +249,13 @@ size_lt WinFile::FileSize(const char *fileName)
 
 size_lt WinFile::Seek(size_lt offset, SeekReference move)
 {
+	if (_mapped)
+	{
+		size_lt base = move == SeekReference::START ? 0 : move == SeekReference::CURRENT ? _viewPos : _viewSize;
+		_viewPos = base + offset;
+		return _viewPos;
+	}
+
 	LARGE_INTEGER ps, FilePos;
 	ps.QuadPart = (size_lt)offset;
 
@@ -213,6 +270,11 @@ size_lt WinFile::Seek(size_lt offset, SeekReference move)
 
 int WinFile::ReadByte()
 {
+	if (_mapped)
+	{
+		return _viewPos < _viewSize ? (int)_view[_viewPos++] : -1;
+	}
+
 	char b;
 	int readedByte;
 	bool res = ReadFile(_hFile, (LPVOID)&b, 1, (LPDWORD)&readedByte, NULL);
@@ -230,6 +292,14 @@ int WinFile::ReadByte()
 
 size_lt WinFile::ReadBlock(byte *block, size_lt blockSize)
 {
+	if (_mapped)
+	{
+		size_lt left = _viewPos < _viewSize ? _viewSize - _viewPos : 0;
+		size_lt readed = blockSize < left ? blockSize : left;
+		memcpy(block, _view + _viewPos, readed);
+		_viewPos += readed;
+		return readed;
+	}
 	return ReadBlock(_hFile, block, blockSize);
 }
 
@@ -264,6 +334,103 @@ void WinFile::WriteBlock(HANDLE hFile, byte * block, size_lt sizeBlock)
 	}
 }
 
+size_lt WinFile::ReadBlockV(IOBuffer *buffers, size_lt count)
+{
+	size_lt readed = 0;
+	for (size_lt i = 0; i < count; i++)
+	{
+		size_lt part = ReadBlock(buffers[i].data, buffers[i].size);
+		readed += part;
+		if (part < buffers[i].size)
+		{
+			break;
+		}
+	}
+	return readed;
+}
+
+void WinFile::WriteBlockV(IOBuffer *buffers, size_lt count)
+{
+	WriteBlockV(_hFile, buffers, count);
+}
+
+void WinFile::WriteBlockV(HANDLE hFile, IOBuffer *buffers, size_lt count)
+{
+	for (size_lt i = 0; i < count; i++)
+	{
+		WriteBlock(hFile, buffers[i].data, buffers[i].size);
+	}
+}
+
+t_filehandle WinFile::GetHandle()
+{
+	return _hFile;
+}
+
+ByteSpan WinFile::GetView()
+{
+	if (!_mapped)
+	{
+		ThrowFileException("File isn't opened in the MAPPED mode!");
+	}
+	ByteSpan view = { _view, _viewSize };
+	return view;
+}
+
+void WinFile::SetAccessPattern(FileAccessPattern pattern)
+{
+	// Windows takes the hint only on opening (FILE_FLAG_SEQUENTIAL_SCAN / FILE_FLAG_RANDOM_ACCESS),
+	// its cache manager detects the sequential reads by itself
+}
+
+void WinFile::Prefetch(size_lt offset, size_lt length)
+{
+	// The cache manager reads ahead the sequentially read files itself
+}
+
+void WinFile::Map()
+{
+	_viewSize = FileSize(_hFile);
+	_viewPos = 0;
+	_hMapping = NULL;
+	_view = NULL;
+	// CreateFileMapping can't map the empty file, it has the empty view
+	if (_viewSize > 0)
+	{
+		_hMapping = CreateFileMapping(_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!_hMapping)
+		{
+			ThrowFileExceptionWithCode("Can't map file into memory!", GetLastError());
+		}
+		_view = (byte*)MapViewOfFile(_hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!_view)
+		{
+			DWORD error = GetLastError();
+			CloseHandle(_hMapping);
+			_hMapping = NULL;
+			ThrowFileExceptionWithCode("Can't map file into memory!", error);
+		}
+	}
+	_mapped = true;
+}
+
+void WinFile::Unmap()
+{
+	if (_view)
+	{
+		UnmapViewOfFile(_view);
+	}
+	if (_hMapping)
+	{
+		CloseHandle(_hMapping);
+	}
+	_mapped = false;
+	_hMapping = NULL;
+	_view = NULL;
+	_viewSize = 0;
+	_viewPos = 0;
+}
+
 size_lt WinFile::ReadAllBytes(const char *fileName, byte **block)
 {
 	TCHAR tFileName[MAX_PATH];
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "../ifile.h"
+#include "../../common/pool.h"
 #include "windows.h"
 
 using namespace std;
@@ -19,7 +20,7 @@ using namespace std;
 \brief  The Windows dependent structure of the file.
 Provides the Windows-specified access to the file methods.
 */
-class WinFile : public IFile
+class WinFile : public IFile, public MSIYBCore::Pooled
 {
 public:
 	/*!
@@ -83,6 +84,19 @@ public:
 	*/
 	static void Rename(const char *fileName, const char *newFileName);
 
+	/*!
+	Writes the data of the opened file through the OS cache to the disk.
+	*/
+	virtual void Sync() override;
+
+	/*!
+	Renames the file over the existing one in one step: the new name has either the old file or the new one. Static.
+	The rename is written to the disk before the return.
+	\param[in] fileName The current name of the file.
+	\param[in] newFileName The name to be replaced.
+	*/
+	static void Replace(const char *fileName, const char *newFileName);
+
 	/*!
 	Checks if the file exists.
 	\return TRUE if the file exists, FALSE otherwise.
@@ -192,6 +206,56 @@ public:
 	*/
 	static void WriteBlock(HANDLE hFile, byte *block, size_lt sizeBlock);
 
+	/*!
+	Returns the handle of the opened file.
+	\return The handle of the file.
+	*/
+	virtual t_filehandle GetHandle() override;
+
+	/*!
+	Reads the file into the several buffers.
+	ReadFileScatter needs the unbuffered file and the page-aligned buffers, so the buffers are read one by one.
+	\param[in] buffers The buffers to be filled.
+	\param[in] count The number of the buffers.
+	\return The number of the bytes read.
+	*/
+	virtual size_lt ReadBlockV(IOBuffer *buffers, size_lt count) override;
+
+	/*!
+	Writes the several buffers into the file.
+	WriteFileGather needs the unbuffered file and the page-aligned buffers, so the buffers are written one by one.
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	virtual void WriteBlockV(IOBuffer *buffers, size_lt count) override;
+
+	/*!
+	Writes the several buffers into the file. Static.
+	\param[in] hFile The handle of the opened file.
+	\param[in] buffers The buffers to be written.
+	\param[in] count The number of the buffers.
+	*/
+	static void WriteBlockV(HANDLE hFile, IOBuffer *buffers, size_lt count);
+
+	/*!
+	Returns the memory of the file opened in the MAPPED mode.
+	\return The view of the whole file.
+	*/
+	virtual ByteSpan GetView() override;
+
+	/*!
+	Tells the OS how the opened file is going to be accessed.
+	\param[in] pattern The expected order of the accesses.
+	*/
+	virtual void SetAccessPattern(FileAccessPattern pattern) override;
+
+	/*!
+	Asks the OS to start reading the region into its cache.
+	\param[in] offset The offset of the region.
+	\param[in] length The length of the region.
+	*/
+	virtual void Prefetch(size_lt offset, size_lt length) override;
+
 	/////////////////////////////////////////////////////////////////////////////
 	////////////////////           STATIC METHODS            ////////////////////
 	/////////////////////////////////////////////////////////////////////////////
@@ -222,8 +286,23 @@ public:
 	static FileMeta LastModified(const char *fileName);
 
 private:
+	/*!
+	Maps the opened file into the memory (the MAPPED mode).
+	*/
+	void Map();
+
+	/*!
+	Unmaps the file if it is mapped.
+	*/
+	void Unmap();
+
 	HANDLE _hFile;			///< The handle of the opened file
 	char *_fileName;		///< The name of the file
 	WCHAR *_tFileName;		///< The name of the file in the unicode charset
 	bool _opened;			///< Determines if the file is opened
+	bool _mapped;			///< Determines if the file is opened in the MAPPED mode
+	HANDLE _hMapping;		///< The file mapping object (NULL for the empty file)
+	byte *_view;			///< The memory of the mapped file (NULL for the empty file)
+	size_lt _viewSize;		///< The size of the mapped memory
+	size_lt _viewPos;		///< The read position in the mapped memory
 };
\ No newline at end of file
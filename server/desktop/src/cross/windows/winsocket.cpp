@@ -114,6 +114,10 @@ int WinSocket::Recv(char *buf, int size)
 {
 
 	int recieved = recv(sock, buf, size, 0);
+	if (recieved < 0 && WSAGetLastError() == WSAEWOULDBLOCK)
+	{
+		return SOCKET_WOULDBLOCK;
+	}
 	if (recieved < 0)
 	{
 		ThrowSocketExceptionWithCode("Error Recieve. WSAGetLastError:", WSAGetLastError());
@@ -121,9 +125,25 @@ int WinSocket::Recv(char *buf, int size)
 	return recieved;
 }
 
+int WinSocket::RecvBuffer(MSIYBCore::Buffer *buffer)
+{
+	size_lt free;
+	byte *tail = buffer->GetTail(&free);
+	int recieved = Recv((char*)tail, free > MAX_INT ? MAX_INT : (int)free);
+	if (recieved > 0)
+	{
+		buffer->Commit(recieved);
+	}
+	return recieved;
+}
+
 int WinSocket::Send(char *buf, int size)
 {
 	int sended = send(sock, buf, size, 0);
+	if (sended < 0 && WSAGetLastError() == WSAEWOULDBLOCK)
+	{
+		return SOCKET_WOULDBLOCK;
+	}
 	if (sended < 0)
 	{
 		ThrowSocketExceptionWithCode("Error Send. WSAGetLastError:", WSAGetLastError());
@@ -132,34 +152,55 @@ int WinSocket::Send(char *buf, int size)
 }
 
 
-int WinSocket::SendAll(char *buf, int bufLen)
+int WinSocket::SendV(IOBuffer *buffers, size_lt count)
 {
-	int sizeBuffer = 0;
-	int lenght = bufLen;
+	// One WSASend per IOBUFFER_MAX_COUNT buffers, the caller sends the rest after the partial result
+	WSABUF wsaBuffers[IOBUFFER_MAX_COUNT];
+	DWORD wsaCount = 0;
+	for (size_lt i = 0; i < count && wsaCount < IOBUFFER_MAX_COUNT; i++)
+	{
+		wsaBuffers[wsaCount].buf = (char*)buffers[i].data;
+		wsaBuffers[wsaCount].len = buffers[i].size > MAX_INT ? MAX_INT : (ULONG)buffers[i].size;
+		wsaCount++;
+	}
 
-	while (sizeBuffer < SIZE_FIRST_MESSAGE)
+	DWORD sended = 0;
+	if (WSASend(sock, wsaBuffers, wsaCount, &sended, 0, NULL, NULL) == SOCKET_ERROR)
 	{
-		int sended = send(sock, (char*)&lenght + sizeBuffer, SIZE_FIRST_MESSAGE - sizeBuffer, 0);
-		if (sended < 0)
+		if (WSAGetLastError() == WSAEWOULDBLOCK)
 		{
-			ThrowSocketExceptionWithCode("Error Send. WSAGetLastError:", WSAGetLastError());
+			return SOCKET_WOULDBLOCK;
 		}
-		sizeBuffer += sended;
+		ThrowSocketExceptionWithCode("Error WSASend. WSAGetLastError:", WSAGetLastError());
 	}
+	return (int)sended;
+}
 
-	sizeBuffer = 0;
-
-	while (sizeBuffer < lenght)
+int WinSocket::SendAll(char *buf, int bufLen)
+{
+	// The header and the payload go out in one call
+	int lenght = bufLen;
+	IOBuffer buffers[2] = { { (byte*)&lenght, SIZE_FIRST_MESSAGE }, { (byte*)buf, (size_lt)bufLen } };
+	size_lt index = 0;
+	size_lt skip = 0;
+	while (index < 2)
 	{
-		int sended = send(sock, buf + sizeBuffer, bufLen - sizeBuffer, 0);
+		IOBuffer rest[2];
+		size_lt count = 0;
+		for (size_lt i = index; i < 2; i++, count++)
+		{
+			rest[count].data = buffers[i].data + (i == index ? skip : 0);
+			rest[count].size = buffers[i].size - (i == index ? skip : 0);
+		}
+		int sended = SendV(rest, count);
 		if (sended < 0)
 		{
 			ThrowSocketExceptionWithCode("Error Send. WSAGetLastError:", WSAGetLastError());
 		}
-		sizeBuffer += sended;
+		AdvanceIOBuffers(buffers, 2, &index, &skip, sended);
 	}
 
-	return sizeBuffer;
+	return bufLen;
 }
 
 void WinSocket::Connect()
@@ -210,17 +251,24 @@ void WinSocket::Listen(int len)
 }
 
 ISocket* WinSocket::Accept()
+{
+	return Accept(NULL);
+}
+
+ISocket* WinSocket::Accept(MSIYBCore::Arena *arena)
 {
 	int sizeSAddr = sizeof(sAddr);
 	SOCKET newS = accept(sock, (sockaddr*)&sAddr, &sizeSAddr);
-	if (!newS) return NULL;
+	if (newS == INVALID_SOCKET && WSAGetLastError() == WSAEWOULDBLOCK)
+	{
+		return NULL;
+	}
 	if (newS == INVALID_SOCKET)
 	{
-		Close();
-		WSACleanup();
+		// The listener stays open: the failure may concern only the accepted connection
 		ThrowSocketExceptionWithCode("Error Accept. WSAGetLastError:", WSAGetLastError());
 	}
-	WinSocket *newSocket = new WinSocket(newS);
+	WinSocket *newSocket = arena ? arena->New<WinSocket>(newS) : new WinSocket(newS);
 	newSocket->sAddr = sAddr;
 	newSocket->wsaData = wsaData;
 	return (ISocket*)newSocket;
@@ -234,4 +282,120 @@ int WinSocket::RecvFrom()
 int WinSocket:: SendTo()
 {
 	return 0;
+}
+
+void WinSocket::SetNonBlocking(bool nonBlocking)
+{
+	u_long mode = nonBlocking ? 1 : 0;
+	if (ioctlsocket(sock, FIONBIO, &mode))
+	{
+		ThrowSocketExceptionWithCode("Error ioctlsocket. WSAGetLastError:", WSAGetLastError());
+	}
+}
+
+t_descriptor WinSocket::GetDescriptor()
+{
+	return sock;
+}
+
+static TransmitFileFn GetTransmitFile()
+{
+	static TransmitFileFn transmitFile = (TransmitFileFn)GetProcAddress(LoadLibraryA("mswsock.dll"), "TransmitFile");
+	return transmitFile;
+}
+
+static void SetFileOffset(HANDLE hFile, size_lt offset)
+{
+	LARGE_INTEGER pos;
+	pos.QuadPart = offset;
+	if (!SetFilePointerEx(hFile, pos, NULL, FILE_BEGIN))
+	{
+		ThrowSocketExceptionWithCode("Error SetFilePointerEx. GetLastError:", GetLastError());
+	}
+}
+
+int WinSocket::SendFilePart(t_filehandle file, size_lt offset, int size)
+{
+	// TransmitFile asked for zero bytes would send the whole file
+	if (size <= 0)
+	{
+		return 0;
+	}
+	TransmitFileFn transmitFile = GetTransmitFile();
+	SetFileOffset(file, offset);
+	if (!transmitFile)
+	{
+		// No TransmitFile: go through a buffer
+		char buf[FILE_BUFFER_SIZE];
+		DWORD readed = 0;
+		if (!ReadFile(file, buf, size < FILE_BUFFER_SIZE ? size : FILE_BUFFER_SIZE, &readed, NULL))
+		{
+			ThrowSocketExceptionWithCode("Error ReadFile. GetLastError:", GetLastError());
+		}
+		return readed ? Send(buf, readed) : 0;
+	}
+
+	if (!transmitFile(sock, file, size, 0, NULL, NULL, 0))
+	{
+		if (WSAGetLastError() == WSAEWOULDBLOCK)
+		{
+			return SOCKET_WOULDBLOCK;
+		}
+		ThrowSocketExceptionWithCode("Error TransmitFile. WSAGetLastError:", WSAGetLastError());
+	}
+	return size;
+}
+
+size_lt WinSocket::SendFile(t_filehandle file, size_lt offset, size_lt length)
+{
+	TransmitFileFn transmitFile = GetTransmitFile();
+	long lenght = (long)length;
+	// TransmitFile asked for zero bytes sends the whole file: the empty region is the prefix alone
+	if (!transmitFile || length == 0)
+	{
+		int sizeBuffer = 0;
+		while (sizeBuffer < (int)SIZE_FIRST_MESSAGE)
+		{
+			int sended = Send((char*)&lenght + sizeBuffer, (int)SIZE_FIRST_MESSAGE - sizeBuffer);
+			if (sended <= 0)
+			{
+				ThrowSocketException("Error Send, the length prefix is not sent");
+			}
+			sizeBuffer += sended;
+		}
+
+		size_lt sendedT = 0;
+		while (sendedT < length)
+		{
+			size_lt left = length - sendedT;
+			int sended = SendFilePart(file, offset + sendedT, left > TRANSMIT_FILE_CHUNK ? TRANSMIT_FILE_CHUNK : (int)left);
+			if (sended == 0)
+			{
+				ThrowSocketException("Error SendFile, file is shorter than length");
+			}
+			sendedT += sended;
+		}
+		return sendedT;
+	}
+
+	// The length prefix goes as the head buffer of the first call
+	TransmitFileBuffers buffers;
+	buffers.Head = &lenght;
+	buffers.HeadLength = SIZE_FIRST_MESSAGE;
+	buffers.Tail = NULL;
+	buffers.TailLength = 0;
+
+	SetFileOffset(file, offset);
+	size_lt sendedT = 0;
+	do
+	{
+		size_lt left = length - sendedT;
+		DWORD chunk = left > TRANSMIT_FILE_CHUNK ? TRANSMIT_FILE_CHUNK : (DWORD)left;
+		if (!transmitFile(sock, file, chunk, 0, NULL, sendedT ? NULL : &buffers, 0))
+		{
+			ThrowSocketExceptionWithCode("Error TransmitFile. WSAGetLastError:", WSAGetLastError());
+		}
+		sendedT += chunk;
+	} while (sendedT < length);
+	return sendedT;
 }
\ No newline at end of file
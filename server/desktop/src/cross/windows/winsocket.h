@@ -5,12 +5,28 @@
 //#include <winsock2.h>
 //#include <ws2tcpip.h>
 #include "../isocket.h"
+#include "../../common/arena.h"
+#include "../../common/pool.h"
+#include "../../common/buffer.h"
 
 #include "windows.h"
 
 #define SIZE_FIRST_MESSAGE sizeof(long)
+#define TRANSMIT_FILE_CHUNK (1 << 30)
 
-class WinSocket : public ISocket
+// TransmitFile lives in mswsock.dll, we load it like the other optional functions,
+// so mswsock.h (which wants winsock2.h before windows.h) is not needed.
+typedef struct
+{
+	PVOID Head;
+	DWORD HeadLength;
+	PVOID Tail;
+	DWORD TailLength;
+} TransmitFileBuffers;
+
+typedef BOOL(PASCAL *TransmitFileFn)(SOCKET, HANDLE, DWORD, DWORD, LPOVERLAPPED, TransmitFileBuffers*, DWORD);
+
+class WinSocket : public ISocket, public MSIYBCore::Pooled
 {
 	SOCKET sock;
 	WSADATA wsaData;
@@ -32,7 +48,9 @@ public:
 	int Select(); // TODO EPOLL SOCKETS	
 	int RecvAll(char *buf);
 	int Recv(char *buf, int size);
+	int RecvBuffer(MSIYBCore::Buffer *buffer);
 	int Send(char *buf, int size);
+	int SendV(IOBuffer *buffers, size_lt count);
 	int SendAll(char *buf, int bufLen);
 	void Connect();
 	void ShutDown(How shutHow);
@@ -40,6 +58,11 @@ public:
 	void Bind();
 	void Listen(int len);
 	ISocket* Accept();
+	ISocket* Accept(MSIYBCore::Arena *arena);
 	int RecvFrom();
 	int SendTo();
+	void SetNonBlocking(bool nonBlocking);
+	t_descriptor GetDescriptor();
+	int SendFilePart(t_filehandle file, size_lt offset, int size);
+	size_lt SendFile(t_filehandle file, size_lt offset, size_lt length);
 };
@@ -1,13 +1,29 @@
 #include "winthread.h"
 
+/// SetThreadDescription, looked up at runtime: kernel32 has it since Windows 10 1607
+typedef HRESULT(WINAPI *SetThreadDescriptionFunc)(HANDLE thread, PCWSTR description);
+
 WinThread::WinThread()
 {
-
+	_hThread = NULL;
+	_threadSecurityAttributes = NULL;
+	_threadStackSize = 0;
+	_threadFunc = NULL;
+	_threadFuncArgs = NULL;
+	_threadFlags = 0;
+	_processor = THREAD_ANY_PROCESSOR;
+	_node = THREAD_ANY_NODE;
+	_name[0] = L'\0';
+	_threadSystemID = 0;
+	_exitCode = 0;
 }
 
 WinThread::~WinThread()
 {
-
+	if (_hThread)
+	{
+		CloseHandle(_hThread);
+	}
 }
 
 
@@ -52,19 +68,67 @@ int WinThread::GetMaxThreadCount()
 	return sysinfo.dwNumberOfProcessors;
 }
 
+int WinThread::GetProcessor(int index)
+{
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) || !processMask)
+	{
+		return index % GetMaxThreadCount();
+	}
+	int count = 0;
+	for (DWORD_PTR mask = processMask; mask; mask &= mask - 1)
+	{
+		count++;
+	}
+	index %= count;
+	for (int i = 0; i < (int)(sizeof(DWORD_PTR) * 8); i++)
+	{
+		if (((processMask >> i) & 1) && index-- == 0)
+		{
+			return i;
+		}
+	}
+	return THREAD_ANY_PROCESSOR;
+}
+
 void WinThread::Start()
 {
+	if (_hThread)
+	{
+		CloseHandle(_hThread);
+	}
+
+	// Created suspended to be set up, so the thread doesn't run on a foreign processor first
+	bool setUp = _processor != THREAD_ANY_PROCESSOR || _node != THREAD_ANY_NODE || _name[0];
 	_hThread = CreateThread(_threadSecurityAttributes,
 		_threadStackSize,
 		_threadFunc,
 		_threadFuncArgs,
-		_threadFlags,
+		setUp ? _threadFlags | CREATE_SUSPENDED : _threadFlags,
 		&_threadSystemID);
 
 	if (!_hThread)
 	{
 		ThrowThreadExceptionWithCode("Could not create new thread!", GetLastError());
 	}
+
+	if (setUp)
+	{
+		try
+		{
+			ApplyAffinity();
+			ApplyName();
+		}
+		catch (ThreadException &)
+		{
+			ResumeThread(_hThread);
+			throw;
+		}
+		if (!(_threadFlags & CREATE_SUSPENDED))
+		{
+			ResumeThread(_hThread);
+		}
+	}
 }
 
 long WinThread::GetThreadID()
@@ -74,11 +138,108 @@ long WinThread::GetThreadID()
 
 bool WinThread::CheckActive(void *result)
 {
-	this->status = GetExitCodeThread(_hThread, _exitCode);
-	result = _exitCode;
+	this->status = GetExitCodeThread(_hThread, &_exitCode);
 	if (this->status == 0)
 	{
 		ThrowThreadExceptionWithCode("Can not check thread status!", GetLastError());
 	}
-	return (this->status == STILL_ACTIVE);
+	return (_exitCode == STILL_ACTIVE);
+}
+
+void WinThread::WaitToComplete()
+{
+	if (WaitForSingleObject(_hThread, INFINITE) == WAIT_FAILED)
+	{
+		ThrowThreadExceptionWithCode("Can not wait for thread!", GetLastError());
+	}
+}
+
+void WinThread::SetAffinity(int processor)
+{
+	_processor = processor;
+	ApplyAffinity();
+}
+
+void WinThread::SetNumaNode(int node)
+{
+	_node = node;
+	ApplyAffinity();
+}
+
+void WinThread::SetName(const char *name)
+{
+	if (!MultiByteToWideChar(CP_UTF8, 0, name, -1, _name, MAX_PATH))
+	{
+		_name[0] = L'\0';
+	}
+	_name[MAX_PATH - 1] = L'\0';
+	ApplyName();
+}
+
+bool WinThread::GetProcessors(GROUP_AFFINITY *affinity)
+{
+	ZeroMemory(affinity, sizeof(GROUP_AFFINITY));
+	if (_processor != THREAD_ANY_PROCESSOR)
+	{
+		// The processors are numbered group after group
+		int processor = _processor;
+		WORD groups = GetActiveProcessorGroupCount();
+		for (WORD group = 0; group < groups && processor >= 0; group++)
+		{
+			int count = (int)GetActiveProcessorCount(group);
+			if (processor < count)
+			{
+				affinity->Group = group;
+				affinity->Mask = (KAFFINITY)1 << processor;
+				return true;
+			}
+			processor -= count;
+		}
+		ThrowThreadExceptionWithCode("Wrong processor!", _processor);
+	}
+	if (_node == THREAD_ANY_NODE)
+	{
+		return false;
+	}
+	// The node without the processors (the memory only) gives no hint
+	return GetNumaNodeProcessorMaskEx((USHORT)_node, affinity) && affinity->Mask != 0;
+}
+
+void WinThread::ApplyAffinity()
+{
+	if (!_hThread)
+	{
+		return;
+	}
+	GROUP_AFFINITY affinity;
+	if (GetProcessors(&affinity))
+	{
+		if (!SetThreadGroupAffinity(_hThread, &affinity, NULL))
+		{
+			ThrowThreadExceptionWithCode("Can not set thread affinity!", GetLastError());
+		}
+		return;
+	}
+	// Unpinned: any processor of the process
+	DWORD_PTR processMask, systemMask;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)
+		|| !SetThreadAffinityMask(_hThread, processMask))
+	{
+		ThrowThreadExceptionWithCode("Can not set thread affinity!", GetLastError());
+	}
+}
+
+void WinThread::ApplyName()
+{
+	if (!_hThread || !_name[0])
+	{
+		return;
+	}
+	static SetThreadDescriptionFunc setDescription =
+		(SetThreadDescriptionFunc)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+	// Only a hint for the tools: the thread works on without the name
+	if (setDescription)
+	{
+		setDescription(_hThread, _name);
+	}
 }
@@ -32,6 +32,9 @@ public:
 	*/
 	~WinThread();
 
+	WinThread(const WinThread& other) = delete;
+	WinThread& operator=(const WinThread& other) = delete;
+
 	/*!
 	Set up thread before launch. Only windows oriented call. 
 	\param[in] threadFunc Pointer to a function to be executed by the thread.
@@ -58,6 +61,14 @@ public:
 	*/
 	static int GetMaxThreadCount();
 
+	/*!
+	Returns the processor the process may run on by its number: the processors outside the affinity
+	of the process (ex. the cpuset of the container) are skipped. Static.
+	\param[in] index The number of the allowed processor, wraps around.
+	\return The index of the logical processor for SetAffinity.
+	*/
+	static int GetProcessor(int index);
+
 	/*!
 	Launch thread with setted parameters.
 	*/
@@ -77,7 +88,47 @@ public:
 	*/
 	virtual bool CheckActive(void *result = nullptr) override;
 
-private:	
+	/*!
+	Blocks until the thread function returns.
+	*/
+	virtual void WaitToComplete() override;
+
+	/*!
+	Pins the thread to the logical processor (numbered over all the processor groups).
+	\param[in] processor The index of the logical processor or THREAD_ANY_PROCESSOR.
+	*/
+	virtual void SetAffinity(int processor) override;
+
+	/*!
+	Keeps the thread on the processors of the NUMA node (GetNumaNodeProcessorMaskEx).
+	\param[in] node The index of the NUMA node or THREAD_ANY_NODE.
+	*/
+	virtual void SetNumaNode(int node) override;
+
+	/*!
+	Names the thread (SetThreadDescription, Windows 10 1607 and later, ignored on the older ones).
+	\param[in] name The name of the thread.
+	*/
+	virtual void SetName(const char *name) override;
+
+private:
+	/*!
+	Fills the processors the thread may run on.
+	\param[out] affinity The processors of one group.
+	\return TRUE if the thread is limited, FALSE if it may run anywhere.
+	*/
+	bool GetProcessors(GROUP_AFFINITY *affinity);
+
+	/*!
+	Applies the affinity to the created thread.
+	*/
+	void ApplyAffinity();
+
+	/*!
+	Applies the name to the created thread.
+	*/
+	void ApplyName();
+
 	HANDLE _hThread;		///< Handle of thread.
 	
 	/* Thread creation parameters */
@@ -87,7 +138,11 @@ private:
 	LPVOID _threadFuncArgs;								///< A pointer to a variable to be passed to the thread.
 	DWORD _threadFlags;									///< The flags that control the creation of the thread.
 
+	int _processor;					///< The processor the thread is pinned to
+	int _node;						///< The NUMA node of the thread
+	WCHAR _name[MAX_PATH];			///< The name of the thread
+
 	DWORD _threadSystemID;		///< Launched threadID
-	LPDWORD _exitCode;			///< Recive the thread termination status
+	DWORD _exitCode;			///< Recive the thread termination status
 
 };
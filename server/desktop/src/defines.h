@@ -4,14 +4,62 @@ typedef unsigned char byte;
 //typedef unsigned long long size_lt;
 typedef size_t size_lt;
 
+/// The read-only view of the contiguous bytes (ex. the mapped file)
+typedef struct
+{
+	const byte *data;	///< The first byte
+	size_lt size;		///< The number of the bytes
+} ByteSpan;
+
+/// The read-only view of the characters (not null-terminated)
+typedef struct
+{
+	const char *data;	///< The first character
+	size_lt size;		///< The number of the characters
+} StringView;
+
 #define MAX_INT 2147483646
 #define MIN_BUFFER_SIZE 128
 #define FILE_BUFFER_SIZE 1024
+#define FILE_BUFFER_MAX_SIZE (1024 * 1024)
+#define FILE_SEQUENTIAL_THRESHOLD 2
+#define FILE_TEMP_SUFFIX ".msiybtemp"
+#define LINEREADER_BUFFER_SIZE (64 * 1024)
+#define DIR_BUFFER_SIZE (32 * 1024)
+#define DIRINDEX_FILE_NAME ".msiybindex"
+#define DIRINDEX_JOURNAL_NAME ".msiybjournal"
 #define MIN_STRING_SIZE 128
 #define MIN_STRING_ARRAY_SIZE 2
 #define INFINITE            0xFFFFFFFF
+#define SERVER_PORT 2345
+#define SERVER_LISTEN_BACKLOG 1024
+#define SERVER_STORAGE_DIR "storage/"
+#define SERVER_COMMAND_PUT "PUT "
+#define SERVER_REPLY_OK "OK"
+#define STREAM_CHUNK_SIZE (64 * 1024)
+#define STREAM_BUFFER_SIZE (256 * 1024)
+#define SERVER_CHUNKSTORE_DIR "chunkstore/"
+#define SERVER_COMMAND_CHUNKPUT "CPUT "
+#define SERVER_COMMAND_CHUNKGET "CGET "
+#define SERVER_COMMAND_CHUNK "CHUNK "
+#define CHUNK_MIN_SIZE (16 * 1024)
+#define CHUNK_AVG_SIZE (64 * 1024)
+#define CHUNK_MAX_SIZE (256 * 1024)
+#define SERVER_COMMAND_DELTAPUT "DPUT "
+#define DELTA_BLOCK_MIN_SIZE (2 * 1024)
+#define DELTA_BLOCK_MAX_SIZE (64 * 1024)
+#define DELTA_LITERAL_MAX_SIZE (64 * 1024)
+#define DELTA_FRAME_SIZE (256 * 1024)
+#define DELTA_TEMP_SUFFIX ".msiybdelta"
 
 #ifdef _WIN32
 #define _CRT_SECURE_NO_WARNINGS
 #define PATH_MAX _MAX_PATH
+typedef void* t_filehandle;
+#define PATH_SEPARATOR '\\'
+#elif __unix__
+#include <limits.h>
+#define MAX_PATH PATH_MAX
+typedef int t_filehandle;
+#define PATH_SEPARATOR '/'
 #endif
@@ -17,17 +17,17 @@ int main()
 		{
 #ifdef CLIENT
 			setlocale(LC_CTYPE, ".1251");
-			byte *arr = new byte[6000000];
 			char tmp[] = "hello";
 			Socket *server = new Socket(2345, "127.0.0.1");
 			server->Connect();
 			server->Send(tmp, sizeof(tmp));
 
-			size_lt cl = server->RecvAll((char*)arr);
-			File::WriteAllBytes("D:\\3.jpg", arr, cl);
+			File file("D:\\3.jpg");
+			file.Open(FileOpenMode::WRITENEWFILE);
+			size_lt cl = server->RecvStream(file);
 #elif SERVER
-			byte* arr;
-			size_lt s = File::ReadAllBytes("D:\\1.jpg", &arr);
+			File file("D:\\1.jpg");
+			file.Open(FileOpenMode::READONLY);
 			Socket *server = new Socket(2345, "127.0.0.1");
 			char tmp[200];
 			server->Bind();
@@ -35,7 +35,11 @@ int main()
 			Socket *client = (Socket*)server->AcceptSocket();
 			client->Recv(tmp, 200);
 			if (!strcmp(tmp, "hello"))
-				size_lt cl = client->SendAll((char*)arr, s);
+				size_lt cl = client->SendStream(file);
+#elif BENCHMARK
+			RunFileBenchmark("benchmark.tmp");
+			RunLockBenchmark();
+			RunAcceptBenchmark();
 #else
 			serverInstance->Start();
 #endif
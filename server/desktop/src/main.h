@@ -6,3 +6,8 @@
 #include "common\file.h"
 #include "tools\exception.h"
 #include "server.h"
+#ifdef BENCHMARK
+#include "benchmarks\filebenchmark.h"
+#include "benchmarks\lockbenchmark.h"
+#include "benchmarks\acceptbenchmark.h"
+#endif
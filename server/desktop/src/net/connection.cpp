@@ -0,0 +1,294 @@
+#include "connection.h"
+
+Connection::Connection(Socket *socket, IEventLoop &loop, IConnectionHandler &handler, MSIYBCore::Arena *arena)
+	: _socket(socket), _loop(loop), _handler(handler), _state(CONNECTIONREADING)
+{
+	_waiting = false;
+	_streamFile = NULL;
+	_streamHasher = NULL;
+	_stream = NULL;
+	_arena = arena;
+	if (_arena)
+	{
+		// The socket stays, everything after it belongs to the requests
+		_requestMark = _arena->Mark();
+	}
+	_socket->SetNonBlocking(true);
+	_loop.Add(_socket, this, EVENTREAD | EVENTWRITE);
+}
+
+Connection::~Connection()
+{
+	if (_state != CONNECTIONCLOSED)
+	{
+		Close();
+	}
+	delete _stream;
+	delete _streamFile;
+	delete _streamHasher;
+	if (_arena)
+	{
+		// The socket and the files of the unsent reply are destroyed with the arena
+		delete _arena;
+	}
+	else
+	{
+		delete _socket;
+	}
+}
+
+void Connection::HandleEvents(int events)
+{
+	if (events & EVENTERROR)
+	{
+		Close();
+	}
+	// Edge-triggered: whatever the event is, work until the socket would block
+	Run();
+}
+
+void Connection::OnFileComplete(AsyncFileRequest *request)
+{
+	try
+	{
+		_stream->OnWritten(request);
+	}
+	catch (FileException &)
+	{
+		Close();
+	}
+	// The socket data left while the queued bytes were at the limit won't be reported again
+	Run();
+}
+
+void Connection::Run()
+{
+	try
+	{
+		Process();
+	}
+	catch (SocketException &)
+	{
+		Close();
+	}
+	catch (FileException &)
+	{
+		// The stream can't be written, the peer can't be told in the middle of it
+		Close();
+	}
+
+	if (_state == CONNECTIONCLOSED && !(_stream && _stream->IsWriting()))
+	{
+		delete this;
+	}
+}
+
+void Connection::Send(char *buf, int size)
+{
+	if (_state == CONNECTIONCLOSED)
+	{
+		return;
+	}
+	_writer.Queue(buf, size);
+	_state = CONNECTIONWRITING;
+}
+
+void Connection::SendFile(File *file, size_lt offset, size_lt length, bool owned)
+{
+	if (_state == CONNECTIONCLOSED)
+	{
+		if (owned)
+		{
+			delete file;
+		}
+		return;
+	}
+	_writer.QueueFile(file, offset, length, owned);
+	_state = CONNECTIONWRITING;
+}
+
+void Connection::ReceiveStream(File *file, IAsyncFile *disk, Hasher *hasher)
+{
+	if (_state == CONNECTIONCLOSED || _stream)
+	{
+		delete file;
+		delete hasher;
+		return;
+	}
+	_streamFile = file;
+	_streamHasher = hasher;
+	_stream = new StreamReader(file, disk, this);
+	_stream->SetHasher(hasher);
+	if (_state == CONNECTIONREADING)
+	{
+		_state = CONNECTIONSTREAMING;
+	}
+}
+
+void Connection::Wait()
+{
+	if (_state == CONNECTIONCLOSED)
+	{
+		return;
+	}
+	_waiting = true;
+	if (_state == CONNECTIONREADING)
+	{
+		_state = CONNECTIONWAITING;
+	}
+}
+
+void Connection::Resume()
+{
+	_waiting = false;
+	if (_state == CONNECTIONWAITING)
+	{
+		_state = GetIdleState();
+		if (_state == CONNECTIONREADING)
+		{
+			EndRequest();
+		}
+	}
+	// The data which came while waiting won't be reported again
+	Run();
+}
+
+void Connection::Close()
+{
+	if (_state == CONNECTIONCLOSED)
+	{
+		return;
+	}
+	_state = CONNECTIONCLOSED;
+	_loop.Remove(_socket);
+	_socket->Close();
+	_handler.OnClose(*this);
+}
+
+ConnectionState Connection::GetState()
+{
+	return _state;
+}
+
+Socket* Connection::GetSocket()
+{
+	return _socket;
+}
+
+MSIYBCore::Arena* Connection::GetArena()
+{
+	return _arena;
+}
+
+MSIYBCore::BufferSlice Connection::GetMessageSlice()
+{
+	return _reader.GetSlice();
+}
+
+void Connection::Process()
+{
+	bool progress = true;
+	while (progress)
+	{
+		switch (_state)
+		{
+		case CONNECTIONREADING:
+			progress = OnReadable();
+			break;
+		case CONNECTIONWRITING:
+			progress = OnWritable();
+			break;
+		case CONNECTIONSTREAMING:
+			progress = OnStreamable();
+			break;
+		default:
+			progress = false;
+			break;
+		}
+	}
+}
+
+bool Connection::OnReadable()
+{
+	while (_state == CONNECTIONREADING)
+	{
+		FrameState frameState = _reader.Read(_socket);
+		if (frameState == FRAMENEEDMORE)
+		{
+			return false;
+		}
+		if (frameState == FRAMECLOSED)
+		{
+			Close();
+			return false;
+		}
+		_handler.OnMessage(*this, _reader.GetFrame(), (int)_reader.GetFrameSize());
+		_reader.Reset();
+		if (_state == CONNECTIONREADING)
+		{
+			// Nothing to reply (ex. the data of the upload session)
+			EndRequest();
+		}
+	}
+	return _state != CONNECTIONREADING && _state != CONNECTIONCLOSED;
+}
+
+bool Connection::OnWritable()
+{
+	if (_writer.Write(_socket) == FRAMENEEDMORE)
+	{
+		return false;
+	}
+	_state = GetIdleState();
+	if (_state == CONNECTIONREADING)
+	{
+		EndRequest();
+	}
+	return true;
+}
+
+bool Connection::OnStreamable()
+{
+	FrameState streamState = _stream->Read(_socket);
+	if (streamState == FRAMENEEDMORE)
+	{
+		return false;
+	}
+	if (streamState == FRAMECLOSED || _stream->GetLeftover() > 0)
+	{
+		Close();
+		return false;
+	}
+
+	File *file = _streamFile;
+	Hasher *hasher = _streamHasher;
+	size_lt size = _stream->GetReceived();
+	delete _stream;
+	_stream = NULL;
+	_streamFile = NULL;
+	_streamHasher = NULL;
+	_state = GetIdleState();
+	_handler.OnStream(*this, file, size, hasher);
+	if (_state == CONNECTIONREADING)
+	{
+		EndRequest();
+	}
+	return _state != CONNECTIONCLOSED;
+}
+
+void Connection::EndRequest()
+{
+	if (_arena)
+	{
+		_arena->Rewind(_requestMark);
+	}
+}
+
+ConnectionState Connection::GetIdleState()
+{
+	if (_stream)
+	{
+		return CONNECTIONSTREAMING;
+	}
+	return _waiting ? CONNECTIONWAITING : CONNECTIONREADING;
+}
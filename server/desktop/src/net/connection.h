@@ -0,0 +1,211 @@
+#pragma once
+#include "socket.h"
+#include "eventloop.h"
+#include "framecodec.h"
+#include "streamreader.h"
+
+/// The state of the connection state machine
+typedef enum ConnectionState_
+{
+	CONNECTIONREADING,	///< Waits for the request data
+	CONNECTIONWRITING,	///< Sends the queued reply, reading is suspended
+	CONNECTIONSTREAMING,	///< Receives the chunked stream into the file
+	CONNECTIONWAITING,	///< The handler waits for its disk job (see Wait), reading is suspended
+	CONNECTIONCLOSED	///< Removed from the loop, will be deleted
+} ConnectionState;
+
+class Connection;
+
+/*!
+\class IConnectionHandler connection.h "server\desktop\src\net\connection.h"
+\brief  The receiver of the connection data.
+*/
+class IConnectionHandler
+{
+public:
+	virtual ~IConnectionHandler() {}
+
+	/*!
+	Handles the frame received by the connection. Called on the loop thread.
+	\param[in] connection The connection which received the frame.
+	\param[in] data The frame payload. Valid only during the call, Connection::GetMessageSlice keeps it longer.
+	\param[in] size The size of the payload.
+	*/
+	virtual void OnMessage(Connection &connection, char *data, int size) = 0;
+
+	/*!
+	Handles the end of the stream started by ReceiveStream. Called on the loop thread.
+	\param[in] connection The connection which received the stream.
+	\param[in] file The file the stream was written to. The handler takes the ownership.
+	\param[in] size The number of the received bytes.
+	\param[in] hasher The hash of the received bytes given to ReceiveStream or NULL. The handler takes the ownership.
+	*/
+	virtual void OnStream(Connection &connection, File *file, size_lt size, Hasher *hasher) = 0;
+
+	/*!
+	Called once when the connection is closed, right before it is deleted.
+	\param[in] connection The closed connection.
+	*/
+	virtual void OnClose(Connection &connection) = 0;
+};
+
+/*!
+\class Connection connection.h "server\desktop\src\net\connection.h"
+\brief  The per-connection state machine driven by the event loop.
+Owns the accepted socket and deletes itself after it is closed
+(and after its asynchronous file write is completed).
+*/
+class Connection : public IEventHandler, public IAsyncFileHandler
+{
+public:
+	/*!
+	Switches the socket into the non-blocking mode and registers it in the loop.
+	\param[in] socket The accepted socket. Connection takes the ownership.
+	\param[in] loop The loop to be registered in.
+	\param[in] handler The receiver of the data.
+	\param[in] arena The arena the socket was accepted into or NULL. Connection takes the ownership,
+	the memory taken from it while a request is handled is released when the reply is sent.
+	*/
+	Connection(Socket *socket, IEventLoop &loop, IConnectionHandler &handler, MSIYBCore::Arena *arena = NULL);
+
+	/*!
+	Closes the connection if it is still open and deletes the socket (with the arena if there is one).
+	*/
+	~Connection();
+
+	/*!
+	Reads or writes the socket until it would block.
+	Deletes the connection if it was closed.
+	\param[in] events The combination of EventType flags.
+	*/
+	void HandleEvents(int events) override;
+
+	/*!
+	Passes the completed write to the stream and goes on receiving it.
+	Deletes the connection if it was closed.
+	\param[in] request The completed request.
+	*/
+	void OnFileComplete(AsyncFileRequest *request) override;
+
+	/*!
+	Queues the frame to be sent. Reading is suspended until the queue is sent.
+	Must be called from the loop thread (normally inside OnMessage).
+	\param[in] buf The payload to be sent.
+	\param[in] size The size of the payload.
+	*/
+	void Send(char *buf, int size);
+
+	/*!
+	Queues the frame with the region of the file as the payload. The data is not copied.
+	Must be called from the loop thread (normally inside OnMessage).
+	\param[in] file The opened file.
+	\param[in] offset The offset of the region in the file.
+	\param[in] length The length of the region.
+	\param[in] owned TRUE if the connection takes the ownership, FALSE if the file is in the arena of the connection.
+	*/
+	void SendFile(File *file, size_lt offset, size_lt length, bool owned = true);
+
+	/*!
+	Receives the next data of the connection as the chunked stream into the file.
+	The stream is received after the queued reply is sent, then OnStream is called.
+	Must be called from the loop thread (normally inside OnMessage).
+	\param[in] file The file opened to write. The connection owns it until OnStream is called.
+	\param[in] disk The asynchronous engine to write the file with, NULL to write synchronously.
+	\param[in] hasher The hash to be updated with the received bytes or NULL. The connection owns it until OnStream is called.
+	*/
+	void ReceiveStream(File *file, IAsyncFile *disk = NULL, Hasher *hasher = NULL);
+
+	/*!
+	Suspends reading until Resume is called: the handler finishes the request on the disk threads.
+	The queued reply is still sent. Must be called from the loop thread (normally inside OnMessage).
+	If the connection is closed meanwhile, it is deleted as usual, the handler learns it from OnClose.
+	*/
+	void Wait();
+
+	/*!
+	Goes on reading after Wait. The reply (if any) is queued before the call.
+	Must be called from the loop thread. May delete the connection if it was closed.
+	*/
+	void Resume();
+
+	/*!
+	Removes the connection from the loop and closes the socket.
+	*/
+	void Close();
+
+	/*!
+	\return The current state of the connection.
+	*/
+	ConnectionState GetState();
+
+	/*!
+	\return The socket of the connection.
+	*/
+	Socket* GetSocket();
+
+	/*!
+	\return The arena of the current request or NULL if the connection has no arena.
+	The memory taken from it is valid until the reply is sent.
+	*/
+	MSIYBCore::Arena* GetArena();
+
+	/*!
+	\return The frame being handled by OnMessage as the slice of the pooled buffer.
+	The slice may be kept after the call instead of copying the data. Empty for the frames bigger than the buffer.
+	*/
+	MSIYBCore::BufferSlice GetMessageSlice();
+
+private:
+	/*!
+	Drives the state machine until the socket would block or the connection is closed.
+	*/
+	void Process();
+
+	/*!
+	Drives the state machine and closes the connection on the socket or file errors.
+	Deletes the connection if it was closed and nothing is in flight.
+	*/
+	void Run();
+
+	/*!
+	Reads the socket and passes the complete frames to the handler.
+	\return TRUE if the state was changed to CONNECTIONWRITING or CONNECTIONSTREAMING, FALSE if the socket would block or was closed.
+	*/
+	bool OnReadable();
+
+	/*!
+	Sends the queued frames.
+	\return TRUE if the queue was sent and the state was changed to CONNECTIONREADING or CONNECTIONSTREAMING, FALSE if the socket would block.
+	*/
+	bool OnWritable();
+
+	/*!
+	Receives the stream into the file and passes the file to the handler at its end.
+	\return TRUE if the stream was received, FALSE if the socket would block or was closed.
+	*/
+	bool OnStreamable();
+
+	/*!
+	Releases the memory taken from the arena while the request was handled.
+	*/
+	void EndRequest();
+
+	/*!
+	\return The state after the reply is sent or the stream is received:
+	CONNECTIONSTREAMING, CONNECTIONWAITING or CONNECTIONREADING.
+	*/
+	ConnectionState GetIdleState();
+
+	Socket *_socket;						///< The accepted socket
+	IEventLoop &_loop;						///< The loop the connection is registered in
+	IConnectionHandler &_handler;			///< The receiver of the data
+	ConnectionState _state;					///< The current state
+	bool _waiting;							///< TRUE from Wait until Resume
+	FrameReader _reader;					///< The partially received frame
+	FrameWriter _writer;					///< The queued frames to be sent
+	File *_streamFile;						///< The file of the received stream
+	Hasher *_streamHasher;					///< The hash of the received stream
+	StreamReader *_stream;					///< The received stream, NULL if there is no stream
+	MSIYBCore::Arena *_arena;				///< The memory of the connection, NULL for the heap
+	MSIYBCore::ArenaMark _requestMark;		///< The state of the arena before the request
+};
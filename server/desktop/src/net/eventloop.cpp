@@ -0,0 +1,56 @@
+#include "eventloop.h"
+
+EventLoop::EventLoop()
+{
+#ifdef __linux__
+	loop = new OSEventLoop();
+#else
+	loop = NULL;
+	ThrowSocketException("The event loop is implemented for Linux only (epoll)");
+#endif
+}
+
+EventLoop::~EventLoop()
+{
+	delete loop;
+}
+
+void EventLoop::Add(ISocket *socket, IEventHandler *handler, int events)
+{
+	loop->Add(socket, handler, events);
+}
+
+void EventLoop::Modify(ISocket *socket, IEventHandler *handler, int events)
+{
+	loop->Modify(socket, handler, events);
+}
+
+void EventLoop::Remove(ISocket *socket)
+{
+	loop->Remove(socket);
+}
+
+void EventLoop::AddDescriptor(t_descriptor descriptor, IEventHandler *handler, int events)
+{
+	loop->AddDescriptor(descriptor, handler, events);
+}
+
+void EventLoop::RemoveDescriptor(t_descriptor descriptor)
+{
+	loop->RemoveDescriptor(descriptor);
+}
+
+int EventLoop::Poll(unsigned long timeout)
+{
+	return loop->Poll(timeout);
+}
+
+void EventLoop::Run()
+{
+	loop->Run();
+}
+
+void EventLoop::Stop()
+{
+	loop->Stop();
+}
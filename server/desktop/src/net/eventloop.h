@@ -0,0 +1,28 @@
+#pragma once
+#include "../cross/ieventloop.h"
+#ifdef __linux__
+#include "../cross/unix/unixeventloop.h"
+typedef UnixEventLoop OSEventLoop;
+#endif
+
+/*!
+\class EventLoop eventloop.h "server\desktop\src\net\eventloop.h"
+\brief  The event loop (reactor) of the server.
+The factory for the OS event loop. The reactor is the edge-triggered epoll, so the server runs on Linux only:
+on the other systems the constructor throws SocketException.
+*/
+class EventLoop : public IEventLoop
+{
+	IEventLoop *loop;
+public:
+	EventLoop();
+	~EventLoop();
+	void Add(ISocket *socket, IEventHandler *handler, int events);
+	void Modify(ISocket *socket, IEventHandler *handler, int events);
+	void Remove(ISocket *socket);
+	void AddDescriptor(t_descriptor descriptor, IEventHandler *handler, int events);
+	void RemoveDescriptor(t_descriptor descriptor);
+	int Poll(unsigned long timeout = INFINITE);
+	void Run();
+	void Stop();
+};
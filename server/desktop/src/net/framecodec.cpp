@@ -0,0 +1,325 @@
+#include "framecodec.h"
+
+FrameReader::FrameReader(size_lt maxFrameSize)
+{
+	_maxFrameSize = maxFrameSize;
+	_buffer = NULL;
+	Reset();
+}
+
+FrameReader::~FrameReader()
+{
+	if (_buffer)
+	{
+		_buffer->Release();
+	}
+}
+
+FrameState FrameReader::Read(ISocket *socket)
+{
+	while (_headerReceived < FRAME_HEADER_SIZE)
+	{
+		int recieved = socket->Recv(_header + _headerReceived, (int)(FRAME_HEADER_SIZE - _headerReceived));
+		if (recieved == SOCKET_WOULDBLOCK)
+		{
+			return FRAMENEEDMORE;
+		}
+		if (recieved == 0)
+		{
+			return FRAMECLOSED;
+		}
+		_headerReceived += recieved;
+		if (_headerReceived == FRAME_HEADER_SIZE)
+		{
+			OnHeader();
+		}
+	}
+
+	while (_received < _length)
+	{
+		size_lt left = _length - _received;
+		int recieved = socket->Recv(GetTarget() + _received, left > MAX_INT ? MAX_INT : (int)left);
+		if (recieved == SOCKET_WOULDBLOCK)
+		{
+			return FRAMENEEDMORE;
+		}
+		if (recieved == 0)
+		{
+			return FRAMECLOSED;
+		}
+		if (_buffer)
+		{
+			_buffer->Commit(recieved);
+		}
+		_received += recieved;
+	}
+	return FRAMECOMPLETE;
+}
+
+FrameState FrameReader::Feed(const char *data, size_lt size, size_lt *consumed)
+{
+	size_lt pos = 0;
+	if (_headerReceived < FRAME_HEADER_SIZE)
+	{
+		size_lt part = FRAME_HEADER_SIZE - _headerReceived;
+		if (part > size)
+		{
+			part = size;
+		}
+		memcpy(_header + _headerReceived, data, part);
+		_headerReceived += part;
+		pos += part;
+		if (_headerReceived < FRAME_HEADER_SIZE)
+		{
+			*consumed = pos;
+			return FRAMENEEDMORE;
+		}
+		OnHeader();
+	}
+
+	size_lt part = _length - _received;
+	if (part > size - pos)
+	{
+		part = size - pos;
+	}
+	if (part > 0)
+	{
+		memcpy(GetTarget() + _received, data + pos, part);
+		if (_buffer)
+		{
+			_buffer->Commit(part);
+		}
+		_received += part;
+	}
+	pos += part;
+
+	*consumed = pos;
+	return _received == _length ? FRAMECOMPLETE : FRAMENEEDMORE;
+}
+
+char* FrameReader::GetFrame()
+{
+	if (_buffer)
+	{
+		return (char*)_buffer->GetData();
+	}
+	return _frame.empty() ? NULL : &_frame[0];
+}
+
+size_lt FrameReader::GetFrameSize()
+{
+	return _length;
+}
+
+MSIYBCore::BufferSlice FrameReader::GetSlice()
+{
+	if (!_buffer || _length == 0)
+	{
+		return MSIYBCore::BufferSlice();
+	}
+	return MSIYBCore::BufferSlice(_buffer, 0, _length);
+}
+
+void FrameReader::Reset()
+{
+	// Don't let one big frame pin its buffer for the whole life of an idle connection
+	if (_frame.size() > FRAME_KEEP_SIZE)
+	{
+		std::vector<char>().swap(_frame);
+	}
+	if (_buffer)
+	{
+		// The idle connection holds no buffer, the slices keep theirs
+		_buffer->Release();
+		_buffer = NULL;
+	}
+	_headerReceived = 0;
+	_length = 0;
+	_received = 0;
+}
+
+void FrameReader::OnHeader()
+{
+	long length = 0;
+	memcpy(&length, _header, FRAME_HEADER_SIZE);
+	if (length < 0 || (size_lt)length > _maxFrameSize)
+	{
+		ThrowSocketExceptionWithCode("Frame length is out of range:", length);
+	}
+	_length = (size_lt)length;
+	_received = 0;
+	if (_length == 0)
+	{
+		return;
+	}
+	if (_length <= MSIYBCore::Buffer::GetCapacity())
+	{
+		_buffer = MSIYBCore::Buffer::Create();
+	}
+	else if (_frame.size() < _length)
+	{
+		_frame.resize(_length);
+	}
+}
+
+char* FrameReader::GetTarget()
+{
+	return _buffer ? (char*)_buffer->GetData() : &_frame[0];
+}
+
+FrameWriter::FrameWriter()
+{
+
+}
+
+FrameWriter::~FrameWriter()
+{
+	for (size_t i = 0; i < _output.size(); i++)
+	{
+		if (_output[i].owned)
+		{
+			delete _output[i].file;
+		}
+	}
+}
+
+OutputChunk& FrameWriter::NewChunk(size_lt length)
+{
+	long frameLength = (long)length;
+	OutputChunk chunk;
+	memcpy(chunk.header, &frameLength, FRAME_HEADER_SIZE);
+	chunk.file = NULL;
+	chunk.owned = false;
+	chunk.handle = 0;
+	chunk.offset = 0;
+	chunk.length = 0;
+	chunk.sent = 0;
+	_output.push_back(std::move(chunk));
+	return _output.back();
+}
+
+void FrameWriter::Queue(const char *buf, size_lt size)
+{
+	OutputChunk &chunk = NewChunk(size);
+	chunk.data.assign(buf, buf + size);
+}
+
+void FrameWriter::QueueFile(File *file, size_lt offset, size_lt length, bool owned)
+{
+	OutputChunk &chunk = NewChunk(length);
+	chunk.file = file;
+	chunk.owned = owned;
+	chunk.handle = file->GetHandle();
+	chunk.offset = offset;
+	chunk.length = length;
+}
+
+FrameState FrameWriter::Write(ISocket *socket)
+{
+	while (!_output.empty())
+	{
+		OutputChunk &chunk = _output.front();
+		if (!chunk.file || chunk.sent < FRAME_HEADER_SIZE)
+		{
+			if (!SendBuffers(socket))
+			{
+				return FRAMENEEDMORE;
+			}
+			continue;
+		}
+
+		if (!SendRegion(socket, chunk))
+		{
+			return FRAMENEEDMORE;
+		}
+		if (chunk.owned)
+		{
+			delete chunk.file;
+		}
+		_output.pop_front();
+	}
+	return FRAMECOMPLETE;
+}
+
+bool FrameWriter::SendBuffers(ISocket *socket)
+{
+	IOBuffer buffers[IOBUFFER_MAX_COUNT];
+	size_lt count = 0;
+	size_lt total = 0;
+	for (size_t i = 0; i < _output.size() && count + 2 <= IOBUFFER_MAX_COUNT && total < MAX_INT; i++)
+	{
+		OutputChunk &chunk = _output[i];
+		size_lt sent = chunk.sent;
+		if (sent < FRAME_HEADER_SIZE)
+		{
+			buffers[count].data = (byte*)chunk.header + sent;
+			buffers[count].size = FRAME_HEADER_SIZE - sent;
+			total += buffers[count].size;
+			count++;
+			sent = FRAME_HEADER_SIZE;
+		}
+		if (chunk.file)
+		{
+			// The region goes by sendfile after its header
+			break;
+		}
+		size_lt payloadSent = sent - FRAME_HEADER_SIZE;
+		if (payloadSent < chunk.data.size())
+		{
+			// The result of the call is an int
+			size_lt left = chunk.data.size() - payloadSent;
+			buffers[count].data = (byte*)&chunk.data[payloadSent];
+			buffers[count].size = left > MAX_INT - total ? MAX_INT - total : left;
+			total += buffers[count].size;
+			count++;
+		}
+	}
+
+	int sended = socket->SendV(buffers, count);
+	if (sended == SOCKET_WOULDBLOCK)
+	{
+		return false;
+	}
+
+	// The sent bytes are spread over the frames, the memory frames sent whole leave the queue
+	size_lt done = (size_lt)sended;
+	while (!_output.empty())
+	{
+		OutputChunk &chunk = _output.front();
+		size_lt size = chunk.file ? FRAME_HEADER_SIZE : FRAME_HEADER_SIZE + chunk.data.size();
+		size_lt taken = done < size - chunk.sent ? done : size - chunk.sent;
+		chunk.sent += taken;
+		done -= taken;
+		if (chunk.file || chunk.sent < size)
+		{
+			break;
+		}
+		_output.pop_front();
+	}
+	return true;
+}
+
+bool FrameWriter::SendRegion(ISocket *socket, OutputChunk &chunk)
+{
+	size_lt end = FRAME_HEADER_SIZE + chunk.length;
+	while (chunk.sent < end)
+	{
+		size_lt left = end - chunk.sent;
+		int sended = socket->SendFilePart(chunk.handle, chunk.offset + chunk.sent - FRAME_HEADER_SIZE, left > MAX_INT ? MAX_INT : (int)left);
+		if (sended == SOCKET_WOULDBLOCK)
+		{
+			return false;
+		}
+		if (sended == 0)
+		{
+			ThrowSocketException("File is shorter than the queued frame");
+		}
+		chunk.sent += sended;
+	}
+	return true;
+}
+
+bool FrameWriter::Empty()
+{
+	return _output.empty();
+}
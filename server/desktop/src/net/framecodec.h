@@ -0,0 +1,182 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include "socket.h"
+
+#define FRAME_HEADER_SIZE SIZE_FIRST_MESSAGE
+#define FRAME_MAX_SIZE (64 * 1024 * 1024)
+#define FRAME_KEEP_SIZE (64 * 1024)
+
+/// The result of feeding data to the frame codec
+typedef enum FrameState_
+{
+	FRAMENEEDMORE,		///< The frame is not complete yet, wait for the next readiness event
+	FRAMECOMPLETE,		///< The frame is complete (received or sent)
+	FRAMECLOSED			///< The peer closed the connection
+} FrameState;
+
+/*!
+\class FrameReader framecodec.h "server\desktop\src\net\framecodec.h"
+\brief  Resumable reader of the length-prefixed frames (the RecvAll format).
+Keeps the partially received header and payload between the readiness events,
+so a slow peer never blocks the thread. The frames which fit into the pooled buffer
+are received into it and can be kept as the slice after the reader moves on.
+*/
+class FrameReader
+{
+public:
+	/*!
+	\param[in] maxFrameSize The biggest frame to be accepted. Bigger length prefixes are treated as a protocol error.
+	*/
+	FrameReader(size_lt maxFrameSize = FRAME_MAX_SIZE);
+
+	/*!
+	Releases the buffer.
+	*/
+	~FrameReader();
+
+	/*!
+	Reads the non-blocking socket until the frame is complete or the socket would block.
+	Reads exactly the frame bytes, so the next frame stays in the socket.
+	\param[in] socket The non-blocking socket.
+	\return The state of the frame.
+	*/
+	FrameState Read(ISocket *socket);
+
+	/*!
+	Feeds the already received data to the reader. Stops at the frame end.
+	\param[in] data The received data.
+	\param[in] size The size of the data.
+	\param[out] consumed The number of bytes used (the rest belongs to the next frame).
+	\return The state of the frame.
+	*/
+	FrameState Feed(const char *data, size_lt size, size_lt *consumed);
+
+	/*!
+	\return The payload of the complete frame. Valid until Reset is called.
+	*/
+	char* GetFrame();
+
+	/*!
+	\return The size of the complete frame payload.
+	*/
+	size_lt GetFrameSize();
+
+	/*!
+	\return The complete frame payload sharing the pooled buffer, it stays valid after Reset.
+	Empty if the frame is bigger than the buffer.
+	*/
+	MSIYBCore::BufferSlice GetSlice();
+
+	/*!
+	Prepares the reader for the next frame. The pooled buffer returns to the pool,
+	the memory of the big frames is kept unless it is too big.
+	*/
+	void Reset();
+
+private:
+	/*!
+	Validates the received header and prepares the payload buffer.
+	*/
+	void OnHeader();
+
+	/*!
+	\return The memory of the payload.
+	*/
+	char* GetTarget();
+
+	size_lt _maxFrameSize;					///< The biggest acceptable payload
+	char _header[FRAME_HEADER_SIZE];		///< The length prefix
+	size_lt _headerReceived;				///< The number of the received header bytes
+	size_lt _length;						///< The payload size, valid after the header is received
+	size_lt _received;						///< The number of the received payload bytes
+	MSIYBCore::Buffer *_buffer;				///< The payload which fits into the pooled buffer, NULL otherwise
+	std::vector<char> _frame;				///< The bigger payload
+};
+
+/// The queued frame: the length prefix and the payload, a memory block or a region of a file
+typedef struct
+{
+	char header[FRAME_HEADER_SIZE];	///< The length prefix, sent as a buffer of its own
+	std::vector<char> data;		///< The payload (if file is NULL)
+	File *file;					///< The file to be sent without copying
+	bool owned;					///< TRUE if the writer deletes the file after it is sent
+	t_filehandle handle;		///< The OS handle of the file
+	size_lt offset;				///< The offset of the region in the file
+	size_lt length;				///< The length of the region in the file
+	size_lt sent;				///< The number of the bytes of the frame (the header included) already sent
+} OutputChunk;
+
+/*!
+\class FrameWriter framecodec.h "server\desktop\src\net\framecodec.h"
+\brief  Resumable writer of the length-prefixed frames (the SendAll format).
+The headers and the payloads are not joined: the queued frames go out as the list of the buffers
+in one gathering call (sendmsg / WSASend), the regions of the files by sendfile / TransmitFile.
+*/
+class FrameWriter
+{
+public:
+	FrameWriter();
+
+	/*!
+	Deletes the owned files which were not sent.
+	*/
+	~FrameWriter();
+
+	/*!
+	Queues a frame: the length prefix and the payload.
+	The payload is kept in the queue as it is, the caller's memory may be reused after the call.
+	\param[in] buf The payload.
+	\param[in] size The size of the payload.
+	*/
+	void Queue(const char *buf, size_lt size);
+
+	/*!
+	Queues a frame with the region of the file as the payload.
+	The payload goes from the file to the socket in the kernel (sendfile / TransmitFile).
+	\param[in] file The opened file.
+	\param[in] offset The offset of the region in the file.
+	\param[in] length The length of the region.
+	\param[in] owned TRUE if the writer takes the ownership and deletes the file after it is sent,
+	FALSE if the file lives longer (ex. in the arena of the connection).
+	*/
+	void QueueFile(File *file, size_lt offset, size_lt length, bool owned = true);
+
+	/*!
+	Sends the queued frames until all of them are sent or the socket would block.
+	\param[in] socket The non-blocking socket.
+	\return FRAMECOMPLETE if the queue is empty, FRAMENEEDMORE otherwise.
+	*/
+	FrameState Write(ISocket *socket);
+
+	/*!
+	\return TRUE if nothing is queued.
+	*/
+	bool Empty();
+
+private:
+	/*!
+	Queues the frame with the length prefix set.
+	\param[in] length The size of the payload.
+	\return The queued frame.
+	*/
+	OutputChunk& NewChunk(size_lt length);
+
+	/*!
+	Sends the headers and the payloads of the frames at the front of the queue in one gathering call,
+	up to the header of the first file region.
+	\param[in] socket The non-blocking socket.
+	\return FALSE if the socket would block.
+	*/
+	bool SendBuffers(ISocket *socket);
+
+	/*!
+	Sends the region of the file of the frame at the front after its header.
+	\param[in] socket The non-blocking socket.
+	\param[in] chunk The frame.
+	\return FALSE if the socket would block.
+	*/
+	bool SendRegion(ISocket *socket, OutputChunk &chunk);
+
+	std::deque<OutputChunk> _output;	///< The queued frames
+};
@@ -1,35 +1,55 @@
 #include "socket.h"
+#include "streamreader.h"
+#include "framecodec.h"
+#include "../common/chunker.h"
+#include "../common/delta.h"
+#include <vector>
 
 Socket::Socket()
 {
+	arena = NULL;
 	sock = new OSSocket();
 }
 
 Socket::Socket(ISocket *socket)
 {
+	arena = NULL;
 	sock = (OSSocket*)socket;
 	//sock = new OSSocket();
 }
 
+Socket::Socket(ISocket *socket, MSIYBCore::Arena *arena)
+{
+	// The socket and its OS socket are destroyed by the arena
+	this->arena = arena;
+	sock = socket;
+}
+
 
 Socket::Socket(short port)
 {
+	arena = NULL;
 	sock = new OSSocket(port);
 }
 
 Socket::Socket(int port, char* ip)
 {
+	arena = NULL;
 	sock = new OSSocket(port, ip);
 }
 
 Socket::Socket(int port, char *ip, SocketFamily family, SocketType type, SocketProtocol)
 {
+	arena = NULL;
 
 }
 
 Socket::~Socket()
 {
-	delete sock;
+	if (!arena)
+	{
+		delete sock;
+	}
 }
 
 int Socket::RecvAll(char *buf)
@@ -37,6 +57,11 @@ int Socket::RecvAll(char *buf)
 	return sock->RecvAll(buf);
 }
 
+int Socket::SendV(IOBuffer *buffers, size_lt count)
+{
+	return sock->SendV(buffers, count);
+}
+
 int Socket::SendAll(char *buf, int size)
 {
 	int sended = sock->SendAll(buf, size);
@@ -62,7 +87,13 @@ Socket* Socket::AcceptOSSocket()
 
 Socket* Socket::AcceptSocket()
 {
-	Socket* newSocket = new Socket(Accept());
+	ISocket* accepted = Accept();
+	if (!accepted)
+	{
+		return NULL;
+	}
+
+	Socket* newSocket = new Socket(accepted);
 	if (!newSocket)
 	{
 		ThrowSocketException("Cant Allocate new socke");
@@ -71,6 +102,17 @@ Socket* Socket::AcceptSocket()
 	return newSocket;
 }
 
+Socket* Socket::AcceptSocket(MSIYBCore::Arena *arena)
+{
+	// Both wrappers are placed in the arena: no heap allocations per connection
+	ISocket* accepted = ((OSSocket*)sock)->Accept(arena);
+	if (!accepted)
+	{
+		return NULL;
+	}
+	return arena->New<Socket>(accepted, arena);
+}
+
 ISocket* Socket::Accept()
 {
 	return sock->Accept();
@@ -98,6 +140,11 @@ int Socket::Recv(char *buf, int size)
 	return sock->Recv(buf, size);
 }
 
+int Socket::RecvBuffer(MSIYBCore::Buffer *buffer)
+{
+	return sock->RecvBuffer(buffer);
+}
+
 int Socket::Send(char *buf, int size)
 {
 	return sock->Send(buf, size);
@@ -125,3 +172,210 @@ int Socket::SendTo()
 	return 0;
 }
 
+void Socket::SetNonBlocking(bool nonBlocking)
+{
+	sock->SetNonBlocking(nonBlocking);
+}
+
+t_descriptor Socket::GetDescriptor()
+{
+	return sock->GetDescriptor();
+}
+
+int Socket::SendFilePart(t_filehandle file, size_lt offset, int size)
+{
+	return sock->SendFilePart(file, offset, size);
+}
+
+size_lt Socket::SendFile(t_filehandle file, size_lt offset, size_lt length)
+{
+	return sock->SendFile(file, offset, length);
+}
+
+size_lt Socket::SendFile(File &file, size_lt offset, size_lt length)
+{
+	return sock->SendFile(file.GetHandle(), offset, length);
+}
+
+size_lt Socket::SendStream(File &file, size_lt chunkSize)
+{
+	// Every chunk goes from the file to the socket in the kernel, the terminator is an empty frame
+	t_filehandle handle = file.GetHandle();
+	size_lt length = file.FileSize();
+	size_lt offset = 0;
+	while (offset < length)
+	{
+		size_lt part = length - offset < chunkSize ? length - offset : chunkSize;
+		offset += sock->SendFile(handle, offset, part);
+	}
+	sock->SendAll(NULL, 0);
+	return offset;
+}
+
+size_lt Socket::RecvStream(File &file, Hasher *hasher)
+{
+	// The socket must be blocking, the non-blocking ones use StreamReader in the event loop
+	StreamReader reader(&file);
+	reader.SetHasher(hasher);
+	FrameState state = reader.Read(sock);
+	if (state == FRAMENEEDMORE)
+	{
+		ThrowSocketException("Can't receive the stream from the non-blocking socket!");
+	}
+	if (state == FRAMECLOSED)
+	{
+		ThrowSocketException("Connection was closed before the end of the stream!");
+	}
+	return reader.GetReceived();
+}
+
+void Socket::RecvFrame(FrameReader &reader)
+{
+	// The socket must be blocking, the reader returns the whole frame
+	reader.Reset();
+	FrameState state = reader.Read(sock);
+	if (state == FRAMENEEDMORE)
+	{
+		ThrowSocketException("Can't receive the frame from the non-blocking socket!");
+	}
+	if (state == FRAMECLOSED)
+	{
+		ThrowSocketException("Connection was closed before the end of the frame!");
+	}
+	if (reader.GetFrameSize() == 0)
+	{
+		ThrowSocketException("The request was rejected by the server!");
+	}
+}
+
+void Socket::SendCommand(const char *command, const char *argument)
+{
+	std::string request = std::string(command) + argument;
+	sock->SendAll((char*)request.c_str(), (int)request.size());
+}
+
+size_lt Socket::SendChunked(const char *name, File &file)
+{
+	// Only the chunks the server doesn't have are sent, the return is their size
+	std::vector<ChunkRef> refs;
+	std::vector<size_lt> offsets;
+	Chunker chunker(file);
+	ByteSpan chunk;
+	size_lt offset = 0;
+	while (chunker.Next(&chunk))
+	{
+		ChunkRef ref;
+		ChunkStore::MakeRef(chunk.data, chunk.size, &ref);
+		refs.push_back(ref);
+		offsets.push_back(offset);
+		offset += chunk.size;
+	}
+
+	FrameReader reader;
+	SendCommand(SERVER_COMMAND_CHUNKPUT, name);
+	RecvFrame(reader);
+	std::vector<byte> packed;
+	ChunkStore::PackRefs(refs, &packed);
+	sock->SendAll((char*)packed.data(), (int)packed.size());
+
+	RecvFrame(reader);
+	unsigned long long count = 0;
+	if (reader.GetFrameSize() < sizeof(count))
+	{
+		ThrowSocketException("Wrong list of the missing chunks!");
+	}
+	memcpy(&count, reader.GetFrame(), sizeof(count));
+	if (reader.GetFrameSize() != sizeof(count) + count * sizeof(unsigned int))
+	{
+		ThrowSocketException("Wrong list of the missing chunks!");
+	}
+	std::vector<unsigned int> missing((size_t)count);
+	memcpy(missing.data(), reader.GetFrame() + sizeof(count), missing.size() * sizeof(unsigned int));
+
+	size_lt sent = 0;
+	std::vector<byte> buffer(CHUNK_MAX_SIZE);
+	for (size_t i = 0; i < missing.size(); i++)
+	{
+		if (missing[i] >= refs.size())
+		{
+			ThrowSocketException("Wrong list of the missing chunks!");
+		}
+		size_lt size = refs[missing[i]].size;
+		file.Seek(offsets[missing[i]], SeekReference::START);
+		if (file.ReadBlock(buffer.data(), size) != size)
+		{
+			ThrowFileException("Can't read the chunk of the file!");
+		}
+		sock->SendAll((char*)buffer.data(), (int)size);
+		sent += size;
+	}
+	// SERVER_REPLY_OK after the manifest is stored
+	RecvFrame(reader);
+	return sent;
+}
+
+size_lt Socket::RecvChunked(const char *name, File &file, ChunkStore *cache)
+{
+	// The chunks found in the cache are not requested, the return is the size of the received ones
+	FrameReader reader;
+	SendCommand(SERVER_COMMAND_CHUNKGET, name);
+	RecvFrame(reader);
+	std::vector<ChunkRef> refs;
+	if (!ChunkStore::UnpackRefs((byte*)reader.GetFrame(), reader.GetFrameSize(), &refs))
+	{
+		ThrowSocketException("Wrong list of the chunks!");
+	}
+
+	size_lt received = 0;
+	std::vector<byte> buffer(CHUNK_MAX_SIZE);
+	char hex[CHUNK_HASH_SIZE * 2 + 1];
+	for (size_t i = 0; i < refs.size(); i++)
+	{
+		if (cache != NULL && cache->Has(refs[i]))
+		{
+			cache->Get(refs[i], buffer.data());
+			file.WriteBlock(buffer.data(), refs[i].size);
+			continue;
+		}
+		ChunkStore::ToHex(refs[i].hash, hex);
+		SendCommand(SERVER_COMMAND_CHUNK, hex);
+		RecvFrame(reader);
+		ChunkRef ref;
+		ChunkStore::MakeRef((byte*)reader.GetFrame(), reader.GetFrameSize(), &ref);
+		if (ref.size != refs[i].size || memcmp(ref.hash, refs[i].hash, CHUNK_HASH_SIZE))
+		{
+			ThrowSocketException("The received chunk doesn't match its hash!");
+		}
+		if (cache != NULL)
+		{
+			cache->Put((byte*)reader.GetFrame(), ref.size, &ref);
+		}
+		file.WriteBlock((byte*)reader.GetFrame(), ref.size);
+		received += ref.size;
+	}
+	file.Flush();
+	return received;
+}
+
+size_lt Socket::SendDelta(const char *name, File &file)
+{
+	// Only the data missing in the stored copy is sent, the return is its size
+	FrameReader reader;
+	SendCommand(SERVER_COMMAND_DELTAPUT, name);
+	RecvFrame(reader);
+	DeltaSignature signature;
+	if (!signature.Unpack((byte*)reader.GetFrame(), reader.GetFrameSize()))
+	{
+		ThrowSocketException("Wrong signature of the stored file!");
+	}
+
+	DeltaEncoder encoder(signature, file);
+	std::vector<byte> frame;
+	while (encoder.Next(&frame))
+	{
+		sock->SendAll((char*)frame.data(), (int)frame.size());
+	}
+	// SERVER_REPLY_OK after the stored file is replaced
+	RecvFrame(reader);
+	return encoder.GetLiteralSize();
+}
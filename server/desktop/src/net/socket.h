@@ -1,5 +1,10 @@
 #pragma once
 #include "../cross/isocket.h"
+#include "../common/file.h"
+#include "../common/chunkstore.h"
+#include "../common/arena.h"
+#include "../common/pool.h"
+#include "../common/buffer.h"
 #ifdef _WIN32
 #include "../cross/windows/winsocket.h"
 typedef WinSocket OSSocket;
@@ -8,12 +13,16 @@ typedef WinSocket OSSocket;
 typedef UnixSocket OSSocket;
 #endif
 
-class Socket : public ISocket
+class FrameReader;
+
+class Socket : public ISocket, public MSIYBCore::Pooled
 {
 	ISocket *sock;
+	MSIYBCore::Arena *arena;
 public:
 	Socket();
 	Socket(ISocket*);
+	Socket(ISocket*, MSIYBCore::Arena *arena);
 	Socket(short port);
 	Socket(int port, char* ip);
 	Socket(int port, char *ip, SocketFamily family, SocketType type, SocketProtocol);
@@ -24,16 +33,32 @@ public:
 	void Listen(int len);
 	Socket* AcceptOSSocket();
 	Socket* AcceptSocket();
+	Socket* AcceptSocket(MSIYBCore::Arena *arena);
 	ISocket* Accept();
 	void Close();
 	void Bind();
 	//int Select(); // TODO EPOLL socket
 	int Recv(char *buf, int size);
+	int RecvBuffer(MSIYBCore::Buffer *buffer);
 	int Send(char *buf, int size);
+	int SendV(IOBuffer *buffers, size_lt count);
 	void ShutDown(How shutHow);
 	void SetDirectPort(short port);
 	int RecvFrom();
 	int SendTo();
+	void SetNonBlocking(bool nonBlocking);
+	t_descriptor GetDescriptor();
+	int SendFilePart(t_filehandle file, size_lt offset, int size);
+	size_lt SendFile(t_filehandle file, size_lt offset, size_lt length);
+	size_lt SendFile(File &file, size_lt offset, size_lt length);
+	size_lt SendStream(File &file, size_lt chunkSize = STREAM_CHUNK_SIZE);
+	size_lt RecvStream(File &file, Hasher *hasher = NULL);
+	size_lt SendChunked(const char *name, File &file);
+	size_lt RecvChunked(const char *name, File &file, ChunkStore *cache = NULL);
+	size_lt SendDelta(const char *name, File &file);
+private:
+	void RecvFrame(FrameReader &reader);
+	void SendCommand(const char *command, const char *argument);
 };
 
 
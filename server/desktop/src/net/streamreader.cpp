@@ -0,0 +1,226 @@
+#include "streamreader.h"
+
+StreamReader::StreamReader(File *file, IAsyncFile *disk, IAsyncFileHandler *handler, size_lt bufferSize)
+	: _file(file), _disk(disk)
+{
+	_writing = false;
+	_fileOffset = 0;
+	memset(&_request, 0, sizeof(_request));
+	if (_disk)
+	{
+		_request.file = _file->GetHandle();
+		_request.handler = handler;
+		_fileOffset = _file->Seek(0, SeekReference::CURRENT);
+	}
+	_bufferSize = bufferSize;
+	_buffer = NULL;
+	_parsed = 0;
+	_queued = 0;
+	_headerReceived = 0;
+	_left = 0;
+	_received = 0;
+	_terminated = false;
+	_leftover = 0;
+	_completed = false;
+	_hasher = NULL;
+}
+
+StreamReader::~StreamReader()
+{
+	if (_buffer)
+	{
+		_buffer->Release();
+	}
+}
+
+FrameState StreamReader::Read(ISocket *socket)
+{
+	while (!_completed)
+	{
+		if (_terminated || _queued >= _bufferSize)
+		{
+			// Nothing to receive (or no room for it) until the queue is written
+			if (_writing)
+			{
+				return FRAMENEEDMORE;
+			}
+			Process(true);
+			continue;
+		}
+
+		size_lt free = 0;
+		if (_buffer)
+		{
+			_buffer->GetTail(&free);
+		}
+		if (free == 0)
+		{
+			if (_buffer && _buffer->IsUnique())
+			{
+				// All the slices of the buffer are written, reuse it
+				_buffer->Clear();
+			}
+			else
+			{
+				// The queued slices keep the full buffer alive
+				if (_buffer)
+				{
+					_buffer->Release();
+				}
+				_buffer = MSIYBCore::Buffer::Create();
+			}
+			_parsed = 0;
+		}
+
+		int recieved = socket->RecvBuffer(_buffer);
+		if (recieved == SOCKET_WOULDBLOCK || recieved == 0)
+		{
+			// Don't keep the data in memory while the peer is slow
+			if (Process(true) == FRAMECOMPLETE)
+			{
+				break;
+			}
+			return recieved == 0 && !_terminated ? FRAMECLOSED : FRAMENEEDMORE;
+		}
+		Process(false);
+	}
+	return FRAMECOMPLETE;
+}
+
+void StreamReader::OnWritten(AsyncFileRequest *request)
+{
+	_writing = false;
+	if (request->result <= 0)
+	{
+		ThrowFileExceptionWithCode("Can't write data into file!", (int)-request->result);
+	}
+
+	size_lt written = (size_lt)request->result;
+	_fileOffset += written;
+	_queued -= written;
+	_received += written;
+	if (written < _writingSlice.GetSize())
+	{
+		// The write was short, the rest goes first with the next one
+		_queue.insert(_queue.begin(), _writingSlice.Slice(written, _writingSlice.GetSize() - written));
+	}
+	_writingSlice.Clear();
+}
+
+bool StreamReader::IsWriting()
+{
+	return _writing;
+}
+
+size_lt StreamReader::GetReceived()
+{
+	return _received;
+}
+
+size_lt StreamReader::GetLeftover()
+{
+	return _terminated ? _leftover : 0;
+}
+
+FrameState StreamReader::Process(bool flush)
+{
+	Parse();
+	if (!_writing && !_queue.empty() && (flush || _terminated || _queued >= _bufferSize / 2))
+	{
+		WriteQueued();
+	}
+	_completed = _terminated && _queue.empty() && !_writing;
+	return _completed ? FRAMECOMPLETE : FRAMENEEDMORE;
+}
+
+void StreamReader::Parse()
+{
+	if (!_buffer)
+	{
+		return;
+	}
+
+	byte *data = _buffer->GetData();
+	size_lt size = _buffer->GetSize();
+	while (!_terminated && _parsed < size)
+	{
+		if (_headerReceived < FRAME_HEADER_SIZE)
+		{
+			// The header may be split between the buffers, copy it out
+			size_lt part = FRAME_HEADER_SIZE - _headerReceived;
+			if (part > size - _parsed)
+			{
+				part = size - _parsed;
+			}
+			memcpy(_header + _headerReceived, data + _parsed, part);
+			_headerReceived += part;
+			_parsed += part;
+			if (_headerReceived < FRAME_HEADER_SIZE)
+			{
+				break;
+			}
+
+			long length = 0;
+			memcpy(&length, _header, FRAME_HEADER_SIZE);
+			if (length < 0)
+			{
+				ThrowSocketExceptionWithCode("Chunk length is out of range:", length);
+			}
+			_left = (size_lt)length;
+			if (_left == 0)
+			{
+				_terminated = true;
+				_leftover = size - _parsed;
+			}
+			continue;
+		}
+
+		// The payload stays in the buffer, the queue references it
+		size_lt part = size - _parsed < _left ? size - _parsed : _left;
+		MSIYBCore::BufferSlice slice(_buffer, _parsed, part);
+		if (_hasher)
+		{
+			// The payload is hashed while it is still in the cache after the receive
+			_hasher->Update(slice.GetData(), part);
+		}
+		if (_queue.empty() || !_queue.back().Join(slice))
+		{
+			_queue.push_back(std::move(slice));
+		}
+		_queued += part;
+		_parsed += part;
+		_left -= part;
+		if (_left == 0)
+		{
+			_headerReceived = 0;
+		}
+	}
+}
+
+void StreamReader::WriteQueued()
+{
+	if (_disk)
+	{
+		// The slice keeps its buffer alive until the write is completed
+		_writingSlice = std::move(_queue.front());
+		_queue.erase(_queue.begin());
+		_request.operation = ASYNCFILEWRITE;
+		_request.buffer = (byte*)_writingSlice.GetData();
+		_request.size = _writingSlice.GetSize();
+		_request.offset = _fileOffset;
+		_request.result = 0;
+		_writing = true;
+		_disk->Submit(&_request);
+		return;
+	}
+
+	_file->WriteSlices(&_queue[0], _queue.size());
+	_received += _queued;
+	_queued = 0;
+	_queue.clear();
+}
+
+void StreamReader::SetHasher(Hasher *hasher)
+{
+	_hasher = hasher;
+}
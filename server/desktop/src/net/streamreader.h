@@ -0,0 +1,107 @@
+#pragma once
+#include "framecodec.h"
+#include "../common/buffer.h"
+#include "../cross/iasyncfile.h"
+
+/*!
+\class StreamReader streamreader.h "server\desktop\src\net\streamreader.h"
+\brief  Resumable receiver of the chunked stream into the file.
+The stream is a sequence of the frames (the SendAll format) terminated by an empty frame.
+The socket data is received into the pooled buffers, the payload is cut into the slices of them
+(the headers are left out) and written to the file without copying, hashed on the way.
+Not more than the buffer size is queued, so the memory does not depend on the size of the stream or its chunks.
+With the asynchronous engine one write at a time is in flight, it holds its slice,
+the socket is read into the next buffers meanwhile.
+*/
+class StreamReader
+{
+public:
+	/*!
+	\param[in] file The file opened to write. Not owned.
+	\param[in] disk The asynchronous engine to write the file with, NULL to write synchronously.
+	\param[in] handler The receiver of the write completions, it must pass them to OnWritten.
+	\param[in] bufferSize The maximum number of the received bytes waiting for the disk.
+	*/
+	StreamReader(File *file, IAsyncFile *disk = NULL, IAsyncFileHandler *handler = NULL, size_lt bufferSize = STREAM_BUFFER_SIZE);
+
+	/*!
+	Releases the buffers. Must not be called while the write is in flight.
+	*/
+	~StreamReader();
+
+	/*!
+	Reads the socket until the stream is complete or the socket would block.
+	Works with both blocking and non-blocking sockets.
+	\param[in] socket The socket.
+	\return FRAMECOMPLETE after the terminating frame, FRAMENEEDMORE if the socket would block,
+	FRAMECLOSED if the peer closed the connection before the stream ended.
+	*/
+	FrameState Read(ISocket *socket);
+
+	/*!
+	Accounts the completed asynchronous write. Call Read after it to go on.
+	\param[in] request The completed request.
+	*/
+	void OnWritten(AsyncFileRequest *request);
+
+	/*!
+	\return TRUE if the asynchronous write is in flight (the reader must not be deleted).
+	*/
+	bool IsWriting();
+
+	/*!
+	\return The number of the payload bytes written to the file.
+	*/
+	size_lt GetReceived();
+
+	/*!
+	\return The number of the bytes received after the terminating frame.
+	The peer must wait for the reply before it sends the next request, so anything but 0 is a protocol error.
+	*/
+	size_lt GetLeftover();
+
+	/*!
+	Sets the hash to be updated with the payload as it arrives (also with the asynchronous writes).
+	\param[in] hasher The hash or NULL. Not owned.
+	*/
+	void SetHasher(Hasher *hasher);
+
+private:
+	/*!
+	Cuts the received data of the current buffer into the payload slices and writes them to the file.
+	Without flush the slices are written only when the half of the limit is queued.
+	\param[in] flush Write all the queued slices.
+	\return FRAMECOMPLETE if the terminating frame was parsed and everything is written, FRAMENEEDMORE otherwise.
+	*/
+	FrameState Process(bool flush);
+
+	/*!
+	Cuts the unparsed data of the current buffer into the headers and the payload slices.
+	*/
+	void Parse();
+
+	/*!
+	Writes the queued slices: all of them synchronously or the first one asynchronously.
+	*/
+	void WriteQueued();
+
+	File *_file;								///< The file the payload is written to
+	IAsyncFile *_disk;							///< The asynchronous engine, NULL for the synchronous writes
+	AsyncFileRequest _request;					///< The asynchronous write in flight
+	MSIYBCore::BufferSlice _writingSlice;		///< The payload of the asynchronous write in flight
+	bool _writing;								///< The asynchronous write is in flight
+	size_lt _fileOffset;						///< The offset of the next asynchronous write
+	size_lt _bufferSize;						///< The limit of the queued bytes
+	MSIYBCore::Buffer *_buffer;					///< The buffer being received into, NULL before the first receive
+	size_lt _parsed;							///< The number of the parsed bytes of the current buffer
+	std::vector<MSIYBCore::BufferSlice> _queue;	///< The payload waiting for the disk
+	size_lt _queued;							///< The number of the bytes in the queue and in flight
+	char _header[FRAME_HEADER_SIZE];			///< The length prefix of the current chunk
+	size_lt _headerReceived;					///< The number of the parsed header bytes
+	size_lt _left;								///< The number of the payload bytes left in the current chunk
+	size_lt _received;							///< The number of the payload bytes written to the file
+	bool _terminated;							///< The terminating frame was parsed
+	size_lt _leftover;							///< The number of the bytes received after the terminating frame
+	bool _completed;							///< The terminating frame was parsed and the payload is written
+	Hasher *_hasher;							///< The hash of the payload, NULL if it is not hashed
+};
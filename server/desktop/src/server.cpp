@@ -1,35 +1,673 @@
 #include "server.h"
-#include "common\file.h"
+#include "common/file.h"
+#include "common/crc32c.h"
+#include "common/dirindex.h"
+#include "common/epoch.h"
+#include <unordered_set>
+#include <cerrno>
+#include <cstdio>
 
 Server::Server()
 {
 	// call config reader
+	listener = NULL;
+	acceptArena = NULL;
+	loop = NULL;
+	disk = NULL;
+	chunks = NULL;
+	storage = NULL;
+	deltasCount = 0;
+	connectionsCount = 0;
+	acceptPaused = false;
 }
 
 Server::~Server()
 {
-
+	delete listener;
+	delete acceptArena;
+	delete disk;
+	delete chunks;
+	// The index retires its views, they are freed with the reclaimer
+	delete storage;
+	MSIYBCore::Epoch::StopReclaimer();
+	delete loop;
 }
 
 void Server::Start()
+{
+	loop = new EventLoop();
+	// The uploads are written by the kernel (or the I/O threads), the completions come to the loop
+	disk = new AsyncFile(*loop);
+	chunks = new ChunkStore(SERVER_CHUNKSTORE_DIR);
+
+	// The downloads are looked up in the index without the locks, the old versions of its views are freed in the background
+	MSIYBCore::Epoch::StartReclaimer();
+	if (!Dir::Exists(SERVER_STORAGE_DIR))
+	{
+		Dir::MakeDir(SERVER_STORAGE_DIR);
+	}
+	storage = new Dir(SERVER_STORAGE_DIR);
+	storage->Watch();
+
+	listener = new Socket((short)SERVER_PORT);
+	listener->Bind();
+	listener->Listen(SERVER_LISTEN_BACKLOG);
+	listener->SetNonBlocking(true);
+	loop->Add(listener, this, EVENTREAD);
+
+	/*
+		One thread waits for all the connections,
+		each connection is a state machine driven by readiness events.
+	*/
+	loop->Run();
+}
+
+void Server::Stop()
+{
+	if (loop)
+	{
+		loop->Stop();
+	}
+}
+
+void Server::HandleEvents(int /*events*/)
+{
+	// Edge-triggered: accept until the backlog is empty
+	Socket *client;
+	for (;;)
+	{
+		// The connection gets its own arena: the socket and the request objects are taken from it.
+		// The arena and its blocks are recycled by Pool, the heap is used only until the warm-up
+		if (!acceptArena)
+		{
+			acceptArena = new MSIYBCore::Arena();
+		}
+		try
+		{
+			client = listener->AcceptSocket(acceptArena);
+		}
+		catch (SocketException &error)
+		{
+			if (OnAcceptError(error.GetErrorCode()))
+			{
+				continue;
+			}
+			break;
+		}
+		acceptPaused = false;
+		if (client == NULL)
+		{
+			break;
+		}
+		try
+		{
+			new Connection(client, *loop, *this, acceptArena);
+			connectionsCount++;
+		}
+		catch (SocketException &)
+		{
+			client->Close();
+			delete acceptArena;
+		}
+		acceptArena = NULL;
+	}
+}
+
+void Server::OnMessage(Connection &connection, char *data, int size)
+{
+	/*
+		"PUT <name>" uploads the file: the reply is SERVER_REPLY_OK, then the client sends
+		the chunked stream and gets SERVER_REPLY_OK again after the file is written,
+		followed by the space and the CRC-32C of the received data in hex.
+		Otherwise the request is the name of the file to download,
+		the reply is the file frame.
+		An empty frame is the reply if the file isn't in the index of the storage or can't be opened.
+		The deduplicated storage is served by OnChunkRequest, the delta uploads by OnDeltaRequest.
+	*/
+	auto session = uploads.find(&connection);
+	if (session != uploads.end())
+	{
+		OnChunkUpload(connection, *session->second, data, size);
+		return;
+	}
+	auto delta = deltas.find(&connection);
+	if (delta != deltas.end())
+	{
+		OnDeltaUpload(connection, *delta->second, data, size);
+		return;
+	}
+	if (OnChunkRequest(connection, data, size) || OnDeltaRequest(connection, data, size))
+	{
+		return;
+	}
+
+	size_t commandLength = strlen(SERVER_COMMAND_PUT);
+	bool upload = size > (int)commandLength && !memcmp(data, SERVER_COMMAND_PUT, commandLength);
+	if (upload)
+	{
+		data += commandLength;
+		size -= (int)commandLength;
+	}
+
+	char path[PATH_MAX];
+	if (!GetStoragePath(data, size, path))
+	{
+		connection.Send(NULL, 0);
+		return;
+	}
+	// The names which aren't stored are answered without the disk access
+	size_lt storedSize;
+	time_t storedTime;
+	if (!upload && !storage->GetIndex().Find(GetIndexPath(path), &storedSize, &storedTime))
+	{
+		connection.Send(NULL, 0);
+		return;
+	}
+
+	MSIYBCore::Arena *arena = connection.GetArena();
+	// The downloaded file lives until the reply is sent: it is taken from the arena of the request
+	File *file = upload || !arena ? new File(path) : arena->New<File>(path, arena);
+	bool owned = upload || !arena;
+	try
+	{
+		if (upload)
+		{
+			file->Open(FileOpenMode::WRITENEWFILE);
+			connection.Send((char*)SERVER_REPLY_OK, (int)strlen(SERVER_REPLY_OK));
+			connection.ReceiveStream(file, disk, new Crc32c());
+		}
+		else
+		{
+			file->Open(FileOpenMode::READONLY);
+			connection.SendFile(file, 0, file->FileSize(), owned);
+		}
+	}
+	catch (FileException &)
+	{
+		if (owned)
+		{
+			delete file;
+		}
+		connection.Send(NULL, 0);
+	}
+}
+
+void Server::OnStream(Connection &connection, File *file, size_lt size, Hasher *hasher)
+{
+	IndexStored(file->GetName(), size);
+
+	// The checksum was computed while the data was received, the client compares it with its own
+	byte digest[HASH_MAX_SIZE];
+	char reply[sizeof(SERVER_REPLY_OK) + 1 + HASH_MAX_SIZE * 2];
+	hasher->Final(digest);
+	strcpy(reply, SERVER_REPLY_OK " ");
+	Hasher::ToHex(digest, hasher->GetSize(), reply + strlen(reply));
+	delete hasher;
+	delete file;
+	connection.Send(reply, (int)strlen(reply));
+}
+
+void Server::OnClose(Connection &connection)
+{
+	auto upload = uploads.find(&connection);
+	if (upload != uploads.end())
+	{
+		// The upload on the disk threads is deleted by its completion
+		upload->second->connection = NULL;
+		if (!upload->second->busy)
+		{
+			delete upload->second;
+		}
+		uploads.erase(upload);
+	}
+	auto delta = deltas.find(&connection);
+	if (delta != deltas.end())
+	{
+		// No reply on the closed connection; the upload on the disk threads is finished by its completion
+		DeltaUpload *upload = delta->second;
+		deltas.erase(delta);
+		upload->connection = NULL;
+		if (!upload->busy)
+		{
+			FinishDeltaUpload(upload, false);
+		}
+	}
+	connectionsCount--;
+
+	// The descriptor of the connection is free: the connections left in the backlog are accepted now
+	if (acceptPaused)
+	{
+		HandleEvents(EVENTREAD);
+	}
+}
+
+bool Server::OnAcceptError(long error)
+{
+	switch (error)
+	{
+	case ECONNABORTED:
+	case EPROTO:
+	case EPERM:
+	case EINTR:
+		// The connection was reset before it was accepted or refused by the firewall, the next one is fine
+		return true;
+	default:
+		// EMFILE, ENFILE, ENOBUFS, ENOMEM: the next accept fails the same way until something is freed
+		if (!acceptPaused)
+		{
+			printf("The connections aren't accepted until a connection closes, accept error %ld\n", error);
+		}
+		acceptPaused = true;
+		return false;
+	}
+}
+
+bool Server::OnChunkRequest(Connection &connection, char *data, int size)
 {
 	/*
-		Initialize listener port
-		Bind and start listen
+		"CPUT <name>" stores the file deduplicated: the reply is SERVER_REPLY_OK, then the client sends
+		the chunk list (ChunkStore::PackRefs) and gets the 64-bit number and the 32-bit indexes
+		of the chunks the store doesn't have. The client sends them one per frame in that order
+		and gets SERVER_REPLY_OK after the file is stored.
+		"CGET <name>" replies the chunk list of the stored file.
+		"CHUNK <hex>" replies the chunk.
+		An empty frame is the reply on any error.
 	*/
+	static const char *commands[] = { SERVER_COMMAND_CHUNKPUT, SERVER_COMMAND_CHUNKGET, SERVER_COMMAND_CHUNK };
+	int command = -1;
+	size_t commandLength = 0;
+	for (int i = 0; i < 3 && command < 0; i++)
+	{
+		commandLength = strlen(commands[i]);
+		if (size > (int)commandLength && !memcmp(data, commands[i], commandLength))
+		{
+			command = i;
+		}
+	}
+	if (command < 0)
+	{
+		return false;
+	}
+	data += commandLength;
+	size -= (int)commandLength;
+
+	char path[PATH_MAX];
+	if (command < 2 && !GetStoragePath(data, size, path))
+	{
+		connection.Send(NULL, 0);
+		return true;
+	}
+	const char *name = path + strlen(SERVER_STORAGE_DIR);
+
+	try
+	{
+		if (command == 0)
+		{
+			ChunkUpload *upload = new ChunkUpload();
+			upload->name = name;
+			upload->listed = false;
+			upload->next = 0;
+			upload->connection = &connection;
+			upload->busy = false;
+			uploads[&connection] = upload;
+			connection.Send((char*)SERVER_REPLY_OK, (int)strlen(SERVER_REPLY_OK));
+		}
+		else if (command == 1)
+		{
+			std::vector<ChunkRef> refs;
+			if (!chunks->GetManifest(name, &refs))
+			{
+				connection.Send(NULL, 0);
+				return true;
+			}
+			std::vector<byte> packed;
+			ChunkStore::PackRefs(refs, &packed);
+			connection.Send((char*)packed.data(), (int)packed.size());
+		}
+		else
+		{
+			ChunkRef ref;
+			if (size != CHUNK_HASH_SIZE * 2 || !ChunkStore::FromHex(data, ref.hash) || !chunks->Has(ref))
+			{
+				connection.Send(NULL, 0);
+				return true;
+			}
+			File *chunk = new File(chunks->GetChunkPath(ref).c_str());
+			try
+			{
+				chunk->Open(FileOpenMode::READONLY);
+			}
+			catch (FileException &)
+			{
+				delete chunk;
+				throw;
+			}
+			connection.SendFile(chunk, 0, chunk->FileSize());
+		}
+	}
+	catch (FileException &)
+	{
+		connection.Send(NULL, 0);
+	}
+	return true;
+}
 
-	File* testFile = new File("F:\\sadve.txt");
-	testFile->Open(FileOpenMode::READONLY);
-	testFile->Close();
+void Server::OnChunkUpload(Connection &connection, ChunkUpload &upload, char *data, int size)
+{
+	// The received chunk is verified and written by the disk threads, the manifest is stored after the last one
+	MSIYBCore::BufferSlice slice;
+	std::vector<byte> copy;
+	const ChunkRef *ref = NULL;
+	try
+	{
+		if (!upload.listed)
+		{
+			if (!ChunkStore::UnpackRefs((byte*)data, size, &upload.chunks))
+			{
+				FinishChunkUpload(&upload, false);
+				return;
+			}
+			upload.listed = true;
+
+			// Every distinct chunk is requested once
+			std::unordered_set<std::string> requested;
+			for (size_lt i = 0; i < upload.chunks.size(); i++)
+			{
+				std::string key((char*)upload.chunks[i].hash, CHUNK_HASH_SIZE);
+				if (!chunks->Has(upload.chunks[i]) && requested.insert(key).second)
+				{
+					upload.missing.push_back(i);
+				}
+			}
 
-	while (1)
+			std::vector<byte> reply(sizeof(unsigned long long) + upload.missing.size() * sizeof(unsigned int));
+			unsigned long long count = upload.missing.size();
+			memcpy(reply.data(), &count, sizeof(count));
+			for (size_lt i = 0; i < upload.missing.size(); i++)
+			{
+				unsigned int index = (unsigned int)upload.missing[i];
+				memcpy(reply.data() + sizeof(count) + i * sizeof(index), &index, sizeof(index));
+			}
+			connection.Send((char*)reply.data(), (int)reply.size());
+		}
+		else
+		{
+			ref = &upload.chunks[upload.missing[upload.next]];
+			upload.next++;
+			// The frame is valid only during the call: its buffer is kept instead (copied if it is too big)
+			slice = connection.GetMessageSlice();
+			if (slice.IsEmpty())
+			{
+				copy.assign((byte*)data, (byte*)data + size);
+			}
+		}
+	}
+	catch (FileException &)
+	{
+		FinishChunkUpload(&upload, false);
+		return;
+	}
+
+	bool last = upload.next == upload.missing.size();
+	if (!ref && !last)
+	{
+		return;
+	}
+	ChunkStore *store = chunks;
+	ChunkUpload *started = &upload;
+	RunUploadJob<ChunkUpload>(started, [store, started, ref, slice, copy = std::move(copy), last]()
+	{
+		if (ref)
+		{
+			const byte *chunk = slice.IsEmpty() ? copy.data() : slice.GetData();
+			store->PutVerified(*ref, chunk, slice.IsEmpty() ? copy.size() : slice.GetSize());
+		}
+		if (last)
+		{
+			store->PutManifest(started->name.c_str(), started->chunks);
+		}
+		return true;
+	}, [this, last](ChunkUpload *upload, bool success)
+	{
+		if (!upload->connection)
+		{
+			delete upload;
+		}
+		else if (!success || last)
+		{
+			FinishChunkUpload(upload, success);
+		}
+	});
+}
+
+void Server::FinishChunkUpload(ChunkUpload *upload, bool success)
+{
+	Connection *connection = upload->connection;
+	if (connection)
+	{
+		uploads.erase(connection);
+	}
+	delete upload;
+
+	if (!connection)
+	{
+		return;
+	}
+	if (success)
+	{
+		connection->Send((char*)SERVER_REPLY_OK, (int)strlen(SERVER_REPLY_OK));
+	}
+	else
+	{
+		connection->Send(NULL, 0);
+	}
+}
+
+template <typename Upload>
+void Server::RunUploadJob(Upload *upload, std::function<bool()> job, std::function<void(Upload *upload, bool success)> done)
+{
+	upload->busy = true;
+	upload->connection->Wait();
+	try
+	{
+		disk->Execute(std::move(job), [upload, done](bool success)
+		{
+			upload->busy = false;
+			// The completion may delete the upload, the connection is taken before
+			Connection *connection = upload->connection;
+			done(upload, success);
+			if (connection)
+			{
+				connection->Resume();
+			}
+		});
+	}
+	catch (...)
+	{
+		// Not started: the connection is closed and OnClose deletes the upload
+		upload->busy = false;
+		throw;
+	}
+}
+
+bool Server::GetStoragePath(const char *request, int size, char *path)
+{
+	size_t dirLength = strlen(SERVER_STORAGE_DIR);
+	if (size <= 0 || dirLength + size >= PATH_MAX)
+	{
+		return false;
+	}
+	if (memchr(request, '\0', size) || request[0] == '/' || request[0] == '\\')
+	{
+		return false;
+	}
+
+	memcpy(path, SERVER_STORAGE_DIR, dirLength);
+	memcpy(path + dirLength, request, size);
+	path[dirLength + size] = '\0';
+	return strstr(path, "..") == NULL && strchr(path, ':') == NULL && !DirIndex::IsIndexFile(path + dirLength);
+}
+
+const char* Server::GetIndexPath(char *path)
+{
+	char *name = path + strlen(SERVER_STORAGE_DIR);
+	for (char *pos = name; *pos; pos++)
+	{
+		if (*pos == '/')
+		{
+			*pos = PATH_SEPARATOR;
+		}
+	}
+	return name;
+}
+
+void Server::IndexStored(const char *path, size_lt size)
+{
+	char name[PATH_MAX];
+	strcpy(name, path);
+	try
+	{
+		storage->GetIndex().Update(GetIndexPath(name), size, time(NULL));
+	}
+	catch (FileException &)
+	{
+		// The file is stored anyway: the journal can't be written, the watcher reports the file
+	}
+}
+
+bool Server::OnDeltaRequest(Connection &connection, char *data, int size)
+{
+	/*
+		"DPUT <name>" updates the stored file by the delta: the reply is the signature of the stored file
+		(DeltaSignature::Pack, no blocks if the file is new), then the client sends the delta frames
+		(DeltaEncoder) and gets SERVER_REPLY_OK after the rebuilt file replaces the stored one.
+		An empty frame is the reply on any error.
+	*/
+	size_t commandLength = strlen(SERVER_COMMAND_DELTAPUT);
+	if (size <= (int)commandLength || memcmp(data, SERVER_COMMAND_DELTAPUT, commandLength))
+	{
+		return false;
+	}
+	char path[PATH_MAX];
+	if (!GetStoragePath(data + commandLength, size - (int)commandLength, path))
+	{
+		connection.Send(NULL, 0);
+		return true;
+	}
+
+	DeltaUpload *upload = new DeltaUpload();
+	upload->path = path;
+	// Unique: the same file may be updated by several connections at once, the last rename wins
+	upload->tempPath = upload->path + DELTA_TEMP_SUFFIX + "." + std::to_string(++deltasCount);
+	upload->basis = NULL;
+	upload->output = NULL;
+	upload->decoder = NULL;
+	upload->connection = &connection;
+	upload->busy = false;
+	upload->complete = false;
+	deltas[&connection] = upload;
+
+	// The signature reads the whole stored file
+	RunUploadJob<DeltaUpload>(upload, [upload]()
+	{
+		if (File::Exist(upload->path.c_str()))
+		{
+			upload->basis = new File(upload->path.c_str());
+			upload->basis->Open(FileOpenMode::READONLY);
+			upload->signature.Build(*upload->basis);
+		}
+		upload->output = new File(upload->tempPath.c_str());
+		upload->output->Open(FileOpenMode::WRITENEWFILE);
+		upload->decoder = new DeltaDecoder(upload->signature, upload->basis, *upload->output);
+		return true;
+	}, [this](DeltaUpload *upload, bool success)
+	{
+		if (!success || !upload->connection)
+		{
+			FinishDeltaUpload(upload, false);
+			return;
+		}
+		std::vector<byte> packed;
+		upload->signature.Pack(&packed);
+		upload->connection->Send((char*)packed.data(), (int)packed.size());
+	});
+	return true;
+}
+
+void Server::OnDeltaUpload(Connection &connection, DeltaUpload &upload, char *data, int size)
+{
+	// The frame is valid only during the call: its buffer is kept instead (copied if it is too big)
+	MSIYBCore::BufferSlice slice = connection.GetMessageSlice();
+	std::vector<byte> copy;
+	if (slice.IsEmpty())
+	{
+		copy.assign((byte*)data, (byte*)data + size);
+	}
+
+	DeltaUpload *started = &upload;
+	RunUploadJob<DeltaUpload>(started, [this, started, slice, copy = std::move(copy)]()
+	{
+		const byte *frame = slice.IsEmpty() ? copy.data() : slice.GetData();
+		if (!started->decoder->Apply(frame, slice.IsEmpty() ? copy.size() : slice.GetSize()))
+		{
+			return true;
+		}
+
+		// The rebuilt file is on the disk before it replaces the stored one
+		delete started->decoder;
+		started->decoder = NULL;
+		delete started->basis;
+		started->basis = NULL;
+		started->output->Sync();
+		size_lt size = started->output->FileSize();
+		started->output->Close();
+		File::Replace(started->tempPath.c_str(), started->path.c_str());
+		IndexStored(started->path.c_str(), size);
+		started->complete = true;
+		return true;
+	}, [this](DeltaUpload *upload, bool success)
+	{
+		// The closed connection sends no more frames, the upload ends here
+		if (!success || upload->complete || !upload->connection)
+		{
+			FinishDeltaUpload(upload, success && upload->complete);
+		}
+	});
+}
+
+void Server::FinishDeltaUpload(DeltaUpload *upload, bool success)
+{
+	Connection *connection = upload->connection;
+	if (connection)
+	{
+		deltas.erase(connection);
+	}
+	delete upload->decoder;
+	delete upload->basis;
+	delete upload->output;
+	try
+	{
+		if (!success && File::Exist(upload->tempPath.c_str()))
+		{
+			File::Delete(upload->tempPath.c_str());
+		}
+	}
+	catch (FileException &)
+	{
+		// Only the leftover of the failed upload
+	}
+	delete upload;
+
+	if (!connection)
+	{
+		return;
+	}
+	if (success)
+	{
+		connection->Send((char*)SERVER_REPLY_OK, (int)strlen(SERVER_REPLY_OK));
+	}
+	else
 	{
-		/*
-			Waiting for request
-			Handle request with single thread
-			Each thread handle comands 
-			So:
-			TODO: thread.h (also divided for different OS)
-		*/
+		connection->Send(NULL, 0);
 	}
 }
@@ -1,15 +1,160 @@
 #pragma once
 #include "net/socket.h"
+#include "net/eventloop.h"
+#include "net/connection.h"
+#include "common/asyncfile.h"
+#include "common/chunkstore.h"
+#include "common/delta.h"
+#include "common/dir.h"
+#include <string>
+#include <functional>
+#include <unordered_map>
 
-class Server
+/// The deduplicated upload in progress (started by SERVER_COMMAND_CHUNKPUT)
+typedef struct ChunkUpload_
+{
+	std::string name;					///< The name of the file in the store
+	bool listed;						///< TRUE after the chunk list is received
+	std::vector<ChunkRef> chunks;		///< The chunks of the file
+	std::vector<size_lt> missing;		///< The indexes of the chunks the store doesn't have
+	size_lt next;						///< The index in missing of the next chunk to be received
+	Connection *connection;				///< The uploading connection, NULL after it is closed
+	bool busy;							///< TRUE while the disk job of the upload runs
+} ChunkUpload;
+
+/// The delta upload in progress (started by SERVER_COMMAND_DELTAPUT)
+typedef struct DeltaUpload_
+{
+	std::string path;				///< The stored file
+	std::string tempPath;			///< The rebuilt file: the path with DELTA_TEMP_SUFFIX and the number of the upload
+	DeltaSignature signature;		///< The signature of the stored file sent to the client
+	File *basis;					///< The stored file or NULL if it is new
+	File *output;					///< The rebuilt file
+	DeltaDecoder *decoder;			///< The decoder of the delta frames
+	Connection *connection;			///< The uploading connection, NULL after it is closed
+	bool busy;						///< TRUE while the disk job of the upload runs
+	bool complete;					///< TRUE after DELTAEND is applied and the stored file is replaced
+} DeltaUpload;
+
+class Server : public IEventHandler, public IConnectionHandler
 {
 public:
 
 	Server();
 	~Server();
-	 
+
+	/*!
+	Serves the connections on the calling thread until Stop is called. Linux only (see EventLoop).
+	*/
 	void Start();
+	void Stop();
+
+	/*!
+	Accepts all the pending connections of the listener. The accept errors never leave it (see OnAcceptError).
+	*/
+	void HandleEvents(int events) override;
+
+	void OnMessage(Connection &connection, char *data, int size) override;
+	void OnStream(Connection &connection, File *file, size_lt size, Hasher *hasher) override;
+	void OnClose(Connection &connection) override;
+
+	/*!
+	Builds the path of the requested file inside the storage dir.
+	\param[in] request The requested file name (not null-terminated).
+	\param[in] size The size of the request.
+	\param[out] path The path of the file, PATH_MAX bytes.
+	\return FALSE if the name is empty, too long, leaves the storage dir or names the files of its index.
+	*/
+	static bool GetStoragePath(const char *request, int size, char *path);
+
+	/*!
+	Turns the path inside the storage dir into the path of the file in its index.
+	\param[in,out] path The path built by GetStoragePath, its slashes are replaced with PATH_SEPARATOR.
+	\return The path relative to the storage dir, points into the path.
+	*/
+	static const char* GetIndexPath(char *path);
 
 private:
+	/*!
+	Decides how to go on after the accept failed. The failed handshakes are skipped. The lack of the descriptors
+	or the memory pauses the accepting: it is resumed by the next closed connection or the next incoming one.
+	\param[in] error The error code of the accept.
+	\return TRUE to accept the next connection, FALSE to stop until the next event.
+	*/
+	bool OnAcceptError(long error);
+
+	/*!
+	Handles the frame of the deduplicated upload: the chunk list first, then the missing chunks.
+	\param[in] connection The uploading connection.
+	\param[in] upload The upload.
+	\param[in] data The frame payload.
+	\param[in] size The size of the payload.
+	*/
+	void OnChunkUpload(Connection &connection, ChunkUpload &upload, char *data, int size);
+
+	/*!
+	Ends the upload and deletes it.
+	\param[in] upload The upload.
+	\param[in] success TRUE to reply SERVER_REPLY_OK (the manifest is stored), FALSE to reply the empty frame.
+	No reply if the connection is closed.
+	*/
+	void FinishChunkUpload(ChunkUpload *upload, bool success);
+
+	/*!
+	Runs the blocking job of the upload on the disk threads, the connection waits meanwhile.
+	The completion is called on the loop thread even if the connection was closed (then its connection is NULL),
+	after it the connection goes on reading.
+	\param[in] upload The upload with its connection. Must not be touched by the loop thread until the completion.
+	\param[in] job The blocking call. Returns FALSE (or throws) if it failed.
+	\param[in] done The completion. Deletes the upload if the connection is closed.
+	*/
+	template <typename Upload>
+	void RunUploadJob(Upload *upload, std::function<bool()> job, std::function<void(Upload *upload, bool success)> done);
+
+	/*!
+	Handles the requests of the chunk store: SERVER_COMMAND_CHUNKPUT, SERVER_COMMAND_CHUNKGET, SERVER_COMMAND_CHUNK.
+	\return FALSE if the request is not one of them.
+	*/
+	bool OnChunkRequest(Connection &connection, char *data, int size);
+
+	/*!
+	Starts the delta upload (SERVER_COMMAND_DELTAPUT): replies the signature of the stored file
+	after the disk threads build it.
+	\return FALSE if the request is not SERVER_COMMAND_DELTAPUT.
+	*/
+	bool OnDeltaRequest(Connection &connection, char *data, int size);
+
+	/*!
+	Applies the delta frame to the rebuilt file on the disk threads (the copies read the basis), the next frame waits.
+	After DELTAEND the same job syncs the rebuilt file and renames it over the stored one, then the upload ends.
+	*/
+	void OnDeltaUpload(Connection &connection, DeltaUpload &upload, char *data, int size);
+
+	/*!
+	Ends the delta upload and deletes it.
+	\param[in] upload The upload.
+	\param[in] success TRUE to reply SERVER_REPLY_OK (the stored file is replaced),
+	FALSE to drop the rebuilt file and reply the empty frame. No reply if the connection is closed.
+	*/
+	void FinishDeltaUpload(DeltaUpload *upload, bool success);
+
+	/*!
+	Records the file stored by the server in the index, so it is downloadable at once
+	(the watcher reports it later). May be called from any thread.
+	\param[in] path The path of the file inside the storage dir.
+	\param[in] size The size of the file.
+	*/
+	void IndexStored(const char *path, size_lt size);
+
 	Socket* listener;
+	MSIYBCore::Arena* acceptArena;	///< The arena for the next accepted connection
+	EventLoop* loop;
+	AsyncFile* disk;
+	ChunkStore* chunks;
+	Dir* storage;					///< The storage dir, its watched index answers the downloads
+	std::unordered_map<Connection*, ChunkUpload*> uploads;
+	std::unordered_map<Connection*, DeltaUpload*> deltas;
+	size_lt deltasCount;			///< The number of the started delta uploads, names their rebuilt files
+	size_lt connectionsCount;
+	bool acceptPaused;				///< TRUE after the accept failed for the lack of the resources
 };
@@ -11,9 +11,6 @@
 #define ERROR_MSG_SIZE 1024
 #define DEBUG
 
-#ifdef _WIN32
-#include "windows.h"
-
 #ifdef DEBUG
 #define ThrowException(msg)											\
 {																	\
@@ -35,6 +32,9 @@
 }
 #endif
 
+#ifdef _WIN32
+#include "windows.h"
+
 inline const char *ParseException(int errCode)
 {
 	char *errMessage = new char[1024];
@@ -48,6 +48,8 @@ inline const char *ParseException(int errCode)
 	return errMessage;
 }
 #elif __unix__
+#include <string.h>
+
 inline const char *ParseException(int errCode)
 {
 	char *errMessage = new char[1024];
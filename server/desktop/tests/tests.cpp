@@ -1,10 +1,882 @@
 #include <CppUnitTest.h>  
 #include "../src/common/file.h"  
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/common/boundedqueue.h"
+#include "../src/common/buffer.h"
+#include "../src/common/chunkstore.h"
+#include "../src/common/delta.h"
+#include "../src/common/dir.h"
+#include "../src/common/dirindex.h"
+#include "../src/common/epoch.h"
+#include "../src/common/locker.h"
+#include "../src/common/threadpool.h"
+#include "../src/net/framecodec.h"
+#include "../src/net/streamreader.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace TestCore
 {
+	/*!
+	The socket replaying the prepared input and recording the output.
+	Every other call would block and the others move at most step bytes, so the codecs have to resume.
+	*/
+	class ScriptedSocket : public ISocket
+	{
+	public:
+		ScriptedSocket(const std::string &input, size_lt step) : _input(input), _position(0), _step(step), _calls(0)
+		{
+
+		}
+
+		int Recv(char *buf, int size) override
+		{
+			if (_calls++ % 2 == 0)
+			{
+				return SOCKET_WOULDBLOCK;
+			}
+			size_lt part = std::min(std::min((size_lt)size, _step), _input.size() - _position);
+			memcpy(buf, _input.data() + _position, part);
+			_position += part;
+			return (int)part;
+		}
+
+		int RecvBuffer(MSIYBCore::Buffer *buffer) override
+		{
+			size_lt free;
+			byte *tail = buffer->GetTail(&free);
+			int recieved = Recv((char*)tail, (int)free);
+			if (recieved > 0)
+			{
+				buffer->Commit(recieved);
+			}
+			return recieved;
+		}
+
+		int SendV(IOBuffer *buffers, size_lt count) override
+		{
+			if (_calls++ % 2 == 0)
+			{
+				return SOCKET_WOULDBLOCK;
+			}
+			size_lt sent = 0;
+			for (size_lt i = 0; i < count && sent < _step; i++)
+			{
+				size_lt part = std::min(buffers[i].size, _step - sent);
+				_output.append((const char*)buffers[i].data, part);
+				sent += part;
+			}
+			return (int)sent;
+		}
+
+		int Send(char *buf, int size) override
+		{
+			IOBuffer buffer = { (byte*)buf, (size_lt)size };
+			return SendV(&buffer, 1);
+		}
+
+		int RecvAll(char *) override { return 0; }
+		int SendAll(char *, int) override { return 0; }
+		void Connect() override {}
+		void Close() override {}
+		void Bind() override {}
+		void Listen(int) override {}
+		ISocket* Accept() override { return NULL; }
+		void SetDirectPort(short) override {}
+		int RecvFrom() override { return 0; }
+		int SendTo() override { return 0; }
+		void ShutDown(How) override {}
+		void SetNonBlocking(bool) override {}
+		t_descriptor GetDescriptor() override { return 0; }
+		int SendFilePart(t_filehandle, size_lt, int) override { return 0; }
+		size_lt SendFile(t_filehandle, size_lt, size_lt) override { return 0; }
+
+		const std::string& GetOutput()
+		{
+			return _output;
+		}
+
+	private:
+		std::string _input;		///< The data to be received
+		size_lt _position;		///< The number of the received bytes
+		size_lt _step;			///< The most bytes moved by one call
+		int _calls;				///< The number of the calls
+		std::string _output;	///< The sent data
+	};
+
+	/*!
+	\return The length prefix and the payload as RecvAll expects them.
+	*/
+	static std::string MakeFrame(const std::string &payload)
+	{
+		long length = (long)payload.size();
+		std::string frame((const char*)&length, FRAME_HEADER_SIZE);
+		return frame + payload;
+	}
+
+	/*!
+	\return The bytes generated from the seed.
+	*/
+	static std::string MakeData(size_lt size, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::string data(size, 0);
+		for (size_lt i = 0; i < size; i++)
+		{
+			data[i] = (char)(random() & 0xFF);
+		}
+		return data;
+	}
+
+	static void WriteAll(const char *fileName, const std::string &data)
+	{
+		File::WriteAllBytes(fileName, (byte*)data.data(), data.size());
+	}
+
+	static std::string ReadAll(const char *fileName)
+	{
+		File file(fileName);
+		file.Open(FileOpenMode::READONLY);
+		std::string data;
+		byte block[4096];
+		size_lt readed;
+		while ((readed = file.ReadBlock(block, sizeof(block))) > 0)
+		{
+			data.append((const char*)block, readed);
+		}
+		file.Close();
+		return data;
+	}
+
+	TEST_CLASS(FrameCodecTest)
+	{
+	public:
+		TEST_METHOD(WriteAndReadResumed)
+		{
+			std::vector<std::string> payloads;
+			payloads.push_back("hello");
+			payloads.push_back("");
+			payloads.push_back(MakeData(MSIYBCore::Buffer::GetCapacity() + 1000, 1));
+
+			FrameWriter writer;
+			for (size_lt i = 0; i < payloads.size(); i++)
+			{
+				writer.Queue(payloads[i].data(), payloads[i].size());
+			}
+			ScriptedSocket output("", 7);
+			int rounds = 0;
+			while (writer.Write(&output) != FRAMECOMPLETE)
+			{
+				Assert::IsTrue(++rounds < 1000000);
+			}
+			Assert::IsTrue(writer.Empty());
+
+			ScriptedSocket input(output.GetOutput(), 3);
+			FrameReader reader;
+			for (size_lt i = 0; i < payloads.size(); i++)
+			{
+				while (reader.Read(&input) == FRAMENEEDMORE)
+				{
+				}
+				Assert::AreEqual(payloads[i].size(), reader.GetFrameSize());
+				Assert::IsTrue(payloads[i] == std::string(reader.GetFrame(), reader.GetFrameSize()));
+				reader.Reset();
+			}
+			FrameState state;
+			while ((state = reader.Read(&input)) == FRAMENEEDMORE)
+			{
+			}
+			Assert::IsTrue(state == FRAMECLOSED);
+		}
+
+		TEST_METHOD(FeedStopsAtFrameEnd)
+		{
+			std::string data = MakeFrame("first") + MakeFrame("second");
+			FrameReader reader;
+			size_lt consumed = 0;
+			Assert::IsTrue(reader.Feed(data.data(), 2, &consumed) == FRAMENEEDMORE);
+			Assert::AreEqual((size_lt)2, consumed);
+			Assert::IsTrue(reader.Feed(data.data() + 2, data.size() - 2, &consumed) == FRAMECOMPLETE);
+			Assert::AreEqual(FRAME_HEADER_SIZE + 5 - 2, consumed);
+
+			MSIYBCore::BufferSlice slice = reader.GetSlice();
+			reader.Reset();
+			Assert::IsTrue(std::string((const char*)slice.GetData(), slice.GetSize()) == "first");
+		}
+
+		TEST_METHOD(RejectsBadLength)
+		{
+			std::string data = MakeFrame(std::string(100, 'x'));
+			FrameReader reader(10);
+			size_lt consumed;
+			Assert::ExpectException<SocketException>([&]() { reader.Feed(data.data(), data.size(), &consumed); });
+		}
+	};
+
+	TEST_CLASS(StreamReaderTest)
+	{
+	public:
+		TEST_METHOD(ResumesAcrossChunks)
+		{
+			std::string payload;
+			std::string stream;
+			for (unsigned int i = 0; i < 20; i++)
+			{
+				std::string chunk = MakeData(1000 + i * 7919, i);
+				payload += chunk;
+				stream += MakeFrame(chunk);
+			}
+			stream += MakeFrame("");
+
+			File file("streamreadertest.bin");
+			file.Open(FileOpenMode::WRITENEWFILE);
+			StreamReader reader(&file, NULL, NULL, 16 * 1024);
+			ScriptedSocket socket(stream, 5000);
+			FrameState state;
+			while ((state = reader.Read(&socket)) == FRAMENEEDMORE)
+			{
+			}
+			file.Close();
+
+			Assert::IsTrue(state == FRAMECOMPLETE);
+			Assert::AreEqual(payload.size(), reader.GetReceived());
+			Assert::AreEqual((size_lt)0, reader.GetLeftover());
+			Assert::IsTrue(ReadAll("streamreadertest.bin") == payload);
+			File::Delete("streamreadertest.bin");
+		}
+
+		TEST_METHOD(ReportsClosedStream)
+		{
+			File file("streamreadertest.bin");
+			file.Open(FileOpenMode::WRITENEWFILE);
+			StreamReader reader(&file);
+			ScriptedSocket socket(MakeFrame("unterminated"), 100);
+			FrameState state;
+			while ((state = reader.Read(&socket)) == FRAMENEEDMORE)
+			{
+			}
+			file.Close();
+			Assert::IsTrue(state == FRAMECLOSED);
+			File::Delete("streamreadertest.bin");
+		}
+	};
+
+	TEST_CLASS(DeltaTest)
+	{
+	public:
+		TEST_METHOD(RoundTrip)
+		{
+			std::string basis = MakeData(300000, 2);
+			std::string changed = basis;
+			changed.insert(1000, "inserted");
+			changed.erase(150000, 3000);
+			changed[250000] ^= 0x55;
+
+			Assert::IsTrue(RoundTrip(basis, changed) < changed.size() / 4);
+			RoundTrip(basis, "");
+			RoundTrip("", changed);
+		}
+
+		TEST_METHOD(RejectsDamagedFrame)
+		{
+			WriteAll("deltabasis.bin", "hello world hello world");
+			File basis("deltabasis.bin");
+			basis.Open(FileOpenMode::READONLY);
+			DeltaSignature signature;
+			signature.Build(basis);
+
+			File output("deltaoutput.bin");
+			output.Open(FileOpenMode::WRITENEWFILE);
+			DeltaDecoder decoder(signature, &basis, output);
+			// DELTACOPY of the blocks the basis doesn't have
+			byte frame[] = { DELTACOPY, 5, 0, 0, 0, 1, 0, 0, 0 };
+			Assert::ExpectException<FileException>([&]() { decoder.Apply(frame, sizeof(frame)); });
+			output.Close();
+			basis.Close();
+			File::Delete("deltabasis.bin");
+			File::Delete("deltaoutput.bin");
+		}
+
+	private:
+		/*!
+		Encodes the changed file against the signature of the basis and rebuilds it.
+		\return The size of the literal data.
+		*/
+		size_lt RoundTrip(const std::string &basisData, const std::string &changedData)
+		{
+			WriteAll("deltabasis.bin", basisData);
+			WriteAll("deltachanged.bin", changedData);
+
+			File basis("deltabasis.bin");
+			basis.Open(FileOpenMode::READONLY);
+			DeltaSignature signature;
+			signature.Build(basis);
+			std::vector<byte> packed;
+			signature.Pack(&packed);
+			DeltaSignature received;
+			Assert::IsTrue(received.Unpack(packed.data(), packed.size()));
+
+			File changed("deltachanged.bin");
+			changed.Open(FileOpenMode::READONLY);
+			DeltaEncoder encoder(received, changed);
+			File output("deltaoutput.bin");
+			output.Open(FileOpenMode::WRITENEWFILE);
+			DeltaDecoder decoder(signature, &basis, output);
+			std::vector<byte> frame;
+			bool complete = false;
+			while (encoder.Next(&frame))
+			{
+				complete = decoder.Apply(frame.data(), frame.size());
+			}
+			output.Close();
+			changed.Close();
+			basis.Close();
+
+			Assert::IsTrue(complete);
+			Assert::IsTrue(ReadAll("deltaoutput.bin") == changedData);
+			File::Delete("deltabasis.bin");
+			File::Delete("deltachanged.bin");
+			File::Delete("deltaoutput.bin");
+			return encoder.GetLiteralSize();
+		}
+	};
+
+	TEST_CLASS(ChunkStoreTest)
+	{
+	public:
+		TEST_METHOD(StoresChunkOnce)
+		{
+			ChunkStore store("chunkstoretest");
+			// Unique for the run, so the chunks of the previous runs don't count
+			std::string data = MakeData(10000, (unsigned int)std::chrono::system_clock::now().time_since_epoch().count());
+			ChunkRef first;
+			ChunkRef second;
+			Assert::IsTrue(store.Put((const byte*)data.data(), data.size(), &first));
+			Assert::IsFalse(store.Put((const byte*)data.data(), data.size(), &second));
+			Assert::IsTrue(memcmp(&first.hash, &second.hash, CHUNK_HASH_SIZE) == 0);
+			Assert::IsTrue(store.Has(first));
+
+			std::vector<byte> stored(first.size);
+			store.Get(first, stored.data());
+			Assert::IsTrue(memcmp(stored.data(), data.data(), data.size()) == 0);
+		}
+
+		TEST_METHOD(StoresChangedFileByNewChunks)
+		{
+			ChunkStore store("chunkstoretest");
+			std::string data = MakeData(2000000, (unsigned int)std::chrono::system_clock::now().time_since_epoch().count());
+			WriteAll("chunkstoresource.bin", data);
+			{
+				File source("chunkstoresource.bin");
+				source.Open(FileOpenMode::MAPPED);
+				Assert::AreEqual(data.size(), store.Store("original.bin", source));
+			}
+			{
+				File source("chunkstoresource.bin");
+				source.Open(FileOpenMode::MAPPED);
+				Assert::AreEqual((size_lt)0, store.Store("copy.bin", source));
+			}
+
+			data[1000000] ^= 0x55;
+			WriteAll("chunkstoresource.bin", data);
+			{
+				File source("chunkstoresource.bin");
+				source.Open(FileOpenMode::MAPPED);
+				Assert::IsTrue(store.Store("changed.bin", source) < data.size() / 4);
+			}
+
+			File restored("chunkstorerestored.bin");
+			restored.Open(FileOpenMode::WRITENEWFILE);
+			Assert::AreEqual(data.size(), store.Restore("changed.bin", restored));
+			restored.Close();
+			Assert::IsTrue(ReadAll("chunkstorerestored.bin") == data);
+			File::Delete("chunkstoresource.bin");
+			File::Delete("chunkstorerestored.bin");
+		}
+	};
+
+	TEST_CLASS(DirIndexTest)
+	{
+	public:
+		TEST_METHOD(ReplaysJournal)
+		{
+			Prepare();
+			{
+				DirIndex index("dirindextest");
+				index.Open();
+				Assert::AreEqual((size_lt)1, index.GetCount());
+				index.Update("x.bin", 7, 70);
+				index.Remove("a.txt");
+			}
+
+			DirIndex index("dirindextest");
+			Assert::IsTrue(index.Load());
+			size_lt size;
+			time_t modTime;
+			Assert::IsTrue(index.Find("x.bin", &size, &modTime));
+			Assert::AreEqual((size_lt)7, size);
+			Assert::IsTrue(modTime == 70);
+			Assert::IsFalse(index.Find("a.txt", &size, &modTime));
+		}
+
+		TEST_METHOD(DropsTornTail)
+		{
+			Prepare();
+			{
+				DirIndex index("dirindextest");
+				index.Open();
+				index.Update("x.bin", 7, 70);
+			}
+			// The record cut by the crash
+			{
+				File journal("dirindextest/" DIRINDEX_JOURNAL_NAME);
+				journal.Open(FileOpenMode::WRITEATTHEEND);
+				byte torn[] = { DIRINDEXUPDATE, 5 };
+				journal.WriteBlock(torn, sizeof(torn));
+				journal.Close();
+			}
+			{
+				DirIndex index("dirindextest");
+				Assert::IsTrue(index.Load());
+				Assert::AreEqual((size_lt)2, index.GetCount());
+				index.Update("y.bin", 8, 80);
+			}
+
+			DirIndex index("dirindextest");
+			Assert::IsTrue(index.Load());
+			size_lt size;
+			time_t modTime;
+			Assert::IsTrue(index.Find("x.bin", &size, &modTime));
+			Assert::IsTrue(index.Find("y.bin", &size, &modTime));
+			Assert::AreEqual((size_lt)3, index.GetCount());
+		}
+
+		TEST_METHOD(RejectsDamagedSnapshot)
+		{
+			Prepare();
+			{
+				DirIndex index("dirindextest");
+				index.Open();
+			}
+			WriteAll("dirindextest/" DIRINDEX_FILE_NAME, "garbage");
+			DirIndex index("dirindextest");
+			Assert::IsFalse(index.Load());
+		}
+
+		TEST_METHOD(RemovesDirectory)
+		{
+			Prepare();
+			DirIndex index("dirindextest");
+			index.Open();
+			index.Update("d/1.bin", 1, 1);
+			index.Update("d/e/2.bin", 2, 2);
+			index.Update("dd.bin", 3, 3);
+			index.RemoveDir("d");
+			size_lt size;
+			time_t modTime;
+			Assert::IsFalse(index.Find("d/1.bin", &size, &modTime));
+			Assert::IsFalse(index.Find("d/e/2.bin", &size, &modTime));
+			Assert::IsTrue(index.Find("dd.bin", &size, &modTime));
+		}
+
+	private:
+		/*!
+		Makes the tree of one file without the stored index.
+		*/
+		void Prepare()
+		{
+			Dir::MakeDir("dirindextest");
+			if (File::Exist("dirindextest/" DIRINDEX_FILE_NAME))
+			{
+				File::Delete("dirindextest/" DIRINDEX_FILE_NAME);
+			}
+			if (File::Exist("dirindextest/" DIRINDEX_JOURNAL_NAME))
+			{
+				File::Delete("dirindextest/" DIRINDEX_JOURNAL_NAME);
+			}
+			WriteAll("dirindextest/a.txt", "hello");
+		}
+	};
+
+	TEST_CLASS(QueueTest)
+	{
+	public:
+		TEST_METHOD(MpmcDeliversEachItemOnce)
+		{
+			MSIYBCore::MpmcQueue<long long> queue(64);
+			const int threads = 4;
+			const long long items = 100000;
+			std::atomic<long long> sum(0);
+			std::atomic<long long> count(0);
+			std::vector<std::thread> producers;
+			std::vector<std::thread> consumers;
+			for (int t = 0; t < threads; t++)
+			{
+				producers.emplace_back([&queue, t, items]()
+				{
+					for (long long i = 1; i <= items; i++)
+					{
+						queue.Push(t * items + i);
+					}
+				});
+				consumers.emplace_back([&]()
+				{
+					long long item;
+					while (queue.Pop(item))
+					{
+						sum += item;
+						count++;
+					}
+				});
+			}
+			for (size_lt i = 0; i < producers.size(); i++)
+			{
+				producers[i].join();
+			}
+			queue.Close();
+			for (size_lt i = 0; i < consumers.size(); i++)
+			{
+				consumers[i].join();
+			}
+
+			long long total = threads * items;
+			Assert::IsTrue(count == total);
+			Assert::IsTrue(sum == total * (total + 1) / 2);
+		}
+
+		TEST_METHOD(MpmcTryPushFailsWhenFull)
+		{
+			MSIYBCore::MpmcQueue<int> queue(4);
+			for (int i = 0; i < 4; i++)
+			{
+				Assert::IsTrue(queue.TryPush(i));
+			}
+			Assert::IsFalse(queue.TryPush(4));
+			int item;
+			Assert::IsTrue(queue.TryPop(item));
+			Assert::AreEqual(0, item);
+			Assert::IsTrue(queue.TryPush(4));
+		}
+
+		TEST_METHOD(CloseWakesBlockedConsumer)
+		{
+			MSIYBCore::MpmcQueue<int> queue(4);
+			std::atomic<bool> popped(true);
+			std::thread consumer([&]()
+			{
+				int item;
+				popped = queue.Pop(item);
+			});
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			queue.Close();
+			consumer.join();
+			Assert::IsFalse(popped);
+			Assert::IsFalse(queue.Push(1));
+		}
+
+		TEST_METHOD(SpscKeepsOrder)
+		{
+			MSIYBCore::SpscQueue<int> queue(16);
+			const int items = 200000;
+			std::thread producer([&]()
+			{
+				for (int i = 0; i < items; i++)
+				{
+					queue.Push(i);
+				}
+				queue.Close();
+			});
+			int expected = 0;
+			int item;
+			bool ordered = true;
+			while (queue.Pop(item))
+			{
+				ordered = ordered && item == expected;
+				expected++;
+			}
+			producer.join();
+			Assert::IsTrue(ordered);
+			Assert::AreEqual(items, expected);
+		}
+	};
+
+	TEST_CLASS(LockTest)
+	{
+	public:
+		TEST_METHOD(MutexExcludes)
+		{
+			MSIYBCore::Mutex mutex;
+			long long counter = 0;
+			std::vector<std::thread> threads;
+			for (int t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&]()
+				{
+					for (int i = 0; i < 20000; i++)
+					{
+						MSIYBCore::Locker locker(mutex);
+						counter++;
+					}
+				});
+			}
+			for (size_lt i = 0; i < threads.size(); i++)
+			{
+				threads[i].join();
+			}
+			Assert::IsTrue(counter == 80000);
+		}
+
+		TEST_METHOD(MutexIsRecursiveAndTimesOut)
+		{
+			MSIYBCore::Mutex mutex(50);
+			Assert::IsTrue(mutex.Lock());
+			Assert::IsTrue(mutex.Lock());
+			bool taken = true;
+			bool tried = true;
+			std::thread other([&]()
+			{
+				tried = mutex.TryLock();
+				taken = mutex.Lock();
+			});
+			other.join();
+			Assert::IsFalse(tried);
+			Assert::IsFalse(taken);
+			Assert::IsTrue(mutex.Unlock());
+			Assert::IsTrue(mutex.Unlock());
+
+			std::thread after([&]()
+			{
+				taken = mutex.Lock();
+				mutex.Unlock();
+			});
+			after.join();
+			Assert::IsTrue(taken);
+		}
+
+		TEST_METHOD(RWLockSharesAndExcludes)
+		{
+			MSIYBCore::RWLock lock;
+			Assert::IsTrue(lock.LockShared());
+			bool shared = false;
+			bool exclusive = true;
+			std::thread other([&]()
+			{
+				shared = lock.TryLockShared();
+				if (shared)
+				{
+					lock.Unlock();
+				}
+				exclusive = lock.TryLock();
+			});
+			other.join();
+			Assert::IsTrue(shared);
+			Assert::IsFalse(exclusive);
+			lock.Unlock();
+
+			// The writers keep the pair equal, the readers must never see it torn
+			long long first = 0;
+			long long second = 0;
+			std::atomic<long long> torn(0);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&, t]()
+				{
+					for (int i = 0; i < 20000; i++)
+					{
+						if (t == 0 || i % 8 == 0)
+						{
+							MSIYBCore::Locker locker(lock);
+							first++;
+							second++;
+						}
+						else
+						{
+							MSIYBCore::Locker locker(lock, MSIYBCore::ELOCKSHARED);
+							if (first != second)
+							{
+								torn++;
+							}
+						}
+					}
+				});
+			}
+			for (size_lt i = 0; i < threads.size(); i++)
+			{
+				threads[i].join();
+			}
+			Assert::IsTrue(torn == 0);
+			Assert::IsTrue(first == 20000 + 3 * 2500);
+		}
+
+#ifdef __unix__
+		TEST_METHOD(ConditionVariableSignals)
+		{
+			MSIYBCore::Mutex mutex;
+			MSIYBCore::ConditionVariable condition;
+			int items = 0;
+			int consumed = 0;
+			std::thread consumer([&]()
+			{
+				MSIYBCore::Locker locker(mutex);
+				while (consumed < 10000)
+				{
+					while (items == 0)
+					{
+						condition.Wait(mutex);
+					}
+					items--;
+					consumed++;
+				}
+			});
+			for (int i = 0; i < 10000; i++)
+			{
+				MSIYBCore::Locker locker(mutex);
+				items++;
+				condition.Signal();
+			}
+			consumer.join();
+			Assert::AreEqual(10000, consumed);
+
+			MSIYBCore::Locker locker(mutex);
+			Assert::IsFalse(condition.Wait(mutex, 20));
+		}
+#endif
+	};
+
+	TEST_CLASS(EpochTest)
+	{
+	public:
+		TEST_METHOD(ReadersNeverSeeFreedVersion)
+		{
+			{
+				MSIYBCore::RcuPointer<Version> pointer(new Version(0));
+				std::atomic<bool> stop(false);
+				std::atomic<long long> torn(0);
+				std::vector<std::thread> readers;
+				for (int t = 0; t < 4; t++)
+				{
+					readers.emplace_back([&]()
+					{
+						while (!stop)
+						{
+							MSIYBCore::EpochGuard guard;
+							Version *version = pointer.Get();
+							if (version->first != version->second || version->first < 0)
+							{
+								torn++;
+							}
+						}
+					});
+				}
+				for (long long i = 1; i <= 50000; i++)
+				{
+					pointer.Publish(new Version(i));
+					if (i % 1000 == 0)
+					{
+						std::this_thread::yield();
+					}
+				}
+				stop = true;
+				for (size_lt i = 0; i < readers.size(); i++)
+				{
+					readers[i].join();
+				}
+				Assert::IsTrue(torn == 0);
+			}
+			MSIYBCore::Epoch::StopReclaimer();
+			Assert::AreEqual(0, Version::live.load());
+		}
+
+	private:
+		/// The published data: the destructor poisons it, so the freed version is seen as torn
+		struct Version
+		{
+			Version(long long value) : first(value), second(value)
+			{
+				live++;
+			}
+
+			~Version()
+			{
+				first = -1;
+				second = -2;
+				live--;
+			}
+
+			long long first;
+			long long second;
+			static std::atomic<int> live;	///< The versions not freed yet
+		};
+	};
+
+	std::atomic<int> EpochTest::Version::live(0);
+
+	TEST_CLASS(ThreadPoolTest)
+	{
+	public:
+		TEST_METHOD(FuturesGetResults)
+		{
+			MSIYBCore::ThreadPool pool(4);
+			std::vector<std::future<int> > results;
+			for (int i = 0; i < 1000; i++)
+			{
+				results.push_back(pool.Submit([](int value) { return value * 2; }, i));
+			}
+			long long sum = 0;
+			for (size_lt i = 0; i < results.size(); i++)
+			{
+				sum += results[i].get();
+			}
+			Assert::IsTrue(sum == 999000);
+		}
+
+		TEST_METHOD(FuturesGetExceptions)
+		{
+			MSIYBCore::ThreadPool pool(2);
+			std::future<int> result = pool.Submit([]() -> int { throw std::runtime_error("submitted"); });
+			Assert::ExpectException<std::runtime_error>([&]() { result.get(); });
+			pool.RethrowFailure();
+		}
+
+		TEST_METHOD(RethrowsExecuteFailureOnce)
+		{
+			// One worker: the next task runs after the failure is kept
+			MSIYBCore::ThreadPool pool(1);
+			pool.Execute([]() { throw std::runtime_error("executed"); });
+			pool.Submit([]() {}).get();
+			Assert::ExpectException<std::runtime_error>([&]() { pool.RethrowFailure(); });
+			pool.RethrowFailure();
+		}
+
+		TEST_METHOD(RunsNestedTasksBeforeStopping)
+		{
+			std::atomic<int> done(0);
+			{
+				MSIYBCore::ThreadPool pool(4);
+				for (int i = 0; i < 100; i++)
+				{
+					pool.Execute([&]()
+					{
+						for (int j = 0; j < 10; j++)
+						{
+							pool.Execute([&]() { done++; });
+						}
+					});
+				}
+			}
+			Assert::AreEqual(1000, done.load());
+		}
+	};
+
 	TEST_CLASS(File)
 	{
 	public:
@@ -14,4 +886,4 @@ namespace TestCore
 
 		}
 	};
-}
\ No newline at end of file
+}